@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "msg/wait_strategy.h"
+
+namespace bench {
+    // everything that changes a number in the report, all of it is echoed
+    // back in the json so two runs can be compared like for like
+    struct Config {
+        std::uint32_t reps = 5;             // throughput runs per case, the median is reported
+        std::uint64_t scale = 1;            // multiplies every iteration count
+        int cpu_a = -1;                     // producer / pinger core, -1 = not pinned
+        int cpu_b = -1;                     // consumer / ponger core
+        std::string filter{};               // only run cases whose name contains this
+        std::uint16_t tcp_port = 39001;     // loopback listener
+        std::string mcast_group = "239.255.0.77";
+        std::uint16_t mcast_port = 39002;
+        std::string self_path{};            // argv[0], used to start the shm child process
+    };
+
+    struct Metric {
+        std::string name;
+        double value;
+    };
+
+    struct Result {
+        std::string name;   // dotted, "msg.spsc.throughput"
+        std::string unit;   // of the headline metrics
+        std::vector<std::pair<std::string, std::string>> params{};
+        std::vector<Metric> metrics{};
+        std::string skipped{};  // why it did not run, empty when it did
+    };
+
+    class Report {
+        private:
+            std::vector<Result> m_results{};
+
+        public:
+            void add(Result r) { m_results.push_back(std::move(r)); }
+            [[nodiscard]] const std::vector<Result>& results() const noexcept { return m_results; }
+
+            // one json document, schema documented in bench_main.cpp
+            void write_json(std::FILE* out, const Config& cfg) const;
+    };
+
+    [[nodiscard]] inline bool wants(const Config& cfg, const char* name) {
+        return cfg.filter.empty() || std::string(name).find(cfg.filter) != std::string::npos;
+    }
+
+    [[nodiscard]] inline std::uint64_t now_ns() noexcept {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // spins, then starts yielding so two threads pinned to the same core
+    // (or an oversubscribed box) still make progress instead of burning
+    // a whole timeslice per hand off
+    template <typename F>
+    inline void spin_until(F&& ready) noexcept {
+        for (std::uint32_t n = 0; !ready(); ++n) {
+            if (n < 4096) {
+                msg::detail::cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // -1 leaves the thread where the os put it
+    void pin_current(int cpu);
+
+    // median/min/max of one value per rep, prefix names the series when a
+    // case reports more than one ("recv" -> recv_median, ...)
+    void add_rate(Result& r, std::vector<double> per_rep, const std::string& prefix = "");
+
+    // p50/p90/p99/p99.9/max/mean of every sample, in ns
+    void add_latency(Result& r, std::vector<std::uint64_t> samples_ns);
+
+    std::string to_str(std::uint64_t v);
+    std::string to_str(int v);
+
+    // suites, each appends one Result per case
+    void run_msg(const Config& cfg, Report& report);
+    void run_evt(const Config& cfg, Report& report);
+    void run_shm(const Config& cfg, Report& report);
+    void run_sock(const Config& cfg, Report& report);
+
+    // the other end of the shm ping pong, runs in a process started with
+    // "--child shm <id> <cpu>"
+    int shm_child(int argc, char** argv);
+
+    // platform dependent, starts cfg.self_path with args. pid is the
+    // process id on linux and a process HANDLE on windows
+    struct ChildProc {
+        std::intptr_t pid = -1;
+    };
+    [[nodiscard]] bool spawn_self(const Config& cfg, const std::vector<std::string>& args, ChildProc& out);
+    int wait_child(ChildProc& child);       // exit code, -1 on failure
+}
@@ -0,0 +1,130 @@
+#include "bench.h"
+#include "evt/event.h"
+#include "evt/fast_semaphore.h"
+#include "evt/named_semaphore.h"
+#include "evt/semaphore.h"
+#include <atomic>
+#include <memory>
+
+namespace bench {
+    namespace {
+        constexpr std::uint64_t wake_iters = 20'000;
+        constexpr std::uint64_t wake_warmup = 1'000;
+        constexpr std::uint64_t emit_calls = 1'000'000;
+
+        // a posts ping and blocks on pong, b does the reverse, so every
+        // sample is two wakeups of a sleeping thread
+        template <typename Sem>
+        std::vector<std::uint64_t> wake_rtt(const Config& cfg, Sem& ping, Sem& pong, std::uint64_t iters) {
+            const auto total = iters + wake_warmup;
+
+            std::thread echo([&]() {
+                pin_current(cfg.cpu_b);
+                for (std::uint64_t i = 0; i < total; ++i) {
+                    if (!ping.wait().ok()) return;
+                    (void)pong.post();
+                }
+            });
+
+            pin_current(cfg.cpu_a);
+            std::vector<std::uint64_t> samples;
+            samples.reserve(static_cast<std::size_t>(iters));
+            for (std::uint64_t i = 0; i < total; ++i) {
+                const auto t0 = now_ns();
+                (void)ping.post();
+                if (!pong.wait().ok()) break;
+                const auto t1 = now_ns();
+                if (i >= wake_warmup) samples.push_back(t1 - t0);
+            }
+            echo.join();
+            return samples;
+        }
+
+        template <typename Sem>
+        void drain(Sem& s) {
+            while (s.try_wait().ok()) {}
+        }
+
+        void base_params(const Config& cfg, Result& r, std::uint64_t iters) {
+            r.params.push_back({ "cpu_a", to_str(cfg.cpu_a) });
+            r.params.push_back({ "cpu_b", to_str(cfg.cpu_b) });
+            r.params.push_back({ "iters", to_str(iters) });
+        }
+
+        double emit_once(std::size_t subscribers, std::uint64_t calls) {
+            evt::Event<int> event;
+            std::atomic<std::uint64_t> hits{0};
+            std::vector<evt::Event<int>::Subscription> subs;
+            for (std::size_t i = 0; i < subscribers; ++i) {
+                subs.push_back(event.subscribe([&hits](int v) {
+                    hits.fetch_add(static_cast<std::uint64_t>(v), std::memory_order_relaxed);
+                }));
+            }
+
+            const auto start = now_ns();
+            for (std::uint64_t i = 0; i < calls; ++i) event.emit(1);
+            const auto elapsed = now_ns() - start;
+
+            if (hits.load() != calls * subscribers) std::fputs("mootils_bench: emit count mismatch\n", stderr);
+            return static_cast<double>(elapsed) / static_cast<double>(calls);
+        }
+    }
+
+    void run_evt(const Config& cfg, Report& report) {
+        const auto iters = wake_iters * cfg.scale;
+
+        if (wants(cfg, "evt.semaphore.wake_rtt")) {
+            Result r{ "evt.semaphore.wake_rtt", "ns" };
+            base_params(cfg, r, iters);
+            evt::Semaphore ping;
+            evt::Semaphore pong;
+            add_latency(r, wake_rtt(cfg, ping, pong, iters));
+            report.add(std::move(r));
+        }
+
+        if (wants(cfg, "evt.fast_semaphore.wake_rtt")) {
+            Result r{ "evt.fast_semaphore.wake_rtt", "ns" };
+            base_params(cfg, r, iters);
+            auto ping = std::make_unique<evt::FastSemaphore>();
+            auto pong = std::make_unique<evt::FastSemaphore>();
+            add_latency(r, wake_rtt(cfg, *ping, *pong, iters));
+            report.add(std::move(r));
+        }
+
+        if (wants(cfg, "evt.named_semaphore.wake_rtt")) {
+            Result r{ "evt.named_semaphore.wake_rtt", "ns" };
+            // named semaphores outlive the process (close() doesnt unlink), use
+            // fixed ids so reruns reuse the same pair and drain what an
+            // interrupted run left behind
+            constexpr std::int64_t base = 0x6D6F0000;
+            evt::NamedSemaphore ping(base);
+            evt::NamedSemaphore pong(base + 1);
+            if (!ping.open().ok() || !pong.open().ok()) {
+                r.skipped = "NamedSemaphore::open failed";
+            } else {
+                drain(ping);
+                drain(pong);
+                base_params(cfg, r, iters);
+                add_latency(r, wake_rtt(cfg, ping, pong, iters));
+            }
+            report.add(std::move(r));
+        }
+
+        for (const std::size_t subs : { std::size_t{0}, std::size_t{1}, std::size_t{8}, std::size_t{64} }) {
+            const auto name = "evt.event.emit.s" + to_str(static_cast<std::uint64_t>(subs));
+            if (!wants(cfg, name.c_str())) continue;
+
+            const auto calls = emit_calls * cfg.scale / (subs > 8 ? 8 : 1);
+            Result r{ name, "ns/emit" };
+            r.params.push_back({ "subscribers", to_str(static_cast<std::uint64_t>(subs)) });
+            r.params.push_back({ "calls", to_str(calls) });
+
+            pin_current(cfg.cpu_a);
+            (void)emit_once(subs, calls / 10);
+            std::vector<double> reps;
+            for (std::uint32_t i = 0; i < cfg.reps; ++i) reps.push_back(emit_once(subs, calls));
+            add_rate(r, std::move(reps));
+            report.add(std::move(r));
+        }
+    }
+}
@@ -0,0 +1,266 @@
+// mootils_bench, microbenchmarks for the queues, shm, sockets and events.
+//
+// Prints one json document to stdout (or --out <file>):
+// {
+//   "schema": 1,
+//   "meta":    { compiler, build, platform, cores, timestamp },
+//   "config":  { every Config field },
+//   "results": [ { "name", "unit", "params": {..}, "metrics": {..} }
+//              | { "name", "skipped": "why" } ]
+// }
+// Throughput metrics are the median/min/max over --reps runs, latency
+// metrics are percentiles over every sample of one run after a warmup.
+// Iteration counts are fixed (times --scale) so runs with the same config
+// on the same box do the same work.
+#include "bench.h"
+#include "platform/platform.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace bench {
+    namespace {
+        void write_escaped(std::FILE* out, const std::string& s) {
+            std::fputc('"', out);
+            for (const char c : s) {
+                switch (c) {
+                    case '"': std::fputs("\\\"", out); break;
+                    case '\\': std::fputs("\\\\", out); break;
+                    case '\n': std::fputs("\\n", out); break;
+                    case '\t': std::fputs("\\t", out); break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            std::fprintf(out, "\\u%04x", static_cast<unsigned>(c));
+                        } else {
+                            std::fputc(c, out);
+                        }
+                }
+            }
+            std::fputc('"', out);
+        }
+
+        void write_kv(std::FILE* out, const char* key, const std::string& value, bool last = false) {
+            std::fprintf(out, "    \"%s\": ", key);
+            write_escaped(out, value);
+            std::fputs(last ? "\n" : ",\n", out);
+        }
+
+        void write_kv(std::FILE* out, const char* key, long long value, bool last = false) {
+            std::fprintf(out, "    \"%s\": %lld%s", key, value, last ? "\n" : ",\n");
+        }
+
+        std::string compiler_str() {
+            #if defined(__clang__)
+                return "clang " __clang_version__;
+            #elif defined(__GNUC__)
+                return "gcc " __VERSION__;
+            #elif defined(_MSC_VER)
+                return "msvc " + to_str(static_cast<std::uint64_t>(_MSC_FULL_VER));
+            #else
+                return "unknown";
+            #endif
+        }
+
+        double percentile(const std::vector<std::uint64_t>& sorted, double pct) {
+            if (sorted.empty()) return 0.0;
+            auto idx = static_cast<std::size_t>(pct / 100.0 * static_cast<double>(sorted.size()));
+            if (idx >= sorted.size()) idx = sorted.size() - 1;
+            return static_cast<double>(sorted[idx]);
+        }
+
+        void usage() {
+            std::fputs(
+                "usage: mootils_bench [options]\n"
+                "  --filter <str>     only run cases whose name contains str (msg., evt., shm., sock.)\n"
+                "  --reps <n>         throughput runs per case, median reported (default 5)\n"
+                "  --scale <n>        multiply every iteration count (default 1)\n"
+                "  --cpus <a>,<b>     pin the two sides of each case to these cores\n"
+                "  --tcp-port <p>     loopback port for sock.tcp (default 39001)\n"
+                "  --mcast <ip>:<p>   group for sock.udp (default 239.255.0.77:39002)\n"
+                "  --out <file>       write the json here instead of stdout\n"
+                "  --list             print the suites and exit\n",
+                stderr);
+        }
+
+        bool parse_u64(const char* s, std::uint64_t& out) {
+            if (s == nullptr || *s == '\0') return false;
+            char* end = nullptr;
+            const auto v = std::strtoull(s, &end, 10);
+            if (end == nullptr || *end != '\0') return false;
+            out = static_cast<std::uint64_t>(v);
+            return true;
+        }
+    }
+
+    void Report::write_json(std::FILE* out, const Config& cfg) const {
+        std::fputs("{\n  \"schema\": 1,\n  \"meta\": {\n", out);
+        write_kv(out, "compiler", compiler_str());
+        #if defined(NDEBUG)
+            write_kv(out, "build", "release");
+        #else
+            write_kv(out, "build", "debug");
+        #endif
+        #if defined(MOO_INSTRUMENT)
+            write_kv(out, "instrument", "on");
+        #else
+            write_kv(out, "instrument", "off");
+        #endif
+        #if defined(MOO_WIN32)
+            write_kv(out, "platform", "windows");
+        #elif defined(MOO_LINUX)
+            write_kv(out, "platform", "linux");
+        #endif
+        write_kv(out, "cores", static_cast<long long>(std::thread::hardware_concurrency()));
+        write_kv(out, "timestamp", plat::timestamp_str(), true);
+
+        std::fputs("  },\n  \"config\": {\n", out);
+        write_kv(out, "reps", static_cast<long long>(cfg.reps));
+        write_kv(out, "scale", static_cast<long long>(cfg.scale));
+        write_kv(out, "cpu_a", static_cast<long long>(cfg.cpu_a));
+        write_kv(out, "cpu_b", static_cast<long long>(cfg.cpu_b));
+        write_kv(out, "filter", cfg.filter);
+        write_kv(out, "tcp_port", static_cast<long long>(cfg.tcp_port));
+        write_kv(out, "mcast", cfg.mcast_group + ":" + to_str(static_cast<std::uint64_t>(cfg.mcast_port)), true);
+
+        std::fputs("  },\n  \"results\": [\n", out);
+        for (std::size_t i = 0; i < m_results.size(); ++i) {
+            const auto& r = m_results[i];
+            std::fputs("    { \"name\": ", out);
+            write_escaped(out, r.name);
+
+            if (!r.skipped.empty()) {
+                std::fputs(", \"skipped\": ", out);
+                write_escaped(out, r.skipped);
+            } else {
+                std::fputs(", \"unit\": ", out);
+                write_escaped(out, r.unit);
+
+                std::fputs(", \"params\": {", out);
+                for (std::size_t p = 0; p < r.params.size(); ++p) {
+                    std::fputs(p == 0 ? " " : ", ", out);
+                    write_escaped(out, r.params[p].first);
+                    std::fputs(": ", out);
+                    write_escaped(out, r.params[p].second);
+                }
+                std::fputs(" }, \"metrics\": {", out);
+                for (std::size_t m = 0; m < r.metrics.size(); ++m) {
+                    std::fputs(m == 0 ? " " : ", ", out);
+                    write_escaped(out, r.metrics[m].name);
+                    std::fprintf(out, ": %.3f", r.metrics[m].value);
+                }
+                std::fputs(" }", out);
+            }
+            std::fputs(i + 1 == m_results.size() ? " }\n" : " },\n", out);
+        }
+        std::fputs("  ]\n}\n", out);
+    }
+
+    void pin_current(int cpu) {
+        if (cpu >= 0) plat::affinitize_current_thread(static_cast<std::uint32_t>(cpu));
+    }
+
+    void add_rate(Result& r, std::vector<double> per_rep, const std::string& prefix) {
+        if (per_rep.empty()) return;
+        std::sort(per_rep.begin(), per_rep.end());
+        const auto pre = prefix.empty() ? prefix : prefix + "_";
+        r.metrics.push_back({ pre + "median", per_rep[per_rep.size() / 2] });
+        r.metrics.push_back({ pre + "min", per_rep.front() });
+        r.metrics.push_back({ pre + "max", per_rep.back() });
+    }
+
+    void add_latency(Result& r, std::vector<std::uint64_t> samples_ns) {
+        if (samples_ns.empty()) return;
+        std::sort(samples_ns.begin(), samples_ns.end());
+
+        double sum = 0.0;
+        for (const auto s : samples_ns) sum += static_cast<double>(s);
+
+        r.metrics.push_back({ "p50", percentile(samples_ns, 50.0) });
+        r.metrics.push_back({ "p90", percentile(samples_ns, 90.0) });
+        r.metrics.push_back({ "p99", percentile(samples_ns, 99.0) });
+        r.metrics.push_back({ "p999", percentile(samples_ns, 99.9) });
+        r.metrics.push_back({ "max", static_cast<double>(samples_ns.back()) });
+        r.metrics.push_back({ "mean", sum / static_cast<double>(samples_ns.size()) });
+        r.metrics.push_back({ "samples", static_cast<double>(samples_ns.size()) });
+    }
+
+    std::string to_str(std::uint64_t v) { return std::to_string(v); }
+    std::string to_str(int v) { return std::to_string(v); }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "--child") == 0) {
+        if (std::strcmp(argv[2], "shm") == 0) return bench::shm_child(argc - 3, argv + 3);
+        return 2;
+    }
+
+    bench::Config cfg{};
+    cfg.self_path = argc > 0 ? argv[0] : "";
+    const char* out_path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* next = i + 1 < argc ? argv[i + 1] : nullptr;
+        std::uint64_t v = 0;
+
+        if (std::strcmp(arg, "--list") == 0) {
+            std::puts("msg  spsc/spmc throughput and round trip\n"
+                      "evt  semaphore wake latency, event emit\n"
+                      "shm  cross process ping pong\n"
+                      "sock tcp loopback throughput, udp multicast pps");
+            return 0;
+        } else if (std::strcmp(arg, "--filter") == 0 && next != nullptr) {
+            cfg.filter = next;
+        } else if (std::strcmp(arg, "--reps") == 0 && bench::parse_u64(next, v) && v > 0 && v <= UINT32_MAX) {
+            cfg.reps = static_cast<std::uint32_t>(v);
+        } else if (std::strcmp(arg, "--scale") == 0 && bench::parse_u64(next, v) && v > 0) {
+            cfg.scale = v;
+        } else if (std::strcmp(arg, "--tcp-port") == 0 && bench::parse_u64(next, v) && v > 0 && v <= UINT16_MAX) {
+            cfg.tcp_port = static_cast<std::uint16_t>(v);
+        } else if (std::strcmp(arg, "--cpus") == 0 && next != nullptr && std::strchr(next, ',') != nullptr) {
+            const std::string s(next);
+            const auto comma = s.find(',');
+            std::uint64_t a = 0;
+            std::uint64_t b = 0;
+            if (!bench::parse_u64(s.substr(0, comma).c_str(), a) || !bench::parse_u64(s.substr(comma + 1).c_str(), b) || a > 4096 || b > 4096) {
+                bench::usage();
+                return 2;
+            }
+            cfg.cpu_a = static_cast<int>(a);
+            cfg.cpu_b = static_cast<int>(b);
+        } else if (std::strcmp(arg, "--mcast") == 0 && next != nullptr && std::strchr(next, ':') != nullptr) {
+            const std::string s(next);
+            const auto colon = s.rfind(':');
+            if (!bench::parse_u64(s.substr(colon + 1).c_str(), v) || v == 0 || v > UINT16_MAX) {
+                bench::usage();
+                return 2;
+            }
+            cfg.mcast_group = s.substr(0, colon);
+            cfg.mcast_port = static_cast<std::uint16_t>(v);
+        } else if (std::strcmp(arg, "--out") == 0 && next != nullptr) {
+            out_path = next;
+        } else {
+            bench::usage();
+            return 2;
+        }
+        ++i; // every option takes a value
+    }
+
+    bench::Report report;
+    bench::run_msg(cfg, report);
+    bench::run_evt(cfg, report);
+    bench::run_shm(cfg, report);
+    bench::run_sock(cfg, report);
+
+    std::FILE* out = stdout;
+    if (out_path != nullptr) {
+        out = std::fopen(out_path, "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "mootils_bench: cannot open %s\n", out_path);
+            return 1;
+        }
+    }
+    report.write_json(out, cfg);
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
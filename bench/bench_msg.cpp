@@ -0,0 +1,216 @@
+#include "bench.h"
+#include "msg/spsc_queue.h"
+#include "msg/spmc_queue.h"
+#include <atomic>
+#include <memory>
+
+namespace bench {
+    namespace {
+        using Spsc = msg::SPSCQueue<std::uint64_t, 4096>;
+        using Spmc = msg::SPMCQueue<std::uint64_t, 4096, 8>;
+
+        constexpr std::uint64_t throughput_msgs = 2'000'000;
+        constexpr std::uint64_t rtt_iters = 100'000;
+        constexpr std::uint64_t rtt_warmup = 10'000;
+        constexpr std::size_t batch = 64;
+
+        void base_params(const Config& cfg, Result& r) {
+            r.params.push_back({ "cpu_a", to_str(cfg.cpu_a) });
+            r.params.push_back({ "cpu_b", to_str(cfg.cpu_b) });
+        }
+
+        // producer on cpu_a, consumer on cpu_b, msgs/s from the first push to the last pop
+        double spsc_throughput_once(const Config& cfg, std::uint64_t msgs, bool batched) {
+            auto q = std::make_unique<Spsc>();
+            auto producer = std::move(q->make_producer().value());
+            auto consumer = std::move(q->make_consumer().value());
+            std::atomic<bool> go{false};
+
+            std::thread prod([&]() {
+                pin_current(cfg.cpu_a);
+                spin_until([&]() noexcept { return go.load(std::memory_order_acquire); });
+
+                std::uint64_t buf[batch];
+                std::uint64_t next = 0;
+                while (next < msgs) {
+                    if (batched) {
+                        std::size_t n = 0;
+                        while (n < batch && next + n < msgs) { buf[n] = next + n; ++n; }
+                        const auto pushed = producer.push_n(buf, n);
+                        next += pushed;
+                        if (pushed == 0) std::this_thread::yield();
+                    } else if (producer.push(next)) {
+                        ++next;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+            pin_current(cfg.cpu_b);
+            go.store(true, std::memory_order_release);
+            const auto start = now_ns();
+
+            std::uint64_t buf[batch];
+            std::uint64_t seen = 0;
+            std::uint64_t sum = 0;
+            while (seen < msgs) {
+                if (batched) {
+                    const auto n = consumer.try_pop_n(buf, batch);
+                    for (std::size_t i = 0; i < n; ++i) sum += buf[i];
+                    seen += n;
+                    if (n == 0) std::this_thread::yield();
+                } else {
+                    std::uint64_t v = 0;
+                    if (consumer.try_pop(v)) {
+                        sum += v;
+                        ++seen;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            const auto elapsed = now_ns() - start;
+            prod.join();
+
+            if (sum != msgs * (msgs - 1) / 2) std::fputs("mootils_bench: spsc checksum mismatch\n", stderr);
+            return static_cast<double>(msgs) * 1e9 / static_cast<double>(elapsed);
+        }
+
+        // one producer, consumers all on cpu_b (they share it when there is more than one)
+        double spmc_throughput_once(const Config& cfg, std::uint64_t msgs, std::size_t consumers) {
+            auto q = std::make_unique<Spmc>();
+            auto producer = std::move(q->make_producer().value());
+            std::vector<Spmc::Consumer> cons;
+            for (std::size_t i = 0; i < consumers; ++i) cons.push_back(std::move(q->make_consumer().value()));
+
+            std::atomic<bool> go{false};
+            std::atomic<std::size_t> done{0};
+            std::vector<std::thread> threads;
+            for (std::size_t i = 0; i < consumers; ++i) {
+                threads.emplace_back([&, i]() {
+                    pin_current(cfg.cpu_b);
+                    spin_until([&]() noexcept { return go.load(std::memory_order_acquire); });
+                    std::uint64_t seen = 0;
+                    std::uint64_t v = 0;
+                    while (seen < msgs) {
+                        if (cons[i].try_pop(v)) {
+                            ++seen;
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    }
+                    done.fetch_add(1, std::memory_order_acq_rel);
+                });
+            }
+
+            pin_current(cfg.cpu_a);
+            go.store(true, std::memory_order_release);
+            const auto start = now_ns();
+            for (std::uint64_t next = 0; next < msgs;) {
+                if (producer.push(next)) {
+                    ++next;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            spin_until([&]() noexcept { return done.load(std::memory_order_acquire) == consumers; });
+            const auto elapsed = now_ns() - start;
+            for (auto& t : threads) t.join();
+
+            return static_cast<double>(msgs) * 1e9 / static_cast<double>(elapsed);
+        }
+
+        // ping goes out on a, comes back on b, every sample is one full round trip
+        template <typename Out, typename Back>
+        std::vector<std::uint64_t> ping_pong(const Config& cfg, Out& out_q, Back& back_q, std::uint64_t iters) {
+            auto ping = std::move(out_q.make_producer().value());
+            auto ping_rx = std::move(out_q.make_consumer().value());
+            auto pong = std::move(back_q.make_producer().value());
+            auto pong_rx = std::move(back_q.make_consumer().value());
+            const auto total = iters + rtt_warmup;
+
+            std::thread echo([&]() {
+                pin_current(cfg.cpu_b);
+                std::uint64_t v = 0;
+                for (std::uint64_t i = 0; i < total; ++i) {
+                    spin_until([&]() noexcept { return ping_rx.try_pop(v); });
+                    while (!pong.push(v)) msg::detail::cpu_relax();
+                }
+            });
+
+            pin_current(cfg.cpu_a);
+            std::vector<std::uint64_t> samples;
+            samples.reserve(static_cast<std::size_t>(iters));
+            std::uint64_t v = 0;
+            for (std::uint64_t i = 0; i < total; ++i) {
+                const auto t0 = now_ns();
+                while (!ping.push(i)) msg::detail::cpu_relax();
+                spin_until([&]() noexcept { return pong_rx.try_pop(v); });
+                const auto t1 = now_ns();
+                if (i >= rtt_warmup) samples.push_back(t1 - t0);
+            }
+            echo.join();
+            return samples;
+        }
+    }
+
+    void run_msg(const Config& cfg, Report& report) {
+        const auto msgs = throughput_msgs * cfg.scale;
+
+        for (const bool batched : { false, true }) {
+            const char* name = batched ? "msg.spsc.throughput_batch" : "msg.spsc.throughput";
+            if (!wants(cfg, name)) continue;
+
+            Result r{ name, "msgs/s" };
+            base_params(cfg, r);
+            r.params.push_back({ "msgs", to_str(msgs) });
+            r.params.push_back({ "capacity", "4096" });
+            if (batched) r.params.push_back({ "batch", to_str(static_cast<std::uint64_t>(batch)) });
+
+            (void)spsc_throughput_once(cfg, msgs / 10, batched); // warmup
+            std::vector<double> reps;
+            for (std::uint32_t i = 0; i < cfg.reps; ++i) reps.push_back(spsc_throughput_once(cfg, msgs, batched));
+            add_rate(r, std::move(reps));
+            report.add(std::move(r));
+        }
+
+        if (wants(cfg, "msg.spsc.rtt")) {
+            Result r{ "msg.spsc.rtt", "ns" };
+            base_params(cfg, r);
+            r.params.push_back({ "iters", to_str(rtt_iters * cfg.scale) });
+            auto a = std::make_unique<Spsc>();
+            auto b = std::make_unique<Spsc>();
+            add_latency(r, ping_pong(cfg, *a, *b, rtt_iters * cfg.scale));
+            report.add(std::move(r));
+        }
+
+        for (const std::size_t consumers : { std::size_t{1}, std::size_t{2}, std::size_t{4} }) {
+            const auto name = "msg.spmc.throughput.c" + to_str(static_cast<std::uint64_t>(consumers));
+            if (!wants(cfg, name.c_str())) continue;
+
+            Result r{ name, "msgs/s" };
+            base_params(cfg, r);
+            r.params.push_back({ "msgs", to_str(msgs / 2) });
+            r.params.push_back({ "consumers", to_str(static_cast<std::uint64_t>(consumers)) });
+            r.params.push_back({ "capacity", "4096" });
+
+            (void)spmc_throughput_once(cfg, msgs / 20, consumers);
+            std::vector<double> reps;
+            for (std::uint32_t i = 0; i < cfg.reps; ++i) reps.push_back(spmc_throughput_once(cfg, msgs / 2, consumers));
+            add_rate(r, std::move(reps));
+            report.add(std::move(r));
+        }
+
+        if (wants(cfg, "msg.spmc.rtt")) {
+            // out through the broadcast queue, back through a plain SPSC
+            Result r{ "msg.spmc.rtt", "ns" };
+            base_params(cfg, r);
+            r.params.push_back({ "iters", to_str(rtt_iters * cfg.scale) });
+            auto a = std::make_unique<Spmc>();
+            auto b = std::make_unique<Spsc>();
+            add_latency(r, ping_pong(cfg, *a, *b, rtt_iters * cfg.scale));
+            report.add(std::move(r));
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "bench.h"
+#include "shm/shm.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace bench {
+    namespace {
+        constexpr std::uint64_t pp_iters = 100'000;
+        constexpr std::uint64_t pp_warmup = 10'000;
+        constexpr std::uint64_t pp_stop = UINT64_MAX;
+        constexpr std::int32_t pp_shm_id = 0x6D6F0100;
+        constexpr std::uint64_t child_timeout_ns = 5'000'000'000;
+
+        // each side only writes its own line
+        struct PingPong {
+            alignas(64) std::atomic<std::uint64_t> ping;
+            alignas(64) std::atomic<std::uint64_t> pong;
+            alignas(64) std::atomic<std::uint32_t> child_ready;
+        };
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ping pong needs process shared 64-bit atomics");
+
+        // spin_until with a way out, so a child that died doesnt hang the run
+        template <typename F>
+        bool spin_until_for(F&& ready, std::uint64_t timeout_ns) noexcept {
+            const auto deadline = now_ns() + timeout_ns;
+            for (std::uint32_t n = 0; !ready(); ++n) {
+                if (n < 4096) {
+                    msg::detail::cpu_relax();
+                    continue;
+                }
+                if ((n & 1023) == 0 && now_ns() > deadline) return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+    }
+
+    int shm_child(int argc, char** argv) {
+        if (argc < 2) return 2;
+        const auto id = static_cast<std::int32_t>(std::strtol(argv[0], nullptr, 10));
+        pin_current(static_cast<int>(std::strtol(argv[1], nullptr, 10)));
+
+        shm::Shm region(id, sizeof(PingPong));
+        if (!region.open().ok()) return 1;
+        auto* pp = region.map_to_type<PingPong>(0);
+        if (pp == nullptr) return 1;
+
+        pp->child_ready.store(1, std::memory_order_release);
+        std::uint64_t last = 0;
+        while (true) {
+            std::uint64_t v = 0;
+            if (!spin_until_for([&]() noexcept {
+                v = pp->ping.load(std::memory_order_acquire);
+                return v != last;
+            }, child_timeout_ns)) {
+                return 1; // parent went away
+            }
+            if (v == pp_stop) return 0;
+            last = v;
+            pp->pong.store(v, std::memory_order_release);
+        }
+    }
+
+    void run_shm(const Config& cfg, Report& report) {
+        if (!wants(cfg, "shm.pingpong.rtt")) return;
+
+        Result r{ "shm.pingpong.rtt", "ns" };
+        const auto iters = pp_iters * cfg.scale;
+
+        // shm files are not unlinked on close, reuse the one an earlier run made
+        shm::Shm region(pp_shm_id, sizeof(PingPong));
+        auto res = region.create();
+        if (res.code == shm::ShmErr::AlreadyExists) res = region.open();
+        auto* pp = res.ok() ? region.map_to_type<PingPong>(0) : nullptr;
+        if (pp == nullptr) {
+            r.skipped = "Shm create/open failed";
+            report.add(std::move(r));
+            return;
+        }
+        new (pp) PingPong{};
+
+        ChildProc child{};
+        if (!spawn_self(cfg, { "--child", "shm", to_str(static_cast<int>(pp_shm_id)), to_str(cfg.cpu_b) }, child)) {
+            r.skipped = "could not start child process";
+            report.add(std::move(r));
+            return;
+        }
+
+        if (!spin_until_for([&]() noexcept { return pp->child_ready.load(std::memory_order_acquire) != 0; }, child_timeout_ns)) {
+            r.skipped = "child process did not attach";
+            pp->ping.store(pp_stop, std::memory_order_release);
+            (void)wait_child(child);
+            report.add(std::move(r));
+            return;
+        }
+
+        pin_current(cfg.cpu_a);
+        std::vector<std::uint64_t> samples;
+        samples.reserve(static_cast<std::size_t>(iters));
+        bool lost = false;
+        for (std::uint64_t i = 1; i <= iters + pp_warmup; ++i) {
+            const auto t0 = now_ns();
+            pp->ping.store(i, std::memory_order_release);
+            if (!spin_until_for([&]() noexcept { return pp->pong.load(std::memory_order_acquire) == i; }, child_timeout_ns)) {
+                lost = true;
+                break;
+            }
+            const auto t1 = now_ns();
+            if (i > pp_warmup) samples.push_back(t1 - t0);
+        }
+
+        pp->ping.store(pp_stop, std::memory_order_release);
+        const int code = wait_child(child);
+
+        if (lost || code != 0) {
+            r.skipped = "child process stopped answering";
+        } else {
+            r.params.push_back({ "cpu_a", to_str(cfg.cpu_a) });
+            r.params.push_back({ "cpu_b", to_str(cfg.cpu_b) });
+            r.params.push_back({ "iters", to_str(iters) });
+            add_latency(r, std::move(samples));
+        }
+        report.add(std::move(r));
+    }
+}
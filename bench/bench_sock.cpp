@@ -0,0 +1,229 @@
+#include "bench.h"
+#include "sock/socket_context.h"
+#include "sock/tcp_socket.h"
+#include "sock/udp_multicast.h"
+#include <atomic>
+#include <memory>
+
+namespace bench {
+    namespace {
+        constexpr std::uint64_t tcp_bytes = 256ull * 1024 * 1024;
+        constexpr std::uint64_t udp_datagrams = 200'000;
+        constexpr std::size_t udp_payload = 64;
+
+        // one connection for every rep, the receiver reads exactly bytes per
+        // rep then bumps reps_done so the sender can stop the clock
+        void tcp_case(const Config& cfg, Report& report, std::size_t chunk) {
+            const auto name = "sock.tcp.throughput.c" + to_str(static_cast<std::uint64_t>(chunk));
+            if (!wants(cfg, name.c_str())) return;
+
+            Result r{ name, "MB/s" };
+            const auto bytes = tcp_bytes * cfg.scale;
+
+            sock::TCPServer server;
+            auto res = server.open_and_listen(cfg.tcp_port, "127.0.0.1");
+            if (!res.ok()) {
+                r.skipped = "listen failed: " + std::string(res.code_to_string());
+                report.add(std::move(r));
+                return;
+            }
+
+            // connect before accepting, the handshake completes off the backlog
+            // and nothing is left blocked in accept() if the connect fails
+            pin_current(cfg.cpu_a);
+            sock::TCPClient client;
+            res = client.open_and_connect("127.0.0.1", cfg.tcp_port);
+            auto [peer, accepted] = res.ok() ? server.accept() : std::make_pair(std::shared_ptr<sock::TCPClient>{}, res);
+            if (!res.ok() || !accepted.ok() || peer == nullptr) {
+                r.skipped = "connect/accept failed: " + std::string(res.ok() ? accepted.code_to_string() : res.code_to_string());
+                report.add(std::move(r));
+                return;
+            }
+
+            std::atomic<std::uint32_t> reps_done{0};
+            std::atomic<bool> failed{false};
+            const auto total_reps = cfg.reps + 1; // first one is warmup
+
+            std::thread rx([&, rx_client = peer]() {
+                pin_current(cfg.cpu_b);
+                std::vector<std::byte> buf(chunk);
+                for (std::uint32_t rep = 0; rep < total_reps; ++rep) {
+                    for (std::uint64_t got = 0; got < bytes; got += chunk) {
+                        if (!rx_client->recv_all(buf.data(), chunk).ok()) {
+                            failed.store(true);
+                            return;
+                        }
+                    }
+                    reps_done.fetch_add(1, std::memory_order_acq_rel);
+                }
+            });
+
+            std::vector<std::byte> buf(chunk, std::byte{0x5a});
+            std::vector<double> reps;
+            for (std::uint32_t rep = 0; rep < total_reps && !failed.load(); ++rep) {
+                const auto start = now_ns();
+                for (std::uint64_t sent = 0; sent < bytes; sent += chunk) {
+                    if (!client.send_all(buf.data(), chunk).ok()) {
+                        failed.store(true);
+                        break;
+                    }
+                }
+                spin_until([&]() noexcept { return reps_done.load(std::memory_order_acquire) > rep || failed.load(); });
+                const auto elapsed = now_ns() - start;
+                if (rep > 0) reps.push_back(static_cast<double>(bytes) / (1024.0 * 1024.0) * 1e9 / static_cast<double>(elapsed));
+            }
+
+            if (failed.load()) client.close(); // wakes a receiver still waiting for bytes
+            rx.join();
+            client.close();
+            peer->close();
+            server.close();
+
+            if (failed.load()) {
+                r.skipped = "connection failed mid run";
+            } else {
+                r.params.push_back({ "cpu_a", to_str(cfg.cpu_a) });
+                r.params.push_back({ "cpu_b", to_str(cfg.cpu_b) });
+                r.params.push_back({ "bytes", to_str(bytes) });
+                r.params.push_back({ "chunk", to_str(static_cast<std::uint64_t>(chunk)) });
+                add_rate(r, std::move(reps));
+            }
+            report.add(std::move(r));
+        }
+
+        struct UdpRep {
+            double sent_pps = 0.0;
+            double recv_pps = 0.0;
+            double loss = 0.0;
+        };
+
+        // fresh sockets every rep so a backed up receive buffer doesnt carry over
+        bool udp_once(const Config& cfg, std::uint64_t count, UdpRep& out, std::string& err) {
+            sock::UdpMcastConfig mc{};
+            mc.group_ip = cfg.mcast_group;
+            mc.port = cfg.mcast_port;
+            mc.loopback = true;
+            mc.rcvbuf = 4 * 1024 * 1024;
+
+            // shared with the receive thread so a receiver that never sees the
+            // stop marker can be left behind without touching freed memory
+            struct RxState {
+                sock::UDPMulticastSocket socket;
+                std::atomic<std::uint64_t> received{0};
+                std::atomic<std::uint64_t> first_ns{0};
+                std::atomic<std::uint64_t> last_ns{0};
+                std::atomic<bool> done{false};
+            };
+            auto rx_state = std::make_shared<RxState>();
+
+            sock::UDPMulticastSocket sender;
+            auto res = rx_state->socket.open_and_join(mc);
+            if (res.ok()) res = sender.open_and_join(mc);
+            if (!res.ok()) {
+                err = "open_and_join failed: " + std::string(res.code_to_string());
+                return false;
+            }
+
+            std::thread rx([st = rx_state, cpu = cfg.cpu_b]() {
+                pin_current(cpu);
+                unsigned char buf[2048];
+                while (true) {
+                    const auto got = st->socket.recv_broadcast(buf, sizeof(buf));
+                    if (!got.ok()) {
+                        if (!st->socket.is_open()) break;
+                        continue;
+                    }
+                    if (got.bytes == 1) break; // stop marker
+                    const auto t = now_ns();
+                    if (st->received.fetch_add(1, std::memory_order_relaxed) == 0) st->first_ns.store(t, std::memory_order_relaxed);
+                    st->last_ns.store(t, std::memory_order_relaxed);
+                }
+                st->done.store(true, std::memory_order_release);
+            });
+
+            pin_current(cfg.cpu_a);
+            unsigned char payload[udp_payload] = {};
+            const auto start = now_ns();
+            std::uint64_t sent = 0;
+            for (std::uint64_t i = 0; i < count; ++i) {
+                payload[0] = static_cast<unsigned char>(i);
+                if (sender.send_broadcast(payload, sizeof(payload)).ok()) ++sent;
+            }
+            const auto send_elapsed = now_ns() - start;
+
+            // closing a socket doesnt wake a blocked recv on linux, so stop the
+            // receiver with 1 byte markers, resent until one gets through
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            for (int tries = 0; tries < 200 && !rx_state->done.load(std::memory_order_acquire); ++tries) {
+                (void)sender.send_broadcast(payload, 1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            sender.close();
+            if (!rx_state->done.load(std::memory_order_acquire)) {
+                rx.detach();
+                err = "receiver never saw the stop marker";
+                return false;
+            }
+            rx.join();
+            rx_state->socket.close();
+
+            const auto& received = rx_state->received;
+            const auto& first_ns = rx_state->first_ns;
+            const auto& last_ns = rx_state->last_ns;
+            const auto got = received.load();
+            const auto span = last_ns.load() > first_ns.load() ? last_ns.load() - first_ns.load() : 1;
+            out.sent_pps = static_cast<double>(sent) * 1e9 / static_cast<double>(send_elapsed);
+            out.recv_pps = got > 1 ? static_cast<double>(got - 1) * 1e9 / static_cast<double>(span) : 0.0;
+            out.loss = sent == 0 ? 1.0 : 1.0 - static_cast<double>(got) / static_cast<double>(sent);
+            if (out.loss < 0.0) out.loss = 0.0;
+            return true;
+        }
+
+        void udp_case(const Config& cfg, Report& report) {
+            if (!wants(cfg, "sock.udp.multicast_pps")) return;
+
+            Result r{ "sock.udp.multicast_pps", "datagrams/s" };
+            const auto count = udp_datagrams * cfg.scale;
+
+            std::vector<double> sent;
+            std::vector<double> recv;
+            std::vector<double> loss;
+            std::string err;
+            for (std::uint32_t rep = 0; rep < cfg.reps; ++rep) {
+                UdpRep one{};
+                if (!udp_once(cfg, count, one, err)) break;
+                sent.push_back(one.sent_pps);
+                recv.push_back(one.recv_pps);
+                loss.push_back(one.loss);
+            }
+
+            if (!err.empty()) {
+                r.skipped = err;
+            } else {
+                r.params.push_back({ "cpu_a", to_str(cfg.cpu_a) });
+                r.params.push_back({ "cpu_b", to_str(cfg.cpu_b) });
+                r.params.push_back({ "datagrams", to_str(count) });
+                r.params.push_back({ "payload", to_str(static_cast<std::uint64_t>(udp_payload)) });
+                r.params.push_back({ "group", cfg.mcast_group + ":" + to_str(static_cast<std::uint64_t>(cfg.mcast_port)) });
+                add_rate(r, std::move(sent), "sent");
+                add_rate(r, std::move(recv), "recv");
+                add_rate(r, std::move(loss), "loss");
+            }
+            report.add(std::move(r));
+        }
+    }
+
+    void run_sock(const Config& cfg, Report& report) {
+        const sock::SocketContext ctx;
+        if (!ctx.ok()) {
+            Result r{ "sock", "" };
+            r.skipped = "socket context init failed";
+            report.add(std::move(r));
+            return;
+        }
+
+        tcp_case(cfg, report, 1024);
+        tcp_case(cfg, report, 64 * 1024);
+        udp_case(cfg, report);
+    }
+}
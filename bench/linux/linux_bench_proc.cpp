@@ -0,0 +1,44 @@
+#if defined(MOO_LINUX)
+
+#include "bench.h"
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+
+extern char** environ;
+
+namespace bench {
+    bool spawn_self(const Config& cfg, const std::vector<std::string>& args, ChildProc& out) {
+        (void)cfg; // argv[0] may not be a path, the kernel knows where we are
+        std::string exe = "/proc/self/exe";
+
+        std::vector<char*> argv;
+        argv.push_back(exe.data());
+        std::vector<std::string> copies(args);
+        for (auto& a : copies) argv.push_back(a.data());
+        argv.push_back(nullptr);
+
+        pid_t pid = -1;
+        if (::posix_spawn(&pid, exe.c_str(), nullptr, nullptr, argv.data(), environ) != 0) return false;
+        out.pid = static_cast<std::intptr_t>(pid);
+        return true;
+    }
+
+    int wait_child(ChildProc& child) {
+        if (child.pid < 0) return -1;
+
+        int status = 0;
+        pid_t rc = -1;
+        do {
+            rc = ::waitpid(static_cast<pid_t>(child.pid), &status, 0);
+        } while (rc < 0 && errno == EINTR);
+        child.pid = -1;
+
+        if (rc < 0 || !WIFEXITED(status)) return -1;
+        return WEXITSTATUS(status);
+    }
+}
+
+#endif
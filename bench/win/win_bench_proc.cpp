@@ -0,0 +1,40 @@
+#if defined(MOO_WIN32)
+
+#include "bench.h"
+#include "windows_hdr.h"
+
+namespace bench {
+    bool spawn_self(const Config& cfg, const std::vector<std::string>& args, ChildProc& out) {
+        (void)cfg; // argv[0] may not be a full path, ask for the module instead
+        char exe[MAX_PATH];
+        const DWORD len = ::GetModuleFileNameA(nullptr, exe, MAX_PATH);
+        if (len == 0 || len == MAX_PATH) return false;
+
+        // CreateProcess takes one command line, args here never hold spaces or quotes
+        std::string cmd = "\"" + std::string(exe, len) + "\"";
+        for (const auto& a : args) cmd += " " + a;
+
+        STARTUPINFOA si{};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi{};
+        if (!::CreateProcessA(exe, cmd.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &si, &pi)) return false;
+
+        ::CloseHandle(pi.hThread);
+        out.pid = reinterpret_cast<std::intptr_t>(pi.hProcess);
+        return true;
+    }
+
+    int wait_child(ChildProc& child) {
+        if (child.pid == -1) return -1;
+
+        HANDLE h = reinterpret_cast<HANDLE>(child.pid);
+        child.pid = -1;
+
+        DWORD code = 0;
+        const bool ok = ::WaitForSingleObject(h, INFINITE) == WAIT_OBJECT_0 && ::GetExitCodeProcess(h, &code);
+        ::CloseHandle(h);
+        return ok ? static_cast<int>(code) : -1;
+    }
+}
+
+#endif
@@ -0,0 +1,248 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "evt/event.h"
+#include "msg/mpsc_queue.h"
+#include "msg/wait_strategy.h"
+#include "platform/platform.h"
+
+namespace evt {
+    struct AsyncEventConfig {
+        std::uint32_t lanes = 1;                // dispatcher threads
+        std::uint32_t queue_capacity = 4096;    // per lane, power of 2
+        bool pin_threads = false;               // pin lane i to cpu first_cpu + i
+        std::uint32_t first_cpu = 0;
+    };
+
+    struct AsyncEventStats {
+        std::uint64_t emitted = 0;      // emit calls accepted by every lane
+        std::uint64_t dispatched = 0;   // lane deliveries finished
+        std::uint64_t dropped = 0;      // lane pushes refused because the queue was full
+        std::uint64_t queued = 0;       // waiting in all lanes right now
+        std::uint64_t max_queued = 0;   // deepest any lane has been (sampled by the dispatchers)
+    };
+
+    namespace detail {
+        // arguments copied back to back into raw bytes (unaligned, memcpy in
+        // and out) so the packet stays trivially copyable for the queues
+        template <typename... Ts>
+        struct ArgPack {
+            static constexpr std::size_t sizes[sizeof...(Ts) + 1] = { sizeof(Ts)..., 0 };
+
+            static constexpr std::size_t offset(std::size_t i) noexcept {
+                std::size_t off = 0;
+                for (std::size_t k = 0; k < i; ++k) off += sizes[k];
+                return off;
+            }
+
+            static constexpr std::size_t total = offset(sizeof...(Ts));
+            unsigned char bytes[total == 0 ? 1 : total];
+
+            template <std::size_t... I>
+            void store(std::index_sequence<I...>, const Ts&... values) noexcept {
+                (std::memcpy(bytes + offset(I), &values, sizeof(Ts)), ...);
+            }
+
+            template <std::size_t I, typename T>
+            T load() const noexcept {
+                T out;
+                std::memcpy(&out, bytes + offset(I), sizeof(T));
+                return out;
+            }
+        };
+    }
+
+    // Event whose emit() only copies the arguments into a lock free queue per
+    // dispatcher lane, lane threads then run the subscribers. Each subscriber
+    // is bound to one lane so it sees emits in queue order and never runs
+    // concurrently with itself, emits from a single thread arrive in order.
+    // Callbacks on different lanes run in parallel.
+    // NOTE: arguments must be trivially copyable (pointers, ids, PODs), they
+    // are copied by value so references and pointers must stay valid until
+    // dispatched
+    // NOTE: Subscription should not outlive AsyncEvent
+    template <typename... Args>
+    class AsyncEvent {
+        static_assert((std::is_trivially_copyable_v<std::decay_t<Args>> && ...),
+                      "AsyncEvent arguments are copied into a queue and must be trivially copyable");
+
+        private:
+            using Pack = detail::ArgPack<std::decay_t<Args>...>;
+
+            struct Packet {
+                std::uint8_t stop;
+                Pack args;
+            };
+
+            using Queue = msg::DynMPSCQueue<Packet, msg::SpinParkWait>;
+
+            struct Lane {
+                Queue queue;
+                std::optional<typename Queue::Producer> producer{};
+                std::optional<typename Queue::Consumer> consumer{};
+                Event<Args...> event{};
+                std::thread thread{};
+
+                alignas(64) std::atomic<std::uint64_t> dispatched{0};
+                std::atomic<std::uint64_t> max_queued{0};
+
+                explicit Lane(std::size_t capacity) : queue(capacity) {}
+            };
+
+            std::vector<std::unique_ptr<Lane>> m_lanes{};
+            alignas(64) std::atomic<std::uint64_t> m_emitted{0};
+            std::atomic<std::uint64_t> m_dropped{0};
+            std::atomic<std::uint32_t> m_next_lane{0};
+            std::atomic<bool> m_stop{false};
+            bool m_valid = false;
+
+            template <std::size_t... I>
+            static void deliver(Lane& lane, const Pack& args, std::index_sequence<I...>) {
+                lane.event.emit(args.template load<I, std::decay_t<Args>>()...);
+            }
+
+            void lane_loop(Lane& lane) noexcept {
+                Packet packet{};
+                while (true) {
+                    if (!lane.consumer->pop_wait(packet, 100000)) {
+                        if (m_stop.load(std::memory_order_acquire)) break; // stop packet didnt fit
+                        continue;
+                    }
+                    if (packet.stop != 0) break;
+
+                    const auto depth = static_cast<std::uint64_t>(lane.consumer->count_snapshot()) + 1;
+                    if (depth > lane.max_queued.load(std::memory_order_relaxed)) {
+                        lane.max_queued.store(depth, std::memory_order_relaxed);
+                    }
+
+                    deliver(lane, packet.args, std::index_sequence_for<Args...>{});
+                    lane.dispatched.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                // deliver whatever was queued before stop
+                while (lane.consumer->try_pop(packet)) {
+                    if (packet.stop != 0) continue;
+                    deliver(lane, packet.args, std::index_sequence_for<Args...>{});
+                    lane.dispatched.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+        public:
+            using Subscription = typename Event<Args...>::Subscription;
+
+            explicit AsyncEvent(const AsyncEventConfig& cfg = AsyncEventConfig{}) {
+                const auto lanes = cfg.lanes == 0 ? 1u : cfg.lanes;
+                for (std::uint32_t i = 0; i < lanes; ++i) {
+                    auto lane = std::make_unique<Lane>(cfg.queue_capacity);
+                    if (!lane->queue.is_valid()) {
+                        m_lanes.clear();
+                        return;
+                    }
+                    lane->producer = lane->queue.make_producer();
+                    lane->consumer = lane->queue.make_consumer();
+                    m_lanes.push_back(std::move(lane));
+                }
+
+                // a lane left joinable when this throws would terminate, stop()
+                // joins the ones already running (and skips the rest) first
+                try {
+                    for (std::uint32_t i = 0; i < lanes; ++i) {
+                        Lane& lane = *m_lanes[i];
+                        lane.thread = std::thread([this, &lane]() noexcept { lane_loop(lane); });
+                        if (cfg.pin_threads) {
+                            plat::affinitize_thread(lane.thread, cfg.first_cpu + i);
+                        }
+                    }
+                } catch (...) {
+                    stop();
+                    throw;
+                }
+                m_valid = true;
+            }
+
+            ~AsyncEvent() { stop(); }
+
+            AsyncEvent(const AsyncEvent&) = delete;
+            AsyncEvent& operator=(const AsyncEvent&) = delete;
+            AsyncEvent(AsyncEvent&&) = delete;
+            AsyncEvent& operator=(AsyncEvent&&) = delete;
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_valid; }
+            [[nodiscard]] std::size_t num_lanes() const noexcept { return m_lanes.size(); }
+
+            // binds f to a lane, round robin unless one is picked. Subscribers
+            // that must stay ordered relative to each other belong on the same lane
+            template <typename F>
+            [[nodiscard]] Subscription subscribe(F&& f) {
+                const auto lane = m_next_lane.fetch_add(1, std::memory_order_relaxed);
+                return subscribe_on(lane, std::forward<F>(f));
+            }
+
+            template <typename F>
+            [[nodiscard]] Subscription subscribe_on(std::uint32_t lane, F&& f) {
+                assert(m_valid && "Invalid AsyncEvent: construction failed");
+                return m_lanes[lane % m_lanes.size()]->event.subscribe(std::forward<F>(f));
+            }
+
+            // one queue push per lane. false when the event is stopped or a
+            // lane was full, that lanes subscribers miss this emit (counted in dropped)
+            [[nodiscard]] bool emit(Args... args) noexcept {
+                if (!m_valid || m_stop.load(std::memory_order_relaxed)) return false;
+
+                Packet packet{};
+                packet.stop = 0;
+                packet.args.store(std::index_sequence_for<Args...>{}, args...);
+
+                bool all = true;
+                for (auto& lane : m_lanes) {
+                    if (!lane->producer->push(packet)) {
+                        m_dropped.fetch_add(1, std::memory_order_relaxed);
+                        all = false;
+                    }
+                }
+
+                if (all) m_emitted.fetch_add(1, std::memory_order_relaxed);
+                return all;
+            }
+
+            // delivers everything already queued then joins the dispatchers
+            void stop() noexcept {
+                if (m_stop.exchange(true, std::memory_order_acq_rel)) return;
+
+                Packet packet{};
+                packet.stop = 1;
+                for (auto& lane : m_lanes) {
+                    (void)lane->producer->push(packet); // if full the lane notices m_stop on its next timeout
+                }
+                for (auto& lane : m_lanes) {
+                    if (lane->thread.joinable()) lane->thread.join();
+                }
+            }
+
+            [[nodiscard]] std::size_t lane_depth(std::uint32_t lane) const noexcept {
+                return m_lanes[lane % m_lanes.size()]->consumer->count_snapshot();
+            }
+
+            [[nodiscard]] AsyncEventStats stats() const noexcept {
+                AsyncEventStats out{};
+                out.emitted = m_emitted.load(std::memory_order_relaxed);
+                out.dropped = m_dropped.load(std::memory_order_relaxed);
+                for (const auto& lane : m_lanes) {
+                    out.dispatched += lane->dispatched.load(std::memory_order_relaxed);
+                    out.queued += lane->consumer->count_snapshot();
+                    const auto depth = lane->max_queued.load(std::memory_order_relaxed);
+                    if (depth > out.max_queued) out.max_queued = depth;
+                }
+                return out;
+            }
+    };
+}
@@ -1,32 +1,118 @@
 #pragma once
-#include <functional>
 #include <vector>
 #include <cstdint>
 #include <algorithm>
+#include <memory>
 #include <utility>
 #include <mutex>
 #include <atomic>
+#include "evt/inplace_function.h"
+#include "instr/instr.h"
 
 namespace evt {
     // Threadsafe C# style event subscription system
+    // emit() never locks or allocates: it reads a subscriber list that
+    // subscribe replaces copy on write (RCU style), unsubscribe only clears its
+    // entry in place so it never allocates either. Replaced lists and removed
+    // callbacks go on a retire list and are freed by a later subscribe/unsubscribe
+    // once every emit that could still be reading them has finished.
+    // Callbacks up to InlineSize bytes are stored without a heap allocation.
     // NOTE: Subscription should not outlive Event
+    // NOTE: like before, a callback can still run once from an emit that
+    // started before its unsubscribe() returned
     template <typename... Args>
     class Event {
+        public:
+            static constexpr std::size_t InlineSize = 48;
+            using Callback = InplaceFunction<void(Args...), InlineSize>;
+
         private:
             struct Handle {
                 std::uint64_t id;
-                std::function<void(Args...)> callback;
+                Callback callback;
+            };
+
+            // fixed once published, entries only ever go to null
+            struct Snapshot {
+                std::unique_ptr<std::atomic<const Handle*>[]> handles;
+                std::size_t count = 0;
+            };
+
+            struct Retired {
+                std::unique_ptr<Snapshot> snapshot; // set when a subscribe replaced it
+                std::unique_ptr<Handle> handle;     // set when an unsubscribe removed it
+                std::uint64_t epoch;
             };
 
-            mutable std::mutex m_mutex;
-            std::vector<Handle> m_handles;
+            // emit side, readers count themselves in for the epoch they saw.
+            // the epoch only advances once the older generation has drained,
+            // so anything retired in epoch e is unreachable by epoch e + 2
+            alignas(64) std::atomic<Snapshot*> m_current{nullptr};
+            std::atomic<std::uint64_t> m_epoch{0};
+            alignas(64) std::atomic<std::uint64_t> m_readers[2]{};
+
+            // subscribe/unsubscribe side
+            alignas(64) mutable std::mutex m_mutex;
+            std::vector<std::unique_ptr<Handle>> m_handles;
+            std::vector<Retired> m_retired;         // capacity >= size + m_handles.size()
             std::atomic<std::uint64_t> m_next_id{0};
 
+            // must hold m_mutex
+            void publish(std::unique_ptr<Snapshot> next, std::unique_ptr<Handle> removed) {
+                Snapshot* old = m_current.exchange(next.release(), std::memory_order_seq_cst);
+                m_retired.push_back(Retired{ std::unique_ptr<Snapshot>(old), std::move(removed),
+                                             m_epoch.load(std::memory_order_relaxed) });
+                reclaim();
+            }
+
+            // must hold m_mutex
+            void reclaim() noexcept {
+                // two steps at most, each one needs the previous generation empty
+                for (int i = 0; i < 2; ++i) {
+                    const auto epoch = m_epoch.load(std::memory_order_relaxed);
+                    if (m_readers[(epoch + 1) & 1].load(std::memory_order_seq_cst) != 0) break;
+                    m_epoch.store(epoch + 1, std::memory_order_seq_cst);
+                }
+
+                const auto epoch = m_epoch.load(std::memory_order_relaxed);
+                auto it = std::remove_if(m_retired.begin(), m_retired.end(),
+                                         [&](const Retired& r) { return r.epoch + 2 <= epoch; });
+                m_retired.erase(it, m_retired.end());
+            }
+
+            std::unique_ptr<Snapshot> build_snapshot() const {
+                auto snap = std::make_unique<Snapshot>();
+                snap->count = m_handles.size();
+                snap->handles = std::make_unique<std::atomic<const Handle*>[]>(snap->count);
+                for (std::size_t i = 0; i < snap->count; ++i) {
+                    snap->handles[i].store(m_handles[i].get(), std::memory_order_relaxed);
+                }
+                return snap;
+            }
+
             void unsubscribe(std::uint64_t id) noexcept {
                 std::lock_guard lock(m_mutex);
-                auto it = std::remove_if(m_handles.begin(), m_handles.end(),
-                                        [&](const Handle& h) { return h.id == id; });
-                m_handles.erase(it, m_handles.end());
+                auto it = std::find_if(m_handles.begin(), m_handles.end(),
+                                       [&](const std::unique_ptr<Handle>& h) { return h->id == id; });
+                if (it == m_handles.end()) return;
+
+                // a published handle is in the current list, clearing it there
+                // hides it from new emits and the ones that already loaded it
+                // are covered by the retire epoch, the same as a replaced list
+                Snapshot* current = m_current.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < current->count; ++i) {
+                    if (current->handles[i].load(std::memory_order_relaxed) == it->get()) {
+                        current->handles[i].store(nullptr, std::memory_order_seq_cst);
+                        break;
+                    }
+                }
+
+                std::unique_ptr<Handle> removed = std::move(*it);
+                m_handles.erase(it);
+
+                // subscribe reserved room for this, push_back can not allocate
+                m_retired.push_back(Retired{ nullptr, std::move(removed), m_epoch.load(std::memory_order_relaxed) });
+                reclaim();
             }
 
         public:
@@ -74,7 +160,10 @@ namespace evt {
             };
 
             Event() = default;
-            ~Event() = default;
+            ~Event() {
+                // no emit may be running by now, so everything can go
+                delete m_current.load(std::memory_order_acquire);
+            }
 
             Event(const Event&) = delete;
             Event& operator=(const Event&) = delete;
@@ -84,20 +173,35 @@ namespace evt {
             template <typename F>
             [[nodiscard]] Subscription subscribe(F&& f) {
                 std::lock_guard lock(m_mutex);
+                // this publish plus one retire for every subscriber, so unsubscribe never allocates
+                m_retired.reserve(m_retired.size() + m_handles.size() + 2);
                 const std::uint64_t id = m_next_id.fetch_add(1, std::memory_order_relaxed);
-                m_handles.push_back(Handle{id, std::function<void(Args...)>(std::forward<F>(f))});
+                m_handles.push_back(std::make_unique<Handle>(Handle{id, Callback(std::forward<F>(f))}));
+                publish(build_snapshot(), nullptr);
                 return Subscription(this, id);
             }
 
             void emit(Args... args) {
-                std::vector<Handle> snapshot;
-                {
-                    std::lock_guard lock(m_mutex);
-                    snapshot = m_handles;
-                }
-                
-                for (auto& handle : snapshot) {
-                    if (handle.callback) handle.callback(args...);
+                MOO_INSTR_SCOPE(instr::Hist::EventEmit);
+
+                // scoped so a throwing callback still counts us out
+                struct ReadGuard {
+                    std::atomic<std::uint64_t>& readers;
+                    explicit ReadGuard(std::atomic<std::uint64_t>& r) noexcept : readers(r) { readers.fetch_add(1, std::memory_order_seq_cst); }
+                    ~ReadGuard() { readers.fetch_sub(1, std::memory_order_release); }
+                    ReadGuard(const ReadGuard&) = delete;
+                    ReadGuard& operator=(const ReadGuard&) = delete;
+                };
+                const ReadGuard guard(m_readers[m_epoch.load(std::memory_order_seq_cst) & 1]);
+
+                // reader count is published before the load, so a writer that
+                // swaps the list after this either sees us or we see its list
+                const Snapshot* snapshot = m_current.load(std::memory_order_seq_cst);
+                if (snapshot != nullptr) {
+                    for (std::size_t i = 0; i < snapshot->count; ++i) {
+                        const Handle* handle = snapshot->handles[i].load(std::memory_order_acquire);
+                        if (handle != nullptr && handle->callback) handle->callback(args...);
+                    }
                 }
             }
 
@@ -106,4 +210,4 @@ namespace evt {
                 return m_handles.size(); 
             }
     };
-}
\ No newline at end of file
+}
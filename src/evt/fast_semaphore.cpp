@@ -0,0 +1,74 @@
+#include "evt/fast_semaphore.h"
+#include "msg/wait_strategy.h"
+#include "platform/futex.h"
+#include <chrono>
+
+namespace evt::detail {
+    SemResult futex_sem_post(FutexSemState& s, bool process_shared) noexcept {
+        if (s.max_count == 0) {
+            s.count.fetch_add(1, std::memory_order_seq_cst);
+        } else {
+            auto c = s.count.load(std::memory_order_relaxed);
+            do {
+                if (c >= s.max_count) return { SemErr::MaxCountReached, SemOp::Post };
+            } while (!s.count.compare_exchange_weak(c, c + 1, std::memory_order_seq_cst, std::memory_order_relaxed));
+        }
+
+        // pairs with the waiters increment in wait, either we see the
+        // sleeper here or it sees the new count before it sleeps
+        if (s.waiters.load(std::memory_order_seq_cst) != 0) {
+            plat::futex_wake_one(s.count, process_shared);
+        }
+        return { SemErr::None, SemOp::Post };
+    }
+
+    SemResult futex_sem_try_wait(FutexSemState& s) noexcept {
+        auto c = s.count.load(std::memory_order_relaxed);
+        while (c != 0) {
+            if (s.count.compare_exchange_weak(c, c - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return { SemErr::None, SemOp::TryWait };
+            }
+        }
+        return { SemErr::WouldBlock, SemOp::TryWait };
+    }
+
+    SemResult futex_sem_wait(FutexSemState& s, std::uint64_t timeout_ns, bool process_shared) noexcept {
+        for (std::uint32_t i = 0; i < FastSemaphore::spin_iterations; ++i) {
+            if (futex_sem_try_wait(s).ok()) return { SemErr::None, SemOp::Wait };
+            msg::detail::cpu_relax();
+        }
+
+        // steady_clock is CLOCK_MONOTONIC, and futex timeouts are relative so
+        // a wall clock step cant change how long we sleep
+        using clock = std::chrono::steady_clock;
+        const bool forever = timeout_ns == 0;
+        constexpr std::uint64_t max_ns = std::uint64_t{1} << 62; // keeps now() + timeout from overflowing
+        const auto end = clock::now() + std::chrono::nanoseconds(forever ? 0 : (timeout_ns < max_ns ? timeout_ns : max_ns));
+
+        // WaitOnAddress cant be woken from another process, so shared waiters
+        // on windows sleep in short slices and recheck
+        #if defined(MOO_WIN32)
+            constexpr std::uint64_t slice_ns = 1000000; // 1ms
+        #endif
+
+        while (true) {
+            if (futex_sem_try_wait(s).ok()) return { SemErr::None, SemOp::Wait };
+
+            std::uint64_t wait_ns = 0;
+            if (!forever) {
+                const auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(end - clock::now()).count();
+                if (left <= 0) return { SemErr::Timeout, SemOp::Wait };
+                wait_ns = static_cast<std::uint64_t>(left);
+            }
+
+            s.waiters.fetch_add(1, std::memory_order_seq_cst);
+            if (s.count.load(std::memory_order_seq_cst) == 0) {
+                #if defined(MOO_WIN32)
+                    if (process_shared && (wait_ns == 0 || wait_ns > slice_ns)) wait_ns = slice_ns;
+                #endif
+                (void)plat::futex_wait(s.count, 0, wait_ns, process_shared);
+            }
+            s.waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "evt/semaphore.h"
+
+namespace evt {
+    namespace detail {
+        // the whole semaphore, plain enough to be placed in shared memory.
+        // count is the futex word, waiters lets post() skip the wake syscall
+        struct FutexSemState {
+            std::atomic<std::uint32_t> count{0};
+            std::atomic<std::uint32_t> waiters{0};
+            std::uint32_t max_count = 0;    // 0 = unbounded
+            std::uint32_t reserved = 0;
+        };
+
+        [[nodiscard]] SemResult futex_sem_post(FutexSemState& s, bool process_shared) noexcept;
+        [[nodiscard]] SemResult futex_sem_try_wait(FutexSemState& s) noexcept;
+        [[nodiscard]] SemResult futex_sem_wait(FutexSemState& s, std::uint64_t timeout_ns, bool process_shared) noexcept;
+    }
+
+    // Counting semaphore with the count in a userspace atomic. Uncontended
+    // post()/try_wait() are one atomic op and never enter the kernel, wait()
+    // spins a little then sleeps on the count with futex/WaitOnAddress.
+    // Same results as Semaphore, wait(0) waits forever.
+    // see shm::ShmSemaphore for the cross process version
+    class FastSemaphore {
+        public:
+            static constexpr std::uint32_t spin_iterations = 256;
+
+        private:
+            alignas(64) detail::FutexSemState m_state{};
+
+        public:
+            FastSemaphore() = default;
+            explicit FastSemaphore(std::uint32_t initial, std::uint32_t max_count = 0) noexcept {
+                m_state.count.store(initial, std::memory_order_relaxed);
+                m_state.max_count = max_count;
+            }
+            ~FastSemaphore() = default;
+
+            FastSemaphore(const FastSemaphore&) = delete;
+            FastSemaphore& operator=(const FastSemaphore&) = delete;
+            FastSemaphore(FastSemaphore&&) = delete;
+            FastSemaphore& operator=(FastSemaphore&&) = delete;
+
+            [[nodiscard]] SemResult post() noexcept { return detail::futex_sem_post(m_state, false); }
+            [[nodiscard]] SemResult try_wait() noexcept { return detail::futex_sem_try_wait(m_state); }
+            [[nodiscard]] SemResult wait(std::uint32_t milliseconds = 0) noexcept {
+                return detail::futex_sem_wait(m_state, static_cast<std::uint64_t>(milliseconds) * 1'000'000u, false);
+            }
+
+            // timeout_ns of 0 waits forever, measured on the monotonic clock
+            [[nodiscard]] SemResult wait_ns(std::uint64_t timeout_ns) noexcept {
+                return detail::futex_sem_wait(m_state, timeout_ns, false);
+            }
+
+            std::uint32_t count_snapshot() const noexcept { return m_state.count.load(std::memory_order_relaxed); }
+    };
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace evt {
+    template <typename Signature, std::size_t Capacity = 48>
+    class InplaceFunction;
+
+    // Move only std::function replacement that constructs callables up to
+    // Capacity bytes in place, larger (or over aligned / throwing move)
+    // callables fall back to one heap allocation at construction.
+    // Calling never allocates.
+    template <typename R, typename... Args, std::size_t Capacity>
+    class InplaceFunction<R(Args...), Capacity> {
+        private:
+            using InvokeFn = R (*)(void*, Args...);
+            using MoveFn = void (*)(void* dst, void* src) noexcept; // move constructs dst, destroys src
+            using DestroyFn = void (*)(void*) noexcept;
+
+            alignas(std::max_align_t) unsigned char m_storage[Capacity];
+            InvokeFn m_invoke = nullptr;
+            MoveFn m_move = nullptr;
+            DestroyFn m_destroy = nullptr;
+
+            template <typename F>
+            static constexpr bool fits_inline = sizeof(F) <= Capacity
+                && alignof(F) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<F>;
+
+            template <typename F>
+            static F* as(void* p) noexcept { return std::launder(static_cast<F*>(p)); }
+
+            template <typename F>
+            static R invoke_inline(void* p, Args... args) { return (*as<F>(p))(std::forward<Args>(args)...); }
+
+            template <typename F>
+            static void move_inline(void* dst, void* src) noexcept {
+                ::new (dst) F(std::move(*as<F>(src)));
+                as<F>(src)->~F();
+            }
+
+            template <typename F>
+            static void destroy_inline(void* p) noexcept { as<F>(p)->~F(); }
+
+            template <typename F>
+            static R invoke_heap(void* p, Args... args) { return (**as<F*>(p))(std::forward<Args>(args)...); }
+
+            static void move_heap(void* dst, void* src) noexcept {
+                ::new (dst) void*(*as<void*>(src)); // just steal the pointer
+            }
+
+            template <typename F>
+            static void destroy_heap(void* p) noexcept { delete *as<F*>(p); }
+
+            void steal(InplaceFunction& other) noexcept {
+                if (other.m_invoke == nullptr) return;
+                other.m_move(m_storage, other.m_storage);
+                m_invoke = other.m_invoke;
+                m_move = other.m_move;
+                m_destroy = other.m_destroy;
+                other.m_invoke = nullptr;
+                other.m_move = nullptr;
+                other.m_destroy = nullptr;
+            }
+
+        public:
+            InplaceFunction() noexcept = default;
+            ~InplaceFunction() { reset(); }
+
+            template <typename F, typename Fn = std::decay_t<F>,
+                      typename = std::enable_if_t<!std::is_same_v<Fn, InplaceFunction> && std::is_invocable_r_v<R, Fn&, Args...>>>
+            InplaceFunction(F&& fn) { // NOLINT: implicit like std::function
+                if constexpr (fits_inline<Fn>) {
+                    ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(fn));
+                    m_invoke = &invoke_inline<Fn>;
+                    m_move = &move_inline<Fn>;
+                    m_destroy = &destroy_inline<Fn>;
+                } else {
+                    ::new (static_cast<void*>(m_storage)) Fn*(new Fn(std::forward<F>(fn)));
+                    m_invoke = &invoke_heap<Fn>;
+                    m_move = &move_heap;
+                    m_destroy = &destroy_heap<Fn>;
+                }
+            }
+
+            InplaceFunction(const InplaceFunction&) = delete;
+            InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+            InplaceFunction(InplaceFunction&& other) noexcept { steal(other); }
+
+            InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    steal(other);
+                }
+                return *this;
+            }
+
+            void reset() noexcept {
+                if (m_destroy != nullptr) m_destroy(m_storage);
+                m_invoke = nullptr;
+                m_move = nullptr;
+                m_destroy = nullptr;
+            }
+
+            explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+            // true when the callable lives in the inline buffer
+            template <typename F>
+            static constexpr bool stores_inline() noexcept { return fits_inline<std::decay_t<F>>; }
+
+            R operator()(Args... args) const {
+                // const like std::function, the callable itself may mutate
+                return m_invoke(const_cast<unsigned char*>(m_storage), std::forward<Args>(args)...);
+            }
+    };
+}
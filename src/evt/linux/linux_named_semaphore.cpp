@@ -1,6 +1,7 @@
 #if defined(MOO_LINUX)
 
 #include "evt/named_semaphore.h"
+#include "evt/linux/linux_sem_wait.h"
 
 #include <semaphore.h>
 #include <fcntl.h>      // O_CREAT
@@ -29,22 +30,6 @@ namespace evt {
         }
     }
 
-    static bool make_abs_deadline_realtime(timespec& out_abs, uint32_t timeout_ms) noexcept {
-        if (::clock_gettime(CLOCK_REALTIME, &out_abs) != 0) {
-            return false;
-        }
-
-        const long add_ns = static_cast<long>((timeout_ms % 1000u) * 1'000'000u);
-        out_abs.tv_sec += static_cast<time_t>(timeout_ms / 1000u);
-        out_abs.tv_nsec += add_ns;
-
-        if (out_abs.tv_nsec >= 1'000'000'000L) {
-            out_abs.tv_sec += 1;
-            out_abs.tv_nsec -= 1'000'000'000L;
-        }
-        return true;
-    }
-
     NamedSemaphore::NamedSemaphore(std::int64_t id) : m_dst_id(id), m_sem(nullptr) {
     }
 
@@ -122,9 +107,13 @@ namespace evt {
     }
 
     NamedSemResult NamedSemaphore::wait(std::uint32_t milliseconds) const {
+        return wait_ns(static_cast<std::uint64_t>(milliseconds) * 1'000'000u);
+    }
+
+    NamedSemResult NamedSemaphore::wait_ns(std::uint64_t timeout_ns) const {
         if (m_sem == nullptr) return { NamedSemErr::NotInitialized, NamedSemOp::Wait };
 
-        if (milliseconds == 0) {
+        if (timeout_ns == 0) {
             for (;;) {
                 if (sem_wait(as_native(m_sem)) == 0) {
                     return { NamedSemErr::None, NamedSemOp::Wait };
@@ -136,12 +125,12 @@ namespace evt {
         }
 
         timespec deadline{};
-        if (!make_abs_deadline_realtime(deadline, milliseconds)) {
+        if (!detail::make_abs_deadline(deadline, timeout_ns)) {
             return { NamedSemErr::SysError, NamedSemOp::Wait };
         }
 
         for (;;) {
-            if (sem_timedwait(as_native(m_sem), &deadline) == 0) {
+            if (detail::timed_wait(as_native(m_sem), deadline) == 0) {
                 return { NamedSemErr::None, NamedSemOp::Wait };
             }
             const int e = errno;
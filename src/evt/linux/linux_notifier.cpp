@@ -0,0 +1,156 @@
+#if defined(MOO_LINUX)
+
+#include "evt/notifier.h"
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+#include <cstdint>
+
+namespace evt {
+    // ppoll takes a relative timeout and measures it on CLOCK_MONOTONIC,
+    // the deadline lives on the same clock so retries after EINTR or a lost
+    // race dont restart the full timeout
+    static std::uint64_t now_ns() noexcept {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000u + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    // false once the deadline passed, otherwise fills in whats left
+    static bool remaining(std::uint64_t deadline_ns, timespec& out) noexcept {
+        const auto now = now_ns();
+        if (now >= deadline_ns) return false;
+        const auto left = deadline_ns - now;
+        out.tv_sec = static_cast<time_t>(left / 1'000'000'000u);
+        out.tv_nsec = static_cast<long>(left % 1'000'000'000u);
+        return true;
+    }
+
+    // EFD_SEMAPHORE makes every read take exactly one count
+    static SemErr take_one(int fd) noexcept {
+        while (true) {
+            std::uint64_t value = 0;
+            if (::read(fd, &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value))) {
+                return SemErr::None;
+            }
+
+            const int err = errno;
+            switch (err) {
+                case EINTR: continue;
+                case EAGAIN: return SemErr::WouldBlock;
+                case EBADF: return SemErr::NotInitialized;
+                default: return SemErr::SysError;
+            }
+        }
+    }
+
+    Notifier::Notifier() : m_handle(-1) {
+        m_handle = ::eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    Notifier::~Notifier() {
+        close();
+    }
+
+    Notifier::Notifier(Notifier&& other) noexcept {
+        m_handle = other.m_handle;
+        other.m_handle = -1;
+    }
+
+    Notifier& Notifier::operator=(Notifier&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_handle = other.m_handle;
+            other.m_handle = -1;
+        }
+        return *this;
+    }
+
+    bool Notifier::is_valid() const noexcept {
+        return m_handle >= 0;
+    }
+
+    SemResult Notifier::post() noexcept {
+        if (m_handle < 0) return { SemErr::NotInitialized, SemOp::Post };
+
+        const std::uint64_t one = 1;
+        while (true) {
+            if (::write(m_handle, &one, sizeof(one)) == static_cast<ssize_t>(sizeof(one))) {
+                return { SemErr::None, SemOp::Post };
+            }
+
+            const int err = errno;
+            switch (err) {
+                case EINTR: continue;
+                case EAGAIN: return { SemErr::MaxCountReached, SemOp::Post }; // counter at UINT64_MAX - 1
+                case EBADF: return { SemErr::NotInitialized, SemOp::Post };
+                default: return { SemErr::SysError, SemOp::Post };
+            }
+        }
+    }
+
+    SemResult Notifier::try_wait() noexcept {
+        if (m_handle < 0) return { SemErr::NotInitialized, SemOp::TryWait };
+        return { take_one(m_handle), SemOp::TryWait };
+    }
+
+    SemResult Notifier::wait_ns(std::uint64_t timeout_ns) noexcept {
+        if (m_handle < 0) return { SemErr::NotInitialized, SemOp::Wait };
+
+        Notifier* self = this;
+        std::size_t ready = 0;
+        const auto res = wait_any(&self, 1, ready, timeout_ns);
+        return { res.code, SemOp::Wait };
+    }
+
+    void Notifier::close() noexcept {
+        if (m_handle >= 0) {
+            ::close(m_handle);
+            m_handle = -1;
+        }
+    }
+
+    SemResult wait_any(Notifier* const* notifiers, std::size_t count, std::size_t& ready, std::uint64_t timeout_ns) noexcept {
+        if (notifiers == nullptr || count == 0 || count > Notifier::max_wait_any) {
+            return { SemErr::InvalidArgument, SemOp::WaitAny };
+        }
+
+        pollfd fds[Notifier::max_wait_any];
+        for (std::size_t i = 0; i < count; ++i) {
+            if (notifiers[i] == nullptr || !notifiers[i]->is_valid()) {
+                return { SemErr::NotInitialized, SemOp::WaitAny };
+            }
+            fds[i] = pollfd{ notifiers[i]->native_handle(), POLLIN, 0 };
+        }
+
+        const bool forever = timeout_ns == 0;
+        const auto deadline = forever ? 0 : now_ns() + timeout_ns;
+
+        while (true) {
+            // another waiter may take the count between poll and read, so
+            // try everything first and only sleep once all of them are empty
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto err = take_one(fds[i].fd);
+                if (err == SemErr::None) {
+                    ready = i;
+                    return { SemErr::None, SemOp::WaitAny };
+                }
+                if (err != SemErr::WouldBlock) return { err, SemOp::WaitAny };
+            }
+
+            timespec left{};
+            if (!forever && !remaining(deadline, left)) {
+                return { SemErr::Timeout, SemOp::WaitAny };
+            }
+
+            const int n = ::ppoll(fds, static_cast<nfds_t>(count), forever ? nullptr : &left, nullptr);
+            if (n < 0 && errno != EINTR) {
+                return { SemErr::SysError, SemOp::WaitAny };
+            }
+        }
+    }
+}
+
+#endif
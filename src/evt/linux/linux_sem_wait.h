@@ -0,0 +1,38 @@
+#pragma once
+#if defined(MOO_LINUX)
+#include <semaphore.h>
+#include <ctime>
+#include <cstdint>
+
+namespace evt::detail {
+    // sem_clockwait (glibc 2.30+) takes a CLOCK_MONOTONIC deadline, older
+    // libcs only have sem_timedwait which always measures CLOCK_REALTIME
+    #if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+        inline constexpr clockid_t wait_clock = CLOCK_MONOTONIC;
+        inline int timed_wait(sem_t* sem, const timespec& deadline) noexcept {
+            return ::sem_clockwait(sem, CLOCK_MONOTONIC, &deadline);
+        }
+    #else
+        inline constexpr clockid_t wait_clock = CLOCK_REALTIME;
+        inline int timed_wait(sem_t* sem, const timespec& deadline) noexcept {
+            return ::sem_timedwait(sem, &deadline);
+        }
+    #endif
+
+    // timeout_ns from now on wait_clock, what timed_wait expects
+    inline bool make_abs_deadline(timespec& deadline, std::uint64_t timeout_ns) noexcept {
+        if (::clock_gettime(wait_clock, &deadline) != 0) {
+            return false;
+        }
+
+        deadline.tv_sec += static_cast<time_t>(timeout_ns / 1'000'000'000u);
+        deadline.tv_nsec += static_cast<long>(timeout_ns % 1'000'000'000u);
+
+        if (deadline.tv_nsec >= 1'000'000'000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1'000'000'000L;
+        }
+        return true;
+    }
+}
+#endif
@@ -1,6 +1,7 @@
 #if defined(MOO_LINUX)
 
 #include "evt/semaphore.h"
+#include "evt/linux/linux_sem_wait.h"
 #include <semaphore.h>
 #include <cerrno>
 #include <ctime>
@@ -22,22 +23,6 @@ namespace evt {
         sem_init(as_native(m_sem), 0, 0);
     }
 
-    static bool make_abs_deadline_realtime(timespec& deadline, std::uint32_t timeout_ms) noexcept {
-        if (::clock_gettime(CLOCK_REALTIME, &deadline) != 0) {
-            return false;
-        }
-
-        const long add_ns = static_cast<long>((timeout_ms % 1000u) * 1'000'000u);
-        deadline.tv_sec += static_cast<time_t>(timeout_ms / 1000u);
-        deadline.tv_nsec += add_ns;
-
-        if (deadline.tv_nsec >= 1'000'000'000L) {
-            deadline.tv_sec += 1;
-            deadline.tv_nsec -= 1'000'000'000L;
-        }
-        return true;
-    }
-
     Semaphore::~Semaphore() {
         close();
     }
@@ -97,9 +82,13 @@ namespace evt {
     }
 
     SemResult Semaphore::wait(std::uint32_t milliseconds) {
+        return wait_ns(static_cast<std::uint64_t>(milliseconds) * 1'000'000u);
+    }
+
+    SemResult Semaphore::wait_ns(std::uint64_t timeout_ns) {
         if (m_sem == nullptr) return { SemErr::NotInitialized, SemOp::Wait };
 
-        if (milliseconds == 0) {
+        if (timeout_ns == 0) {
             // infinite wait
             while (true) {
                 if (sem_wait(as_native(m_sem)) == 0) {
@@ -116,12 +105,12 @@ namespace evt {
         } else {
             // timed wait
             timespec deadline{};
-            if (!make_abs_deadline_realtime(deadline, milliseconds)) {
+            if (!detail::make_abs_deadline(deadline, timeout_ns)) {
                 return { SemErr::SysError, SemOp::Wait };
             }
 
             while (true) {
-                if (sem_timedwait(as_native(m_sem), &deadline) == 0) {
+                if (detail::timed_wait(as_native(m_sem), deadline) == 0) {
                     return { SemErr::None, SemOp::Wait };
                 }
 
@@ -139,7 +128,7 @@ namespace evt {
     void Semaphore::close() {
         if (m_sem != nullptr) {
             sem_destroy(as_native(m_sem));
-            //delete m_sem; // TODO: double check this is correct
+            delete as_native(m_sem); // allocated with new in the constructor
             m_sem = nullptr;
         }
     }
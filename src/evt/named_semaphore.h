@@ -87,6 +87,9 @@ namespace evt {
             [[nodiscard]] NamedSemResult post() const;
             [[nodiscard]] NamedSemResult try_wait() const;
             [[nodiscard]] NamedSemResult wait(std::uint32_t milliseconds = 0) const;
+
+            // timeout_ns of 0 waits forever, same clock rules as Semaphore::wait_ns
+            [[nodiscard]] NamedSemResult wait_ns(std::uint64_t timeout_ns) const;
             void close();
 
         private: 
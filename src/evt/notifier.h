@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "evt/semaphore.h"
+
+namespace evt {
+    #if defined(MOO_WIN32)
+        using notify_handle = void*;    // semaphore HANDLE
+    #elif defined(MOO_LINUX)
+        using notify_handle = int;      // eventfd
+    #endif
+
+    // Counting semaphore backed by a pollable kernel object (eventfd in
+    // semaphore mode on linux, a semaphore HANDLE on windows) so one thread
+    // can block on many of them at once with wait_any(), or hand them to a
+    // sock::Reactor next to its sockets. Each post() adds one, each
+    // successful try_wait()/wait() takes one.
+    // Timed waits use the monotonic clock, timeout_ns of 0 waits forever.
+    // NOTE: check is_valid() after construction, creating the handle can fail
+    class Notifier {
+        public:
+            static constexpr std::size_t max_wait_any = 64; // MAXIMUM_WAIT_OBJECTS on windows
+
+        private:
+            notify_handle m_handle;
+
+        public:
+            Notifier();
+            ~Notifier();
+
+            Notifier(const Notifier&) = delete;
+            Notifier& operator=(const Notifier&) = delete;
+            Notifier(Notifier&& other) noexcept;
+            Notifier& operator=(Notifier&& other) noexcept;
+
+            [[nodiscard]] bool is_valid() const noexcept;
+            [[nodiscard]] notify_handle native_handle() const noexcept { return m_handle; }
+
+            [[nodiscard]] SemResult post() noexcept;
+            [[nodiscard]] SemResult try_wait() noexcept;
+            [[nodiscard]] SemResult wait_ns(std::uint64_t timeout_ns = 0) noexcept;
+            [[nodiscard]] SemResult wait(std::uint32_t milliseconds = 0) noexcept {
+                return wait_ns(static_cast<std::uint64_t>(milliseconds) * 1'000'000u);
+            }
+            void close() noexcept;
+    };
+
+    // blocks until any of the count notifiers can be taken, takes one count
+    // from it and writes its position to ready. When several are ready the
+    // lowest index wins. count must be 1..Notifier::max_wait_any
+    [[nodiscard]] SemResult wait_any(Notifier* const* notifiers, std::size_t count, std::size_t& ready, std::uint64_t timeout_ns = 0) noexcept;
+}
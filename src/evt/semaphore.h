@@ -9,13 +9,15 @@ namespace evt {
         Timeout,
         WouldBlock,
         MaxCountReached,
+        InvalidArgument,
         SysError,
     };
 
     enum class SemOp {
         Post,
         TryWait,
-        Wait
+        Wait,
+        WaitAny
     };
     
     struct SemResult {
@@ -33,6 +35,7 @@ namespace evt {
                 case SemErr::Timeout: return "Timeout";
                 case SemErr::WouldBlock: return "WouldBlock";
                 case SemErr::MaxCountReached: return "MaxCountReached";
+                case SemErr::InvalidArgument: return "InvalidArgument";
                 case SemErr::SysError: return "SysError";
                 default: return "Unknown - error is undefined";
             }
@@ -43,6 +46,7 @@ namespace evt {
                 case SemOp::Post: return "Post";
                 case SemOp::TryWait: return "TryWait";
                 case SemOp::Wait: return "Wait";
+                case SemOp::WaitAny: return "WaitAny";
                 default: return "Unknown - op is undefined";
             }
         }
@@ -73,6 +77,11 @@ namespace evt {
             [[nodiscard]] SemResult post();
             [[nodiscard]] SemResult try_wait();
             [[nodiscard]] SemResult wait(std::uint32_t milliseconds = 0);
+
+            // timeout_ns of 0 waits forever, timed on the monotonic clock so
+            // wall clock steps (NTP, manual changes) dont stretch or cut it short
+            // NOTE: windows waits have millisecond resolution, rounded up
+            [[nodiscard]] SemResult wait_ns(std::uint64_t timeout_ns);
             void close();
     };
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #if defined(MOO_WIN32)
 
 #include "evt/named_semaphore.h"
+#include "evt/win/win_wait.h"
 #include "windows_hdr.h"
 
 namespace evt {
@@ -140,14 +141,13 @@ namespace evt {
     }
 
     NamedSemResult NamedSemaphore::wait(std::uint32_t milliseconds) const {
+        return wait_ns(static_cast<std::uint64_t>(milliseconds) * 1'000'000u);
+    }
+
+    NamedSemResult NamedSemaphore::wait_ns(std::uint64_t timeout_ns) const {
         if (m_sem == nullptr) return { NamedSemErr::NotInitialized, NamedSemOp::Wait };
-        
-        DWORD timeout = static_cast<DWORD>(milliseconds);
-        if (milliseconds == 0) {
-            timeout = INFINITE;
-        }
 
-        DWORD rc = ::WaitForSingleObject(as_native(m_sem), timeout);
+        DWORD rc = ::WaitForSingleObject(as_native(m_sem), detail::to_wait_ms(timeout_ns));
         switch (rc) {
             case WAIT_OBJECT_0: return { NamedSemErr::None, NamedSemOp::Wait };
             case WAIT_TIMEOUT: return { NamedSemErr::Timeout, NamedSemOp::Wait };
@@ -0,0 +1,108 @@
+#if defined(MOO_WIN32)
+
+#include "evt/notifier.h"
+#include "evt/win/win_wait.h"
+#include "windows_hdr.h"
+#include <limits>
+
+namespace evt {
+    static HANDLE as_native(notify_handle p) noexcept {
+        return static_cast<HANDLE>(p);
+    }
+
+    static notify_handle from_native(HANDLE h) noexcept {
+        return static_cast<notify_handle>(h);
+    }
+
+    Notifier::Notifier() : m_handle(nullptr) {
+        m_handle = from_native(::CreateSemaphoreW(nullptr, 0, std::numeric_limits<LONG>::max(), nullptr));
+    }
+
+    Notifier::~Notifier() {
+        close();
+    }
+
+    Notifier::Notifier(Notifier&& other) noexcept {
+        m_handle = other.m_handle;
+        other.m_handle = nullptr;
+    }
+
+    Notifier& Notifier::operator=(Notifier&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_handle = other.m_handle;
+            other.m_handle = nullptr;
+        }
+        return *this;
+    }
+
+    bool Notifier::is_valid() const noexcept {
+        return m_handle != nullptr;
+    }
+
+    SemResult Notifier::post() noexcept {
+        if (m_handle == nullptr) return { SemErr::NotInitialized, SemOp::Post };
+
+        if (!::ReleaseSemaphore(as_native(m_handle), 1, nullptr)) {
+            DWORD err = ::GetLastError();
+            if (err == ERROR_TOO_MANY_POSTS) return { SemErr::MaxCountReached, SemOp::Post };
+            return { SemErr::SysError, SemOp::Post };
+        }
+        return { SemErr::None, SemOp::Post };
+    }
+
+    SemResult Notifier::try_wait() noexcept {
+        if (m_handle == nullptr) return { SemErr::NotInitialized, SemOp::TryWait };
+
+        DWORD rc = ::WaitForSingleObject(as_native(m_handle), 0);
+        switch (rc) {
+            case WAIT_OBJECT_0: return { SemErr::None, SemOp::TryWait };
+            case WAIT_TIMEOUT: return { SemErr::WouldBlock, SemOp::TryWait };
+            default: return { SemErr::SysError, SemOp::TryWait };
+        }
+    }
+
+    SemResult Notifier::wait_ns(std::uint64_t timeout_ns) noexcept {
+        if (m_handle == nullptr) return { SemErr::NotInitialized, SemOp::Wait };
+
+        DWORD rc = ::WaitForSingleObject(as_native(m_handle), detail::to_wait_ms(timeout_ns));
+        switch (rc) {
+            case WAIT_OBJECT_0: return { SemErr::None, SemOp::Wait };
+            case WAIT_TIMEOUT: return { SemErr::Timeout, SemOp::Wait };
+            default: return { SemErr::SysError, SemOp::Wait };
+        }
+    }
+
+    void Notifier::close() noexcept {
+        if (m_handle != nullptr) {
+            ::CloseHandle(as_native(m_handle));
+            m_handle = nullptr;
+        }
+    }
+
+    SemResult wait_any(Notifier* const* notifiers, std::size_t count, std::size_t& ready, std::uint64_t timeout_ns) noexcept {
+        if (notifiers == nullptr || count == 0 || count > Notifier::max_wait_any) {
+            return { SemErr::InvalidArgument, SemOp::WaitAny };
+        }
+
+        HANDLE handles[Notifier::max_wait_any];
+        for (std::size_t i = 0; i < count; ++i) {
+            if (notifiers[i] == nullptr || !notifiers[i]->is_valid()) {
+                return { SemErr::NotInitialized, SemOp::WaitAny };
+            }
+            handles[i] = as_native(notifiers[i]->native_handle());
+        }
+
+        // a satisfied wait on a semaphore takes one count from it, and only
+        // the lowest signalled index is taken when several are ready
+        DWORD rc = ::WaitForMultipleObjects(static_cast<DWORD>(count), handles, FALSE, detail::to_wait_ms(timeout_ns));
+        if (rc >= WAIT_OBJECT_0 && rc < WAIT_OBJECT_0 + count) {
+            ready = static_cast<std::size_t>(rc - WAIT_OBJECT_0);
+            return { SemErr::None, SemOp::WaitAny };
+        }
+        if (rc == WAIT_TIMEOUT) return { SemErr::Timeout, SemOp::WaitAny };
+        return { SemErr::SysError, SemOp::WaitAny };
+    }
+}
+
+#endif
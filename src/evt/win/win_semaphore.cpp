@@ -1,6 +1,7 @@
 #if defined(MOO_WIN32)
 
 #include "evt/semaphore.h"
+#include "evt/win/win_wait.h"
 #include "windows_hdr.h"
 #include <limits>
 
@@ -82,14 +83,13 @@ namespace evt {
     }
 
     SemResult Semaphore::wait(std::uint32_t milliseconds) {
-        if (m_sem == nullptr) return { SemErr::NotInitialized, SemOp::Wait };
+        return wait_ns(static_cast<std::uint64_t>(milliseconds) * 1'000'000u);
+    }
 
-        DWORD timeout = static_cast<DWORD>(milliseconds);
-        if (milliseconds <= 0) {
-            timeout = INFINITE;
-        }
+    SemResult Semaphore::wait_ns(std::uint64_t timeout_ns) {
+        if (m_sem == nullptr) return { SemErr::NotInitialized, SemOp::Wait };
 
-        DWORD rc = ::WaitForSingleObject(as_native(m_sem), timeout);
+        DWORD rc = ::WaitForSingleObject(as_native(m_sem), detail::to_wait_ms(timeout_ns));
         switch (rc) {
             case WAIT_OBJECT_0: return { SemErr::None, SemOp::Wait };
             case WAIT_TIMEOUT: return { SemErr::Timeout, SemOp::Wait };
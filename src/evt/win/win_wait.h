@@ -0,0 +1,15 @@
+#pragma once
+#if defined(MOO_WIN32)
+#include "windows_hdr.h"
+#include <cstdint>
+
+namespace evt::detail {
+    // rounds up so a short wait never turns into a poll, 0 = INFINITE.
+    // WaitFor*Object(s) timeouts already tick on the monotonic interrupt clock
+    inline DWORD to_wait_ms(std::uint64_t timeout_ns) noexcept {
+        if (timeout_ns == 0) return INFINITE;
+        const std::uint64_t ms = (timeout_ns + 999'999u) / 1'000'000u;
+        return ms >= INFINITE ? INFINITE - 1 : static_cast<DWORD>(ms);
+    }
+}
+#endif
@@ -0,0 +1,627 @@
+#pragma once
+// C++20 coroutine layer over the reactor, thread pool, notifiers and queues.
+// The library itself builds as C++17, so everything below compiles to
+// nothing unless the including translation unit has coroutine support
+// (-std=c++20, or configure with MOO_COROUTINES=ON to build mootils as C++20)
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+    #if __has_include(<coroutine>)
+        #define MOO_HAS_COROUTINES 1
+    #endif
+#endif
+
+#if defined(MOO_HAS_COROUTINES)
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "exec/thread_pool.h"
+#include "evt/notifier.h"
+#include "evt/semaphore.h"
+#include "sock/reactor.h"
+#include "sock/tcp_socket.h"
+
+namespace exec {
+    namespace detail {
+        // Per thread free lists of coroutine frames in 64 byte size classes.
+        // A frame freed on another thread than it was made on just joins that
+        // threads lists, each list keeps at most max_cached frames
+        class FramePool {
+            private:
+                static constexpr std::size_t granule = 64;
+                static constexpr std::size_t classes = 16;      // frames up to 1KB are pooled
+                static constexpr std::uint32_t max_cached = 256;
+
+                struct Node { Node* next; };
+
+                Node* m_free[classes]{};
+                std::uint32_t m_count[classes]{};
+
+                static std::size_t class_of(std::size_t bytes) noexcept { return (bytes + granule - 1) / granule - 1; }
+
+            public:
+                FramePool() = default;
+                ~FramePool() {
+                    for (auto* head : m_free) {
+                        while (head != nullptr) {
+                            Node* next = head->next;
+                            ::operator delete(head);
+                            head = next;
+                        }
+                    }
+                }
+
+                FramePool(const FramePool&) = delete;
+                FramePool& operator=(const FramePool&) = delete;
+
+                void* allocate(std::size_t bytes) {
+                    const auto c = class_of(bytes);
+                    if (c >= classes) return ::operator new(bytes);
+                    if (Node* n = m_free[c]) {
+                        m_free[c] = n->next;
+                        --m_count[c];
+                        return n;
+                    }
+                    return ::operator new((c + 1) * granule);
+                }
+
+                void deallocate(void* p, std::size_t bytes) noexcept {
+                    const auto c = class_of(bytes);
+                    if (c >= classes || m_count[c] >= max_cached) {
+                        ::operator delete(p);
+                        return;
+                    }
+                    auto* n = static_cast<Node*>(p);
+                    n->next = m_free[c];
+                    m_free[c] = n;
+                    ++m_count[c];
+                }
+
+                static FramePool& local() noexcept {
+                    thread_local FramePool pool;
+                    return pool;
+                }
+        };
+
+        // frames of every coroutine type here come from the frame pool
+        struct PooledFrame {
+            static void* operator new(std::size_t bytes) { return FramePool::local().allocate(bytes); }
+            static void operator delete(void* p, std::size_t bytes) noexcept { FramePool::local().deallocate(p, bytes); }
+        };
+
+        struct PromiseBase : PooledFrame {
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                template <typename P>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+                    return h.promise().continuation; // symmetric transfer back to whoever awaited
+                }
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() const noexcept { std::terminate(); } // same rule as ThreadPool tasks
+        };
+
+        template <typename T>
+        struct Promise : PromiseBase {
+            std::optional<T> value{};
+            template <typename U>
+            void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+            T take() { return std::move(*value); }
+        };
+
+        template <>
+        struct Promise<void> : PromiseBase {
+            void return_void() const noexcept {}
+            void take() const noexcept {}
+        };
+    }
+
+    // Lazy coroutine, starts when awaited and resumes its awaiter when done.
+    // NOTE: coroutines must not throw, an escaping exception terminates
+    template <typename T = void>
+    class [[nodiscard]] Task {
+        public:
+            struct promise_type : detail::Promise<T> {
+                Task get_return_object() noexcept { return Task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            };
+
+        private:
+            std::coroutine_handle<promise_type> m_handle{};
+
+            explicit Task(std::coroutine_handle<promise_type> h) noexcept : m_handle(h) {}
+
+        public:
+            Task() noexcept = default;
+            ~Task() { if (m_handle) m_handle.destroy(); }
+
+            Task(const Task&) = delete;
+            Task& operator=(const Task&) = delete;
+            Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+            Task& operator=(Task&& other) noexcept {
+                if (this != &other) {
+                    if (m_handle) m_handle.destroy();
+                    m_handle = std::exchange(other.m_handle, {});
+                }
+                return *this;
+            }
+
+            [[nodiscard]] bool valid() const noexcept { return static_cast<bool>(m_handle); }
+
+            bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                m_handle.promise().continuation = awaiting;
+                return m_handle;
+            }
+            T await_resume() { return m_handle.promise().take(); }
+    };
+
+    namespace detail {
+        struct Detached {
+            struct promise_type : PooledFrame {
+                Detached get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; } // frees itself
+                void return_void() const noexcept {}
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+        inline Detached run_detached(Task<void> task) {
+            co_await task;
+        }
+
+        // anything registered with IoContext's reactor, the token is its address
+        struct IoWaiter {
+            void (*on_event)(IoWaiter& self, std::uint32_t events) noexcept = nullptr;
+        };
+    }
+
+    // runs task on the calling thread until its first suspension, after
+    // that it finishes wherever it is resumed and frees itself
+    inline void spawn(Task<void> task) {
+        detail::run_detached(std::move(task));
+    }
+
+    // moves the awaiting coroutine onto a pool worker, resumes inline when
+    // the pool refuses the task
+    struct ResumeOn {
+        ThreadPool& pool;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h) {
+            return pool.submit([h] { h.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    [[nodiscard]] inline ResumeOn resume_on(ThreadPool& pool) noexcept { return ResumeOn{ pool }; }
+
+    // runs a blocking call on a pool worker and resumes the awaiting
+    // coroutine there with its result, for things that cant be polled
+    template <typename Fn>
+    struct Offload {
+        using Result = std::invoke_result_t<Fn&>;
+
+        ThreadPool& pool;
+        Fn fn;
+        std::optional<Result> result{};
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h) {
+            if (pool.submit([this, h] { result.emplace(fn()); h.resume(); })) return true;
+            result.emplace(fn()); // pool full or stopping, block right here
+            return false;
+        }
+        Result await_resume() { return std::move(*result); }
+    };
+
+    template <typename Fn>
+    [[nodiscard]] Offload<std::decay_t<Fn>> offload(ThreadPool& pool, Fn&& fn) {
+        return Offload<std::decay_t<Fn>>{ pool, std::forward<Fn>(fn) };
+    }
+
+    struct IoContextConfig {
+        std::size_t max_events = 256;       // reactor events handled per poll
+        ThreadPool* pool = nullptr;         // resume io waiters on this pool, nullptr = on the loop thread
+        std::int32_t queue_poll_ms = 1;     // how often coroutines waiting on a queue recheck it
+    };
+
+    // Event loop driving coroutines: run() polls the reactor and resumes
+    // whoever waits on a ready socket or notifier, either inline or on
+    // cfg.pool so thousands of sessions share a handful of threads.
+    // schedule() and idle() waiters always resume on the loop thread.
+    // NOTE: run() from one thread, post()/schedule()/spawn()/stop() from any
+    class IoContext {
+        private:
+            IoContextConfig m_cfg{};
+            sock::Reactor m_reactor;
+            std::vector<sock::ReactorEvent> m_events{};
+            std::mutex m_mtx;
+            std::vector<std::coroutine_handle<>> m_posted{};
+            std::vector<std::coroutine_handle<>> m_idle{};
+            std::vector<std::coroutine_handle<>> m_batch{};  // loop thread only
+            std::atomic<bool> m_stop{false};
+
+            void resume_all(std::vector<std::coroutine_handle<>>& list) {
+                m_batch.clear();
+                {
+                    std::lock_guard<std::mutex> lock(m_mtx);
+                    m_batch.swap(list);
+                }
+                for (auto h : m_batch) h.resume();
+            }
+
+        public:
+            explicit IoContext(const IoContextConfig& cfg = IoContextConfig{}) : m_cfg(cfg) {}
+            ~IoContext() { close(); }
+
+            IoContext(const IoContext&) = delete;
+            IoContext& operator=(const IoContext&) = delete;
+            IoContext(IoContext&&) = delete;
+            IoContext& operator=(IoContext&&) = delete;
+
+            [[nodiscard]] sock::SockResult open() {
+                m_events.resize(m_cfg.max_events == 0 ? 1 : m_cfg.max_events);
+                m_stop.store(false, std::memory_order_relaxed);
+                return m_reactor.open();
+            }
+
+            void close() noexcept { m_reactor.close(); }
+
+            [[nodiscard]] sock::Reactor& reactor() noexcept { return m_reactor; }
+
+            // hands h to whoever resumes io waiters, the pool or this thread
+            void dispatch(std::coroutine_handle<> h) {
+                if (m_cfg.pool != nullptr && m_cfg.pool->submit([h] { h.resume(); })) return;
+                h.resume();
+            }
+
+            // resumes h on the loop thread
+            void post(std::coroutine_handle<> h) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mtx);
+                    m_posted.push_back(h);
+                }
+                m_reactor.wake();
+            }
+
+            // one pass: waits up to timeout_ms (-1 = forever), resumes ready
+            // io waiters, posted coroutines and queue waiters
+            [[nodiscard]] sock::SockResult run_once(std::int32_t timeout_ms) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mtx);
+                    if (!m_posted.empty()) timeout_ms = 0;
+                    else if (!m_idle.empty() && (timeout_ms < 0 || timeout_ms > m_cfg.queue_poll_ms)) timeout_ms = m_cfg.queue_poll_ms;
+                }
+
+                const auto r = m_reactor.poll(m_events.data(), m_events.size(), timeout_ms);
+                if (!r.ok()) return r;
+
+                for (std::int32_t i = 0; i < r.bytes; ++i) {
+                    const auto& ev = m_events[static_cast<std::size_t>(i)];
+                    auto* waiter = reinterpret_cast<detail::IoWaiter*>(static_cast<std::uintptr_t>(ev.token));
+                    waiter->on_event(*waiter, ev.events);
+                }
+
+                resume_all(m_posted);
+                resume_all(m_idle);
+                return r;
+            }
+
+            // loops until stop()
+            void run() {
+                while (!m_stop.load(std::memory_order_acquire)) {
+                    if (!run_once(-1).ok()) break;
+                }
+            }
+
+            void stop() noexcept {
+                m_stop.store(true, std::memory_order_release);
+                m_reactor.wake();
+            }
+
+            [[nodiscard]] bool stopping() const noexcept { return m_stop.load(std::memory_order_acquire); }
+
+            // co_await io.schedule() continues on the loop thread
+            struct ScheduleAwaiter {
+                IoContext& io;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> h) { io.post(h); }
+                void await_resume() const noexcept {}
+            };
+            [[nodiscard]] ScheduleAwaiter schedule() noexcept { return ScheduleAwaiter{ *this }; }
+
+            // co_await io.idle() continues on the loop thread after the next
+            // poll, at most queue_poll_ms later
+            struct IdleAwaiter {
+                IoContext& io;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> h) {
+                    bool first = false;
+                    {
+                        std::lock_guard<std::mutex> lock(io.m_mtx);
+                        first = io.m_idle.empty();
+                        io.m_idle.push_back(h);
+                    }
+                    if (first) io.m_reactor.wake(); // a poll(-1) has to pick up the shorter timeout
+                }
+                void await_resume() const noexcept {}
+            };
+            [[nodiscard]] IdleAwaiter idle() noexcept { return IdleAwaiter{ *this }; }
+
+            // starts task on the loop thread
+            void spawn(Task<void> task);
+    };
+
+    namespace detail {
+        inline Task<void> started_on(IoContext& io, Task<void> task) {
+            co_await io.schedule();
+            co_await task;
+        }
+    }
+
+    inline void IoContext::spawn(Task<void> task) {
+        exec::spawn(detail::started_on(*this, std::move(task)));
+    }
+
+    // A socket registered with an IoContext. Puts it in non-blocking mode,
+    // readable()/writable() suspend until the reactor reports it, at most
+    // one coroutine waits for each direction at a time. Only the waited for
+    // directions are armed, so level triggered windows polling stays quiet.
+    // NOTE: detach() (or destroy) before closing the socket, and not while a
+    // coroutine is waiting on it
+    class AsyncSocket : private detail::IoWaiter {
+        private:
+            IoContext* m_io = nullptr;
+            sock::TCPSocket* m_socket = nullptr;
+            std::mutex m_mtx;
+            std::coroutine_handle<> m_reader{};
+            std::coroutine_handle<> m_writer{};
+            std::uint32_t m_armed = 0;
+            std::uint32_t m_last = 0;           // events that woke the last waiter
+
+            std::uint64_t token() noexcept {
+                return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(static_cast<detail::IoWaiter*>(this)));
+            }
+
+            static void handle_event(detail::IoWaiter& self, std::uint32_t events) noexcept {
+                auto& s = static_cast<AsyncSocket&>(self);
+                constexpr auto fail = sock::ready::Error | sock::ready::HangUp;
+                std::coroutine_handle<> reader{};
+                std::coroutine_handle<> writer{};
+                IoContext* io = s.m_io;
+                {
+                    std::lock_guard<std::mutex> lock(s.m_mtx);
+                    s.m_last = events;
+                    if ((events & (sock::ready::Read | fail)) != 0) reader = std::exchange(s.m_reader, {});
+                    if ((events & (sock::ready::Write | fail)) != 0) writer = std::exchange(s.m_writer, {});
+
+                    const std::uint32_t armed = (s.m_reader ? sock::ready::Read : 0u) | (s.m_writer ? sock::ready::Write : 0u);
+                    if (armed != s.m_armed) {
+                        s.m_armed = armed;
+                        (void)io->reactor().modify(*s.m_socket, s.token(), armed);
+                    }
+                }
+                // s may be gone once a waiter runs
+                if (reader) io->dispatch(reader);
+                if (writer) io->dispatch(writer);
+            }
+
+            // false = could not arm, resume right away and let the next call report the error
+            bool arm(std::coroutine_handle<> h, std::uint32_t dir) {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                auto& slot = dir == sock::ready::Read ? m_reader : m_writer;
+                assert(!slot && "AsyncSocket: one waiter per direction");
+                slot = h;
+                m_armed |= dir;
+                if (!m_io->reactor().modify(*m_socket, token(), m_armed).ok()) {
+                    slot = {};
+                    m_armed &= ~dir;
+                    return false;
+                }
+                return true;
+            }
+
+        public:
+            AsyncSocket() noexcept { on_event = &AsyncSocket::handle_event; }
+            ~AsyncSocket() { detach(); }
+
+            AsyncSocket(const AsyncSocket&) = delete;
+            AsyncSocket& operator=(const AsyncSocket&) = delete;
+            AsyncSocket(AsyncSocket&&) = delete;
+            AsyncSocket& operator=(AsyncSocket&&) = delete;
+
+            [[nodiscard]] sock::SockResult attach(IoContext& io, sock::TCPSocket& socket) {
+                if (m_socket != nullptr) return sock::SockResult{ sock::SockErr::DoubleOpen, sock::SockOp::Configure, 0, 0 };
+
+                auto r = socket.set_nonblocking(true);
+                if (!r.ok()) return r;
+                r = io.reactor().add(socket, token(), 0);
+                if (!r.ok()) return r;
+
+                m_io = &io;
+                m_socket = &socket;
+                m_armed = 0;
+                return r;
+            }
+
+            void detach() noexcept {
+                if (m_socket == nullptr) return;
+                (void)m_io->reactor().remove(*m_socket);
+                m_socket = nullptr;
+                m_io = nullptr;
+            }
+
+            [[nodiscard]] bool is_attached() const noexcept { return m_socket != nullptr; }
+            [[nodiscard]] sock::TCPSocket& socket() const noexcept { return *m_socket; }
+            [[nodiscard]] IoContext& context() const noexcept { return *m_io; }
+
+            struct ReadyAwaiter {
+                AsyncSocket& s;
+                std::uint32_t dir;
+                bool await_ready() const noexcept { return false; }
+                bool await_suspend(std::coroutine_handle<> h) { return s.arm(h, dir); }
+                // ready:: bits that woke it
+                std::uint32_t await_resume() const noexcept { return s.m_last; }
+            };
+
+            [[nodiscard]] ReadyAwaiter readable() noexcept { return ReadyAwaiter{ *this, sock::ready::Read }; }
+            [[nodiscard]] ReadyAwaiter writable() noexcept { return ReadyAwaiter{ *this, sock::ready::Write }; }
+    };
+
+    // A Notifier registered with an IoContext so coroutines can wait on its
+    // counts, the coroutine version of a semaphore wait
+    // NOTE: detach() (or destroy) before closing the notifier
+    class AsyncNotifier : private detail::IoWaiter {
+        private:
+            IoContext* m_io = nullptr;
+            evt::Notifier* m_notifier = nullptr;
+            std::mutex m_mtx;
+            std::coroutine_handle<> m_waiter{};
+            bool m_signalled = false;   // an event came in with nobody waiting
+
+            static void handle_event(detail::IoWaiter& self, std::uint32_t) noexcept {
+                auto& n = static_cast<AsyncNotifier&>(self);
+                std::coroutine_handle<> h{};
+                IoContext* io = n.m_io;
+                {
+                    std::lock_guard<std::mutex> lock(n.m_mtx);
+                    h = std::exchange(n.m_waiter, {});
+                    if (!h) n.m_signalled = true;
+                }
+                if (h) io->dispatch(h);
+            }
+
+            struct SignalAwaiter {
+                AsyncNotifier& n;
+                bool await_ready() const noexcept { return false; }
+                bool await_suspend(std::coroutine_handle<> h) {
+                    std::lock_guard<std::mutex> lock(n.m_mtx);
+                    if (std::exchange(n.m_signalled, false)) return false;
+                    assert(!n.m_waiter && "AsyncNotifier: one waiter at a time");
+                    n.m_waiter = h;
+                    return true;
+                }
+                void await_resume() const noexcept {}
+            };
+
+        public:
+            AsyncNotifier() noexcept { on_event = &AsyncNotifier::handle_event; }
+            ~AsyncNotifier() { detach(); }
+
+            AsyncNotifier(const AsyncNotifier&) = delete;
+            AsyncNotifier& operator=(const AsyncNotifier&) = delete;
+            AsyncNotifier(AsyncNotifier&&) = delete;
+            AsyncNotifier& operator=(AsyncNotifier&&) = delete;
+
+            [[nodiscard]] sock::SockResult attach(IoContext& io, evt::Notifier& notifier) {
+                if (m_notifier != nullptr) return sock::SockResult{ sock::SockErr::DoubleOpen, sock::SockOp::Configure, 0, 0 };
+                const auto token = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(static_cast<detail::IoWaiter*>(this)));
+                const auto r = io.reactor().add(notifier, token);
+                if (!r.ok()) return r;
+                m_io = &io;
+                m_notifier = &notifier;
+                return r;
+            }
+
+            void detach() noexcept {
+                if (m_notifier == nullptr) return;
+                (void)m_io->reactor().remove(*m_notifier);
+                m_notifier = nullptr;
+                m_io = nullptr;
+            }
+
+            // takes one count, suspending while there is none
+            Task<evt::SemResult> wait() {
+                for (;;) {
+                    const auto r = m_notifier->try_wait();
+                    if (r.code != evt::SemErr::WouldBlock) co_return r;
+                    co_await SignalAwaiter{ *this };
+                }
+            }
+    };
+
+    // one recv, suspending while nothing is there. bytes = bytes read
+    inline Task<sock::SockResult> async_recv(AsyncSocket& s, void* data, std::size_t size) {
+        auto& client = static_cast<sock::TCPClient&>(s.socket());
+        for (;;) {
+            const auto r = client.recv(data, size);
+            if (r.code != sock::SockErr::WouldBlock) co_return r;
+            (void)co_await s.readable();
+        }
+    }
+
+    // fills all size bytes, Closed if the peer goes away first
+    inline Task<sock::SockResult> async_recv_all(AsyncSocket& s, void* data, std::size_t size) {
+        auto* out = static_cast<std::byte*>(data);
+        std::size_t done = 0;
+        while (done < size) {
+            auto r = co_await async_recv(s, out + done, size - done);
+            if (!r.ok()) {
+                r.bytes = static_cast<std::int32_t>(done);
+                co_return r;
+            }
+            done += static_cast<std::size_t>(r.bytes);
+        }
+        co_return sock::SockResult{ sock::SockErr::None, sock::SockOp::Recv, 0, static_cast<std::int32_t>(done) };
+    }
+
+    // sends all size bytes, suspending whenever the send buffer is full
+    inline Task<sock::SockResult> async_send_all(AsyncSocket& s, const void* data, std::size_t size) {
+        auto& client = static_cast<sock::TCPClient&>(s.socket());
+        const auto* in = static_cast<const std::byte*>(data);
+        std::size_t done = 0;
+        while (done < size) {
+            auto r = client.send(in + done, size - done);
+            if (r.code == sock::SockErr::WouldBlock) {
+                (void)co_await s.writable();
+                continue;
+            }
+            if (!r.ok()) {
+                r.bytes = static_cast<std::int32_t>(done);
+                co_return r;
+            }
+            done += static_cast<std::size_t>(r.bytes);
+        }
+        co_return sock::SockResult{ sock::SockErr::None, sock::SockOp::Send, 0, static_cast<std::int32_t>(done) };
+    }
+
+    // accepts one client into out, s must wrap a listening TCPServer
+    inline Task<sock::SockResult> async_accept(AsyncSocket& s, sock::TCPClient& out) {
+        auto& server = static_cast<sock::TCPServer&>(s.socket());
+        for (;;) {
+            const auto r = server.accept_into(out);
+            if (r.code != sock::SockErr::WouldBlock) co_return r;
+            (void)co_await s.readable();
+        }
+    }
+
+    // plain semaphores cant be polled, the wait blocks a pool worker instead.
+    // Prefer AsyncNotifier when many coroutines wait
+    inline Task<evt::SemResult> async_wait(ThreadPool& pool, evt::Semaphore& sem, std::uint32_t milliseconds = 0) {
+        co_return co_await offload(pool, [&sem, milliseconds] { return sem.wait(milliseconds); });
+    }
+
+    // pops one element from any queue consumer with try_pop(T&), rechecking
+    // on the loop thread every queue_poll_ms while it is empty
+    template <typename Consumer, typename T>
+    Task<void> async_pop(IoContext& io, Consumer& consumer, T& out) {
+        while (!consumer.try_pop(out)) {
+            co_await io.idle();
+        }
+    }
+}
+#endif
@@ -0,0 +1,137 @@
+#include "exec/thread_pool.h"
+#include "platform/platform.h"
+
+namespace exec {
+    namespace {
+        // which pool/worker the current thread belongs to, lets submit() from
+        // inside a task go straight onto the local deque
+        struct WorkerContext {
+            const ThreadPool* pool = nullptr;
+            std::uint32_t index = 0;
+        };
+
+        thread_local WorkerContext tls_worker{};
+    }
+
+    ThreadPool::ThreadPool(const ThreadPoolConfig& cfg)
+        : m_free(cfg.max_tasks), m_inject(cfg.max_tasks) {
+        if (!m_free.is_valid() || !m_inject.is_valid()) return;
+
+        auto threads = cfg.num_threads;
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+
+        m_free_push = m_free.make_producer();
+        m_free_pop = m_free.make_consumer();
+        m_inject_push = m_inject.make_producer();
+        m_inject_pop = m_inject.make_consumer();
+
+        m_nodes = std::make_unique<detail::TaskNode[]>(cfg.max_tasks);
+        for (std::uint32_t i = 0; i < cfg.max_tasks; ++i) {
+            (void)m_free_push->push(i);
+        }
+
+        m_deques.reserve(threads);
+        for (std::uint32_t i = 0; i < threads; ++i) {
+            m_deques.push_back(std::make_unique<WorkDeque<std::uint32_t>>(cfg.deque_capacity));
+            if (!m_deques.back()->is_valid()) return;
+        }
+
+        m_valid = true;
+        m_threads.reserve(threads);
+        for (std::uint32_t i = 0; i < threads; ++i) {
+            m_threads.emplace_back([this, i]() noexcept { worker_loop(i); });
+            if (!cfg.cpus.empty()) {
+                (void)plat::set_thread_affinity(m_threads.back(), plat::CpuSet::single(cfg.cpus.nth(i)));
+            } else if (cfg.pin_threads) {
+                plat::affinitize_thread(m_threads.back(), cfg.first_cpu + i);
+            }
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        shutdown();
+    }
+
+    void ThreadPool::shutdown() noexcept {
+        m_stop.store(true, std::memory_order_release);
+        m_park.notify();
+        for (auto& t : m_threads) {
+            if (t.joinable()) t.join();
+        }
+
+        // a submit that raced the stop flag may have landed after the workers left
+        std::uint32_t idx = 0;
+        while (m_valid && m_inject_pop->try_pop(idx)) {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            run_node(idx);
+        }
+    }
+
+    bool ThreadPool::acquire_node(std::uint32_t& idx) noexcept {
+        return m_free_pop->try_pop(idx);
+    }
+
+    void ThreadPool::release_node(std::uint32_t idx) noexcept {
+        // there are exactly max_tasks indices so this cant fail
+        (void)m_free_push->push(idx);
+    }
+
+    bool ThreadPool::enqueue(std::uint32_t idx) noexcept {
+        // count before publishing so a parked worker never misses it
+        m_queued.fetch_add(1, std::memory_order_release);
+
+        const bool local = tls_worker.pool == this && m_deques[tls_worker.index]->push(idx);
+        if (!local) {
+            // injection queue holds max_tasks so this cant fail either
+            (void)m_inject_push->push(idx);
+        }
+
+        m_park.notify();
+        return true;
+    }
+
+    bool ThreadPool::find_work(std::uint32_t worker, std::uint32_t& idx) noexcept {
+        if (m_deques[worker]->pop(idx)) return true;
+        if (m_inject_pop->try_pop(idx)) return true;
+
+        // steal from everyone else, starting with our neighbour
+        const auto count = static_cast<std::uint32_t>(m_deques.size());
+        for (std::uint32_t i = 1; i < count; ++i) {
+            if (m_deques[(worker + i) % count]->steal(idx)) return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::run_node(std::uint32_t idx) noexcept {
+        auto& node = m_nodes[idx];
+        node.run(node);
+        node.run = nullptr;
+        release_node(idx);
+    }
+
+    void ThreadPool::worker_loop(std::uint32_t worker) noexcept {
+        tls_worker = WorkerContext{ this, worker };
+
+        while (true) {
+            std::uint32_t idx = 0;
+            if (find_work(worker, idx)) {
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                run_node(idx);
+                continue;
+            }
+
+            if (m_stop.load(std::memory_order_acquire)) {
+                if (m_queued.load(std::memory_order_acquire) == 0) break;
+                std::this_thread::yield(); // someone is mid publish, go again
+                continue;
+            }
+
+            (void)m_park.wait([this]() noexcept {
+                return m_queued.load(std::memory_order_acquire) != 0 || m_stop.load(std::memory_order_acquire);
+            }, 0);
+        }
+
+        tls_worker = WorkerContext{};
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "exec/work_deque.h"
+#include "msg/mpmc_queue.h"
+#include "msg/wait_strategy.h"
+#include "platform/topology.h"
+
+namespace exec {
+    struct ThreadPoolConfig {
+        std::uint32_t num_threads = 0;      // 0 = std::thread::hardware_concurrency()
+        std::uint32_t max_tasks = 4096;     // max queued tasks, power of 2
+        std::uint32_t deque_capacity = 256; // per worker deque, power of 2
+        bool pin_threads = false;           // pin worker i to cpu first_cpu + i
+        std::uint32_t first_cpu = 0;
+        // when not empty, pin worker i to the i'th cpu of this set instead (wrapping),
+        // e.g. plat::topology().l3_peers(cpu) to keep the pool on one cache domain
+        plat::CpuSet cpus{};
+    };
+
+    namespace detail {
+        // preallocated task slot, small callables are constructed in place,
+        // anything larger than inline_size (or over aligned) goes to the heap
+        struct alignas(64) TaskNode {
+            static constexpr std::size_t inline_size = 64 - sizeof(void*);
+
+            alignas(std::max_align_t) unsigned char storage[inline_size];
+            void (*run)(TaskNode&) noexcept = nullptr; // invokes then destroys
+
+            template <typename F>
+            static constexpr bool fits_inline = sizeof(F) <= inline_size
+                && alignof(F) <= alignof(std::max_align_t)
+                && std::is_nothrow_move_constructible_v<F>;
+
+            template <typename F>
+            F* as() noexcept { return std::launder(static_cast<F*>(static_cast<void*>(storage))); }
+
+            template <typename F>
+            static void run_inline(TaskNode& node) noexcept {
+                F& fn = *node.as<F>();
+                fn();
+                fn.~F();
+            }
+
+            template <typename F>
+            static void run_heap(TaskNode& node) noexcept {
+                F* fn = *node.as<F*>();
+                (*fn)();
+                delete fn;
+            }
+        };
+    }
+
+    // Work stealing thread pool. Each worker owns a Chase-Lev deque, tasks
+    // submitted from outside the pool land in a shared injection queue, idle
+    // workers steal from each other and then park (spin, yield, futex).
+    // Tasks live in a fixed pool of nodes so submit never allocates for small
+    // callables, submit returns false when every node is in use.
+    // NOTE: tasks must not throw, an escaping exception terminates
+    class ThreadPool {
+        private:
+            using IndexQueue = msg::DynMPMCQueue<std::uint32_t>;
+
+            std::unique_ptr<detail::TaskNode[]> m_nodes{};
+            IndexQueue m_free;
+            IndexQueue m_inject;
+            std::optional<IndexQueue::Producer> m_free_push{};
+            std::optional<IndexQueue::Consumer> m_free_pop{};
+            std::optional<IndexQueue::Producer> m_inject_push{};
+            std::optional<IndexQueue::Consumer> m_inject_pop{};
+
+            std::vector<std::unique_ptr<WorkDeque<std::uint32_t>>> m_deques{};
+            std::vector<std::thread> m_threads{};
+
+            alignas(64) std::atomic<std::uint64_t> m_queued{0}; // submitted but not yet picked up
+            alignas(64) std::atomic<bool> m_stop{false};
+            msg::SpinParkWait m_park{};
+            bool m_valid = false;
+
+            [[nodiscard]] bool acquire_node(std::uint32_t& idx) noexcept;
+            void release_node(std::uint32_t idx) noexcept;
+            [[nodiscard]] bool enqueue(std::uint32_t idx) noexcept;
+            [[nodiscard]] bool find_work(std::uint32_t worker, std::uint32_t& idx) noexcept;
+            void run_node(std::uint32_t idx) noexcept;
+            void worker_loop(std::uint32_t worker) noexcept;
+
+        public:
+            explicit ThreadPool(const ThreadPoolConfig& cfg = ThreadPoolConfig{});
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+            ThreadPool(ThreadPool&&) = delete;
+            ThreadPool& operator=(ThreadPool&&) = delete;
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_valid; }
+            [[nodiscard]] std::size_t num_threads() const noexcept { return m_threads.size(); }
+            std::size_t pending_snapshot() const noexcept { return static_cast<std::size_t>(m_queued.load(std::memory_order_relaxed)); }
+
+            // queues fn to run on a worker. From a worker thread the task goes on
+            // that workers own deque, otherwise into the injection queue.
+            // returns false if the pool is stopping or out of task nodes
+            template <typename F>
+            [[nodiscard]] bool submit(F&& fn) {
+                using Fn = std::decay_t<F>;
+                static_assert(std::is_invocable_v<Fn&>, "ThreadPool::submit requires a callable taking no arguments");
+
+                if (!m_valid || m_stop.load(std::memory_order_acquire)) return false;
+
+                std::uint32_t idx = 0;
+                if (!acquire_node(idx)) return false;
+
+                // copying captures may throw, the node goes back before it escapes
+                auto& node = m_nodes[idx];
+                try {
+                    if constexpr (detail::TaskNode::fits_inline<Fn>) {
+                        ::new (static_cast<void*>(node.storage)) Fn(std::forward<F>(fn));
+                        node.run = &detail::TaskNode::run_inline<Fn>;
+                    } else {
+                        Fn* heap = new (std::nothrow) Fn(std::forward<F>(fn));
+                        if (heap == nullptr) {
+                            release_node(idx);
+                            return false;
+                        }
+                        ::new (static_cast<void*>(node.storage)) Fn*(heap);
+                        node.run = &detail::TaskNode::run_heap<Fn>;
+                    }
+                } catch (...) {
+                    release_node(idx);
+                    throw;
+                }
+
+                return enqueue(idx);
+            }
+
+            // stops accepting work, lets the workers drain whats queued and joins them
+            void shutdown() noexcept;
+    };
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+
+namespace exec {
+    // Bounded Chase-Lev work stealing deque (Le et al. C11 formulation).
+    // The owning thread pushes and pops at the bottom, any other thread steals
+    // from the top. Capacity is fixed, push fails when full instead of growing.
+    // NOTE: T must be lock free as an atomic, the pool stores uint32 task indices
+    template <typename T>
+    class WorkDeque {
+        static_assert(std::atomic<T>::is_always_lock_free, "WorkDeque requires a lock free T");
+
+        private:
+            alignas(64) std::atomic<std::int64_t> m_top{0};
+            alignas(64) std::atomic<std::int64_t> m_bottom{0};
+            std::unique_ptr<std::atomic<T>[]> m_buffer{};
+            std::size_t m_mask = 0;
+
+            std::atomic<T>& cell(std::int64_t i) noexcept { return m_buffer[static_cast<std::size_t>(i) & m_mask]; }
+
+        public:
+            // capacity must be a power of 2, check is_valid() before use
+            explicit WorkDeque(std::size_t capacity) {
+                if (capacity == 0 || (capacity & (capacity - 1)) != 0) return;
+                m_buffer = std::make_unique<std::atomic<T>[]>(capacity);
+                m_mask = capacity - 1;
+            }
+            ~WorkDeque() = default;
+
+            WorkDeque(const WorkDeque&) = delete;
+            WorkDeque& operator=(const WorkDeque&) = delete;
+            WorkDeque(WorkDeque&&) = delete;
+            WorkDeque& operator=(WorkDeque&&) = delete;
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_buffer != nullptr; }
+            [[nodiscard]] std::size_t capacity() const noexcept { return m_buffer != nullptr ? m_mask + 1 : 0; }
+
+            // owner only
+            [[nodiscard]] bool push(T item) noexcept {
+                const auto b = m_bottom.load(std::memory_order_relaxed);
+                const auto t = m_top.load(std::memory_order_acquire);
+                if (static_cast<std::size_t>(b - t) > m_mask) {
+                    return false; // full
+                }
+
+                cell(b).store(item, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return true;
+            }
+
+            // owner only, LIFO end
+            [[nodiscard]] bool pop(T& out) noexcept {
+                const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+                m_bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto t = m_top.load(std::memory_order_relaxed);
+
+                if (t > b) {
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                    return false; // empty
+                }
+
+                out = cell(b).load(std::memory_order_relaxed);
+                if (t == b) {
+                    // last item, race the thieves for it
+                    const bool won = m_top.compare_exchange_strong(t, t + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed);
+                    m_bottom.store(b + 1, std::memory_order_relaxed);
+                    return won;
+                }
+                return true;
+            }
+
+            // any thread, FIFO end. false means empty or lost a race
+            [[nodiscard]] bool steal(T& out) noexcept {
+                auto t = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const auto b = m_bottom.load(std::memory_order_acquire);
+                if (t >= b) {
+                    return false; // empty
+                }
+
+                out = cell(t).load(std::memory_order_relaxed);
+                return m_top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed);
+            }
+
+            std::size_t count_snapshot() const noexcept {
+                const auto b = m_bottom.load(std::memory_order_acquire);
+                const auto t = m_top.load(std::memory_order_acquire);
+                return b > t ? static_cast<std::size_t>(b - t) : 0;
+            }
+    };
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace instr {
+    namespace detail {
+        // log linear buckets in the style of HdrHistogram: values below 32 get a
+        // bucket each, above that every power of 2 is split into 16 buckets so
+        // the relative error stays under 1/16 across the whole 64 bit range
+        constexpr unsigned hist_sub_bits = 5;
+        constexpr std::uint64_t hist_linear = std::uint64_t{1} << hist_sub_bits;   // 32
+        constexpr std::uint64_t hist_half = hist_linear / 2;                     // 16
+        constexpr std::size_t hist_buckets = static_cast<std::size_t>((64 - hist_sub_bits + 1) * hist_half + hist_half);
+
+        inline unsigned msb(std::uint64_t v) noexcept {
+            #if defined(_MSC_VER) && !defined(__clang__)
+                unsigned long idx = 0;
+                _BitScanReverse64(&idx, v);
+                return static_cast<unsigned>(idx);
+            #else
+                return 63u - static_cast<unsigned>(__builtin_clzll(v));
+            #endif
+        }
+
+        inline std::size_t bucket_of(std::uint64_t v) noexcept {
+            if (v < hist_linear) return static_cast<std::size_t>(v);
+            const unsigned e = msb(v) - hist_sub_bits + 1;
+            return static_cast<std::size_t>(e * hist_half + (v >> e));
+        }
+
+        // highest value that lands in bucket i
+        inline std::uint64_t bucket_upper(std::size_t i) noexcept {
+            if (i < hist_linear) return i;
+            const auto e = static_cast<unsigned>(i / hist_half - 1);
+            const auto mant = static_cast<std::uint64_t>(i - e * hist_half);
+            return ((mant + 1) << e) - 1;
+        }
+    }
+
+    // plain copy of a histogram, what snapshots and the shm stats page carry
+    struct HistSnapshot {
+        std::uint64_t count = 0;
+        std::uint64_t sum = 0;
+        std::uint64_t max = 0;
+        std::uint64_t buckets[detail::hist_buckets]{};
+
+        void merge(const HistSnapshot& other) noexcept {
+            count += other.count;
+            sum += other.sum;
+            if (other.max > max) max = other.max;
+            for (std::size_t i = 0; i < detail::hist_buckets; ++i) buckets[i] += other.buckets[i];
+        }
+
+        // upper bound of the bucket holding the pct'th percentile (0-100), in
+        // whatever unit was recorded
+        [[nodiscard]] std::uint64_t value_at(double pct) const noexcept {
+            if (count == 0) return 0;
+            auto rank = static_cast<std::uint64_t>(pct / 100.0 * static_cast<double>(count));
+            if (rank >= count) rank = count - 1;
+
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < detail::hist_buckets; ++i) {
+                seen += buckets[i];
+                if (seen > rank) {
+                    const auto upper = detail::bucket_upper(i);
+                    return upper < max ? upper : max;
+                }
+            }
+            return max;
+        }
+
+        [[nodiscard]] double mean() const noexcept {
+            return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+        }
+    };
+
+    // Single writer histogram, the owning thread records with relaxed
+    // load/store pairs (no locked instructions), any thread can snapshot it
+    class Histogram {
+        private:
+            std::atomic<std::uint64_t> m_count{0};
+            std::atomic<std::uint64_t> m_sum{0};
+            std::atomic<std::uint64_t> m_max{0};
+            std::atomic<std::uint64_t> m_buckets[detail::hist_buckets]{};
+
+            static void bump(std::atomic<std::uint64_t>& cell, std::uint64_t n) noexcept {
+                cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+
+        public:
+            // owning thread only
+            void record(std::uint64_t value) noexcept {
+                bump(m_buckets[detail::bucket_of(value)], 1);
+                bump(m_count, 1);
+                bump(m_sum, value);
+                if (value > m_max.load(std::memory_order_relaxed)) m_max.store(value, std::memory_order_relaxed);
+            }
+
+            // adds this histogram into out, may be mid record so counts can be off by one
+            void snapshot_into(HistSnapshot& out) const noexcept {
+                out.count += m_count.load(std::memory_order_relaxed);
+                out.sum += m_sum.load(std::memory_order_relaxed);
+                const auto mx = m_max.load(std::memory_order_relaxed);
+                if (mx > out.max) out.max = mx;
+                for (std::size_t i = 0; i < detail::hist_buckets; ++i) {
+                    out.buckets[i] += m_buckets[i].load(std::memory_order_relaxed);
+                }
+            }
+    };
+}
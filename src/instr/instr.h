@@ -0,0 +1,21 @@
+#pragma once
+
+// Instrumentation hooks used inside the library. With MOO_INSTRUMENT
+// undefined (the default, see the CMake option) every macro expands to an
+// empty statement and nothing from instr/ is pulled in, so hot paths are
+// unchanged. Arguments are not evaluated when disabled
+#if defined(MOO_INSTRUMENT)
+    #include "instr/metrics.h"
+
+    #define MOO_INSTR_COUNT(id, n) ::instr::count(id, static_cast<std::uint64_t>(n))
+    #define MOO_INSTR_COUNT_IF(cond, id) do { if (cond) ::instr::count(id, 1); } while (0)
+    #define MOO_INSTR_SCOPE(hist) const ::instr::ScopedTimer moo_instr_scope(hist)
+    #define MOO_INSTR_TIMER_START(name) const std::uint64_t name = ::instr::ticks()
+    #define MOO_INSTR_TIMER_RECORD(name, hist) ::instr::record_ticks(hist, ::instr::ticks() - name)
+#else
+    #define MOO_INSTR_COUNT(id, n) do { (void)sizeof(n); } while (0)
+    #define MOO_INSTR_COUNT_IF(cond, id) do { (void)sizeof(cond); } while (0)
+    #define MOO_INSTR_SCOPE(hist) do { } while (0)
+    #define MOO_INSTR_TIMER_START(name) do { } while (0)
+    #define MOO_INSTR_TIMER_RECORD(name, hist) do { } while (0)
+#endif
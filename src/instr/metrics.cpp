@@ -0,0 +1,129 @@
+#include "instr/metrics.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace instr {
+    namespace {
+        // blocks are never freed, a thread that exits marks its block retired
+        // and the next new thread takes it over. The counts it already holds
+        // stay in the totals so nothing has to be folded anywhere on exit
+        struct Registry {
+            std::mutex mtx;
+            std::vector<std::unique_ptr<detail::ThreadMetrics>> blocks;
+        };
+
+        // leaked on purpose, thread_local destructors of late exiting threads
+        // still get to it after static destruction starts
+        Registry* registry() noexcept {
+            static Registry* reg = new (std::nothrow) Registry();
+            return reg;
+        }
+
+        detail::ThreadMetrics g_fallback{};
+
+        double calibrate() noexcept {
+            using clock = std::chrono::steady_clock;
+            const auto t0 = clock::now();
+            const auto c0 = ticks();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const auto c1 = ticks();
+            const auto t1 = clock::now();
+
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+            if (c1 <= c0 || ns <= 0) return 1.0;
+            return static_cast<double>(ns) / static_cast<double>(c1 - c0);
+        }
+    }
+
+    double ns_per_tick() noexcept {
+        #if defined(MOO_HAS_RDTSC)
+            static const double scale = calibrate();
+            return scale;
+        #else
+            return 1.0; // steady_clock already counts ns
+        #endif
+    }
+
+    std::string_view counter_name(Counter c) noexcept {
+        switch (c) {
+            case Counter::SpscPushFull: return "spsc_push_full";
+            case Counter::SpscPopEmpty: return "spsc_pop_empty";
+            case Counter::SpmcPushFull: return "spmc_push_full";
+            case Counter::SpmcPopEmpty: return "spmc_pop_empty";
+            case Counter::TcpSendCalls: return "tcp_send_calls";
+            case Counter::TcpSendBytes: return "tcp_send_bytes";
+            case Counter::TcpPartialSends: return "tcp_partial_sends";
+            case Counter::TcpRecvCalls: return "tcp_recv_calls";
+            case Counter::TcpRecvBytes: return "tcp_recv_bytes";
+            case Counter::Count: break;
+        }
+        return "unknown";
+    }
+
+    std::string_view hist_name(Hist h) noexcept {
+        switch (h) {
+            case Hist::EventEmit: return "event_emit";
+            case Hist::TcpSendLockWait: return "tcp_send_lock_wait";
+            case Hist::Count: break;
+        }
+        return "unknown";
+    }
+
+    namespace detail {
+        ThreadMetrics* register_thread() noexcept {
+            Registry* reg = registry();
+            if (reg == nullptr) return &g_fallback;
+
+            try {
+                std::lock_guard lock(reg->mtx);
+                for (auto& block : reg->blocks) {
+                    if (block->retired.load(std::memory_order_acquire)) {
+                        block->retired.store(false, std::memory_order_relaxed);
+                        return block.get();
+                    }
+                }
+
+                auto block = std::unique_ptr<ThreadMetrics>(new (std::nothrow) ThreadMetrics());
+                if (block == nullptr) return &g_fallback;
+                reg->blocks.push_back(std::move(block));
+                return reg->blocks.back().get();
+            } catch (...) {
+                return &g_fallback;
+            }
+        }
+
+        void retire_thread(ThreadMetrics* m) noexcept {
+            if (m == &g_fallback) return;
+            // release so the next owner sees every count this thread made
+            m->retired.store(true, std::memory_order_release);
+        }
+    }
+
+    void snapshot(MetricsSnapshot& out) noexcept {
+        out = MetricsSnapshot{};
+        out.taken_ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        out.ns_per_tick = ns_per_tick();
+
+        auto add = [&out](const detail::ThreadMetrics& m) {
+            for (std::size_t i = 0; i < counter_count; ++i) {
+                out.counters[i] += m.counters[i].load(std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i < hist_count; ++i) {
+                m.hists[i].snapshot_into(out.hists[i]);
+            }
+        };
+
+        add(g_fallback);
+
+        Registry* reg = registry();
+        if (reg == nullptr) return;
+
+        std::lock_guard lock(reg->mtx);
+        for (const auto& block : reg->blocks) add(*block);
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string_view>
+#include "instr/histogram.h"
+#include "instr/tsc.h"
+
+namespace instr {
+    // fixed ids so the shm stats page has a stable layout, add new ones
+    // right before Count
+    enum class Counter : std::uint16_t {
+        SpscPushFull,       // SPSCQueue push refused, ring full
+        SpscPopEmpty,       // SPSCQueue pop found nothing
+        SpmcPushFull,
+        SpmcPopEmpty,
+        TcpSendCalls,       // send/sendmsg/WSASend syscalls
+        TcpSendBytes,
+        TcpPartialSends,    // a send syscall took fewer bytes than offered
+        TcpRecvCalls,
+        TcpRecvBytes,
+        Count
+    };
+
+    enum class Hist : std::uint16_t {
+        EventEmit,          // ticks spent in evt::Event::emit, so fan out cost
+        TcpSendLockWait,    // ticks waiting for TCPClient's send lock
+        Count
+    };
+
+    constexpr std::size_t counter_count = static_cast<std::size_t>(Counter::Count);
+    constexpr std::size_t hist_count = static_cast<std::size_t>(Hist::Count);
+
+    [[nodiscard]] std::string_view counter_name(Counter c) noexcept;
+    [[nodiscard]] std::string_view hist_name(Hist h) noexcept;
+
+    // everything summed over all threads (live and exited), trivially
+    // copyable so it can be published through shm as is
+    struct MetricsSnapshot {
+        std::uint64_t taken_ns = 0;     // system clock, ns since epoch
+        double ns_per_tick = 1.0;       // scale for the histogram values
+        std::uint64_t counters[counter_count]{};
+        HistSnapshot hists[hist_count]{};
+
+        [[nodiscard]] std::uint64_t counter(Counter c) const noexcept { return counters[static_cast<std::size_t>(c)]; }
+        [[nodiscard]] const HistSnapshot& hist(Hist h) const noexcept { return hists[static_cast<std::size_t>(h)]; }
+
+        // percentile of a histogram converted from ticks to ns
+        [[nodiscard]] double hist_ns(Hist h, double pct) const noexcept {
+            return static_cast<double>(hist(h).value_at(pct)) * ns_per_tick;
+        }
+    };
+
+    namespace detail {
+        // one per thread, only the owning thread writes so updates are plain
+        // relaxed load/store pairs and never bounce a cache line between cores
+        struct alignas(64) ThreadMetrics {
+            std::atomic<std::uint64_t> counters[counter_count]{};
+            Histogram hists[hist_count]{};
+            std::atomic<bool> retired{false};
+        };
+
+        // registers the calling thread on first use, never fails (falls back
+        // to a shared block if allocation does, counts there can lose updates)
+        [[nodiscard]] ThreadMetrics* register_thread() noexcept;
+        void retire_thread(ThreadMetrics* m) noexcept;
+
+        struct ThreadSlot {
+            ThreadMetrics* metrics = nullptr;
+            ~ThreadSlot() { if (metrics != nullptr) retire_thread(metrics); }
+        };
+
+        inline ThreadMetrics& local() noexcept {
+            thread_local ThreadSlot slot{};
+            if (slot.metrics == nullptr) slot.metrics = register_thread();
+            return *slot.metrics;
+        }
+    }
+
+    // Per thread metrics. count()/record_ticks() only touch the calling
+    // threads block, snapshot() walks every block and sums them.
+    // The library calls these through the MOO_INSTR_* macros in instr.h,
+    // which compile to nothing unless MOO_INSTRUMENT is defined
+    inline void count(Counter c, std::uint64_t n = 1) noexcept {
+        auto& cell = detail::local().counters[static_cast<std::size_t>(c)];
+        cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    inline void record_ticks(Hist h, std::uint64_t elapsed) noexcept {
+        detail::local().hists[static_cast<std::size_t>(h)].record(elapsed);
+    }
+
+    // records the ticks from construction to destruction
+    class ScopedTimer {
+        private:
+            Hist m_hist;
+            std::uint64_t m_start;
+
+        public:
+            explicit ScopedTimer(Hist h) noexcept : m_hist(h), m_start(ticks()) {}
+            ~ScopedTimer() { record_ticks(m_hist, ticks() - m_start); }
+
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+            ScopedTimer(ScopedTimer&&) = delete;
+            ScopedTimer& operator=(ScopedTimer&&) = delete;
+    };
+
+    // sums every thread into out, never blocks a recording thread
+    void snapshot(MetricsSnapshot& out) noexcept;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include "instr/metrics.h"
+#include "shm/shm.h"
+#include "shm/shm_snapshot.h"
+
+namespace instr {
+    // Exports MetricsSnapshot through a Shm region so another process
+    // (a monitor, a dashboard scraper) can watch a running one without
+    // touching its threads. One slot of ShmSnapshot, readers never block
+    // the publisher.
+    // The owning process calls publish() from a housekeeping thread every so
+    // often, it walks every thread's metrics so keep it off the hot path.
+    // NOTE: ShmStatsPage must not outlive the Shm mapping
+    class ShmStatsPage {
+        private:
+            using Page = shm::ShmSnapshot<MetricsSnapshot>;
+
+            Page m_page{};
+            std::optional<Page::Writer> m_writer{};
+            MetricsSnapshot m_scratch{};    // publisher side, avoids a large stack copy
+
+        public:
+            ShmStatsPage() = default;
+            ~ShmStatsPage() = default;
+
+            ShmStatsPage(const ShmStatsPage&) = delete;
+            ShmStatsPage& operator=(const ShmStatsPage&) = delete;
+            ShmStatsPage(ShmStatsPage&&) = delete;
+            ShmStatsPage& operator=(ShmStatsPage&&) = delete;
+
+            static constexpr std::size_t required_size() noexcept { return Page::required_size(1); }
+
+            // publisher side, lays out the page at offset and claims its writer
+            [[nodiscard]] shm::ShmResult create(shm::Shm& shm, std::size_t offset = 0) noexcept {
+                const auto res = m_page.create(shm, 1, offset);
+                if (!res.ok()) return res;
+                m_writer = m_page.make_writer();
+                if (!m_writer.has_value()) return { shm::ShmErr::UnknownError, shm::ShmOp::Create };
+                return res;
+            }
+
+            // reader side, any number of processes
+            [[nodiscard]] shm::ShmResult attach(shm::Shm& shm, std::size_t offset = 0) noexcept {
+                return m_page.attach(shm, offset);
+            }
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_page.is_valid(); }
+            [[nodiscard]] bool is_publisher() const noexcept { return m_writer.has_value(); }
+
+            // number of publishes so far, lets a reader skip unchanged pages
+            [[nodiscard]] std::uint64_t version() const noexcept { return m_page.version(0); }
+
+            // takes a fresh snapshot of this process and publishes it, false
+            // when this page was attached rather than created
+            bool publish() noexcept {
+                if (!m_writer.has_value()) return false;
+                snapshot(m_scratch);
+                m_writer->publish(m_scratch);
+                return true;
+            }
+
+            // copies the latest published page, false if not attached
+            [[nodiscard]] bool read(MetricsSnapshot& out) const noexcept {
+                const auto reader = m_page.make_reader();
+                if (!reader.has_value()) return false;
+                return reader->read(out);
+            }
+    };
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #define MOO_HAS_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+    #define MOO_HAS_RDTSC 1
+#endif
+
+namespace instr {
+    // cheapest timestamp available, rdtsc on x86 (~20 cycles, no serialization
+    // so a measurement can be off by a few instructions either way). Elsewhere
+    // falls back to steady_clock which is clock_gettime/QueryPerformanceCounter.
+    // ticks are only comparable on one machine, ns_per_tick() converts them
+    inline std::uint64_t ticks() noexcept {
+        #if defined(MOO_HAS_RDTSC)
+            return static_cast<std::uint64_t>(__rdtsc());
+        #else
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        #endif
+    }
+
+    // measured against steady_clock once on first call (blocks ~10ms),
+    // call it at startup rather than from a hot path
+    [[nodiscard]] double ns_per_tick() noexcept;
+}
@@ -0,0 +1,276 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "msg/ring_buffer.h"
+#include "msg/wait_strategy.h"
+
+namespace msg {
+    // Lock free bounded multiple producer multiple consumer queue (Vyukov style,
+    // one sequence number per slot so producers and consumers only contend on
+    // their own position counter)
+    // NOTE: Producer and Consumer must not outlive MPMCQueue instance
+    // Wait picks how pop_wait() idles, see wait_strategy.h
+    template <typename T, std::size_t NumSlots = 1024, typename Wait = BusySpinWait>
+    class MPMCQueue {
+        static_assert((NumSlots & (NumSlots-1)) == 0, "MPMCQueue size must be a power of 2 (or dynamic_slots) for efficient modulo operation");
+        static_assert(std::is_trivially_copyable_v<T>, "MPMCQueue only supports trivially copyable types");
+
+        private:
+            struct Cell {
+                std::atomic<std::uint64_t> seq{0};
+                T value{};
+            };
+
+            detail::RingBuffer<Cell, NumSlots> m_buffer{};
+            alignas(64) std::atomic<std::uint64_t> m_enqueue_pos{0};
+            alignas(64) std::atomic<std::uint64_t> m_dequeue_pos{0};
+            alignas(64) Wait m_wait{};
+
+            std::size_t to_index(std::uint64_t i) const noexcept { return static_cast<std::size_t>(i) & m_buffer.mask(); }
+
+            static std::int64_t seq_diff(std::uint64_t seq, std::uint64_t expected) noexcept {
+                return static_cast<std::int64_t>(seq - expected);
+            }
+
+            void init_cells() noexcept {
+                if (!m_buffer.is_valid()) return;
+                for (std::size_t i = 0; i < capacity(); ++i) {
+                    m_buffer[i].seq.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            // claims up to n consecutive positions for producers (Offset 0) or
+            // consumers (Offset 1) with a single CAS, returns the count claimed
+            // and the first claimed position in out_pos
+            template <std::uint64_t Offset>
+            std::size_t claim(std::atomic<std::uint64_t>& position, std::size_t n, std::uint64_t& out_pos) noexcept {
+                auto pos = position.load(std::memory_order_relaxed);
+                while (true) {
+                    std::size_t count = 0;
+                    while (count < n) {
+                        const auto seq = m_buffer[to_index(pos + count)].seq.load(std::memory_order_acquire);
+                        if (seq_diff(seq, pos + count + Offset) != 0) break;
+                        ++count;
+                    }
+
+                    if (count == 0) {
+                        const auto seq = m_buffer[to_index(pos)].seq.load(std::memory_order_acquire);
+                        if (seq_diff(seq, pos + Offset) < 0) {
+                            return 0; // full (producers) or empty (consumers)
+                        }
+                        pos = position.load(std::memory_order_relaxed); // someone else got it
+                        continue;
+                    }
+
+                    if (position.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                        out_pos = pos;
+                        return count;
+                    }
+                }
+            }
+
+            [[nodiscard]] std::size_t push_n_impl(const T* items, std::size_t n) noexcept {
+                std::uint64_t pos = 0;
+                const auto count = claim<0>(m_enqueue_pos, n, pos);
+                for (std::size_t i = 0; i < count; ++i) {
+                    auto& cell = m_buffer[to_index(pos + i)];
+                    cell.value = items[i];
+                    cell.seq.store(pos + i + 1, std::memory_order_release);
+                }
+
+                if (count != 0) m_wait.notify();
+                return count;
+            }
+
+            [[nodiscard]] std::size_t try_pop_n_impl(T* out, std::size_t max) noexcept {
+                std::uint64_t pos = 0;
+                const auto count = claim<1>(m_dequeue_pos, max, pos);
+                for (std::size_t i = 0; i < count; ++i) {
+                    auto& cell = m_buffer[to_index(pos + i)];
+                    out[i] = cell.value;
+                    cell.seq.store(pos + i + capacity(), std::memory_order_release);
+                }
+                return count;
+            }
+
+            [[nodiscard]] bool readable() const noexcept {
+                const auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                const auto seq = m_buffer[to_index(pos)].seq.load(std::memory_order_acquire);
+                return seq_diff(seq, pos + 1) >= 0;
+            }
+
+            [[nodiscard]] std::size_t count_snapshot_impl() const noexcept {
+                const auto tail = m_dequeue_pos.load(std::memory_order_acquire);
+                const auto head = m_enqueue_pos.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::int64_t>(head - tail);
+                if (diff <= 0) return 0;
+                if (static_cast<std::size_t>(diff) > capacity()) {
+                    return capacity(); // overflow
+                }
+                return static_cast<std::size_t>(diff);
+            }
+
+        public:
+            MPMCQueue() { init_cells(); }
+            ~MPMCQueue() = default;
+
+            // runtime sized queue (NumSlots == dynamic_slots), capacity must be a power of 2,
+            // check is_valid() before use since the ring allocation can fail
+            explicit MPMCQueue(std::size_t capacity, bool hugepages = false) : m_buffer(capacity, hugepages) {
+                static_assert(NumSlots == dynamic_slots, "MPMCQueue capacity is fixed at compile time, use dynamic_slots");
+                init_cells();
+            }
+
+            MPMCQueue(const MPMCQueue&) = delete;
+            MPMCQueue& operator=(const MPMCQueue&) = delete;
+            MPMCQueue(MPMCQueue&&) = delete;
+            MPMCQueue& operator=(MPMCQueue&&) = delete;
+
+            class Producer {
+                private:
+                    MPMCQueue* m_queue = nullptr;
+
+                public:
+                    explicit Producer(MPMCQueue& q) noexcept : m_queue(&q) {}
+                    ~Producer() = default;
+
+                    Producer(const Producer&) = delete;
+                    Producer& operator=(const Producer&) = delete;
+
+                    Producer(Producer&& other) noexcept : m_queue(other.m_queue) {
+                        other.m_queue = nullptr;
+                    }
+
+                    Producer& operator=(Producer&& other) noexcept {
+                        if (this != &other) {
+                            m_queue = other.m_queue;
+                            other.m_queue = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    [[nodiscard]] bool push(const T& item) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        return m_queue->push_n_impl(&item, 1) == 1;
+                    }
+
+                    // claims up to n slots with one CAS, returns how many were pushed
+                    [[nodiscard]] std::size_t push_n(const T* items, std::size_t n) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        assert((items != nullptr || n == 0) && "Invalid producer: items is null");
+                        return m_queue->push_n_impl(items, n);
+                    }
+
+                    // span-style overload for any contiguous container of T (array, vector, ...)
+                    template <typename Container, typename = std::enable_if_t<
+                        std::is_convertible_v<decltype(std::data(std::declval<const Container&>())), const T*>>>
+                    [[nodiscard]] std::size_t push_n(const Container& items) noexcept {
+                        return push_n(std::data(items), std::size(items));
+                    }
+
+                    std::size_t count_snapshot() const noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        return m_queue->count_snapshot_impl();
+                    }
+            };
+
+            class Consumer {
+                private:
+                    MPMCQueue* m_queue = nullptr;
+
+                public:
+                    explicit Consumer(MPMCQueue& q) noexcept : m_queue(&q) {}
+                    ~Consumer() = default;
+
+                    Consumer(const Consumer&) = delete;
+                    Consumer& operator=(const Consumer&) = delete;
+
+                    Consumer(Consumer&& other) noexcept : m_queue(other.m_queue) {
+                        other.m_queue = nullptr;
+                    }
+
+                    Consumer& operator=(Consumer&& other) noexcept {
+                        if (this != &other) {
+                            m_queue = other.m_queue;
+                            other.m_queue = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    std::optional<T> pop() noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        T out{};
+                        if (m_queue->try_pop_n_impl(&out, 1) == 0) return std::nullopt;
+                        return out;
+                    }
+
+                    [[nodiscard]] bool try_pop(T& out) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        return m_queue->try_pop_n_impl(&out, 1) == 1;
+                    }
+
+                    // claims up to max slots with one CAS, returns how many were popped
+                    [[nodiscard]] std::size_t try_pop_n(T* out, std::size_t max) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        assert((out != nullptr || max == 0) && "Invalid consumer: out is null");
+                        return m_queue->try_pop_n_impl(out, max);
+                    }
+
+                    // span-style overload for any contiguous container of T (array, vector, ...)
+                    template <typename Container, typename = std::enable_if_t<
+                        std::is_convertible_v<decltype(std::data(std::declval<Container&>())), T*>>>
+                    [[nodiscard]] std::size_t try_pop_n(Container& out) noexcept {
+                        return try_pop_n(std::data(out), std::size(out));
+                    }
+
+                    // pops one item, idling with the queues Wait strategy while empty.
+                    // timeout_us of 0 waits forever, returns false on timeout
+                    [[nodiscard]] bool pop_wait(T& out, std::uint32_t timeout_us = 0) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& q = *m_queue;
+                        const detail::Deadline deadline(timeout_us);
+                        while (true) {
+                            if (q.try_pop_n_impl(&out, 1) == 1) return true;
+
+                            // another consumer may win the item we were woken for, so loop
+                            std::uint32_t wait_us = 0;
+                            if (timeout_us != 0) {
+                                if (deadline.expired()) return false;
+                                wait_us = static_cast<std::uint32_t>(deadline.remaining_ns() / 1000u);
+                                if (wait_us == 0) wait_us = 1;
+                            }
+                            if (!q.m_wait.wait([&q]() noexcept { return q.readable(); }, wait_us)) return false;
+                        }
+                    }
+
+                    std::size_t count_snapshot() const noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        return m_queue->count_snapshot_impl();
+                    }
+            };
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_buffer.is_valid(); }
+            [[nodiscard]] std::size_t capacity() const noexcept { return m_buffer.capacity(); }
+
+            // any number of producers may be made
+            [[nodiscard]] std::optional<Producer> make_producer() noexcept {
+                if (!is_valid()) return std::nullopt;
+                return Producer(*this);
+            }
+
+            // any number of consumers may be made, each item goes to exactly one of them
+            [[nodiscard]] std::optional<Consumer> make_consumer() noexcept {
+                if (!is_valid()) return std::nullopt;
+                return Consumer(*this);
+            }
+    };
+
+    // MPMCQueue with its capacity chosen at construction, ring lives on the heap
+    template <typename T, typename Wait = BusySpinWait>
+    using DynMPMCQueue = MPMCQueue<T, dynamic_slots, Wait>;
+}
@@ -0,0 +1,283 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "msg/ring_buffer.h"
+#include "msg/wait_strategy.h"
+
+namespace msg {
+    // Lock free bounded multiple producer single consumer queue (Vyukov style,
+    // one sequence number per slot, producers contend on one CAS per push or
+    // batch, the consumer side never needs a CAS)
+    // NOTE: Producer and Consumer must not outlive MPSCQueue instance
+    // Wait picks how pop_wait() idles, see wait_strategy.h
+    template <typename T, std::size_t NumSlots = 1024, typename Wait = BusySpinWait>
+    class MPSCQueue {
+        static_assert((NumSlots & (NumSlots-1)) == 0, "MPSCQueue size must be a power of 2 (or dynamic_slots) for efficient modulo operation");
+        static_assert(std::is_trivially_copyable_v<T>, "MPSCQueue only supports trivially copyable types");
+
+        private:
+            struct Cell {
+                std::atomic<std::uint64_t> seq{0};
+                T value{};
+            };
+
+            detail::RingBuffer<Cell, NumSlots> m_buffer{};
+            alignas(64) std::atomic<std::uint64_t> m_enqueue_pos{0};
+            alignas(64) std::atomic<std::uint64_t> m_dequeue_pos{0}; // written by the consumer only
+            alignas(64) Wait m_wait{};
+            std::atomic<bool> m_consumer_claimed{false};
+
+            std::size_t to_index(std::uint64_t i) const noexcept { return static_cast<std::size_t>(i) & m_buffer.mask(); }
+
+            static std::int64_t seq_diff(std::uint64_t seq, std::uint64_t expected) noexcept {
+                return static_cast<std::int64_t>(seq - expected);
+            }
+
+            void init_cells() noexcept {
+                if (!m_buffer.is_valid()) return;
+                for (std::size_t i = 0; i < capacity(); ++i) {
+                    m_buffer[i].seq.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            // claims up to n consecutive positions for producers with a single CAS,
+            // returns the count claimed and the first claimed position in out_pos
+            std::size_t claim(std::atomic<std::uint64_t>& position, std::size_t n, std::uint64_t& out_pos) noexcept {
+                auto pos = position.load(std::memory_order_relaxed);
+                while (true) {
+                    std::size_t count = 0;
+                    while (count < n) {
+                        const auto seq = m_buffer[to_index(pos + count)].seq.load(std::memory_order_acquire);
+                        if (seq_diff(seq, pos + count) != 0) break;
+                        ++count;
+                    }
+
+                    if (count == 0) {
+                        const auto seq = m_buffer[to_index(pos)].seq.load(std::memory_order_acquire);
+                        if (seq_diff(seq, pos) < 0) {
+                            return 0; // full
+                        }
+                        pos = position.load(std::memory_order_relaxed); // someone else got it
+                        continue;
+                    }
+
+                    if (position.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                        out_pos = pos;
+                        return count;
+                    }
+                }
+            }
+
+            [[nodiscard]] std::size_t push_n_impl(const T* items, std::size_t n) noexcept {
+                std::uint64_t pos = 0;
+                const auto count = claim(m_enqueue_pos, n, pos);
+                for (std::size_t i = 0; i < count; ++i) {
+                    auto& cell = m_buffer[to_index(pos + i)];
+                    cell.value = items[i];
+                    cell.seq.store(pos + i + 1, std::memory_order_release);
+                }
+
+                if (count != 0) m_wait.notify();
+                return count;
+            }
+
+            [[nodiscard]] std::size_t try_pop_n_impl(T* out, std::size_t max) noexcept {
+                // single consumer, just walk forward while slots are published
+                const auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                std::size_t count = 0;
+                while (count < max) {
+                    auto& cell = m_buffer[to_index(pos + count)];
+                    if (seq_diff(cell.seq.load(std::memory_order_acquire), pos + count + 1) != 0) break;
+
+                    out[count] = cell.value;
+                    cell.seq.store(pos + count + capacity(), std::memory_order_release);
+                    ++count;
+                }
+
+                if (count != 0) m_dequeue_pos.store(pos + count, std::memory_order_relaxed);
+                return count;
+            }
+
+            [[nodiscard]] bool readable() const noexcept {
+                const auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                const auto seq = m_buffer[to_index(pos)].seq.load(std::memory_order_acquire);
+                return seq_diff(seq, pos + 1) >= 0;
+            }
+
+            [[nodiscard]] std::size_t count_snapshot_impl() const noexcept {
+                const auto tail = m_dequeue_pos.load(std::memory_order_acquire);
+                const auto head = m_enqueue_pos.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::int64_t>(head - tail);
+                if (diff <= 0) return 0;
+                if (static_cast<std::size_t>(diff) > capacity()) {
+                    return capacity(); // overflow
+                }
+                return static_cast<std::size_t>(diff);
+            }
+
+        public:
+            MPSCQueue() { init_cells(); }
+            ~MPSCQueue() = default;
+
+            // runtime sized queue (NumSlots == dynamic_slots), capacity must be a power of 2,
+            // check is_valid() before use since the ring allocation can fail
+            explicit MPSCQueue(std::size_t capacity, bool hugepages = false) : m_buffer(capacity, hugepages) {
+                static_assert(NumSlots == dynamic_slots, "MPSCQueue capacity is fixed at compile time, use dynamic_slots");
+                init_cells();
+            }
+
+            MPSCQueue(const MPSCQueue&) = delete;
+            MPSCQueue& operator=(const MPSCQueue&) = delete;
+            MPSCQueue(MPSCQueue&&) = delete;
+            MPSCQueue& operator=(MPSCQueue&&) = delete;
+
+            class Producer {
+                private:
+                    MPSCQueue* m_queue = nullptr;
+
+                public:
+                    explicit Producer(MPSCQueue& q) noexcept : m_queue(&q) {}
+                    ~Producer() = default;
+
+                    Producer(const Producer&) = delete;
+                    Producer& operator=(const Producer&) = delete;
+
+                    Producer(Producer&& other) noexcept : m_queue(other.m_queue) {
+                        other.m_queue = nullptr;
+                    }
+
+                    Producer& operator=(Producer&& other) noexcept {
+                        if (this != &other) {
+                            m_queue = other.m_queue;
+                            other.m_queue = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    [[nodiscard]] bool push(const T& item) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        return m_queue->push_n_impl(&item, 1) == 1;
+                    }
+
+                    // claims up to n slots with one CAS, returns how many were pushed
+                    [[nodiscard]] std::size_t push_n(const T* items, std::size_t n) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        assert((items != nullptr || n == 0) && "Invalid producer: items is null");
+                        return m_queue->push_n_impl(items, n);
+                    }
+
+                    // span-style overload for any contiguous container of T (array, vector, ...)
+                    template <typename Container, typename = std::enable_if_t<
+                        std::is_convertible_v<decltype(std::data(std::declval<const Container&>())), const T*>>>
+                    [[nodiscard]] std::size_t push_n(const Container& items) noexcept {
+                        return push_n(std::data(items), std::size(items));
+                    }
+
+                    std::size_t count_snapshot() const noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        return m_queue->count_snapshot_impl();
+                    }
+            };
+
+            class Consumer {
+                private:
+                    MPSCQueue* m_queue = nullptr;
+
+                public:
+                    explicit Consumer(MPSCQueue& q) noexcept : m_queue(&q) {}
+
+                    ~Consumer() {
+                        if (m_queue != nullptr) {
+                            m_queue->m_consumer_claimed.store(false, std::memory_order_release);
+                        }
+                    }
+
+                    Consumer(const Consumer&) = delete;
+                    Consumer& operator=(const Consumer&) = delete;
+
+                    Consumer(Consumer&& other) noexcept : m_queue(other.m_queue) {
+                        other.m_queue = nullptr;
+                    }
+
+                    Consumer& operator=(Consumer&& other) noexcept {
+                        if (this != &other) {
+                            if (m_queue) {
+                                m_queue->m_consumer_claimed.store(false, std::memory_order_release);
+                            }
+                            m_queue = other.m_queue;
+                            other.m_queue = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    std::optional<T> pop() noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        T out{};
+                        if (m_queue->try_pop_n_impl(&out, 1) == 0) return std::nullopt;
+                        return out;
+                    }
+
+                    [[nodiscard]] bool try_pop(T& out) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        return m_queue->try_pop_n_impl(&out, 1) == 1;
+                    }
+
+                    // pops up to max items, returns how many were popped
+                    [[nodiscard]] std::size_t try_pop_n(T* out, std::size_t max) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        assert((out != nullptr || max == 0) && "Invalid consumer: out is null");
+                        return m_queue->try_pop_n_impl(out, max);
+                    }
+
+                    // span-style overload for any contiguous container of T (array, vector, ...)
+                    template <typename Container, typename = std::enable_if_t<
+                        std::is_convertible_v<decltype(std::data(std::declval<Container&>())), T*>>>
+                    [[nodiscard]] std::size_t try_pop_n(Container& out) noexcept {
+                        return try_pop_n(std::data(out), std::size(out));
+                    }
+
+                    // pops one item, idling with the queues Wait strategy while empty.
+                    // timeout_us of 0 waits forever, returns false on timeout
+                    [[nodiscard]] bool pop_wait(T& out, std::uint32_t timeout_us = 0) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& q = *m_queue;
+                        if (q.try_pop_n_impl(&out, 1) == 1) return true;
+                        if (!q.m_wait.wait([&q]() noexcept { return q.readable(); }, timeout_us)) return false;
+                        return q.try_pop_n_impl(&out, 1) == 1;
+                    }
+
+                    std::size_t count_snapshot() const noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        return m_queue->count_snapshot_impl();
+                    }
+            };
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_buffer.is_valid(); }
+            [[nodiscard]] std::size_t capacity() const noexcept { return m_buffer.capacity(); }
+
+            // any number of producers may be made
+            [[nodiscard]] std::optional<Producer> make_producer() noexcept {
+                if (!is_valid()) return std::nullopt;
+                return Producer(*this);
+            }
+
+            [[nodiscard]] std::optional<Consumer> make_consumer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
+                bool expected = false;
+                if (!m_consumer_claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                    return std::nullopt;
+                }
+                return Consumer(*this);
+            }
+    };
+
+    // MPSCQueue with its capacity chosen at construction, ring lives on the heap
+    template <typename T, typename Wait = BusySpinWait>
+    using DynMPSCQueue = MPSCQueue<T, dynamic_slots, Wait>;
+}
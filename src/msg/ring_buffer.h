@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include "platform/memory.h"
+
+namespace msg {
+    // pass as NumSlots to size a queue at construction instead of compile time
+    constexpr std::size_t dynamic_slots = 0;
+
+    namespace detail {
+        constexpr std::size_t cache_line = 64;
+
+        // Ring storage for the queues, inline std::array when the size is known
+        // at compile time
+        template <typename T, std::size_t NumSlots>
+        class RingBuffer {
+            private:
+                std::array<T, NumSlots> m_data{};
+
+            public:
+                RingBuffer() = default;
+
+                static constexpr std::size_t capacity() noexcept { return NumSlots; }
+                static constexpr std::size_t mask() noexcept { return NumSlots - 1; }
+                constexpr bool is_valid() const noexcept { return true; }
+
+                T& operator[](std::size_t i) noexcept { return m_data[i]; }
+                const T& operator[](std::size_t i) const noexcept { return m_data[i]; }
+        };
+
+        // Heap storage for runtime sized queues, 64-byte aligned and optionally
+        // backed by 2MB huge pages (falls back to normal pages if unavailable)
+        template <typename T>
+        class RingBuffer<T, dynamic_slots> {
+            private:
+                T* m_data = nullptr;
+                std::size_t m_capacity = 0;
+                std::size_t m_bytes = 0;
+                bool m_huge = false;
+
+            public:
+                RingBuffer() = default;
+
+                RingBuffer(std::size_t capacity, bool hugepages) {
+                    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+                        return; // not a power of 2, leave invalid
+                    }
+
+                    m_bytes = capacity * sizeof(T);
+                    void* mem = nullptr;
+                    if (hugepages) {
+                        mem = plat::alloc_huge(m_bytes);
+                        m_huge = mem != nullptr;
+                    }
+
+                    if (mem == nullptr) {
+                        mem = ::operator new(m_bytes, std::align_val_t{ cache_line }, std::nothrow);
+                        if (mem == nullptr) return;
+                    }
+
+                    m_data = static_cast<T*>(mem);
+                    for (std::size_t i = 0; i < capacity; ++i) {
+                        new (&m_data[i]) T{};
+                    }
+                    m_capacity = capacity;
+                }
+
+                ~RingBuffer() {
+                    if (m_data == nullptr) return;
+
+                    if (m_huge) {
+                        plat::free_huge(m_data, m_bytes);
+                    } else {
+                        ::operator delete(m_data, std::align_val_t{ cache_line });
+                    }
+                    m_data = nullptr;
+                }
+
+                RingBuffer(const RingBuffer&) = delete;
+                RingBuffer& operator=(const RingBuffer&) = delete;
+                RingBuffer(RingBuffer&&) = delete;
+                RingBuffer& operator=(RingBuffer&&) = delete;
+
+                std::size_t capacity() const noexcept { return m_capacity; }
+                std::size_t mask() const noexcept { return m_capacity - 1; }
+                bool is_valid() const noexcept { return m_data != nullptr; }
+
+                T& operator[](std::size_t i) noexcept { return m_data[i]; }
+                const T& operator[](std::size_t i) const noexcept { return m_data[i]; }
+        };
+    }
+}
@@ -0,0 +1,316 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include "msg/span.h"
+
+// Describes the wire/shm layout of a plain struct so it can be checked at
+// compile time and fingerprinted. Put it at namespace scope right after the
+// struct, in the same namespace (found by ADL):
+//
+//     struct Quote {
+//         std::uint64_t ts;
+//         double px;
+//         std::uint32_t qty;
+//         std::uint32_t pad;  // padding must be spelled out
+//     };
+//     MOO_SCHEMA(Quote, 1,
+//         MOO_FIELD(Quote, ts),
+//         MOO_FIELD(Quote, px),
+//         MOO_FIELD(Quote, qty),
+//         MOO_FIELD(Quote, pad));
+//
+// Fields are listed in declaration order and must cover every byte of the
+// struct, so two builds that both compile agree on the layout. Bump the
+// version when the meaning of a field changes without its layout changing
+#define MOO_FIELD(Type, member) \
+    ::msg::Field<&Type::member, offsetof(Type, member), ::msg::detail::fnv1a(#member)>
+
+#define MOO_SCHEMA(Type, Version, ...)                                                          \
+    [[maybe_unused]] constexpr auto moo_schema_of(const Type*) noexcept {                       \
+        return ::msg::Schema<Type, Version, ::msg::detail::fnv1a(#Type), __VA_ARGS__>{ #Type }; \
+    }
+
+namespace msg {
+    namespace detail {
+        constexpr std::uint64_t fnv_offset = 0xCBF29CE484222325ull;
+        constexpr std::uint64_t fnv_prime = 0x100000001B3ull;
+
+        constexpr std::uint64_t fnv1a(const char* s, std::uint64_t h = fnv_offset) noexcept {
+            for (; *s != '\0'; ++s) {
+                h ^= static_cast<unsigned char>(*s);
+                h *= fnv_prime;
+            }
+            return h;
+        }
+
+        // folds v into h a byte at a time, little end first so the hash is
+        // the same whatever the host byte order is
+        constexpr std::uint64_t mix(std::uint64_t h, std::uint64_t v) noexcept {
+            for (int i = 0; i < 8; ++i) {
+                h ^= (v >> (i * 8)) & 0xFFu;
+                h *= fnv_prime;
+            }
+            return h;
+        }
+
+        #if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            constexpr std::uint64_t host_endian = 2;
+        #else
+            constexpr std::uint64_t host_endian = 1;
+        #endif
+
+        template <typename M>
+        struct member_traits;
+
+        template <typename C, typename F>
+        struct member_traits<F C::*> {
+            using owner = C;
+            using type = F;
+        };
+
+        template <typename T, typename = void>
+        struct has_schema : std::false_type {};
+
+        template <typename T>
+        struct has_schema<T, std::void_t<decltype(moo_schema_of(static_cast<const T*>(nullptr)))>> : std::true_type {};
+    }
+
+    template <typename T>
+    inline constexpr bool has_schema_v = detail::has_schema<T>::value;
+
+    template <typename T>
+    using schema_t = decltype(moo_schema_of(static_cast<const T*>(nullptr)));
+
+    // 64 bit fingerprint of T's layout: name, version, size, alignment, byte
+    // order and every field's name, offset, size and type. 0 for types that
+    // have no MOO_SCHEMA, those only get the size/alignment checks
+    template <typename T>
+    [[nodiscard]] constexpr std::uint64_t schema_hash() noexcept {
+        if constexpr (has_schema_v<T>) return schema_t<T>::hash;
+        else return 0;
+    }
+
+    namespace detail {
+        // what kind of value a field holds, nested schema types contribute
+        // their own hash so a change anywhere below shows up at the top
+        template <typename F>
+        constexpr std::uint64_t type_code() noexcept {
+            if constexpr (std::is_array_v<F>) {
+                return mix(mix(6, type_code<std::remove_extent_t<F>>()), std::extent_v<F>);
+            } else if constexpr (std::is_enum_v<F>) {
+                return type_code<std::underlying_type_t<F>>();
+            } else if constexpr (std::is_same_v<F, bool>) {
+                return 1;
+            } else if constexpr (std::is_integral_v<F>) {
+                return (std::is_signed_v<F> ? 2u << 8 : 3u << 8) | sizeof(F);
+            } else if constexpr (std::is_floating_point_v<F>) {
+                return (4u << 8) | sizeof(F);
+            } else if constexpr (has_schema_v<F>) {
+                return schema_hash<F>();
+            } else {
+                return mix((5u << 8) | sizeof(F), alignof(F)); // opaque bytes
+            }
+        }
+    }
+
+    // one described member, made by MOO_FIELD
+    template <auto Member, std::size_t Offset, std::uint64_t NameHash>
+    struct Field {
+        using owner = typename detail::member_traits<decltype(Member)>::owner;
+        using type = typename detail::member_traits<decltype(Member)>::type;
+
+        static constexpr auto member = Member;
+        static constexpr std::size_t offset = Offset;
+        static constexpr std::size_t size = sizeof(type);
+        static constexpr std::size_t align = alignof(type);
+        static constexpr std::uint64_t name_hash = NameHash;
+        static constexpr std::uint64_t type_code = detail::type_code<type>();
+    };
+
+    namespace detail {
+        // declaration order, no overlap, no gaps, nothing past the end
+        template <typename T, typename... Fields>
+        constexpr bool covers_exactly() noexcept {
+            constexpr std::size_t offsets[] = { Fields::offset... };
+            constexpr std::size_t sizes[] = { Fields::size... };
+            std::size_t pos = 0;
+            for (std::size_t i = 0; i < sizeof...(Fields); ++i) {
+                if (offsets[i] != pos) return false;
+                pos += sizes[i];
+            }
+            return pos == sizeof(T);
+        }
+
+        template <typename T, std::uint32_t Version, std::uint64_t NameHash, typename... Fields>
+        constexpr std::uint64_t layout_hash() noexcept {
+            std::uint64_t h = mix(fnv_offset, NameHash);
+            h = mix(h, Version);
+            h = mix(h, sizeof(T));
+            h = mix(h, alignof(T));
+            h = mix(h, host_endian);
+            ((h = mix(mix(mix(mix(h, Fields::name_hash), Fields::offset), Fields::size), Fields::type_code)), ...);
+            return h == 0 ? 1 : h; // 0 is "no schema"
+        }
+    }
+
+    // compile time description of T made by MOO_SCHEMA, all the layout
+    // rules are static_asserts so a bad description does not build
+    template <typename T, std::uint32_t Version, std::uint64_t NameHash, typename... Fields>
+    struct Schema {
+        static_assert(sizeof...(Fields) > 0, "MOO_SCHEMA needs at least one field");
+        static_assert(std::is_trivially_copyable_v<T>, "schema types must be trivially copyable");
+        static_assert(std::is_standard_layout_v<T>, "schema types must be standard layout");
+        static_assert((std::is_same_v<typename Fields::owner, T> && ...), "MOO_FIELD names a member of another type");
+        static_assert(((Fields::offset % Fields::align == 0) && ...), "schema field is not naturally aligned");
+        static_assert(detail::covers_exactly<T, Fields...>(), "schema fields must be listed in declaration order and cover every byte of the type, add explicit padding fields");
+
+        using type = T;
+        using fields = std::tuple<Fields...>;
+
+        static constexpr std::uint32_t version = Version;
+        static constexpr std::size_t field_count = sizeof...(Fields);
+        static constexpr std::uint64_t hash = detail::layout_hash<T, Version, NameHash, Fields...>();
+
+        const char* name;
+    };
+
+    template <typename T>
+    [[nodiscard]] constexpr const char* schema_name() noexcept {
+        return moo_schema_of(static_cast<const T*>(nullptr)).name;
+    }
+
+    namespace detail {
+        template <auto A, auto B>
+        constexpr bool same_member() noexcept {
+            if constexpr (std::is_same_v<decltype(A), decltype(B)>) return A == B;
+            else return false;
+        }
+
+        template <auto M, typename Tuple, std::size_t I = 0>
+        constexpr std::size_t field_index() noexcept {
+            if constexpr (I == std::tuple_size_v<Tuple>) {
+                return I;
+            } else if constexpr (same_member<std::tuple_element_t<I, Tuple>::member, M>()) {
+                return I;
+            } else {
+                return field_index<M, Tuple, I + 1>();
+            }
+        }
+    }
+
+    // the Field describing member M of T
+    template <typename T, auto M>
+    struct field_of {
+        using fields = typename schema_t<T>::fields;
+        static constexpr std::size_t index = detail::field_index<M, fields>();
+        static_assert(index < std::tuple_size_v<fields>, "member is not part of the schema");
+        using type = std::tuple_element_t<index, fields>;
+    };
+
+    template <typename T, auto M>
+    using field_t = typename field_of<T, M>::type;
+
+    // Flyweight read access to a T laid out in someone else's memory (a ring
+    // slot, a socket recv buffer, a mapped file) without copying the record
+    // out first. Each get() is a fixed size memcpy from a compile time offset
+    // so it is a single load and the buffer does not need to be aligned.
+    // NOTE: the view must not outlive the bytes it points at
+    template <typename T>
+    class View {
+        static_assert(has_schema_v<T>, "View needs a MOO_SCHEMA for T");
+
+        private:
+            const std::byte* m_data = nullptr;
+
+        public:
+            View() = default;
+            explicit View(const T& rec) noexcept : m_data(reinterpret_cast<const std::byte*>(&rec)) {}
+
+            // invalid view when size is too short to hold a T
+            View(const void* data, std::size_t size) noexcept
+                : m_data(data != nullptr && size >= sizeof(T) ? static_cast<const std::byte*>(data) : nullptr) {}
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_data != nullptr; }
+            [[nodiscard]] const std::byte* data() const noexcept { return m_data; }
+            static constexpr std::size_t size() noexcept { return sizeof(T); }
+
+            template <auto M>
+            [[nodiscard]] auto get() const noexcept {
+                using F = field_t<T, M>;
+                static_assert(!std::is_array_v<typename F::type>, "array fields are read with bytes()");
+                assert(m_data != nullptr && "Invalid view: data is null");
+                typename F::type out;
+                std::memcpy(&out, m_data + F::offset, F::size);
+                return out;
+            }
+
+            // the raw bytes of a field, for arrays and fixed strings
+            template <auto M>
+            [[nodiscard]] Span<const std::byte> bytes() const noexcept {
+                using F = field_t<T, M>;
+                assert(m_data != nullptr && "Invalid view: data is null");
+                return Span<const std::byte>{ m_data + F::offset, F::size };
+            }
+
+            // view over a nested schema field
+            template <auto M>
+            [[nodiscard]] auto sub() const noexcept {
+                using F = field_t<T, M>;
+                assert(m_data != nullptr && "Invalid view: data is null");
+                return View<typename F::type>(m_data + F::offset, F::size);
+            }
+
+            [[nodiscard]] T copy() const noexcept {
+                assert(m_data != nullptr && "Invalid view: data is null");
+                T out;
+                std::memcpy(&out, m_data, sizeof(T));
+                return out;
+            }
+    };
+
+    // write side of View, fills a record in place (a reserve()d slot, a
+    // send buffer) one field at a time
+    template <typename T>
+    class Writer {
+        static_assert(has_schema_v<T>, "Writer needs a MOO_SCHEMA for T");
+
+        private:
+            std::byte* m_data = nullptr;
+
+        public:
+            Writer() = default;
+            explicit Writer(T& rec) noexcept : m_data(reinterpret_cast<std::byte*>(&rec)) {}
+
+            Writer(void* data, std::size_t size) noexcept
+                : m_data(data != nullptr && size >= sizeof(T) ? static_cast<std::byte*>(data) : nullptr) {}
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_data != nullptr; }
+            [[nodiscard]] std::byte* data() const noexcept { return m_data; }
+            [[nodiscard]] View<T> view() const noexcept { return View<T>(m_data, m_data != nullptr ? sizeof(T) : 0); }
+
+            template <auto M>
+            void set(const typename field_t<T, M>::type& value) noexcept {
+                using F = field_t<T, M>;
+                static_assert(!std::is_array_v<typename F::type>, "array fields are written with bytes()");
+                assert(m_data != nullptr && "Invalid writer: data is null");
+                std::memcpy(m_data + F::offset, &value, F::size);
+            }
+
+            template <auto M>
+            [[nodiscard]] Span<std::byte> bytes() const noexcept {
+                using F = field_t<T, M>;
+                assert(m_data != nullptr && "Invalid writer: data is null");
+                return Span<std::byte>{ m_data + F::offset, F::size };
+            }
+
+            // zeroes the whole record, explicit padding included
+            void clear() noexcept {
+                assert(m_data != nullptr && "Invalid writer: data is null");
+                std::memset(m_data, 0, sizeof(T));
+            }
+    };
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+
+namespace msg {
+    // Minimal contiguous view (C++17 has no std::span), used to hand out
+    // runs of queue slots for in-place reads/writes
+    template <typename T>
+    struct Span {
+        T* ptr = nullptr;
+        std::size_t len = 0;
+
+        T* data() const noexcept { return ptr; }
+        std::size_t size() const noexcept { return len; }
+        bool empty() const noexcept { return len == 0; }
+
+        T& operator[](std::size_t i) const noexcept { return ptr[i]; }
+        T* begin() const noexcept { return ptr; }
+        T* end() const noexcept { return ptr + len; }
+    };
+}
@@ -6,19 +6,40 @@
 #include <type_traits>
 #include <utility>
 #include <cassert>
+#include "msg/span.h"
+#include "msg/ring_buffer.h"
+#include "msg/wait_strategy.h"
+#include "instr/instr.h"
 
 namespace msg {
+    // What an SPMCQueue producer does when the slowest consumer is a full ring behind
+    enum class OverflowPolicy : std::uint8_t {
+        Block = 0,  // push fails until every consumer catches up
+        Lossy,      // push always succeeds, lagging consumers skip ahead and count drops
+    };
+
+    namespace detail {
+        inline std::size_t lowest_bit(std::uint64_t bits) noexcept {
+            #if defined(__GNUC__) || defined(__clang__)
+                return static_cast<std::size_t>(__builtin_ctzll(bits));
+            #else
+                std::size_t i = 0;
+                while ((bits & 1u) == 0) { bits >>= 1; ++i; }
+                return i;
+            #endif
+        }
+    }
+
     // Lock free single producer multiple consumer broadcast queue
     // NOTE: Producer and Consumer must not outlive SPMCQueue instance
-    template <typename T, std::size_t NumSlots = 1024, std::size_t MaxConsumers = 16>
+    // Wait picks how pop_wait() idles, see wait_strategy.h
+    template <typename T, std::size_t NumSlots = 1024, std::size_t MaxConsumers = 16, typename Wait = BusySpinWait>
     class SPMCQueue {
-        static_assert(NumSlots > 0, "SPMCQueue size must be > 0");
-        static_assert((NumSlots & (NumSlots-1)) == 0, "SPMCQueue size must be a power of 2 for efficient modulo operation");
+        static_assert((NumSlots & (NumSlots-1)) == 0, "SPMCQueue size must be a power of 2 (or dynamic_slots) for efficient modulo operation");
         static_assert(std::is_trivially_copyable_v<T>, "SPMCQueue only supports trivially copyable types");
         static_assert(MaxConsumers > 0, "SPMCQueue MaxConsumers must be > 0");
-        
-        static constexpr std::size_t mask = NumSlots - 1;
-        static constexpr std::size_t to_index(std::uint64_t i) noexcept { return static_cast<std::size_t>(i) & mask; }
+
+        static constexpr std::size_t active_words = (MaxConsumers + 63) / 64;
 
         private:
             enum class SlotState : uint8_t {
@@ -30,79 +51,219 @@ namespace msg {
             struct alignas(64) ConsumerSlot  {
                 std::atomic<SlotState> state{SlotState::Free};
                 std::atomic<std::uint64_t> tail{0};
+                alignas(64) std::uint64_t cached_head{0}; // consumer only, last seen m_head
+                std::uint64_t dropped{0};                 // consumer only, lossy mode overruns
             };
 
-            std::array<T, NumSlots> m_buffer{};
+            detail::RingBuffer<T, NumSlots> m_buffer{};
+            // lossy mode only, per slot sequence (position + 1, 0 while being written)
+            detail::RingBuffer<std::atomic<std::uint64_t>, dynamic_slots> m_seqs{};
+            OverflowPolicy m_policy = OverflowPolicy::Block;
+
             alignas(64) std::atomic<std::uint64_t> m_head{0};
+            alignas(64) std::uint64_t m_cached_min_tail{0}; // producer only, last scanned min tail
+            alignas(64) std::array<std::atomic<std::uint64_t>, active_words> m_active{}; // bitmap of Active slots
             std::array<ConsumerSlot , MaxConsumers> m_slots{};
-            std::atomic<bool> m_producer_claimed{false};
+            alignas(64) std::atomic<bool> m_producer_claimed{false};
+            Wait m_wait{};
+
+            std::size_t to_index(std::uint64_t i) const noexcept { return static_cast<std::size_t>(i) & m_buffer.mask(); }
+            bool lossy() const noexcept { return m_policy == OverflowPolicy::Lossy; }
+
+            // number of readable slots as seen by a consumer, only goes to the
+            // producers cache line when the cached head says we are empty
+            [[nodiscard]] std::size_t available_slots(ConsumerSlot& slot, std::uint64_t tail) noexcept {
+                if (slot.cached_head <= tail) {
+                    slot.cached_head = m_head.load(std::memory_order_acquire);
+                    if (slot.cached_head <= tail) return 0;
+                }
+                return static_cast<std::size_t>(slot.cached_head - tail);
+            }
+
+            [[nodiscard]] bool readable(std::size_t idx) noexcept {
+                auto& slot = m_slots[idx];
+                return available_slots(slot, slot.tail.load(std::memory_order_relaxed)) != 0;
+            }
 
+            // only walks slots whose bit is set in the active bitmap
             std::uint64_t min_tail_snapshot(std::uint64_t head) const noexcept {
                 std::uint64_t min_tail = head;
-                bool any = false;
 
-                for (const auto& slot : m_slots) {
-                    if (slot.state.load(std::memory_order_acquire) == SlotState::Active) {
-                        any = true;
-                        const auto t = slot.tail.load(std::memory_order_relaxed);
+                for (std::size_t w = 0; w < active_words; ++w) {
+                    auto bits = m_active[w].load(std::memory_order_acquire);
+                    while (bits != 0) {
+                        const auto i = w * 64 + detail::lowest_bit(bits);
+                        bits &= bits - 1;
+
+                        const auto t = m_slots[i].tail.load(std::memory_order_acquire);
                         if (t < min_tail) min_tail = t;
                     }
                 }
-                return any ? min_tail : head;
+                return min_tail;
+            }
+
+            // number of free slots as seen by the producer, only rescans the consumers
+            // when the cached min tail says we dont have room
+            [[nodiscard]] std::size_t free_slots(std::uint64_t head) noexcept {
+                if (lossy()) return capacity(); // never blocks, just overwrites
+
+                if (head - m_cached_min_tail >= capacity()) {
+                    m_cached_min_tail = min_tail_snapshot(head);
+                }
+                return capacity() - static_cast<std::size_t>(head - m_cached_min_tail);
+            }
+
+            // lossy mode wraps writes with the slots sequence so readers can detect overruns
+            void begin_write(std::uint64_t pos) noexcept {
+                if (!lossy()) return;
+                m_seqs[to_index(pos)].store(0, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            void end_write(std::uint64_t pos) noexcept {
+                if (!lossy()) return;
+                m_seqs[to_index(pos)].store(pos + 1, std::memory_order_release);
             }
 
             [[nodiscard]] bool push_impl(const T& item) noexcept {
                 const auto head = m_head.load(std::memory_order_relaxed);
-                const auto min_tail = min_tail_snapshot(head);
-
-                if (head - min_tail >= NumSlots) {
+                if (free_slots(head) == 0) {
+                    MOO_INSTR_COUNT(instr::Counter::SpmcPushFull, 1);
                     return false; // queue is full
                 }
 
+                begin_write(head);
                 m_buffer[to_index(head)] = item;
+                end_write(head);
                 m_head.store(head + 1, std::memory_order_release);
+                m_wait.notify();
                 return true;
             }
 
             [[nodiscard]] bool push_impl(T&& item) noexcept {
                 const auto head = m_head.load(std::memory_order_relaxed);
-                const auto min_tail = min_tail_snapshot(head);
-
-                if (head - min_tail >= NumSlots) {
+                if (free_slots(head) == 0) {
+                    MOO_INSTR_COUNT(instr::Counter::SpmcPushFull, 1);
                     return false; // queue is full
                 }
 
+                begin_write(head);
                 m_buffer[to_index(head)] = std::move(item);
+                end_write(head);
                 m_head.store(head + 1, std::memory_order_release);
+                m_wait.notify();
                 return true;
             }
 
-            [[nodiscard]] std::optional<T> pop_impl(std::size_t idx) noexcept {
-                const auto head = m_head.load(std::memory_order_acquire);
-                const auto tail = m_slots[idx].tail.load(std::memory_order_relaxed);
+            [[nodiscard]] Span<T> reserve_impl(std::size_t max) noexcept {
+                const auto head = m_head.load(std::memory_order_relaxed);
+                const auto start = to_index(head);
+                const auto free = free_slots(head);
 
-                if (tail >= head) {
+                // only hand out the run up to the wrap point
+                auto count = max < free ? max : free;
+                if (count > capacity() - start) count = capacity() - start;
+
+                for (std::size_t i = 0; i < count; ++i) begin_write(head + i);
+                return Span<T>{ &m_buffer[start], count };
+            }
+
+            void commit_impl(std::size_t n) noexcept {
+                const auto head = m_head.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < n; ++i) end_write(head + i);
+                m_head.store(head + n, std::memory_order_release);
+                m_wait.notify();
+            }
+
+            [[nodiscard]] Span<const T> front_impl(std::size_t max, std::size_t idx) noexcept {
+                // in place reads cant be checked against the producer lapping us
+                assert(!lossy() && "front() is not available in lossy mode");
+                auto& slot = m_slots[idx];
+                const auto tail = slot.tail.load(std::memory_order_relaxed);
+                const auto start = to_index(tail);
+                const auto available = available_slots(slot, tail);
+
+                // only hand out the run up to the wrap point
+                auto count = max < available ? max : available;
+                if (count > capacity() - start) count = capacity() - start;
+                return Span<const T>{ &m_buffer[start], count };
+            }
+
+            void release_impl(std::size_t n, std::size_t idx) noexcept {
+                auto& slot = m_slots[idx];
+                const auto tail = slot.tail.load(std::memory_order_relaxed);
+                assert(static_cast<std::size_t>(slot.cached_head - tail) >= n && "release() past readable slots");
+                slot.tail.store(tail + n, std::memory_order_release);
+            }
+
+            [[nodiscard]] std::optional<T> pop_impl(std::size_t idx) noexcept {
+                T out{};
+                if (!try_pop_impl(out, idx)) {
                     return std::nullopt; // queue is empty
                 }
-                
-                T out = m_buffer[to_index(tail)];
-                m_slots[idx].tail.store(tail + 1, std::memory_order_release);
                 return out;
             }
 
             [[nodiscard]] bool try_pop_impl(T& out, std::size_t idx) noexcept {
-                const auto head = m_head.load(std::memory_order_acquire);
-                const auto tail = m_slots[idx].tail.load(std::memory_order_relaxed);
-
-                if (tail >= head) {
+                auto& slot = m_slots[idx];
+                const auto tail = slot.tail.load(std::memory_order_relaxed);
+                if (available_slots(slot, tail) == 0) {
+                    MOO_INSTR_COUNT(instr::Counter::SpmcPopEmpty, 1);
                     return false; // queue is empty
                 }
-                
+
+                if (lossy()) return try_pop_lossy(out, slot, tail);
+
                 out = m_buffer[to_index(tail)];
-                m_slots[idx].tail.store(tail + 1, std::memory_order_release);
+                slot.tail.store(tail + 1, std::memory_order_release);
                 return true;
             }
 
+            // seqlock style read, if the producer lapped us skip to the oldest
+            // slot still in the ring and count what we missed
+            [[nodiscard]] bool try_pop_lossy(T& out, ConsumerSlot& slot, std::uint64_t tail) noexcept {
+                while (true) {
+                    const auto i = to_index(tail);
+                    const auto seq = m_seqs[i].load(std::memory_order_acquire);
+                    if (seq == tail + 1) {
+                        out = m_buffer[i];
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (m_seqs[i].load(std::memory_order_relaxed) == seq) {
+                            slot.tail.store(tail + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+
+                    // overrun, resync
+                    const auto head = m_head.load(std::memory_order_acquire);
+                    slot.cached_head = head;
+                    const auto oldest = head > capacity() ? head - capacity() + 1 : 0;
+                    const auto resync = oldest > tail ? oldest : tail + 1;
+                    slot.dropped += resync - tail;
+                    tail = resync;
+
+                    if (tail >= head) {
+                        slot.tail.store(tail, std::memory_order_release);
+                        return false; // nothing left to read
+                    }
+                }
+            }
+
+            void claim_slot(std::size_t idx, std::uint64_t head) noexcept {
+                auto& slot = m_slots[idx];
+                slot.tail.store(head, std::memory_order_relaxed);
+                slot.cached_head = head;
+                slot.dropped = 0;
+                slot.state.store(SlotState::Active, std::memory_order_release);
+                m_active[idx / 64].fetch_or(std::uint64_t{1} << (idx % 64), std::memory_order_acq_rel);
+            }
+
+            void release_slot(std::size_t idx) noexcept {
+                // drop out of the producers scan before the slot can be reused
+                m_active[idx / 64].fetch_and(~(std::uint64_t{1} << (idx % 64)), std::memory_order_acq_rel);
+                m_slots[idx].state.store(SlotState::Free, std::memory_order_release);
+            }
+
             [[nodiscard]] std::optional<T> peek(std::size_t idx) const noexcept {
                 const auto head = m_head.load(std::memory_order_acquire);
                 const auto tail = m_slots[idx].tail.load(std::memory_order_relaxed);
@@ -131,8 +292,8 @@ namespace msg {
                 const auto tail = m_slots[idx].tail.load(std::memory_order_relaxed);
 
                 const auto diff = head - tail;
-                if (diff > NumSlots) { 
-                    return NumSlots; // overflow
+                if (diff > capacity()) { 
+                    return capacity(); // overflow
                 }
                 return static_cast<std::size_t>(diff);
             }
@@ -142,8 +303,8 @@ namespace msg {
                 const auto min_tail = min_tail_snapshot(head);
 
                 const auto diff = head - min_tail;
-                if (diff > NumSlots) { 
-                    return NumSlots; // overflow
+                if (diff > capacity()) { 
+                    return capacity(); // overflow
                 }
                 return static_cast<std::size_t>(diff);
             }
@@ -152,6 +313,18 @@ namespace msg {
             SPMCQueue() = default;
             ~SPMCQueue() = default;
 
+            explicit SPMCQueue(OverflowPolicy policy)
+                : m_seqs(policy == OverflowPolicy::Lossy ? NumSlots : 0, false), m_policy(policy) {
+                static_assert(NumSlots != dynamic_slots, "runtime sized SPMCQueue needs a capacity");
+            }
+
+            // runtime sized queue (NumSlots == dynamic_slots), capacity must be a power of 2,
+            // check is_valid() before use since the ring allocation can fail
+            explicit SPMCQueue(std::size_t capacity, bool hugepages = false, OverflowPolicy policy = OverflowPolicy::Block)
+                : m_buffer(capacity, hugepages), m_seqs(policy == OverflowPolicy::Lossy ? capacity : 0, false), m_policy(policy) {
+                static_assert(NumSlots == dynamic_slots, "SPMCQueue capacity is fixed at compile time, use dynamic_slots");
+            }
+
             SPMCQueue(const SPMCQueue&) = delete;
             SPMCQueue& operator=(const SPMCQueue&) = delete;
             SPMCQueue(SPMCQueue&&) = delete;
@@ -198,6 +371,27 @@ namespace msg {
                         return m_queue->push_impl(std::move(item));
                     }
 
+                    // zero-copy write: returns the next free slot (nullptr when full),
+                    // write into it in place then commit() to publish
+                    [[nodiscard]] T* reserve() noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        const auto run = m_queue->reserve_impl(1);
+                        return run.empty() ? nullptr : run.data();
+                    }
+
+                    // zero-copy write: returns up to max contiguous free slots, the run
+                    // stops at the wrap point so it may be shorter than what is free
+                    [[nodiscard]] Span<T> reserve(std::size_t max) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        return m_queue->reserve_impl(max);
+                    }
+
+                    // publishes n slots previously handed out by reserve()
+                    void commit(std::size_t n = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        m_queue->commit_impl(n);
+                    }
+
                     std::size_t count_snapshot() const noexcept {
                         // returns the number of items in the queue based
                         // on the slowest consumer
@@ -218,8 +412,7 @@ namespace msg {
 
                     ~Consumer() {
                         if (m_queue != nullptr) {
-                            m_queue->m_slots[m_slot_idx].tail.store(0, std::memory_order_relaxed);
-                            m_queue->m_slots[m_slot_idx].state.store(SlotState::Free, std::memory_order_release);
+                            m_queue->release_slot(m_slot_idx);
                         }
                     }
 
@@ -234,7 +427,7 @@ namespace msg {
                     Consumer& operator=(Consumer&& other) noexcept {
                         if (this != &other) {
                             if (m_queue != nullptr) {
-                                m_queue->m_slots[m_slot_idx].state.store(SlotState::Free, std::memory_order_release);
+                                m_queue->release_slot(m_slot_idx);
                             }
 
                             m_queue = other.m_queue;
@@ -254,6 +447,38 @@ namespace msg {
                         return m_queue->try_pop_impl(out, m_slot_idx);
                     }
 
+                    // pops one item, idling with the queues Wait strategy while empty.
+                    // timeout_us of 0 waits forever, returns false on timeout
+                    [[nodiscard]] bool pop_wait(T& out, std::uint32_t timeout_us = 0) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& q = *m_queue;
+                        const auto idx = m_slot_idx;
+                        if (q.try_pop_impl(out, idx)) return true;
+                        if (!q.m_wait.wait([&q, idx]() noexcept { return q.readable(idx); }, timeout_us)) return false;
+                        return q.try_pop_impl(out, idx);
+                    }
+
+                    // zero-copy read: returns the oldest unread slot (nullptr when empty),
+                    // read it in place then release() so the producer can reuse it
+                    [[nodiscard]] const T* front() noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        const auto run = m_queue->front_impl(1, m_slot_idx);
+                        return run.empty() ? nullptr : run.data();
+                    }
+
+                    // zero-copy read: returns up to max contiguous unread slots, the run
+                    // stops at the wrap point so it may be shorter than what is readable
+                    [[nodiscard]] Span<const T> front(std::size_t max) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        return m_queue->front_impl(max, m_slot_idx);
+                    }
+
+                    // releases n slots previously handed out by front()
+                    void release(std::size_t n = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        m_queue->release_impl(n, m_slot_idx);
+                    }
+
                     std::optional<T> peek() const noexcept {
                         assert(m_queue != nullptr && "Invalid consumer: queue is null");
                         return m_queue->peek(m_slot_idx);
@@ -268,9 +493,27 @@ namespace msg {
                         assert(m_queue != nullptr && "Invalid consumer: queue is null");
                         return m_queue->count_snapshot_impl(m_slot_idx);
                     }
+
+                    // lossy mode: messages skipped because the producer lapped this
+                    // consumer since the last call, resets the count
+                    std::uint64_t take_dropped() noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& slot = m_queue->m_slots[m_slot_idx];
+                        const auto dropped = slot.dropped;
+                        slot.dropped = 0;
+                        return dropped;
+                    }
             };
 
+            [[nodiscard]] bool is_valid() const noexcept {
+                return m_buffer.is_valid() && (!lossy() || m_seqs.is_valid());
+            }
+            [[nodiscard]] OverflowPolicy overflow_policy() const noexcept { return m_policy; }
+            [[nodiscard]] std::size_t capacity() const noexcept { return m_buffer.capacity(); }
+
             [[nodiscard]] std::optional<Producer> make_producer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
                 bool expected = false;
                 if (!m_producer_claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
                     return std::nullopt;
@@ -279,13 +522,14 @@ namespace msg {
             }
 
             [[nodiscard]] std::optional<Consumer> make_consumer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
                 const auto head = m_head.load(std::memory_order_acquire);
 
                 for (std::size_t i = 0; i < MaxConsumers; ++i) {
                     SlotState expected = SlotState::Free;
                     if (m_slots[i].state.compare_exchange_strong(expected, SlotState::Initializing, std::memory_order_acq_rel)) {
-                        m_slots[i].tail.store(head, std::memory_order_relaxed);
-                        m_slots[i].state.store(SlotState::Active, std::memory_order_release);
+                        claim_slot(i, head);
                         return Consumer(*this, i);
                     }
                 }
@@ -293,4 +537,8 @@ namespace msg {
                 return std::nullopt; // no free consumer slots
             }
     };
+
+    // SPMCQueue with its capacity chosen at construction, ring lives on the heap
+    template <typename T, std::size_t MaxConsumers = 16, typename Wait = BusySpinWait>
+    using DynSPMCQueue = SPMCQueue<T, dynamic_slots, MaxConsumers, Wait>;
 }
\ No newline at end of file
@@ -1,66 +1,119 @@
 #pragma once
-#include <array>
 #include <cstdint>
 #include <cassert>
+#include <cstring>
 #include <atomic>
+#include <iterator>
 #include <optional>
 #include <type_traits>
 #include <utility>
+#include "msg/span.h"
+#include "msg/ring_buffer.h"
+#include "msg/wait_strategy.h"
+#include "instr/instr.h"
 
 namespace msg {
     // Lock free single producer single consumer queue
     // NOTE: Producer and Consumer must not outlive SPSCQueue instance
-    template <typename T, std::size_t NumSlots = 1024>
+    // Wait picks how pop_wait() idles, see wait_strategy.h
+    template <typename T, std::size_t NumSlots = 1024, typename Wait = BusySpinWait>
     class SPSCQueue {
-        static_assert(NumSlots > 0, "SPSCQueue size must be > 0");
-        static_assert((NumSlots & (NumSlots-1)) == 0, "SPSCQueue size must be a power of 2 for efficient modulo operation");
+        static_assert((NumSlots & (NumSlots-1)) == 0, "SPSCQueue size must be a power of 2 (or dynamic_slots) for efficient modulo operation");
         static_assert(std::is_trivially_copyable_v<T>, "SPSCQueue only supports trivially copyable types");
 
-        static constexpr std::size_t mask = NumSlots - 1;
-        static constexpr std::size_t to_index(std::uint64_t i) noexcept { return static_cast<std::size_t>(i) & mask; }
 
         private:
-            std::array<T, NumSlots> m_buffer{};
+            detail::RingBuffer<T, NumSlots> m_buffer{};
+
+            std::size_t to_index(std::uint64_t i) const noexcept { return static_cast<std::size_t>(i) & m_buffer.mask(); }
             alignas(64) std::atomic<std::uint64_t> m_head{0};
+            alignas(64) std::uint64_t m_cached_tail{0}; // producer only, last seen m_tail
             alignas(64) std::atomic<std::uint64_t> m_tail{0};
+            alignas(64) std::uint64_t m_cached_head{0}; // consumer only, last seen m_head
 
-            std::atomic<bool> m_producer_claimed{false};
+            alignas(64) std::atomic<bool> m_producer_claimed{false};
             std::atomic<bool> m_consumer_claimed{false};
+            Wait m_wait{};
+
+            // number of free slots as seen by the producer, only goes to the
+            // consumers cache line when the cached tail says we dont have room
+            [[nodiscard]] std::size_t free_slots(std::uint64_t head, std::size_t wanted) noexcept {
+                auto free = capacity() - static_cast<std::size_t>(head - m_cached_tail);
+                if (free < wanted) {
+                    m_cached_tail = m_tail.load(std::memory_order_acquire);
+                    free = capacity() - static_cast<std::size_t>(head - m_cached_tail);
+                }
+                return free;
+            }
+
+            // number of readable slots as seen by the consumer, only goes to the
+            // producers cache line when the cached head says we dont have enough
+            [[nodiscard]] std::size_t available_slots(std::uint64_t tail, std::size_t wanted) noexcept {
+                auto available = static_cast<std::size_t>(m_cached_head - tail);
+                if (available < wanted) {
+                    m_cached_head = m_head.load(std::memory_order_acquire);
+                    available = static_cast<std::size_t>(m_cached_head - tail);
+                }
+                return available;
+            }
 
             [[nodiscard]] bool push_impl(const T& item) noexcept {
-                // get the current head and tail values
                 const auto head = m_head.load(std::memory_order_relaxed);
-                const auto tail = m_tail.load(std::memory_order_acquire);
-
-                if (head - tail >= NumSlots) {
+                if (free_slots(head, 1) == 0) {
+                    MOO_INSTR_COUNT(instr::Counter::SpscPushFull, 1);
                     return false; // channel is full
                 }
 
                 m_buffer[to_index(head)] = item;
                 m_head.store(head + 1, std::memory_order_release);
+                m_wait.notify();
                 return true;
             }
 
             [[nodiscard]] bool push_impl(T&& item) noexcept {
-                // get the current head and tail values
                 const auto head = m_head.load(std::memory_order_relaxed);
-                const auto tail = m_tail.load(std::memory_order_acquire);
-
-                if (head - tail >= NumSlots) {
+                if (free_slots(head, 1) == 0) {
+                    MOO_INSTR_COUNT(instr::Counter::SpscPushFull, 1);
                     return false; // channel is full
                 }
 
                 m_buffer[to_index(head)] = std::move(item);
                 m_head.store(head + 1, std::memory_order_release);
+                m_wait.notify();
                 return true;
             }
 
+            [[nodiscard]] bool readable() noexcept {
+                return available_slots(m_tail.load(std::memory_order_relaxed), 1) != 0;
+            }
+
+            [[nodiscard]] std::size_t push_n_impl(const T* items, std::size_t n) noexcept {
+                const auto head = m_head.load(std::memory_order_relaxed);
+                const auto free = free_slots(head, n);
+                const auto count = n < free ? n : free;
+                if (count == 0) {
+                    MOO_INSTR_COUNT_IF(n != 0, instr::Counter::SpscPushFull);
+                    return 0; // channel is full (or nothing to push)
+                }
+
+                // copy in at most two runs, split where the ring wraps
+                const auto start = to_index(head);
+                const auto first = (capacity() - start) < count ? (capacity() - start) : count;
+                std::memcpy(&m_buffer[start], items, first * sizeof(T));
+                if (count > first) {
+                    std::memcpy(&m_buffer[0], items + first, (count - first) * sizeof(T));
+                }
+
+                // publish the whole batch at once
+                m_head.store(head + count, std::memory_order_release);
+                m_wait.notify();
+                return count;
+            }
+
             [[nodiscard]] std::optional<T> pop_impl() noexcept {
-                // get the current head and tail values
-                const auto head = m_head.load(std::memory_order_acquire);
                 const auto tail = m_tail.load(std::memory_order_relaxed);
-
-                if (tail >= head) {
+                if (available_slots(tail, 1) == 0) {
+                    MOO_INSTR_COUNT(instr::Counter::SpscPopEmpty, 1);
                     return std::nullopt; // channel is empty
                 }
                 
@@ -70,11 +123,9 @@ namespace msg {
             }
 
             [[nodiscard]] bool try_pop_impl(T& out) noexcept {
-                // get the current head and tail values
-                const auto head = m_head.load(std::memory_order_acquire);
                 const auto tail = m_tail.load(std::memory_order_relaxed);
-
-                if (tail >= head) {
+                if (available_slots(tail, 1) == 0) {
+                    MOO_INSTR_COUNT(instr::Counter::SpscPopEmpty, 1);
                     return false; // channel is empty
                 }
                 
@@ -83,6 +134,63 @@ namespace msg {
                 return true;
             }
 
+            [[nodiscard]] std::size_t try_pop_n_impl(T* out, std::size_t max) noexcept {
+                const auto tail = m_tail.load(std::memory_order_relaxed);
+                const auto available = available_slots(tail, max);
+                const auto count = max < available ? max : available;
+                if (count == 0) {
+                    MOO_INSTR_COUNT_IF(max != 0, instr::Counter::SpscPopEmpty);
+                    return 0; // channel is empty (or nowhere to put it)
+                }
+
+                // copy out in at most two runs, split where the ring wraps
+                const auto start = to_index(tail);
+                const auto first = (capacity() - start) < count ? (capacity() - start) : count;
+                std::memcpy(out, &m_buffer[start], first * sizeof(T));
+                if (count > first) {
+                    std::memcpy(out + first, &m_buffer[0], (count - first) * sizeof(T));
+                }
+
+                // release the whole batch at once
+                m_tail.store(tail + count, std::memory_order_release);
+                return count;
+            }
+
+            [[nodiscard]] Span<T> reserve_impl(std::size_t max) noexcept {
+                const auto head = m_head.load(std::memory_order_relaxed);
+                const auto start = to_index(head);
+                const auto free = free_slots(head, 1);
+
+                // only hand out the run up to the wrap point
+                auto count = max < free ? max : free;
+                if (count > capacity() - start) count = capacity() - start;
+                return Span<T>{ &m_buffer[start], count };
+            }
+
+            void commit_impl(std::size_t n) noexcept {
+                const auto head = m_head.load(std::memory_order_relaxed);
+                assert(static_cast<std::size_t>(head + n - m_cached_tail) <= capacity() && "commit() past reserved slots");
+                m_head.store(head + n, std::memory_order_release);
+                m_wait.notify();
+            }
+
+            [[nodiscard]] Span<const T> front_impl(std::size_t max) noexcept {
+                const auto tail = m_tail.load(std::memory_order_relaxed);
+                const auto start = to_index(tail);
+                const auto available = available_slots(tail, 1);
+
+                // only hand out the run up to the wrap point
+                auto count = max < available ? max : available;
+                if (count > capacity() - start) count = capacity() - start;
+                return Span<const T>{ &m_buffer[start], count };
+            }
+
+            void release_impl(std::size_t n) noexcept {
+                const auto tail = m_tail.load(std::memory_order_relaxed);
+                assert(static_cast<std::size_t>(m_cached_head - tail) >= n && "release() past readable slots");
+                m_tail.store(tail + n, std::memory_order_release);
+            }
+
             [[nodiscard]] std::optional<T> peek() const noexcept {
                 const auto head = m_head.load(std::memory_order_acquire);
                 const auto tail = m_tail.load(std::memory_order_acquire);
@@ -110,8 +218,8 @@ namespace msg {
                 const auto head = m_head.load(std::memory_order_acquire);
                 const auto tail = m_tail.load(std::memory_order_acquire);
                 const auto diff = head - tail;
-                if (diff > NumSlots) {
-                    return NumSlots; // overflow
+                if (diff > capacity()) {
+                    return capacity(); // overflow
                 }
                 return static_cast<std::size_t>(head - tail);
             }
@@ -120,6 +228,12 @@ namespace msg {
             SPSCQueue() = default;
             ~SPSCQueue() = default;
 
+            // runtime sized queue (NumSlots == dynamic_slots), capacity must be a power of 2,
+            // check is_valid() before use since the ring allocation can fail
+            explicit SPSCQueue(std::size_t capacity, bool hugepages = false) : m_buffer(capacity, hugepages) {
+                static_assert(NumSlots == dynamic_slots, "SPSCQueue capacity is fixed at compile time, use dynamic_slots");
+            }
+
             SPSCQueue(const SPSCQueue&) = delete;
             SPSCQueue& operator=(const SPSCQueue&) = delete;
             SPSCQueue(SPSCQueue&&) = delete;
@@ -166,6 +280,41 @@ namespace msg {
                         return m_queue->push_impl(std::move(item));
                     }
 
+                    // pushes up to n items with a single publish, returns how many fit
+                    [[nodiscard]] std::size_t push_n(const T* items, std::size_t n) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        assert((items != nullptr || n == 0) && "Invalid producer: items is null");
+                        return m_queue->push_n_impl(items, n);
+                    }
+
+                    // span-style overload for any contiguous container of T (array, vector, ...)
+                    template <typename Container, typename = std::enable_if_t<
+                        std::is_convertible_v<decltype(std::data(std::declval<const Container&>())), const T*>>>
+                    [[nodiscard]] std::size_t push_n(const Container& items) noexcept {
+                        return push_n(std::data(items), std::size(items));
+                    }
+
+                    // zero-copy write: returns the next free slot (nullptr when full),
+                    // write into it in place then commit() to publish
+                    [[nodiscard]] T* reserve() noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        const auto run = m_queue->reserve_impl(1);
+                        return run.empty() ? nullptr : run.data();
+                    }
+
+                    // zero-copy write: returns up to max contiguous free slots, the run
+                    // stops at the wrap point so it may be shorter than what is free
+                    [[nodiscard]] Span<T> reserve(std::size_t max) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        return m_queue->reserve_impl(max);
+                    }
+
+                    // publishes n slots previously handed out by reserve()
+                    void commit(std::size_t n = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        m_queue->commit_impl(n);
+                    }
+
                     std::size_t count_snapshot() const noexcept {
                         assert(m_queue != nullptr && "Invalid producer: queue is null");
                         return m_queue->count_snapshot_impl();
@@ -213,6 +362,51 @@ namespace msg {
                         return m_queue->try_pop_impl(out);
                     }
 
+                    // pops one item, idling with the queues Wait strategy while empty.
+                    // timeout_us of 0 waits forever, returns false on timeout
+                    [[nodiscard]] bool pop_wait(T& out, std::uint32_t timeout_us = 0) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& q = *m_queue;
+                        if (q.try_pop_impl(out)) return true;
+                        if (!q.m_wait.wait([&q]() noexcept { return q.readable(); }, timeout_us)) return false;
+                        return q.try_pop_impl(out);
+                    }
+
+                    // pops up to max items with a single release, returns how many were popped
+                    [[nodiscard]] std::size_t try_pop_n(T* out, std::size_t max) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        assert((out != nullptr || max == 0) && "Invalid consumer: out is null");
+                        return m_queue->try_pop_n_impl(out, max);
+                    }
+
+                    // span-style overload for any contiguous container of T (array, vector, ...)
+                    template <typename Container, typename = std::enable_if_t<
+                        std::is_convertible_v<decltype(std::data(std::declval<Container&>())), T*>>>
+                    [[nodiscard]] std::size_t try_pop_n(Container& out) noexcept {
+                        return try_pop_n(std::data(out), std::size(out));
+                    }
+
+                    // zero-copy read: returns the oldest unread slot (nullptr when empty),
+                    // read it in place then release() to hand it back to the producer
+                    [[nodiscard]] const T* front() noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        const auto run = m_queue->front_impl(1);
+                        return run.empty() ? nullptr : run.data();
+                    }
+
+                    // zero-copy read: returns up to max contiguous unread slots, the run
+                    // stops at the wrap point so it may be shorter than what is readable
+                    [[nodiscard]] Span<const T> front(std::size_t max) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        return m_queue->front_impl(max);
+                    }
+
+                    // releases n slots previously handed out by front()
+                    void release(std::size_t n = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        m_queue->release_impl(n);
+                    }
+
                     std::optional<T> peek() const noexcept {
                         assert(m_queue != nullptr && "Invalid consumer: queue is null");
                         return m_queue->peek();
@@ -229,7 +423,12 @@ namespace msg {
                     }
             };
 
+            [[nodiscard]] bool is_valid() const noexcept { return m_buffer.is_valid(); }
+            [[nodiscard]] std::size_t capacity() const noexcept { return m_buffer.capacity(); }
+
             [[nodiscard]] std::optional<Producer> make_producer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
                 bool expected = false;
                 if (!m_producer_claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
                     return std::nullopt;
@@ -238,6 +437,8 @@ namespace msg {
             }
 
             [[nodiscard]] std::optional<Consumer> make_consumer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
                 bool expected = false;
                 if (!m_consumer_claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
                     return std::nullopt;
@@ -245,4 +446,8 @@ namespace msg {
                 return Consumer(*this);
             }
     };
+
+    // SPSCQueue with its capacity chosen at construction, ring lives on the heap
+    template <typename T, typename Wait = BusySpinWait>
+    using DynSPSCQueue = SPSCQueue<T, dynamic_slots, Wait>;
 }
\ No newline at end of file
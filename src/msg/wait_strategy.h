@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "platform/futex.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #include <immintrin.h>
+#endif
+
+namespace msg {
+    namespace detail {
+        inline void cpu_relax() noexcept {
+            #if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+                _mm_pause();
+            #elif defined(__aarch64__) || defined(__arm__)
+                __asm__ __volatile__("yield");
+            #endif
+        }
+
+        // deadline helper, timeout_us of 0 means no deadline
+        class Deadline {
+            private:
+                using clock = std::chrono::steady_clock;
+                clock::time_point m_end{};
+                bool m_forever = true;
+
+            public:
+                explicit Deadline(std::uint32_t timeout_us) noexcept {
+                    if (timeout_us != 0) {
+                        m_forever = false;
+                        m_end = clock::now() + std::chrono::microseconds(timeout_us);
+                    }
+                }
+
+                bool expired() const noexcept {
+                    return !m_forever && clock::now() >= m_end;
+                }
+
+                // remaining time in ns, 0 means wait forever
+                std::uint64_t remaining_ns() const noexcept {
+                    if (m_forever) return 0;
+                    const auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(m_end - clock::now()).count();
+                    return left > 0 ? static_cast<std::uint64_t>(left) : 1;
+                }
+        };
+    }
+
+    // Wait strategies plug into the queues as a template parameter. The
+    // consumer side calls wait(ready, timeout_us) where ready() re-checks the
+    // queue, the producer side calls notify() after every publish.
+    // wait() returns false if the timeout expires first (timeout_us 0 = forever).
+
+    // Burns the core with pause instructions, lowest latency, notify() is free
+    struct BusySpinWait {
+        template <typename Ready>
+        bool wait(Ready&& ready, std::uint32_t timeout_us) noexcept {
+            const detail::Deadline deadline(timeout_us);
+            std::uint32_t spins = 0;
+            while (!ready()) {
+                detail::cpu_relax();
+                // only read the clock every so often
+                if ((++spins & 0xFFu) == 0 && deadline.expired()) return false;
+            }
+            return true;
+        }
+
+        void notify() noexcept {}
+    };
+
+    // Spins for a while then gives the core away with yield, notify() is free
+    struct SpinYieldWait {
+        static constexpr std::uint32_t spin_iterations = 1024;
+
+        template <typename Ready>
+        bool wait(Ready&& ready, std::uint32_t timeout_us) noexcept {
+            const detail::Deadline deadline(timeout_us);
+            for (std::uint32_t i = 0; i < spin_iterations; ++i) {
+                if (ready()) return true;
+                detail::cpu_relax();
+            }
+
+            while (!ready()) {
+                if (deadline.expired()) return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        void notify() noexcept {}
+    };
+
+    // Spins, yields, then parks on a futex/WaitOnAddress word. The producer
+    // only pays for a syscall when a consumer is actually parked.
+    // NOTE: futex words are 32-bit so consumers park on a wake counter bumped
+    // next to the head publish rather than on the 64-bit head itself
+    class SpinParkWait {
+        public:
+            static constexpr std::uint32_t spin_iterations = 1024;
+            static constexpr std::uint32_t yield_iterations = 64;
+
+        private:
+            alignas(64) std::atomic<std::uint32_t> m_epoch{0};
+            std::atomic<std::uint32_t> m_waiters{0};
+
+        public:
+            template <typename Ready>
+            bool wait(Ready&& ready, std::uint32_t timeout_us) noexcept {
+                const detail::Deadline deadline(timeout_us);
+                for (std::uint32_t i = 0; i < spin_iterations; ++i) {
+                    if (ready()) return true;
+                    detail::cpu_relax();
+                }
+
+                for (std::uint32_t i = 0; i < yield_iterations; ++i) {
+                    if (ready()) return true;
+                    if (deadline.expired()) return false;
+                    std::this_thread::yield();
+                }
+
+                while (true) {
+                    // announce ourselves before the final check so a producer that
+                    // publishes after it is guaranteed to see us and wake us
+                    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+                    const auto epoch = m_epoch.load(std::memory_order_seq_cst);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                    if (ready()) {
+                        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+
+                    const bool woken = plat::futex_wait(m_epoch, epoch, deadline.remaining_ns());
+                    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+
+                    if (ready()) return true;
+                    if (!woken || deadline.expired()) return false;
+                }
+            }
+
+            void notify() noexcept {
+                // pairs with the fence in wait(), orders the head publish before
+                // reading the waiter count
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_waiters.load(std::memory_order_relaxed) != 0) {
+                    m_epoch.fetch_add(1, std::memory_order_release);
+                    plat::futex_wake_all(m_epoch);
+                }
+            }
+    };
+}
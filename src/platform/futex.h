@@ -0,0 +1,15 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace plat {
+    // Thin wrappers over futex (linux) / WaitOnAddress (windows).
+    // futex_wait blocks while word == expected, timeout_ns of 0 waits forever.
+    // Returns false on timeout, spurious wakeups are possible so callers
+    // must recheck their condition.
+    // NOTE: process_shared is needed when word lives in shared memory, it is
+    // ignored on windows where WaitOnAddress only works inside one process
+    bool futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::uint64_t timeout_ns = 0, bool process_shared = false) noexcept;
+    void futex_wake_one(std::atomic<std::uint32_t>& word, bool process_shared = false) noexcept;
+    void futex_wake_all(std::atomic<std::uint32_t>& word, bool process_shared = false) noexcept;
+}
@@ -1,8 +1,18 @@
 #if defined(MOO_LINUX)
 #include "platform/platform.h"
+#include "platform/memory.h"
+#include "platform/futex.h"
 #include <semaphore.h>
 #include <pthread.h>
 #include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#include <ctime>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
@@ -65,5 +75,116 @@ namespace plat {
         oss << std::put_time(&tm, "%Y%m%d_%H%M%S");
         return oss.str();
     }
+
+    static constexpr std::size_t huge_page_size = 2u * 1024u * 1024u;
+
+    static std::size_t round_to_huge_page(std::size_t bytes) {
+        return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+    }
+
+    void* alloc_huge(std::size_t bytes) {
+        if (bytes == 0) return nullptr;
+
+        void* mem = ::mmap(
+            nullptr,
+            round_to_huge_page(bytes),
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+            -1,
+            0
+        );
+
+        if (mem == MAP_FAILED) {
+            return nullptr;
+        }
+        return mem;
+    }
+
+    void free_huge(void* ptr, std::size_t bytes) {
+        if (ptr == nullptr) return;
+        ::munmap(ptr, round_to_huge_page(bytes));
+    }
+
+    static constexpr std::size_t small_page = 4096;
+
+    static std::size_t round_to_page(std::size_t bytes) {
+        return (bytes + small_page - 1) & ~(small_page - 1);
+    }
+
+    int current_numa_node() noexcept {
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return -1;
+        return static_cast<int>(node);
+    }
+
+    // the policy only says where pages go once they are faulted in, so bind
+    // before anything touches the mapping
+    void* alloc_on_node(std::size_t bytes, int node) {
+        if (bytes == 0) return nullptr;
+        if (node < 0) node = current_numa_node();
+        if (node < 0) return nullptr;
+
+        constexpr std::size_t bits = sizeof(unsigned long) * 8;
+        constexpr std::size_t max_nodes = 1024;
+        if (static_cast<std::size_t>(node) >= max_nodes) return nullptr;
+
+        const auto size = round_to_page(bytes);
+        void* mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) return nullptr;
+
+        unsigned long mask[max_nodes / bits]{};
+        const auto n = static_cast<std::size_t>(node);
+        mask[n / bits] = 1ul << (n % bits);
+        if (::syscall(SYS_mbind, mem, size, MPOL_BIND, mask, max_nodes + 1, 0) != 0) {
+            // kernels without numa reject mbind outright, node 0 is all there is
+            if (!(errno == ENOSYS && node == 0)) {
+                ::munmap(mem, size);
+                return nullptr;
+            }
+        }
+        return mem;
+    }
+
+    void free_on_node(void* ptr, std::size_t bytes) {
+        if (ptr == nullptr) return;
+        ::munmap(ptr, round_to_page(bytes));
+    }
+
+    static std::uint32_t* futex_addr(std::atomic<std::uint32_t>& word) noexcept {
+        static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex word must be a plain 32-bit int");
+        return reinterpret_cast<std::uint32_t*>(&word);
+    }
+
+    static long futex_call(std::uint32_t* addr, int op, std::uint32_t val, const timespec* timeout) noexcept {
+        return ::syscall(SYS_futex, addr, op, val, timeout, nullptr, 0);
+    }
+
+    bool futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::uint64_t timeout_ns, bool process_shared) noexcept {
+        const int op = process_shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE;
+
+        timespec ts{};
+        timespec* timeout = nullptr;
+        if (timeout_ns != 0) {
+            ts.tv_sec = static_cast<time_t>(timeout_ns / 1'000'000'000ull);
+            ts.tv_nsec = static_cast<long>(timeout_ns % 1'000'000'000ull);
+            timeout = &ts; // FUTEX_WAIT takes a relative timeout
+        }
+
+        if (futex_call(futex_addr(word), op, expected, timeout) != 0) {
+            return errno != ETIMEDOUT; // EAGAIN (value changed) and EINTR count as wakeups
+        }
+        return true;
+    }
+
+    void futex_wake_one(std::atomic<std::uint32_t>& word, bool process_shared) noexcept {
+        const int op = process_shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+        (void)futex_call(futex_addr(word), op, 1, nullptr);
+    }
+
+    void futex_wake_all(std::atomic<std::uint32_t>& word, bool process_shared) noexcept {
+        const int op = process_shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE;
+        (void)futex_call(futex_addr(word), op, static_cast<std::uint32_t>(INT_MAX), nullptr);
+    }
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,225 @@
+#if defined(MOO_LINUX)
+#include "platform/topology.h"
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace plat {
+    static const char* const sys_cpu = "/sys/devices/system/cpu";
+    static const char* const sys_node = "/sys/devices/system/node";
+
+    // whole (small) sysfs file, trailing newline stripped
+    static bool read_file(const std::string& path, std::string& out) {
+        std::FILE* f = std::fopen(path.c_str(), "r");
+        if (f == nullptr) return false;
+
+        char buf[4096];
+        const auto n = std::fread(buf, 1, sizeof(buf) - 1, f);
+        std::fclose(f);
+
+        out.assign(buf, n);
+        while (!out.empty() && (out.back() == '\n' || out.back() == ' ')) out.pop_back();
+        return !out.empty();
+    }
+
+    static bool read_u64(const std::string& path, std::uint64_t& out) {
+        std::string s;
+        if (!read_file(path, s)) return false;
+        char* end = nullptr;
+        out = std::strtoull(s.c_str(), &end, 10);
+        return end != s.c_str();
+    }
+
+    // kernel cpu list format, "0-3,8,10-11"
+    static bool parse_cpu_list(const std::string& s, CpuSet& out) {
+        out = CpuSet{};
+        const char* p = s.c_str();
+        while (*p != '\0') {
+            char* end = nullptr;
+            const auto lo = std::strtoul(p, &end, 10);
+            if (end == p) return false;
+            auto hi = lo;
+            p = end;
+            if (*p == '-') {
+                ++p;
+                hi = std::strtoul(p, &end, 10);
+                if (end == p) return false;
+                p = end;
+            }
+            for (auto cpu = lo; cpu <= hi && cpu < CpuSet::max_cpus; ++cpu) out.set(static_cast<std::uint32_t>(cpu));
+            if (*p == ',') ++p;
+        }
+        return true;
+    }
+
+    static bool read_cpu_list(const std::string& path, CpuSet& out) {
+        std::string s;
+        return read_file(path, s) && parse_cpu_list(s, out);
+    }
+
+    // "32K", "1024K", "8M"
+    static std::uint64_t parse_size(const std::string& s) {
+        char* end = nullptr;
+        const auto v = std::strtoull(s.c_str(), &end, 10);
+        if (end == nullptr) return v;
+        switch (*end) {
+            case 'K': return v * 1024u;
+            case 'M': return v * 1024u * 1024u;
+            case 'G': return v * 1024u * 1024u * 1024u;
+            default: return v;
+        }
+    }
+
+    // index of set in domains, appended when it is new
+    static std::uint32_t domain_index(std::vector<CpuSet>& domains, const CpuSet& set) {
+        for (std::size_t i = 0; i < domains.size(); ++i) {
+            if (domains[i] == set) return static_cast<std::uint32_t>(i);
+        }
+        domains.push_back(set);
+        return static_cast<std::uint32_t>(domains.size() - 1);
+    }
+
+    // L2 and L3 from cpuN/cache/index*, data and unified caches only
+    static void read_caches(Topology& out, CpuInfo& info, const std::string& cpu_dir) {
+        for (int idx = 0; idx < 16; ++idx) {
+            const std::string dir = cpu_dir + "/cache/index" + std::to_string(idx);
+            std::uint64_t level = 0;
+            if (!read_u64(dir + "/level", level)) break;
+
+            std::string type;
+            if (read_file(dir + "/type", type) && type == "Instruction") continue;
+
+            std::uint64_t line = 0;
+            if (level == 1 && read_u64(dir + "/coherency_line_size", line) && line != 0) {
+                out.cache_line = static_cast<std::uint32_t>(line);
+            }
+            if (level != 2 && level != 3) continue;
+
+            CpuSet shared;
+            if (!read_cpu_list(dir + "/shared_cpu_list", shared)) shared = CpuSet::single(info.cpu);
+
+            std::string size;
+            const auto bytes = read_file(dir + "/size", size) ? parse_size(size) : 0;
+            if (level == 2) {
+                info.l2 = static_cast<std::int32_t>(domain_index(out.l2_domains, shared));
+                if (bytes != 0) out.l2_bytes = bytes;
+            } else {
+                info.l3 = static_cast<std::int32_t>(domain_index(out.l3_domains, shared));
+                if (bytes != 0) out.l3_bytes = bytes;
+            }
+        }
+    }
+
+    // nodeN/cpulist for every node directory, nodes may not exist at all on
+    // kernels built without numa, everything is node 0 then
+    static void read_nodes(Topology& out) {
+        DIR* dir = ::opendir(sys_node);
+        if (dir == nullptr) return;
+
+        while (const dirent* ent = ::readdir(dir)) {
+            if (std::strncmp(ent->d_name, "node", 4) != 0) continue;
+            char* end = nullptr;
+            const auto id = std::strtoul(ent->d_name + 4, &end, 10);
+            if (end == ent->d_name + 4 || *end != '\0' || id >= 4096) continue;
+
+            CpuSet cpus;
+            if (!read_cpu_list(std::string(sys_node) + "/" + ent->d_name + "/cpulist", cpus)) cpus = CpuSet{};
+            if (out.nodes.size() <= id) out.nodes.resize(id + 1);
+            out.nodes[id] = cpus;
+        }
+        ::closedir(dir);
+    }
+
+    bool query_topology(Topology& out) {
+        out = Topology{};
+
+        CpuSet online;
+        bool from_sysfs = read_cpu_list(std::string(sys_cpu) + "/online", online);
+        if (!from_sysfs) {
+            const auto n = std::thread::hardware_concurrency();
+            for (std::uint32_t i = 0; i < (n == 0 ? 1u : n); ++i) online.set(i);
+        }
+
+        read_nodes(out);
+
+        for (auto cpu = online.next(0); cpu < CpuSet::max_cpus; cpu = online.next(cpu + 1)) {
+            const std::string cpu_dir = std::string(sys_cpu) + "/cpu" + std::to_string(cpu);
+            CpuInfo info{};
+            info.cpu = cpu;
+
+            // core_cpus_list / package_cpus_list are the 5.x names
+            CpuSet core;
+            if (!read_cpu_list(cpu_dir + "/topology/core_cpus_list", core) &&
+                !read_cpu_list(cpu_dir + "/topology/thread_siblings_list", core)) {
+                core = CpuSet::single(cpu);
+            }
+            core &= online;
+            info.core = domain_index(out.cores, core);
+
+            CpuSet package;
+            if (!read_cpu_list(cpu_dir + "/topology/package_cpus_list", package) &&
+                !read_cpu_list(cpu_dir + "/topology/core_siblings_list", package)) {
+                package = online;
+            }
+            package &= online;
+            info.package = domain_index(out.packages, package);
+
+            info.node = 0;
+            for (std::size_t n = 0; n < out.nodes.size(); ++n) {
+                if (out.nodes[n].test(cpu)) {
+                    info.node = static_cast<std::uint32_t>(n);
+                    break;
+                }
+            }
+
+            read_caches(out, info, cpu_dir);
+            out.cpus.push_back(info);
+        }
+
+        if (out.nodes.empty()) out.nodes.push_back(online);
+        return from_sysfs;
+    }
+
+    static bool to_native(const CpuSet& cpus, cpu_set_t& set) noexcept {
+        CPU_ZERO(&set);
+        bool any = false;
+        for (auto cpu = cpus.next(0); cpu < CpuSet::max_cpus && cpu < CPU_SETSIZE; cpu = cpus.next(cpu + 1)) {
+            CPU_SET(cpu, &set);
+            any = true;
+        }
+        return any;
+    }
+
+    bool set_thread_affinity(std::thread& t, const CpuSet& cpus) {
+        cpu_set_t set;
+        if (!to_native(cpus, set)) return false;
+        return ::pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0;
+    }
+
+    bool set_current_thread_affinity(const CpuSet& cpus) {
+        cpu_set_t set;
+        if (!to_native(cpus, set)) return false;
+        return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    bool get_current_thread_affinity(CpuSet& out) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (::pthread_getaffinity_np(::pthread_self(), sizeof(set), &set) != 0) return false;
+
+        out = CpuSet{};
+        for (std::uint32_t cpu = 0; cpu < CpuSet::max_cpus && cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) out.set(cpu);
+        }
+        return true;
+    }
+
+    int current_cpu() noexcept {
+        return ::sched_getcpu();
+    }
+}
+#endif
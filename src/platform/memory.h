@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+namespace plat {
+    // huge page (2MB) backed anonymous memory, returns nullptr when the system
+    // has none available so callers can fall back to normal allocations
+    [[nodiscard]] void* alloc_huge(std::size_t bytes);
+    void free_huge(void* ptr, std::size_t bytes);
+
+    // page aligned anonymous memory whose pages come from numa node (mbind on
+    // linux, VirtualAllocExNuma on windows), node < 0 = the callers current
+    // node. nullptr when the node doesnt exist or the bind failed. Machines
+    // without numa support only have node 0
+    [[nodiscard]] void* alloc_on_node(std::size_t bytes, int node);
+    void free_on_node(void* ptr, std::size_t bytes);
+
+    // numa node of the cpu the caller is running on, -1 if unknown
+    [[nodiscard]] int current_numa_node() noexcept;
+}
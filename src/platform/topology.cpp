@@ -0,0 +1,97 @@
+#include "platform/topology.h"
+
+namespace plat {
+    namespace {
+        CpuSet domain_of(const std::vector<CpuSet>& domains, std::int64_t idx) noexcept {
+            if (idx < 0 || static_cast<std::size_t>(idx) >= domains.size()) return CpuSet{};
+            return domains[static_cast<std::size_t>(idx)];
+        }
+
+        // first pair (a, b) in candidates where b is in the same domain as a
+        // and not a's smt sibling (unless allow_smt)
+        template <typename DomainOf>
+        bool pair_within(const Topology& topo, const CpuSet& candidates, bool allow_smt, DomainOf&& domain, std::uint32_t& a, std::uint32_t& b) noexcept {
+            for (auto x = candidates.next(0); x < CpuSet::max_cpus; x = candidates.next(x + 1)) {
+                CpuSet peers = domain(x) & candidates;
+                peers.clear(x);
+                if (!allow_smt) {
+                    const auto sib = topo.smt_siblings(x);
+                    for (auto s = sib.next(0); s < CpuSet::max_cpus; s = sib.next(s + 1)) peers.clear(s);
+                }
+                const auto y = peers.next(0);
+                if (y < CpuSet::max_cpus) {
+                    a = x;
+                    b = y;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    CpuSet Topology::online() const noexcept {
+        CpuSet s;
+        for (const auto& c : cpus) s.set(c.cpu);
+        return s;
+    }
+
+    const CpuInfo* Topology::find(std::uint32_t cpu) const noexcept {
+        for (const auto& c : cpus) {
+            if (c.cpu == cpu) return &c;
+        }
+        return nullptr;
+    }
+
+    CpuSet Topology::smt_siblings(std::uint32_t cpu) const noexcept {
+        const auto* c = find(cpu);
+        return c == nullptr ? CpuSet{} : domain_of(cores, c->core);
+    }
+
+    CpuSet Topology::l2_peers(std::uint32_t cpu) const noexcept {
+        const auto* c = find(cpu);
+        return c == nullptr ? CpuSet{} : domain_of(l2_domains, c->l2);
+    }
+
+    CpuSet Topology::l3_peers(std::uint32_t cpu) const noexcept {
+        const auto* c = find(cpu);
+        return c == nullptr ? CpuSet{} : domain_of(l3_domains, c->l3);
+    }
+
+    int Topology::node_of(std::uint32_t cpu) const noexcept {
+        const auto* c = find(cpu);
+        return c == nullptr ? -1 : static_cast<int>(c->node);
+    }
+
+    CpuSet Topology::one_per_core() const noexcept {
+        CpuSet s;
+        for (const auto& core : cores) {
+            const auto first = core.next(0);
+            if (first < CpuSet::max_cpus) s.set(first);
+        }
+        return s;
+    }
+
+    bool Topology::pick_pair(std::uint32_t& a, std::uint32_t& b, bool allow_smt, const CpuSet& allowed) const noexcept {
+        CpuSet candidates = online();
+        if (!allowed.empty()) candidates &= allowed;
+        if (candidates.count() < 2) return false;
+
+        // smt siblings share L1 and L2, closest of all but they also share
+        // the execution units, so only when asked for
+        if (allow_smt && pair_within(*this, candidates, true, [this](std::uint32_t x) { return smt_siblings(x); }, a, b)) return true;
+        if (pair_within(*this, candidates, false, [this](std::uint32_t x) { return l2_peers(x); }, a, b)) return true;
+        if (pair_within(*this, candidates, false, [this](std::uint32_t x) { return l3_peers(x); }, a, b)) return true;
+        if (pair_within(*this, candidates, false, [this](std::uint32_t x) { return domain_of(nodes, node_of(x)); }, a, b)) return true;
+        if (pair_within(*this, candidates, allow_smt, [&candidates](std::uint32_t) { return candidates; }, a, b)) return true;
+        return false;
+    }
+
+    const Topology& topology() {
+        static const Topology topo = []() {
+            Topology t;
+            (void)query_topology(t);
+            return t;
+        }();
+        return topo;
+    }
+}
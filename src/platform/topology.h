@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace plat {
+    // Fixed size set of logical cpus, bit i = logical cpu i.
+    // On windows cpu i is processor (i % 64) of processor group (i / 64)
+    class CpuSet {
+        public:
+            static constexpr std::uint32_t max_cpus = 1024;   // CPU_SETSIZE on linux
+            static constexpr std::uint32_t word_bits = 64;
+            static constexpr std::uint32_t word_count = max_cpus / word_bits;
+
+        private:
+            std::uint64_t m_words[word_count]{};
+
+            static std::uint32_t popcount(std::uint64_t v) noexcept {
+                std::uint32_t n = 0;
+                for (; v != 0; v &= v - 1) ++n;
+                return n;
+            }
+
+        public:
+            CpuSet() = default;
+
+            [[nodiscard]] static CpuSet single(std::uint32_t cpu) noexcept {
+                CpuSet s;
+                s.set(cpu);
+                return s;
+            }
+
+            void set(std::uint32_t cpu) noexcept {
+                if (cpu < max_cpus) m_words[cpu / word_bits] |= std::uint64_t{1} << (cpu % word_bits);
+            }
+
+            void clear(std::uint32_t cpu) noexcept {
+                if (cpu < max_cpus) m_words[cpu / word_bits] &= ~(std::uint64_t{1} << (cpu % word_bits));
+            }
+
+            [[nodiscard]] bool test(std::uint32_t cpu) const noexcept {
+                return cpu < max_cpus && (m_words[cpu / word_bits] >> (cpu % word_bits) & 1u) != 0;
+            }
+
+            [[nodiscard]] std::uint32_t count() const noexcept {
+                std::uint32_t n = 0;
+                for (const auto w : m_words) n += popcount(w);
+                return n;
+            }
+
+            [[nodiscard]] bool empty() const noexcept {
+                for (const auto w : m_words) {
+                    if (w != 0) return false;
+                }
+                return true;
+            }
+
+            // lowest cpu >= from in the set, max_cpus when there is none
+            [[nodiscard]] std::uint32_t next(std::uint32_t from = 0) const noexcept {
+                for (std::uint32_t cpu = from; cpu < max_cpus; ++cpu) {
+                    const auto w = m_words[cpu / word_bits] >> (cpu % word_bits);
+                    if (w == 0) {
+                        cpu = (cpu / word_bits + 1) * word_bits - 1; // rest of the word is empty
+                        continue;
+                    }
+                    if ((w & 1u) != 0) return cpu;
+                }
+                return max_cpus;
+            }
+
+            // i'th cpu of the set wrapping around, max_cpus when empty
+            [[nodiscard]] std::uint32_t nth(std::uint32_t i) const noexcept {
+                const auto n = count();
+                if (n == 0) return max_cpus;
+                i %= n;
+                std::uint32_t cpu = next(0);
+                while (i-- != 0) cpu = next(cpu + 1);
+                return cpu;
+            }
+
+            [[nodiscard]] std::uint64_t word(std::uint32_t i) const noexcept { return i < word_count ? m_words[i] : 0; }
+            void set_word(std::uint32_t i, std::uint64_t bits) noexcept { if (i < word_count) m_words[i] = bits; }
+
+            CpuSet& operator|=(const CpuSet& o) noexcept {
+                for (std::uint32_t i = 0; i < word_count; ++i) m_words[i] |= o.m_words[i];
+                return *this;
+            }
+
+            CpuSet& operator&=(const CpuSet& o) noexcept {
+                for (std::uint32_t i = 0; i < word_count; ++i) m_words[i] &= o.m_words[i];
+                return *this;
+            }
+
+            friend CpuSet operator|(CpuSet a, const CpuSet& b) noexcept { return a |= b; }
+            friend CpuSet operator&(CpuSet a, const CpuSet& b) noexcept { return a &= b; }
+
+            friend bool operator==(const CpuSet& a, const CpuSet& b) noexcept {
+                for (std::uint32_t i = 0; i < word_count; ++i) {
+                    if (a.m_words[i] != b.m_words[i]) return false;
+                }
+                return true;
+            }
+            friend bool operator!=(const CpuSet& a, const CpuSet& b) noexcept { return !(a == b); }
+    };
+
+    struct CpuInfo {
+        std::uint32_t cpu = 0;      // logical cpu index
+        std::uint32_t core = 0;     // index into Topology::cores
+        std::uint32_t package = 0;  // index into Topology::packages
+        std::uint32_t node = 0;     // numa node id, index into Topology::nodes
+        std::int32_t l2 = -1;       // index into Topology::l2_domains, -1 = unknown
+        std::int32_t l3 = -1;       // index into Topology::l3_domains, -1 = unknown
+    };
+
+    // Snapshot of the machine layout, parsed from sysfs on linux (no libnuma
+    // needed) and GetLogicalProcessorInformationEx on windows.
+    // Every domain list holds the cpus that share it, so placement is just
+    // picking cpus out of the right set. When the os wont tell us something the
+    // query falls back to one package, one node and every cpu its own core.
+    struct Topology {
+        std::vector<CpuInfo> cpus{};            // online cpus, ascending
+        std::vector<CpuSet> cores{};            // smt siblings of each physical core
+        std::vector<CpuSet> packages{};         // sockets
+        std::vector<CpuSet> nodes{};            // by numa node id, may hold empty (memory only) nodes
+        std::vector<CpuSet> l2_domains{};       // cpus sharing each L2
+        std::vector<CpuSet> l3_domains{};       // cpus sharing each L3 (last level cache)
+        std::uint32_t cache_line = 64;
+        std::uint64_t l2_bytes = 0;             // per domain, 0 = unknown
+        std::uint64_t l3_bytes = 0;
+
+        [[nodiscard]] CpuSet online() const noexcept;
+        [[nodiscard]] const CpuInfo* find(std::uint32_t cpu) const noexcept;
+
+        // the domain holding cpu (cpu included), empty if unknown
+        [[nodiscard]] CpuSet smt_siblings(std::uint32_t cpu) const noexcept;
+        [[nodiscard]] CpuSet l2_peers(std::uint32_t cpu) const noexcept;
+        [[nodiscard]] CpuSet l3_peers(std::uint32_t cpu) const noexcept;
+        [[nodiscard]] int node_of(std::uint32_t cpu) const noexcept;
+
+        // one cpu per physical core (the lowest sibling), for spreading
+        // threads without doubling up on a core
+        [[nodiscard]] CpuSet one_per_core() const noexcept;
+
+        // Picks two cpus on different physical cores that share the closest
+        // cache: same L2 first, then same L3, then same node, then anything.
+        // allow_smt lets a and b be hyperthreads of one core when that is the
+        // closest option. Only cpus in allowed are considered (empty = all
+        // online). false when fewer than two cpus qualify
+        [[nodiscard]] bool pick_pair(std::uint32_t& a, std::uint32_t& b, bool allow_smt = false, const CpuSet& allowed = CpuSet{}) const noexcept;
+    };
+
+    // platform dependent, reads the topology fresh. false if nothing usable
+    // could be read (out still holds the fallback layout)
+    [[nodiscard]] bool query_topology(Topology& out);
+
+    // read once on first call and cached, call at startup rather than from a hot path
+    [[nodiscard]] const Topology& topology();
+
+    // platform dependent, false when the os refused (offline cpus, cpus
+    // outside the process mask, or a set spanning processor groups on windows)
+    [[nodiscard]] bool set_thread_affinity(std::thread& t, const CpuSet& cpus);
+    [[nodiscard]] bool set_current_thread_affinity(const CpuSet& cpus);
+    [[nodiscard]] bool get_current_thread_affinity(CpuSet& out);
+
+    // cpu the caller is running on right now, -1 if unknown
+    [[nodiscard]] int current_cpu() noexcept;
+}
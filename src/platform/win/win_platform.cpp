@@ -1,5 +1,8 @@
 #if defined(MOO_WIN32)
 #include "platform/platform.h"
+#include "platform/memory.h"
+#include "platform/futex.h"
+#include "platform/topology.h"
 #include <chrono>
 #include <sstream>
 #include <iomanip>
@@ -31,26 +34,19 @@ namespace plat {
         return static_cast<int>(ERROR_SUCCESS);
     }
 
-    void affinitize_thread(std::thread& /*t*/, int /*cpu*/) {
-        // this does not work, for some reason t.native_handle()
-        // is returning a unix-like int-ish handle, not a windows
-        // HANDLE
-
-        // single cpu
-        //const DWORD_PTR mask = (DWORD_PTR(1) << cpu);
-        //::SetThreadAffinityMask(t.native_handle(), mask);
-
-        // multiple cpus
-        //::SetThreadAffinityMask(handle.thread, 1ull << 1 | 1ull << 2);
+    // cpu is the flat index from topology.h, group * 64 + processor.
+    // only works with the msvc runtime, see set_thread_affinity
+    void affinitize_thread(std::thread& t, uint32_t cpu) {
+        (void)set_thread_affinity(t, CpuSet::single(cpu));
     }
 
     void affinitize_current_thread(uint32_t cpu) {
-        ::SetThreadAffinityMask(::GetCurrentThread(), 1ull << cpu);
+        (void)set_current_thread_affinity(CpuSet::single(cpu));
     }
 
     void affinitize_current_thread_to_current_cpu() {
-        DWORD cpu = ::GetCurrentProcessorNumber();
-        affinitize_current_thread(static_cast<uint32_t>(cpu));
+        const int cpu = current_cpu();
+        if (cpu >= 0) affinitize_current_thread(static_cast<uint32_t>(cpu));
     }
 
     std::string timestamp_str() {
@@ -64,5 +60,76 @@ namespace plat {
         oss << std::put_time(&tm, "%Y%m%d_%H%M%S");
         return oss.str();
     }
+
+    void* alloc_huge(std::size_t bytes) {
+        // requires SeLockMemoryPrivilege, without it this fails and
+        // callers fall back to normal pages
+        const SIZE_T large = ::GetLargePageMinimum();
+        if (bytes == 0 || large == 0) return nullptr;
+
+        const SIZE_T rounded = (bytes + large - 1) & ~(large - 1);
+        return ::VirtualAlloc(
+            nullptr, 
+            rounded, 
+            MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, 
+            PAGE_READWRITE
+        );
+    }
+
+    void free_huge(void* ptr, std::size_t /*bytes*/) {
+        if (ptr == nullptr) return;
+        ::VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+
+    int current_numa_node() noexcept {
+        PROCESSOR_NUMBER pn{};
+        ::GetCurrentProcessorNumberEx(&pn);
+        USHORT node = 0;
+        if (!::GetNumaProcessorNodeEx(&pn, &node)) return -1;
+        return static_cast<int>(node);
+    }
+
+    void* alloc_on_node(std::size_t bytes, int node) {
+        if (bytes == 0) return nullptr;
+        if (node < 0) node = current_numa_node();
+        if (node < 0) return nullptr;
+
+        // VirtualAlloc rounds to the page size itself
+        return ::VirtualAllocExNuma(
+            ::GetCurrentProcess(),
+            nullptr,
+            bytes,
+            MEM_RESERVE | MEM_COMMIT,
+            PAGE_READWRITE,
+            static_cast<DWORD>(node)
+        );
+    }
+
+    void free_on_node(void* ptr, std::size_t /*bytes*/) {
+        if (ptr == nullptr) return;
+        ::VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+
+    bool futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::uint64_t timeout_ns, bool /*process_shared*/) noexcept {
+        DWORD timeout_ms = INFINITE;
+        if (timeout_ns != 0) {
+            // WaitOnAddress has millisecond resolution, round up so we never return early
+            const std::uint64_t ms = (timeout_ns + 999'999ull) / 1'000'000ull;
+            timeout_ms = ms >= INFINITE ? INFINITE - 1 : static_cast<DWORD>(ms);
+        }
+
+        if (!::WaitOnAddress(&word, &expected, sizeof(expected), timeout_ms)) {
+            return ::GetLastError() != ERROR_TIMEOUT;
+        }
+        return true;
+    }
+
+    void futex_wake_one(std::atomic<std::uint32_t>& word, bool /*process_shared*/) noexcept {
+        ::WakeByAddressSingle(&word);
+    }
+
+    void futex_wake_all(std::atomic<std::uint32_t>& word, bool /*process_shared*/) noexcept {
+        ::WakeByAddressAll(&word);
+    }
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,160 @@
+#if defined(MOO_WIN32)
+#include "platform/topology.h"
+#include "windows_hdr.h"
+#include <memory>
+#include <new>
+
+namespace plat {
+    // logical cpu i is processor (i % 64) of group (i / 64)
+    static CpuSet from_group(const GROUP_AFFINITY& ga) noexcept {
+        CpuSet s;
+        s.set_word(ga.Group, static_cast<std::uint64_t>(ga.Mask));
+        return s;
+    }
+
+    // a windows thread can only be bound inside one processor group
+    static bool to_group(const CpuSet& cpus, GROUP_AFFINITY& out) noexcept {
+        out = GROUP_AFFINITY{};
+        bool found = false;
+        for (std::uint32_t g = 0; g < CpuSet::word_count; ++g) {
+            const auto bits = cpus.word(g);
+            if (bits == 0) continue;
+            if (found) return false; // spans groups
+            out.Group = static_cast<WORD>(g);
+            out.Mask = static_cast<KAFFINITY>(bits);
+            found = true;
+        }
+        return found;
+    }
+
+    // std::thread::native_handle() is only a HANDLE with the msvc runtime,
+    // mingw's winpthreads hands back a pthread_t
+    static HANDLE native_thread(std::thread& t) noexcept {
+        #if defined(_MSC_VER)
+            return static_cast<HANDLE>(t.native_handle());
+        #else
+            (void)t;
+            return nullptr;
+        #endif
+    }
+
+    static std::uint32_t domain_index(std::vector<CpuSet>& domains, const CpuSet& set) {
+        for (std::size_t i = 0; i < domains.size(); ++i) {
+            if (domains[i] == set) return static_cast<std::uint32_t>(i);
+        }
+        domains.push_back(set);
+        return static_cast<std::uint32_t>(domains.size() - 1);
+    }
+
+    static std::int32_t index_containing(const std::vector<CpuSet>& domains, std::uint32_t cpu) noexcept {
+        for (std::size_t i = 0; i < domains.size(); ++i) {
+            if (domains[i].test(cpu)) return static_cast<std::int32_t>(i);
+        }
+        return -1;
+    }
+
+    bool query_topology(Topology& out) {
+        out = Topology{};
+
+        DWORD len = 0;
+        (void)::GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
+        std::unique_ptr<unsigned char[]> buf(len == 0 ? nullptr : new (std::nothrow) unsigned char[len]);
+        const bool ok = buf != nullptr &&
+            ::GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buf.get()), &len);
+
+        if (ok) {
+            for (DWORD off = 0; off < len;) {
+                const auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buf.get() + off);
+                switch (info->Relationship) {
+                    case RelationProcessorCore: {
+                        CpuSet core;
+                        for (WORD g = 0; g < info->Processor.GroupCount; ++g) core |= from_group(info->Processor.GroupMask[g]);
+                        (void)domain_index(out.cores, core);
+                        break;
+                    }
+                    case RelationProcessorPackage: {
+                        CpuSet package;
+                        for (WORD g = 0; g < info->Processor.GroupCount; ++g) package |= from_group(info->Processor.GroupMask[g]);
+                        (void)domain_index(out.packages, package);
+                        break;
+                    }
+                    case RelationNumaNode: {
+                        const auto id = static_cast<std::size_t>(info->NumaNode.NodeNumber);
+                        if (out.nodes.size() <= id) out.nodes.resize(id + 1);
+                        out.nodes[id] |= from_group(info->NumaNode.GroupMask);
+                        break;
+                    }
+                    case RelationCache: {
+                        const auto& c = info->Cache;
+                        if (c.Type == CacheInstruction) break;
+                        if (c.Level == 1 && c.LineSize != 0) out.cache_line = c.LineSize;
+                        if (c.Level == 2) {
+                            (void)domain_index(out.l2_domains, from_group(c.GroupMask));
+                            out.l2_bytes = c.CacheSize;
+                        } else if (c.Level == 3) {
+                            (void)domain_index(out.l3_domains, from_group(c.GroupMask));
+                            out.l3_bytes = c.CacheSize;
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                }
+                off += info->Size;
+            }
+        }
+
+        if (out.cores.empty()) {
+            SYSTEM_INFO si{};
+            ::GetSystemInfo(&si);
+            const auto n = si.dwNumberOfProcessors == 0 ? 1u : si.dwNumberOfProcessors;
+            for (std::uint32_t i = 0; i < n && i < 64; ++i) out.cores.push_back(CpuSet::single(i));
+        }
+
+        CpuSet online;
+        for (const auto& core : out.cores) online |= core;
+        if (out.packages.empty()) out.packages.push_back(online);
+        if (out.nodes.empty()) out.nodes.push_back(online);
+
+        for (auto cpu = online.next(0); cpu < CpuSet::max_cpus; cpu = online.next(cpu + 1)) {
+            CpuInfo info{};
+            info.cpu = cpu;
+            info.core = static_cast<std::uint32_t>(index_containing(out.cores, cpu));
+            const auto pkg = index_containing(out.packages, cpu);
+            info.package = pkg < 0 ? 0 : static_cast<std::uint32_t>(pkg);
+            const auto node = index_containing(out.nodes, cpu);
+            info.node = node < 0 ? 0 : static_cast<std::uint32_t>(node);
+            info.l2 = index_containing(out.l2_domains, cpu);
+            info.l3 = index_containing(out.l3_domains, cpu);
+            out.cpus.push_back(info);
+        }
+        return ok;
+    }
+
+    bool set_thread_affinity(std::thread& t, const CpuSet& cpus) {
+        GROUP_AFFINITY ga{};
+        const HANDLE h = native_thread(t);
+        if (h == nullptr || !to_group(cpus, ga)) return false;
+        return ::SetThreadGroupAffinity(h, &ga, nullptr) != 0;
+    }
+
+    bool set_current_thread_affinity(const CpuSet& cpus) {
+        GROUP_AFFINITY ga{};
+        if (!to_group(cpus, ga)) return false;
+        return ::SetThreadGroupAffinity(::GetCurrentThread(), &ga, nullptr) != 0;
+    }
+
+    bool get_current_thread_affinity(CpuSet& out) {
+        GROUP_AFFINITY ga{};
+        if (!::GetThreadGroupAffinity(::GetCurrentThread(), &ga)) return false;
+        out = from_group(ga);
+        return true;
+    }
+
+    int current_cpu() noexcept {
+        PROCESSOR_NUMBER pn{};
+        ::GetCurrentProcessorNumberEx(&pn);
+        return static_cast<int>(pn.Group) * 64 + static_cast<int>(pn.Number);
+    }
+}
+#endif
@@ -0,0 +1,47 @@
+#if defined(MOO_LINUX)
+
+#include "print/logger.h"
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace print::detail {
+    void write_slices(LogStream stream, const LogSlice* slices, std::size_t count) noexcept {
+        constexpr std::size_t max_iov = 64;
+        const int fd = stream == LogStream::Out ? STDOUT_FILENO : STDERR_FILENO;
+
+        iovec iov[max_iov];
+        while (count != 0) {
+            const std::size_t n = count < max_iov ? count : max_iov;
+            for (std::size_t i = 0; i < n; ++i) {
+                iov[i].iov_base = const_cast<char*>(slices[i].data);
+                iov[i].iov_len = slices[i].size;
+            }
+
+            // short writes (pipes, terminals) resume mid slice
+            std::size_t first = 0;
+            while (first < n) {
+                const ssize_t wrote = ::writev(fd, iov + first, static_cast<int>(n - first));
+                if (wrote < 0) {
+                    if (errno == EINTR) continue;
+                    return; // nowhere left to report it
+                }
+
+                auto left = static_cast<std::size_t>(wrote);
+                while (first < n && left >= iov[first].iov_len) {
+                    left -= iov[first].iov_len;
+                    ++first;
+                }
+                if (first < n) {
+                    iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+                    iov[first].iov_len -= left;
+                }
+            }
+
+            slices += n;
+            count -= n;
+        }
+    }
+}
+
+#endif
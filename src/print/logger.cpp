@@ -0,0 +1,499 @@
+#include "print/logger.h"
+#include "print/print.h"
+#include "evt/fast_semaphore.h"
+#include "msg/spsc_queue.h"
+#include "platform/futex.h"
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace print::detail {
+    namespace {
+        using Ring = msg::DynSPSCQueue<LogRecord>;
+
+        struct ThreadBuffer {
+            Ring ring;
+            std::optional<Ring::Producer> producer{};
+            std::optional<Ring::Consumer> consumer{};
+            std::size_t wake_at = 0;                    // ring depth that wakes the writer early
+            alignas(64) std::atomic<std::uint64_t> dropped{0}; // only the owning thread writes it
+            std::atomic<bool> retired{false};           // owning thread exited, free once drained
+            std::uint64_t reported = 0;                 // writer only, drops already logged
+
+            explicit ThreadBuffer(std::size_t capacity) : ring(capacity) {}
+        };
+
+        // formatted output waiting for the next writev, lines never straddle
+        // chunks so every chunk is one iovec
+        class OutBatch {
+            public:
+                static constexpr std::size_t chunk_size = 32 * 1024;
+                static constexpr std::size_t max_chunks = 8;
+                static constexpr std::size_t max_line = 2048;
+
+            private:
+                std::unique_ptr<char[]> m_mem{};
+                std::size_t m_used[max_chunks]{};
+                std::size_t m_chunk = 0;
+
+            public:
+                bool init() noexcept {
+                    m_mem.reset(new (std::nothrow) char[chunk_size * max_chunks]);
+                    return m_mem != nullptr;
+                }
+
+                // at least max_line bytes to format into, nullptr when every chunk is full
+                char* line() noexcept {
+                    if (chunk_size - m_used[m_chunk] < max_line) {
+                        if (m_chunk + 1 == max_chunks) return nullptr;
+                        ++m_chunk;
+                    }
+                    return m_mem.get() + m_chunk * chunk_size + m_used[m_chunk];
+                }
+
+                void commit(std::size_t n) noexcept { m_used[m_chunk] += n; }
+
+                void write(LogStream stream) noexcept {
+                    LogSlice slices[max_chunks];
+                    std::size_t count = 0;
+                    for (std::size_t i = 0; i <= m_chunk; ++i) {
+                        if (m_used[i] == 0) continue;
+                        slices[count++] = LogSlice{ m_mem.get() + i * chunk_size, m_used[i] };
+                    }
+                    if (count != 0) write_slices(stream, slices, count);
+
+                    for (auto& used : m_used) used = 0;
+                    m_chunk = 0;
+                }
+        };
+
+        // bounded writer over one line, anything past the end is cut
+        class LineWriter {
+            private:
+                char* m_begin;
+                char* m_pos;
+                char* m_end;
+
+            public:
+                LineWriter(char* begin, std::size_t size) noexcept : m_begin(begin), m_pos(begin), m_end(begin + size) {}
+
+                void put(char c) noexcept {
+                    if (m_pos < m_end) *m_pos++ = c;
+                }
+
+                void put(std::string_view s) noexcept {
+                    const auto room = static_cast<std::size_t>(m_end - m_pos);
+                    const auto n = s.size() < room ? s.size() : room;
+                    std::memcpy(m_pos, s.data(), n);
+                    m_pos += n;
+                }
+
+                template <typename T>
+                void put_int(T value, int base = 10, int width = 0) noexcept {
+                    char tmp[32];
+                    const auto res = std::to_chars(tmp, tmp + sizeof(tmp), value, base);
+                    for (auto len = static_cast<int>(res.ptr - tmp); len < width; ++len) put('0');
+                    put(std::string_view(tmp, static_cast<std::size_t>(res.ptr - tmp)));
+                }
+
+                void put_double(double value) noexcept {
+                    char tmp[64];
+                    const auto res = std::to_chars(tmp, tmp + sizeof(tmp), value, std::chars_format::general, 6);
+                    put(std::string_view(tmp, static_cast<std::size_t>(res.ptr - tmp)));
+                }
+
+                std::size_t size() const noexcept { return static_cast<std::size_t>(m_pos - m_begin); }
+        };
+
+        // walks the tagged args written by ArgWriter
+        class ArgReader {
+            private:
+                const unsigned char* m_pos;
+                const unsigned char* m_end;
+
+            public:
+                explicit ArgReader(const LogRecord& rec) noexcept : m_pos(rec.payload), m_end(rec.payload + rec.size) {}
+
+                [[nodiscard]] bool done() const noexcept { return m_pos >= m_end; }
+
+                // iostream_style prints bools as 1/0 like the old print functions did
+                void render(LineWriter& out, bool iostream_style) noexcept {
+                    const auto type = static_cast<ArgType>(*m_pos++);
+                    if (type == ArgType::Char) {
+                        out.put(static_cast<char>(*m_pos++));
+                        return;
+                    }
+                    if (type == ArgType::Str) {
+                        std::uint16_t len = 0;
+                        std::memcpy(&len, m_pos, sizeof(len));
+                        m_pos += sizeof(len);
+                        out.put(std::string_view(reinterpret_cast<const char*>(m_pos), len));
+                        m_pos += len;
+                        return;
+                    }
+
+                    std::uint64_t raw = 0;
+                    std::memcpy(&raw, m_pos, sizeof(raw));
+                    m_pos += sizeof(raw);
+                    switch (type) {
+                        case ArgType::I64: {
+                            std::int64_t v = 0;
+                            std::memcpy(&v, &raw, sizeof(v));
+                            out.put_int(v);
+                            break;
+                        }
+                        case ArgType::U64: out.put_int(raw); break;
+                        case ArgType::F64: {
+                            double v = 0;
+                            std::memcpy(&v, &raw, sizeof(v));
+                            out.put_double(v);
+                            break;
+                        }
+                        case ArgType::Bool:
+                            if (iostream_style) out.put(raw != 0 ? '1' : '0');
+                            else out.put(raw != 0 ? std::string_view("true") : std::string_view("false"));
+                            break;
+                        case ArgType::Ptr:
+                            out.put(std::string_view("0x"));
+                            out.put_int(raw, 16);
+                            break;
+                        default: break;
+                    }
+                }
+        };
+
+        // "HH:MM:SS.uuuuuu [ id ] LEVEL: body\n", the prefix matches the old
+        // db_print/info_print/error_print output with a utc timestamp in front
+        std::size_t format_record(const LogRecord& rec, char* dst, std::size_t cap) noexcept {
+            LineWriter out(dst, cap - 1); // room for the newline
+
+            const auto secs = rec.timestamp_ns / 1'000'000'000u;
+            const auto day = secs % 86'400u;
+            out.put_int(day / 3600u, 10, 2);
+            out.put(':');
+            out.put_int((day / 60u) % 60u, 10, 2);
+            out.put(':');
+            out.put_int(day % 60u, 10, 2);
+            out.put('.');
+            out.put_int((rec.timestamp_ns % 1'000'000'000u) / 1000u, 10, 6);
+
+            out.put(std::string_view(" [ "));
+            out.put_int(print::detail::__id);
+            out.put(std::string_view(" ] "));
+            switch (rec.level) {
+                case Level::Info: out.put(std::string_view("INFO: ")); break;
+                case Level::Error:
+                    out.put(std::string_view("ERROR "));
+                    if (rec.func != nullptr) {
+                        out.put(std::string_view(rec.func));
+                        out.put(std::string_view(": "));
+                    }
+                    break;
+                default: break;
+            }
+
+            ArgReader args(rec);
+            if (rec.fmt == nullptr) {
+                while (!args.done()) args.render(out, true);
+            } else {
+                for (const char* p = rec.fmt; *p != '\0'; ++p) {
+                    if (p[0] == '{' && p[1] == '}' && !args.done()) {
+                        args.render(out, false);
+                        ++p;
+                        continue;
+                    }
+                    out.put(*p);
+                }
+                while (!args.done()) {
+                    out.put(' ');
+                    args.render(out, false);
+                }
+            }
+            if (rec.truncated != 0) out.put(std::string_view(" [truncated]"));
+
+            const auto n = out.size();
+            dst[n] = '\n';
+            return n + 1;
+        }
+
+        class LogBackend {
+            private:
+                std::mutex m_mtx;
+                std::vector<std::unique_ptr<ThreadBuffer>> m_buffers{};
+                LogConfig m_cfg{};
+                bool m_started = false;
+                bool m_failed = false;
+                std::thread m_thread{};
+
+                OutBatch m_out{};
+                OutBatch m_err{};
+
+                alignas(64) std::atomic<bool> m_stop{false};
+                evt::FastSemaphore m_wake{};
+                alignas(64) std::atomic<std::uint32_t> m_flush_req{0};
+                alignas(64) std::atomic<std::uint32_t> m_flush_done{0};
+                std::atomic<std::uint64_t> m_written{0};
+                std::atomic<std::uint64_t> m_dropped{0};
+
+                void emit(const LogRecord& rec) noexcept {
+                    auto& batch = rec.level == Level::Debug ? m_out : m_err;
+                    char* line = batch.line();
+                    if (line == nullptr) {
+                        batch.write(rec.level == Level::Debug ? LogStream::Out : LogStream::Err);
+                        line = batch.line();
+                    }
+                    batch.commit(format_record(rec, line, OutBatch::max_line));
+                }
+
+                void report_drops(ThreadBuffer& buf, std::uint64_t now_ns) noexcept {
+                    const auto dropped = buf.dropped.load(std::memory_order_relaxed);
+                    if (dropped == buf.reported) return;
+
+                    const auto lost = dropped - buf.reported;
+                    buf.reported = dropped;
+                    m_dropped.fetch_add(lost, std::memory_order_relaxed);
+
+                    LogRecord rec{};
+                    rec.fmt = "logger ring full, dropped {} records";
+                    rec.level = Level::Error;
+                    rec.timestamp_ns = now_ns;
+                    ArgWriter writer(rec);
+                    writer.put(lost);
+                    writer.finish();
+                    emit(rec);
+                }
+
+                // formats everything that was queued when the pass started,
+                // returns how many records were handled
+                std::size_t drain_pass() noexcept {
+                    std::size_t total = 0;
+                    {
+                        std::lock_guard lock(m_mtx);
+                        const auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count());
+
+                        for (auto& buf : m_buffers) {
+                            auto& consumer = *buf->consumer;
+                            std::size_t left = consumer.count_snapshot();
+                            while (left != 0) {
+                                const auto run = consumer.front(left);
+                                if (run.empty()) break;
+                                for (std::size_t i = 0; i < run.size(); ++i) emit(run[i]);
+                                consumer.release(run.size());
+                                left -= run.size();
+                                total += run.size();
+                            }
+                            report_drops(*buf, now);
+                        }
+
+                        // a retired ring has no producer left, once its empty it can go
+                        for (std::size_t i = 0; i < m_buffers.size();) {
+                            auto& buf = m_buffers[i];
+                            if (buf->retired.load(std::memory_order_acquire) && buf->consumer->count_snapshot() == 0) {
+                                m_buffers[i] = std::move(m_buffers.back());
+                                m_buffers.pop_back();
+                                continue;
+                            }
+                            ++i;
+                        }
+                    }
+
+                    m_out.write(LogStream::Out);
+                    m_err.write(LogStream::Err);
+                    m_written.fetch_add(total, std::memory_order_relaxed);
+                    return total;
+                }
+
+                void run() noexcept {
+                    const auto idle_ns = static_cast<std::uint64_t>(m_cfg.flush_interval_us) * 1000u;
+                    std::uint32_t done = 0;
+                    while (true) {
+                        const bool stopping = m_stop.load(std::memory_order_acquire);
+                        const auto req = m_flush_req.load(std::memory_order_acquire);
+                        const auto handled = drain_pass();
+
+                        if (req != done) {
+                            done = req;
+                            m_flush_done.store(done, std::memory_order_release);
+                            plat::futex_wake_all(m_flush_done);
+                        }
+
+                        if (handled == 0) {
+                            if (stopping) break;
+                            (void)m_wake.wait_ns(idle_ns);
+                        }
+                    }
+                }
+
+                // caller holds m_mtx
+                bool start_locked() noexcept {
+                    if (m_started) return true;
+                    if (m_failed) return false;
+
+                    if (!m_out.init() || !m_err.init()) {
+                        m_failed = true;
+                        return false;
+                    }
+
+                    try {
+                        m_thread = std::thread([this]() noexcept { run(); });
+                    } catch (...) {
+                        m_failed = true;
+                        return false;
+                    }
+                    m_started = true;
+                    return true;
+                }
+
+            public:
+                LogBackend() = default;
+                ~LogBackend() {
+                    m_stop.store(true, std::memory_order_release);
+                    (void)m_wake.post();
+                    if (m_thread.joinable()) m_thread.join();
+                }
+
+                LogBackend(const LogBackend&) = delete;
+                LogBackend& operator=(const LogBackend&) = delete;
+                LogBackend(LogBackend&&) = delete;
+                LogBackend& operator=(LogBackend&&) = delete;
+
+                bool configure(const LogConfig& cfg) noexcept {
+                    const auto cap = cfg.ring_capacity;
+                    if (cap == 0 || (cap & (cap - 1)) != 0) return false;
+                    if (cfg.flush_interval_us == 0) return false;   // wait_ns(0) would sleep until a wake
+
+                    std::lock_guard lock(m_mtx);
+                    if (m_started) return false;
+                    m_cfg = cfg;
+                    return true;
+                }
+
+                ThreadBuffer* register_thread() noexcept {
+                    std::lock_guard lock(m_mtx);
+                    if (!start_locked()) return nullptr;
+
+                    try {
+                        auto buf = std::make_unique<ThreadBuffer>(m_cfg.ring_capacity);
+                        if (!buf->ring.is_valid()) return nullptr;
+                        buf->producer = buf->ring.make_producer();
+                        buf->consumer = buf->ring.make_consumer();
+                        buf->wake_at = buf->ring.capacity() - buf->ring.capacity() / 4;
+                        m_buffers.push_back(std::move(buf));
+                    } catch (...) {
+                        return nullptr;
+                    }
+                    return m_buffers.back().get();
+                }
+
+                void wake() noexcept { (void)m_wake.post(); }
+
+                void flush() noexcept {
+                    {
+                        std::lock_guard lock(m_mtx);
+                        if (!m_started) return;
+                    }
+
+                    const auto target = m_flush_req.fetch_add(1, std::memory_order_acq_rel) + 1;
+                    (void)m_wake.post();
+                    while (true) {
+                        const auto done = m_flush_done.load(std::memory_order_acquire);
+                        if (static_cast<std::int32_t>(done - target) >= 0) return;
+                        (void)plat::futex_wait(m_flush_done, done, 1'000'000);
+                    }
+                }
+
+                LogStats stats() const noexcept {
+                    return LogStats{ m_written.load(std::memory_order_relaxed), m_dropped.load(std::memory_order_relaxed) };
+                }
+        };
+
+        // set once the backend is destroyed at exit, threads still logging
+        // after that get their records dropped instead of touching freed rings
+        std::atomic<bool> g_backend_gone{false};
+
+        LogBackend& backend() noexcept {
+            struct Holder {
+                LogBackend backend{};
+                ~Holder() { g_backend_gone.store(true, std::memory_order_release); }
+            };
+            static Holder holder{};
+            return holder.backend;
+        }
+
+        struct ThreadHandle {
+            ThreadBuffer* buf = nullptr;
+            bool failed = false;
+
+            ~ThreadHandle() {
+                if (buf != nullptr && !g_backend_gone.load(std::memory_order_acquire)) {
+                    buf->retired.store(true, std::memory_order_release);
+                }
+                // the writer may free a retired ring at any time, a log from a
+                // later thread_local destructor must not reach it or register again
+                buf = nullptr;
+                failed = true;
+            }
+        };
+
+        thread_local ThreadHandle t_handle{};
+    }
+
+    LogRecord* begin_record(Level level, const char* fmt, const char* func) noexcept {
+        // checked on every record, the ring went with the backend
+        if (g_backend_gone.load(std::memory_order_acquire)) return nullptr;
+
+        auto& handle = t_handle;
+        if (handle.buf == nullptr) {
+            if (handle.failed) return nullptr;
+            handle.buf = backend().register_thread();
+            if (handle.buf == nullptr) {
+                handle.failed = true;
+                return nullptr;
+            }
+        }
+
+        LogRecord* rec = handle.buf->producer->reserve();
+        if (rec == nullptr) {
+            auto& dropped = handle.buf->dropped;
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        rec->fmt = fmt;
+        rec->func = func;
+        rec->timestamp_ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        rec->size = 0;
+        rec->level = level;
+        rec->truncated = 0;
+        return rec;
+    }
+
+    void commit_record() noexcept {
+        auto& buf = *t_handle.buf;
+        buf.producer->commit();
+
+        // the writer polls on its own, only nudge it when the ring is filling up
+        if (buf.producer->count_snapshot() == buf.wake_at) backend().wake();
+    }
+}
+
+namespace print {
+    bool log_init(const LogConfig& cfg) noexcept {
+        return detail::backend().configure(cfg);
+    }
+
+    void log_flush() noexcept {
+        detail::backend().flush();
+    }
+
+    LogStats log_stats() noexcept {
+        return detail::backend().stats();
+    }
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+// compile time level filter, calls below it compile to nothing.
+// 0 = debug, 1 = info, 2 = error, 3 = off. Defaults to debug in debug
+// builds and info in release, define MOO_LOG_LEVEL to override
+#define MOO_LOG_LEVEL_DEBUG 0
+#define MOO_LOG_LEVEL_INFO 1
+#define MOO_LOG_LEVEL_ERROR 2
+#define MOO_LOG_LEVEL_OFF 3
+
+#if !defined(MOO_LOG_LEVEL)
+    #if !defined(NDEBUG)
+        #define MOO_LOG_LEVEL MOO_LOG_LEVEL_DEBUG
+    #else
+        #define MOO_LOG_LEVEL MOO_LOG_LEVEL_INFO
+    #endif
+#endif
+
+namespace print {
+    enum class Level : std::uint8_t {
+        Debug = MOO_LOG_LEVEL_DEBUG,
+        Info = MOO_LOG_LEVEL_INFO,
+        Error = MOO_LOG_LEVEL_ERROR,
+    };
+
+    struct LogConfig {
+        std::uint32_t ring_capacity = 1024;       // records per logging thread, power of 2
+        std::uint32_t flush_interval_us = 1000;   // how long the writer sleeps when every ring is empty, at least 1
+    };
+
+    struct LogStats {
+        std::uint64_t written = 0;  // records formatted and handed to the os
+        std::uint64_t dropped = 0;  // records lost to a full ring
+    };
+
+    namespace detail {
+        enum class ArgType : std::uint8_t {
+            I64,
+            U64,
+            F64,
+            Bool,
+            Char,
+            Ptr,
+            Str,
+        };
+
+        // one log call, fixed size so it lives in a plain SPSC ring. The format
+        // string is stored by pointer, arguments as tagged raw bytes, nothing is
+        // formatted until the writer thread picks it up
+        struct alignas(64) LogRecord {
+            static constexpr std::size_t record_size = 256;
+            static constexpr std::size_t header_size = 8 + 8 + 8 + 4;
+            static constexpr std::size_t payload_size = record_size - header_size;
+
+            const char* fmt;            // "{}" placeholders, nullptr = concatenate the args
+            const char* func;           // prefixed to errors when set
+            std::uint64_t timestamp_ns; // system clock, ns since epoch
+            std::uint16_t size;         // payload bytes used
+            Level level;
+            std::uint8_t truncated;     // ran out of payload, some args were cut
+            unsigned char payload[payload_size];
+        };
+        static_assert(sizeof(LogRecord) == LogRecord::record_size, "LogRecord must stay one 256 byte slot");
+
+        // fills a reserved record, each arg is a type tag then its bytes,
+        // strings are a 2 byte length then the chars (copied, the caller's
+        // buffer may be gone by the time the writer runs)
+        class ArgWriter {
+            private:
+                LogRecord& m_rec;
+                std::size_t m_pos = 0;
+
+                template <typename T>
+                static constexpr bool always_false = false;
+
+                void put_raw(ArgType type, const void* value, std::size_t size) noexcept {
+                    if (m_pos + 1 + size > LogRecord::payload_size) {
+                        m_rec.truncated = 1;
+                        return;
+                    }
+                    m_rec.payload[m_pos++] = static_cast<unsigned char>(type);
+                    std::memcpy(m_rec.payload + m_pos, value, size);
+                    m_pos += size;
+                }
+
+                void put_str(std::string_view s) noexcept {
+                    if (m_pos + 3 > LogRecord::payload_size) {
+                        m_rec.truncated = 1;
+                        return;
+                    }
+
+                    std::size_t len = s.size();
+                    if (len > LogRecord::payload_size - m_pos - 3) {
+                        len = LogRecord::payload_size - m_pos - 3;
+                        m_rec.truncated = 1;
+                    }
+
+                    const auto len16 = static_cast<std::uint16_t>(len);
+                    m_rec.payload[m_pos++] = static_cast<unsigned char>(ArgType::Str);
+                    std::memcpy(m_rec.payload + m_pos, &len16, sizeof(len16));
+                    m_pos += sizeof(len16);
+                    std::memcpy(m_rec.payload + m_pos, s.data(), len);
+                    m_pos += len;
+                }
+
+            public:
+                explicit ArgWriter(LogRecord& rec) noexcept : m_rec(rec) {}
+
+                template <typename T>
+                void put(const T& value) noexcept {
+                    using U = std::decay_t<T>;
+                    if constexpr (std::is_same_v<U, bool>) {
+                        const std::uint64_t v = value ? 1u : 0u;
+                        put_raw(ArgType::Bool, &v, sizeof(v));
+                    } else if constexpr (std::is_same_v<U, char>) {
+                        put_raw(ArgType::Char, &value, 1);
+                    } else if constexpr (std::is_enum_v<U>) {
+                        put(static_cast<std::underlying_type_t<U>>(value));
+                    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+                        const auto v = static_cast<std::int64_t>(value);
+                        put_raw(ArgType::I64, &v, sizeof(v));
+                    } else if constexpr (std::is_integral_v<U>) {
+                        const auto v = static_cast<std::uint64_t>(value);
+                        put_raw(ArgType::U64, &v, sizeof(v));
+                    } else if constexpr (std::is_floating_point_v<U>) {
+                        const auto v = static_cast<double>(value);
+                        put_raw(ArgType::F64, &v, sizeof(v));
+                    } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+                        const char* p = value;
+                        put_str(p != nullptr ? std::string_view(p) : std::string_view("(null)"));
+                    } else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+                        const auto v = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(static_cast<const void*>(value)));
+                        put_raw(ArgType::Ptr, &v, sizeof(v));
+                    } else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+                        put_str(std::string_view(value));
+                    } else {
+                        static_assert(always_false<U>, "log args must be numbers, chars, strings or pointers");
+                    }
+                }
+
+                void finish() noexcept { m_rec.size = static_cast<std::uint16_t>(m_pos); }
+        };
+
+        // reserves the next slot in this threads ring (registering the ring on
+        // first use), nullptr when the ring is full and the record is dropped
+        [[nodiscard]] LogRecord* begin_record(Level level, const char* fmt, const char* func) noexcept;
+        void commit_record() noexcept;
+
+        enum class LogStream : std::uint8_t {
+            Out,
+            Err,
+        };
+
+        struct LogSlice {
+            const char* data;
+            std::size_t size;
+        };
+
+        // platform dependent, writes every slice in order (writev on linux)
+        void write_slices(LogStream stream, const LogSlice* slices, std::size_t count) noexcept;
+    }
+
+    // Asynchronous logger. Each logging thread gets its own SPSC ring of
+    // fixed size records, the call site only copies the format pointer and
+    // raw args into its ring (no lock, no allocation, no syscall). One
+    // background thread formats the records, batches them and writes each
+    // batch to stdout/stderr with a single writev.
+    // A full ring drops the record instead of blocking, see log_stats().
+    // NOTE: fmt must be a string literal (or otherwise outlive the record),
+    // only its pointer is queued
+    // NOTE: output is written shortly after the call, log_flush() waits for it
+    //
+    // "{}" in fmt is replaced by the next arg, args left over are appended
+    template <typename... Args>
+    inline void logf(Level level, const char* fmt, const Args&... args) noexcept {
+        detail::LogRecord* rec = detail::begin_record(level, fmt, nullptr);
+        if (rec == nullptr) return;
+        detail::ArgWriter writer(*rec);
+        (writer.put(args), ...);
+        writer.finish();
+        detail::commit_record();
+    }
+
+    // iostream style, every arg is written back to back with no separators
+    template <typename... Args>
+    inline void log_concat(Level level, const char* func, const Args&... args) noexcept {
+        detail::LogRecord* rec = detail::begin_record(level, nullptr, func);
+        if (rec == nullptr) return;
+        detail::ArgWriter writer(*rec);
+        (writer.put(args), ...);
+        writer.finish();
+        detail::commit_record();
+    }
+
+    // must run before the first log call to take effect, false once the
+    // logger is already running or cfg is out of range
+    [[nodiscard]] bool log_init(const LogConfig& cfg = LogConfig{}) noexcept;
+
+    // blocks until everything queued before the call has been written
+    void log_flush() noexcept;
+
+    [[nodiscard]] LogStats log_stats() noexcept;
+}
+
+#if MOO_LOG_LEVEL <= MOO_LOG_LEVEL_DEBUG
+    #define MOO_LOG_DEBUG(...) print::logf(print::Level::Debug, __VA_ARGS__)
+#else
+    #define MOO_LOG_DEBUG(...) do { (void)0; } while (0)
+#endif
+
+#if MOO_LOG_LEVEL <= MOO_LOG_LEVEL_INFO
+    #define MOO_LOG_INFO(...) print::logf(print::Level::Info, __VA_ARGS__)
+#else
+    #define MOO_LOG_INFO(...) do { (void)0; } while (0)
+#endif
+
+#if MOO_LOG_LEVEL <= MOO_LOG_LEVEL_ERROR
+    #define MOO_LOG_ERROR(...) print::logf(print::Level::Error, __VA_ARGS__)
+#else
+    #define MOO_LOG_ERROR(...) do { (void)0; } while (0)
+#endif
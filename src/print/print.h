@@ -4,6 +4,7 @@
 #include <utility>
 #include <mutex>
 #include <cstdint>
+#include "print/logger.h"
 
 #if defined(__clang__) || defined(__GNUC__)
     #define FUNC_SIG __PRETTY_FUNCTION__
@@ -55,14 +56,25 @@ namespace print {
     }
 }
 
-#if !defined(NDEBUG) // debug
-    #define PRINT(...) print::db_print(__VA_ARGS__)
-    #define ERR_VERBOSE(...) print::error_print(FUNC_SIG, __VA_ARGS__)
-    #define ERR_PRINT(...) print::error_print(__VA_ARGS__)
-    #define LOG(...) print::info_print(__VA_ARGS__)
-#else // release
+// the macros go through the async logger (see logger.h), MOO_LOG_LEVEL
+// picks which ones compile in. By default debug builds keep all of them and
+// release drops PRINT only, same as before
+#if MOO_LOG_LEVEL <= MOO_LOG_LEVEL_DEBUG
+    #define PRINT(...) print::log_concat(print::Level::Debug, nullptr, __VA_ARGS__)
+#else
     #define PRINT(...) do { (void)0; } while (0)
-    #define ERR_VERBOSE(...) print::error_print(FUNC_SIG, __VA_ARGS__)
-    #define ERR_PRINT(...) print::error_print(__VA_ARGS__)
-    #define LOG(...) print::info_print(__VA_ARGS__)
-#endif
\ No newline at end of file
+#endif
+
+#if MOO_LOG_LEVEL <= MOO_LOG_LEVEL_INFO
+    #define LOG(...) print::log_concat(print::Level::Info, nullptr, __VA_ARGS__)
+#else
+    #define LOG(...) do { (void)0; } while (0)
+#endif
+
+#if MOO_LOG_LEVEL <= MOO_LOG_LEVEL_ERROR
+    #define ERR_VERBOSE(...) print::log_concat(print::Level::Error, FUNC_SIG, __VA_ARGS__)
+    #define ERR_PRINT(...) print::log_concat(print::Level::Error, nullptr, __VA_ARGS__)
+#else
+    #define ERR_VERBOSE(...) do { (void)0; } while (0)
+    #define ERR_PRINT(...) do { (void)0; } while (0)
+#endif
@@ -0,0 +1,27 @@
+#if defined(MOO_WIN32)
+
+#include "print/logger.h"
+#include "windows_hdr.h"
+
+namespace print::detail {
+    // no writev on windows, one WriteFile per slice (each slice is a whole
+    // chunk of formatted lines so this is still a handful of calls per batch)
+    void write_slices(LogStream stream, const LogSlice* slices, std::size_t count) noexcept {
+        HANDLE out = ::GetStdHandle(stream == LogStream::Out ? STD_OUTPUT_HANDLE : STD_ERROR_HANDLE);
+        if (out == nullptr || out == INVALID_HANDLE_VALUE) return;
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const char* data = slices[i].data;
+            std::size_t left = slices[i].size;
+            while (left != 0) {
+                const DWORD want = left > 0x7FFFFFFFu ? 0x7FFFFFFFu : static_cast<DWORD>(left);
+                DWORD wrote = 0;
+                if (!::WriteFile(out, data, want, &wrote, nullptr) || wrote == 0) return;
+                data += wrote;
+                left -= wrote;
+            }
+        }
+    }
+}
+
+#endif
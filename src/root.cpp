@@ -2,13 +2,50 @@
 #include <iostream>
 #include "msg/spsc_queue.h"
 #include "msg/spmc_queue.h"
+#include "msg/mpsc_queue.h"
+#include "msg/mpmc_queue.h"
+#include "msg/span.h"
+#include "msg/ring_buffer.h"
+#include "msg/schema.h"
+#include "msg/wait_strategy.h"
+#include "evt/async_event.h"
 #include "evt/event.h"
+#include "evt/fast_semaphore.h"
+#include "evt/inplace_function.h"
+#include "exec/coro.h"
+#include "exec/thread_pool.h"
+#include "exec/work_deque.h"
 #include "evt/named_semaphore.h"
+#include "evt/notifier.h"
 #include "evt/semaphore.h"
+#include "instr/histogram.h"
+#include "instr/instr.h"
+#include "instr/metrics.h"
+#include "instr/shm_stats.h"
+#include "instr/tsc.h"
 #include "platform/platform.h"
+#include "platform/memory.h"
+#include "platform/futex.h"
+#include "platform/topology.h"
+#include "print/logger.h"
 #include "print/print.h"
+#include "shm/ipc_bus.h"
+#include "shm/journal.h"
 #include "shm/shm.h"
+#include "shm/shm_queue.h"
+#include "shm/shm_semaphore.h"
+#include "shm/shm_slab.h"
+#include "shm/shm_snapshot.h"
+#include "sock/codec.h"
+#include "sock/framing.h"
+#include "sock/io_ring.h"
+#include "sock/reactor.h"
+#include "sock/reliable_mcast.h"
+#include "sock/rpc_channel.h"
+#include "sock/sharded_listener.h"
 #include "sock/socket_context.h"
+#include "sock/socket_handle.h"
+#include "sock/socket_options.h"
 #include "sock/socket_result.h"
 #include "sock/tcp_socket.h"
 #include "sock/udp_multicast.h"
@@ -54,6 +91,12 @@ inline void do_nothing() {
         std::cerr << "Failed to pop item from broadcast channel\n";
     }
 
+    msg::DynSPSCQueue<int> dyn_channel(4096);
+    if (dyn_channel.is_valid()) {
+        auto dyn_producer = std::move(dyn_channel.make_producer().value());
+        (void)dyn_producer.push(7);
+    }
+
     evt::Event<int> OnMessage;
     const auto sub = OnMessage.subscribe([](int x){
         std::cout << x << std::endl;
@@ -0,0 +1,319 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include "shm/shm.h"
+#include "shm/shm_queue.h"
+#include "evt/event.h"
+#include "evt/named_semaphore.h"
+#include "msg/wait_strategy.h"
+
+namespace shm {
+    namespace detail {
+        constexpr std::uint32_t bus_magic = 0x4D4F4F42; // "MOOB"
+        constexpr std::uint32_t bus_version = 1;
+
+        // futex word pair living in the shared region, same protocol as
+        // msg::SpinParkWait: waiters announce themselves, the publisher only
+        // bumps the epoch and wakes when someone is parked
+        struct IpcSignalWord {
+            alignas(cache_line) std::atomic<std::uint32_t> epoch;
+            std::atomic<std::uint32_t> waiters;
+        };
+
+        // lives at the front of a topic region, the ShmQueue follows at
+        // queue_offset. layout must not change without bumping bus_version
+        struct IpcTopicHeader {
+            std::atomic<std::uint32_t> magic;       // written last by the creator
+            std::uint32_t version;
+            std::uint64_t reserved;
+            IpcSignalWord signal;
+        };
+
+        constexpr std::size_t bus_queue_offset = align_up(sizeof(IpcTopicHeader), cache_line);
+    }
+
+    // Cross process wakeup over a shared IpcSignalWord. Linux parks on the
+    // word itself with a process shared futex. WaitOnAddress does not work
+    // across processes, so windows parks on a named semaphore instead and
+    // notify() posts it once per parked waiter.
+    class IpcSignal {
+        public:
+            static constexpr std::uint32_t spin_iterations = 1024;
+            static constexpr std::uint32_t yield_iterations = 64;
+
+        private:
+            detail::IpcSignalWord* m_word = nullptr;
+            evt::NamedSemaphore m_sem;
+
+            // platform dependent, false on timeout
+            bool park(std::uint32_t epoch, std::uint64_t timeout_ns) noexcept;
+            void wake() noexcept;
+
+        public:
+            // sem_id only names the windows semaphore
+            explicit IpcSignal(std::int64_t sem_id) : m_sem(sem_id) {}
+
+            // platform dependent
+            [[nodiscard]] ShmResult bind(detail::IpcSignalWord* word) noexcept;
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_word != nullptr; }
+
+            template <typename Ready>
+            bool wait(Ready&& ready, std::uint32_t timeout_us) noexcept {
+                assert(m_word != nullptr && "Invalid signal: not bound");
+                const msg::detail::Deadline deadline(timeout_us);
+                for (std::uint32_t i = 0; i < spin_iterations; ++i) {
+                    if (ready()) return true;
+                    msg::detail::cpu_relax();
+                }
+
+                for (std::uint32_t i = 0; i < yield_iterations; ++i) {
+                    if (ready()) return true;
+                    if (deadline.expired()) return false;
+                    std::this_thread::yield();
+                }
+
+                while (true) {
+                    m_word->waiters.fetch_add(1, std::memory_order_seq_cst);
+                    const auto epoch = m_word->epoch.load(std::memory_order_seq_cst);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                    if (ready()) {
+                        m_word->waiters.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+
+                    const bool woken = park(epoch, deadline.remaining_ns());
+                    m_word->waiters.fetch_sub(1, std::memory_order_relaxed);
+
+                    if (ready()) return true;
+                    if (!woken || deadline.expired()) return false;
+                }
+            }
+
+            // publisher side, free unless a subscriber somewhere is parked
+            void notify() noexcept {
+                assert(m_word != nullptr && "Invalid signal: not bound");
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_word->waiters.load(std::memory_order_relaxed) != 0) wake();
+            }
+
+            // wakes every parked waiter whether or not anything was published
+            void wake_all() noexcept {
+                if (m_word != nullptr) wake();
+            }
+    };
+
+    struct IpcTopicConfig {
+        std::size_t capacity = 1024;        // ring slots, power of 2
+        std::size_t max_subscribers = 16;   // subscribing processes (consumer slots)
+        ShmOptions shm{};
+    };
+
+    // One topic of a local pub/sub bus: a Shm region holding an SPMC
+    // broadcast ShmQueue<T> plus a wake word, so a publisher in one process
+    // reaches subscribers in others without going near the network stack.
+    // A process takes one consumer slot with claim_subscriber() and fans
+    // each message out to its local callbacks through an evt::Event, so
+    // subscribe() has the same shape as Event::subscribe. Callbacks are
+    // handed a reference straight into the ring (no copy), copy out anything
+    // kept past the callback. Subscribers that are not keeping up back pressure
+    // the publisher, publish() returns false while the slowest one is a full ring behind.
+    // Topic ids share the Shm id space, creator and openers must pass the
+    // same IpcTopicConfig.
+    // NOTE: a process that dies holding a claim leaves it set, like ShmQueue
+    template <typename T>
+    class IpcTopic {
+        public:
+            using Event = evt::Event<const T&>;
+            using Subscription = typename Event::Subscription;
+            using Queue = ShmQueue<T>;
+
+        private:
+            std::int32_t m_id;
+            IpcTopicConfig m_cfg;
+            Shm m_shm;
+            Queue m_queue;
+            IpcSignal m_signal;
+            detail::IpcTopicHeader* m_header = nullptr;
+            std::optional<typename Queue::Producer> m_producer{};
+            std::optional<typename Queue::Consumer> m_consumer{};
+            Event m_event;
+
+            std::thread m_dispatcher{};
+            std::atomic<bool> m_stop{false};
+
+            // keeps the windows semaphore names out of the way of the
+            // NamedSemaphore ids callers pick themselves
+            static constexpr std::int64_t sem_id(std::int32_t id) noexcept {
+                return static_cast<std::int64_t>(static_cast<std::uint32_t>(id)) | (std::int64_t{1} << 40);
+            }
+
+            static std::size_t region_size(const IpcTopicConfig& cfg) noexcept {
+                return detail::bus_queue_offset + Queue::required_size(cfg.capacity, cfg.max_subscribers);
+            }
+
+        public:
+            IpcTopic(std::int32_t id, const IpcTopicConfig& cfg = IpcTopicConfig{})
+                : m_id(id), m_cfg(cfg), m_shm(id, region_size(cfg), cfg.shm), m_signal(sem_id(id)) {}
+
+            ~IpcTopic() {
+                stop_dispatch();
+                m_producer.reset();
+                m_consumer.reset();
+            }
+
+            IpcTopic(const IpcTopic&) = delete;
+            IpcTopic& operator=(const IpcTopic&) = delete;
+            IpcTopic(IpcTopic&&) = delete;
+            IpcTopic& operator=(IpcTopic&&) = delete;
+
+            // makes the region and the ring, AlreadyExists if the topic is there
+            [[nodiscard]] ShmResult create() {
+                auto r = m_shm.create();
+                if (!r.ok()) return r;
+
+                auto* base = m_shm.map_to_type<std::byte>(0);
+                if (base == nullptr) return { ShmErr::InvalidOffset, ShmOp::Create };
+
+                auto* header = new (base) detail::IpcTopicHeader{};
+                header->version = detail::bus_version;
+                header->signal.epoch.store(0, std::memory_order_relaxed);
+                header->signal.waiters.store(0, std::memory_order_relaxed);
+
+                r = m_queue.create(m_shm, m_cfg.capacity, m_cfg.max_subscribers, detail::bus_queue_offset);
+                if (!r.ok()) return r;
+                r = m_signal.bind(&header->signal);
+                if (!r.ok()) return r;
+
+                // publish last, open() fails with BadMagic until this is visible
+                header->magic.store(detail::bus_magic, std::memory_order_release);
+                m_header = header;
+                return { ShmErr::None, ShmOp::Create };
+            }
+
+            // attaches to a topic another process created
+            [[nodiscard]] ShmResult open() {
+                auto r = m_shm.open();
+                if (!r.ok()) return r;
+
+                auto* header = m_shm.map_to_type<detail::IpcTopicHeader>(0);
+                if (header == nullptr) return { ShmErr::InvalidOffset, ShmOp::Attach };
+                if (header->magic.load(std::memory_order_acquire) != detail::bus_magic) return { ShmErr::BadMagic, ShmOp::Attach };
+                if (header->version != detail::bus_version) return { ShmErr::VersionMismatch, ShmOp::Attach };
+
+                r = m_queue.attach(m_shm, detail::bus_queue_offset);
+                if (!r.ok()) return r;
+                r = m_signal.bind(&header->signal);
+                if (!r.ok()) return r;
+
+                m_header = header;
+                return { ShmErr::None, ShmOp::Attach };
+            }
+
+            // create() or open(), whichever applies
+            [[nodiscard]] ShmResult create_or_open() {
+                auto r = create();
+                if (r.code == ShmErr::AlreadyExists) r = open();
+                return r;
+            }
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_header != nullptr; }
+            [[nodiscard]] std::int32_t id() const noexcept { return m_id; }
+            [[nodiscard]] Queue& queue() noexcept { return m_queue; }
+
+            // the single publisher across every process, UnknownError when
+            // another process (or an earlier call) holds it
+            [[nodiscard]] ShmResult claim_publisher() noexcept {
+                if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Write };
+                if (m_producer) return { ShmErr::DoubleOpen, ShmOp::Write };
+                m_producer = m_queue.make_producer();
+                if (!m_producer) return { ShmErr::UnknownError, ShmOp::Write };
+                return { ShmErr::None, ShmOp::Write };
+            }
+
+            // takes this process' consumer slot, messages published from now on
+            // are delivered. call before start_dispatch()/dispatch().
+            // TooLarge when every slot is taken
+            [[nodiscard]] ShmResult claim_subscriber() noexcept {
+                if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Read };
+                if (m_consumer) return { ShmErr::DoubleOpen, ShmOp::Read };
+                m_consumer = m_queue.make_consumer();
+                if (!m_consumer) return { ShmErr::TooLarge, ShmOp::Read };
+                return { ShmErr::None, ShmOp::Read };
+            }
+
+            // false when the slowest subscriber is a whole ring behind
+            [[nodiscard]] bool publish(const T& item) noexcept {
+                assert(m_producer && "Invalid topic: claim_publisher() first");
+                if (!m_producer->push(item)) return false;
+                m_signal.notify();
+                return true;
+            }
+
+            // zero copy publishing: reserve() from the producer, fill the slots,
+            // commit() them, then notify() once for the whole batch
+            [[nodiscard]] typename Queue::Producer& publisher() noexcept {
+                assert(m_producer && "Invalid topic: claim_publisher() first");
+                return *m_producer;
+            }
+            void notify() noexcept { m_signal.notify(); }
+
+            // local callbacks, same as evt::Event::subscribe. callbacks run on
+            // whichever thread calls dispatch()
+            template <typename F>
+            [[nodiscard]] Subscription subscribe(F&& f) {
+                return m_event.subscribe(std::forward<F>(f));
+            }
+
+            // waits up to timeout_us (0 = forever) for messages, then emits
+            // everything queued to the local subscribers. returns messages delivered
+            std::size_t dispatch(std::uint32_t timeout_us = 0) {
+                assert(m_consumer && "Invalid topic: claim_subscriber() first");
+                auto& consumer = *m_consumer;
+                const bool ready = m_signal.wait([&]() noexcept {
+                    return m_stop.load(std::memory_order_relaxed) || consumer.count_snapshot() != 0;
+                }, timeout_us);
+                if (!ready) return 0;
+
+                // at most one ring's worth, a busy publisher cant keep us here
+                std::size_t delivered = 0;
+                while (delivered < m_queue.capacity()) {
+                    const auto items = consumer.front(64);
+                    if (items.empty()) break;
+                    for (const T& item : items) m_event.emit(item);
+                    consumer.release(items.size());
+                    delivered += items.size();
+                }
+                return delivered;
+            }
+
+            // background thread calling dispatch() until stop_dispatch()
+            [[nodiscard]] ShmResult start_dispatch() {
+                if (!m_consumer) return { ShmErr::NotInitialized, ShmOp::Read };
+                if (m_dispatcher.joinable()) return { ShmErr::DoubleOpen, ShmOp::Read };
+                m_stop.store(false, std::memory_order_relaxed);
+                m_dispatcher = std::thread([this]() {
+                    while (!m_stop.load(std::memory_order_acquire)) (void)dispatch();
+                });
+                return { ShmErr::None, ShmOp::Read };
+            }
+
+            // NOTE: wakes every parked subscriber of the topic in every process, they
+            // just go back to sleep
+            void stop_dispatch() noexcept {
+                if (!m_dispatcher.joinable()) return;
+                m_stop.store(true, std::memory_order_release);
+                m_signal.wake_all();
+                m_dispatcher.join();
+            }
+
+            [[nodiscard]] std::size_t subscriber_count() const noexcept { return m_event.subscriber_count(); }
+    };
+}
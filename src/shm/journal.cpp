@@ -0,0 +1,447 @@
+#include "shm/journal.h"
+#include <chrono>
+#include <cstdio>
+#include <new>
+
+namespace shm {
+    namespace {
+        using Header = detail::JournalSegmentHeader;
+        using Entry = detail::JournalIndexEntry;
+        using Record = detail::JournalRecordHeader;
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "JournalSegmentHeader needs lock free 64-bit atomics to be process shared");
+
+        constexpr std::uint64_t align_up(std::uint64_t v, std::uint64_t a) noexcept {
+            return (v + a - 1) & ~(a - 1);
+        }
+
+        constexpr std::uint64_t index_offset() noexcept {
+            return align_up(sizeof(Header), 64);
+        }
+
+        // records start on a page so the header/index flush never touches them
+        std::uint64_t data_offset(std::uint32_t index_capacity) noexcept {
+            return align_up(index_offset() + std::uint64_t{index_capacity} * sizeof(Entry), 4096);
+        }
+
+        std::string segment_path(const JournalConfig& cfg, std::uint32_t no) {
+            char num[16];
+            std::snprintf(num, sizeof(num), "%08u", static_cast<unsigned>(no));
+            return cfg.dir + "/" + cfg.name + "." + num + ".jnl";
+        }
+
+        bool file_exists(const std::string& path) noexcept {
+            std::FILE* f = std::fopen(path.c_str(), "rb");
+            if (f == nullptr) return false;
+            std::fclose(f);
+            return true;
+        }
+
+        ShmOptions with_path(const ShmOptions& opts, const std::string& path) noexcept {
+            ShmOptions out = opts;
+            out.file_path = path.c_str();
+            out.page_size = ShmPageSize::Default;
+            return out;
+        }
+
+        // checks the header of a freshly mapped segment and points the view at it
+        ShmErr bind(detail::JournalSegment& seg, std::uint64_t schema_hash) noexcept {
+            auto* h = seg.shm.map_to_type<Header>(0);
+            if (h == nullptr) return ShmErr::SizeMismatch;
+
+            const auto magic = h->magic.load(std::memory_order_acquire);
+            if (magic == 0) return ShmErr::NotInitialized; // creator still filling it in
+            if (magic != detail::journal_magic) return ShmErr::BadMagic;
+            if (h->version != detail::journal_version) return ShmErr::VersionMismatch;
+            if (h->segment_size != seg.shm.total_size() || h->index_stride == 0 ||
+                h->index_offset + std::uint64_t{h->index_capacity} * sizeof(Entry) > h->data_offset ||
+                h->data_offset >= h->segment_size) {
+                return ShmErr::LayoutMismatch;
+            }
+            if (schema_hash != 0 && h->schema_hash != schema_hash) return ShmErr::SchemaMismatch;
+
+            auto* base = reinterpret_cast<std::byte*>(h);
+            seg.header = h;
+            seg.index = reinterpret_cast<Entry*>(base + h->index_offset);
+            seg.data = base + h->data_offset;
+            seg.capacity = h->segment_size - h->data_offset;
+            return ShmErr::None;
+        }
+    }
+
+    namespace detail {
+        JournalSegment::JournalSegment(std::string p, std::uint32_t no, std::size_t size, const ShmOptions& opts) :
+            path(std::move(p)), shm(static_cast<std::int32_t>(no), size, with_path(opts, path)) {}
+    }
+
+    //
+    // writer
+    //
+
+    JournalWriter::JournalWriter(const JournalConfig& cfg) : m_cfg(cfg) {
+        if (m_cfg.index_stride == 0) m_cfg.index_stride = 1;
+    }
+
+    JournalWriter::~JournalWriter() {
+        close();
+    }
+
+    std::size_t JournalWriter::max_record() const noexcept {
+        const auto data = data_offset(m_cfg.index_capacity) + sizeof(Record);
+        if (m_cfg.segment_size <= data) return 0;
+        const auto max = (m_cfg.segment_size - data) & ~(detail::journal_align - 1);
+        return max > UINT32_MAX ? UINT32_MAX : static_cast<std::size_t>(max);
+    }
+
+    ShmResult JournalWriter::start_segment(std::uint32_t no, std::uint64_t first_seq) noexcept {
+        if (max_record() == 0) return { ShmErr::TooLarge, ShmOp::Create };
+
+        auto seg = std::make_unique<Segment>(segment_path(m_cfg, no), no, m_cfg.segment_size, m_cfg.shm);
+        const auto res = seg->shm.create();
+        if (!res.ok()) return res;
+
+        void* at = seg->shm.map_to_type<Header>(0);
+        if (at == nullptr) return { ShmErr::SizeMismatch, ShmOp::Create };
+        auto* h = new (at) Header;
+        h->version = detail::journal_version;
+        h->segment = no;
+        h->index_stride = m_cfg.index_stride;
+        h->index_capacity = m_cfg.index_capacity;
+        h->reserved = 0;
+        h->first_seq = first_seq;
+        h->segment_size = m_cfg.segment_size;
+        h->index_offset = index_offset();
+        h->data_offset = data_offset(m_cfg.index_capacity);
+        h->schema_hash = m_cfg.schema_hash;
+        h->end.store(0, std::memory_order_relaxed);
+        h->next_seq.store(first_seq, std::memory_order_relaxed);
+        h->index_count.store(0, std::memory_order_relaxed);
+        h->sealed.store(0, std::memory_order_relaxed);
+        h->magic.store(detail::journal_magic, std::memory_order_release);
+
+        const ShmErr err = bind(*seg, 0);
+        if (err != ShmErr::None) return { err, ShmOp::Create };
+
+        {
+            std::lock_guard<std::mutex> lock(m_seg_mtx);
+            if (m_cur != nullptr) {
+                // readers move on once they see the seal, the syncer does the final flush
+                m_cur->header->sealed.store(1, std::memory_order_release);
+                m_retired.push_back(std::move(m_cur));
+            }
+            m_cur = std::move(seg);
+        }
+        m_segment = no;
+        m_end = 0;
+        m_since_index = 0;
+        return res;
+    }
+
+    ShmResult JournalWriter::rotate() noexcept {
+        return start_segment(m_segment + 1, m_next_seq);
+    }
+
+    ShmResult JournalWriter::open() {
+        if (m_cur != nullptr) return { ShmErr::DoubleOpen, ShmOp::Open };
+
+        std::uint32_t count = 0;
+        while (file_exists(segment_path(m_cfg, count))) ++count;
+
+        if (count == 0) {
+            m_next_seq = 1;
+            const auto res = start_segment(0, m_next_seq);
+            if (!res.ok()) return res;
+        } else {
+            // carry on in the last segment, or after it when it was sealed
+            const auto last = count - 1;
+            auto seg = std::make_unique<Segment>(segment_path(m_cfg, last), last, 0, m_cfg.shm);
+            const auto res = seg->shm.open();
+            if (!res.ok()) return res;
+
+            const ShmErr err = bind(*seg, m_cfg.schema_hash);
+            if (err != ShmErr::None) return { err, ShmOp::Open };
+
+            const auto& h = *seg->header;
+            m_next_seq = h.next_seq.load(std::memory_order_acquire);
+            m_end = h.end.load(std::memory_order_acquire);
+            m_since_index = static_cast<std::uint32_t>((m_next_seq - h.first_seq) % h.index_stride);
+            m_segment = last;
+            seg->synced = m_end;
+            const bool sealed = h.sealed.load(std::memory_order_acquire) != 0;
+            {
+                std::lock_guard<std::mutex> lock(m_seg_mtx);
+                m_cur = std::move(seg);
+            }
+
+            if (sealed) {
+                const auto next = start_segment(count, m_next_seq);
+                if (!next.ok()) {
+                    close();
+                    return next;
+                }
+            }
+        }
+
+        if (m_cfg.sync_interval_ms != 0) {
+            m_stop = false;
+            m_syncer = std::thread(&JournalWriter::sync_loop, this);
+        }
+        return { ShmErr::None, ShmOp::Open };
+    }
+
+    void JournalWriter::close() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(m_seg_mtx);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_syncer.joinable()) m_syncer.join();
+
+        std::lock_guard<std::mutex> lock(m_seg_mtx);
+        if (m_cur != nullptr) (void)flush_locked(false);
+        m_retired.clear();
+        m_cur.reset();
+    }
+
+    ShmResult JournalWriter::reserve(std::size_t size, std::byte*& out) noexcept {
+        if (m_cur == nullptr) return { ShmErr::NotOpen, ShmOp::Write };
+        if (size > max_record()) return { ShmErr::TooLarge, ShmOp::Write };
+
+        if (m_end + detail::journal_record_bytes(size) > m_cur->capacity) {
+            const auto res = rotate();
+            if (!res.ok()) return res;
+        }
+        out = m_cur->data + m_end + sizeof(Record);
+        return { ShmErr::None, ShmOp::Write };
+    }
+
+    void JournalWriter::commit(std::size_t size, std::uint64_t timestamp) noexcept {
+        assert(m_cur != nullptr && "JournalWriter::commit without a reserve");
+        auto& seg = *m_cur;
+        auto& h = *seg.header;
+        const auto at = m_end;
+        const auto seq = m_next_seq++;
+
+        auto* rec = reinterpret_cast<Record*>(seg.data + at);
+        rec->size = static_cast<std::uint32_t>(size);
+        rec->reserved = 0;
+        rec->seq = seq;
+        rec->timestamp = timestamp;
+
+        m_end += detail::journal_record_bytes(size);
+        h.next_seq.store(m_next_seq, std::memory_order_relaxed);
+        h.end.store(m_end, std::memory_order_release);
+
+        // index entries go in after the record is visible, so any entry a
+        // reader can see points at a complete record
+        if (m_since_index == 0) {
+            const auto n = h.index_count.load(std::memory_order_relaxed);
+            if (n < h.index_capacity) {
+                seg.index[n] = Entry{ seq, at };
+                h.index_count.store(n + 1, std::memory_order_release);
+            }
+        }
+        if (++m_since_index == h.index_stride) m_since_index = 0;
+    }
+
+    ShmResult JournalWriter::flush_locked(bool async) noexcept {
+        ShmResult res{ ShmErr::None, ShmOp::Write };
+
+        // sealed segments get one full synchronous flush then are unmapped
+        for (auto& seg : m_retired) {
+            const auto r = seg->shm.sync(0, seg->shm.total_size(), false);
+            if (!r.ok()) res = r;
+        }
+        m_retired.clear();
+
+        if (m_cur != nullptr) {
+            auto& seg = *m_cur;
+            const auto end = seg.header->end.load(std::memory_order_acquire);
+            if (end > seg.synced) {
+                const auto data = seg.header->data_offset;
+                const auto r = seg.shm.sync(static_cast<size_t>(data + seg.synced), static_cast<size_t>(end - seg.synced), async);
+                // header and index after the records they describe
+                const auto rh = seg.shm.sync(0, static_cast<size_t>(data), async);
+                if (!r.ok()) res = r;
+                else if (!rh.ok()) res = rh;
+                else seg.synced = end;
+            }
+        }
+        return res;
+    }
+
+    ShmResult JournalWriter::flush() noexcept {
+        std::lock_guard<std::mutex> lock(m_seg_mtx);
+        if (m_cur == nullptr) return { ShmErr::NotOpen, ShmOp::Write };
+        return flush_locked(false);
+    }
+
+    void JournalWriter::sync_loop() noexcept {
+        const auto interval = std::chrono::milliseconds(m_cfg.sync_interval_ms);
+        std::unique_lock<std::mutex> lock(m_seg_mtx);
+        while (!m_stop) {
+            m_cv.wait_for(lock, interval, [this] { return m_stop; });
+            if (m_stop) break;
+            (void)flush_locked(!m_cfg.durable);
+        }
+    }
+
+    //
+    // reader
+    //
+
+    JournalReader::JournalReader(const JournalConfig& cfg) : m_cfg(cfg) {}
+
+    std::string JournalReader::path(std::uint32_t no) const {
+        return segment_path(m_cfg, no);
+    }
+
+    void JournalReader::refresh() noexcept {
+        while (file_exists(path(static_cast<std::uint32_t>(m_first_seqs.size())))) {
+            m_first_seqs.push_back(0);
+        }
+    }
+
+    ShmResult JournalReader::open_segment(std::uint32_t no, std::unique_ptr<Segment>& out, bool map_all) const noexcept {
+        ShmOptions opts = m_cfg.shm;
+        if (!map_all) {
+            // just peeking at the header
+            opts.prefault = false;
+            opts.lock = false;
+        }
+
+        auto seg = std::make_unique<Segment>(path(no), no, 0, opts);
+        const auto res = seg->shm.open();
+        if (!res.ok()) return res;
+
+        const ShmErr err = bind(*seg, m_cfg.schema_hash);
+        if (err != ShmErr::None) return { err, ShmOp::Open };
+        out = std::move(seg);
+        return res;
+    }
+
+    ShmResult JournalReader::first_seq(std::uint32_t no, std::uint64_t& out) noexcept {
+        if (m_first_seqs[no] != 0) {
+            out = m_first_seqs[no];
+            return { ShmErr::None, ShmOp::Read };
+        }
+
+        if (m_cur != nullptr && no == m_segment) {
+            out = m_cur->header->first_seq;
+        } else {
+            std::unique_ptr<Segment> seg;
+            const auto res = open_segment(no, seg, false);
+            if (!res.ok()) return res;
+            out = seg->header->first_seq;
+        }
+        m_first_seqs[no] = out;
+        return { ShmErr::None, ShmOp::Read };
+    }
+
+    ShmResult JournalReader::open() {
+        if (m_cur != nullptr) return { ShmErr::DoubleOpen, ShmOp::Open };
+
+        refresh();
+        if (m_first_seqs.empty()) return { ShmErr::DoesNotExist, ShmOp::Open };
+
+        const auto res = open_segment(0, m_cur, true);
+        if (!res.ok()) return res;
+        m_segment = 0;
+        m_pos = 0;
+        return res;
+    }
+
+    void JournalReader::close() noexcept {
+        m_cur.reset();
+        m_first_seqs.clear();
+        m_segment = 0;
+        m_pos = 0;
+    }
+
+    bool JournalReader::next(JournalRecord& out) noexcept {
+        if (m_cur == nullptr) return false;
+
+        for (;;) {
+            auto& seg = *m_cur;
+            const auto end = seg.header->end.load(std::memory_order_acquire);
+            if (m_pos < end) {
+                const auto* rec = reinterpret_cast<const Record*>(seg.data + m_pos);
+                const auto bytes = detail::journal_record_bytes(rec->size);
+                if (m_pos + bytes > end) return false; // torn or corrupt, stop here
+
+                out.seq = rec->seq;
+                out.timestamp = rec->timestamp;
+                out.data = seg.data + m_pos + sizeof(Record);
+                out.size = rec->size;
+                m_pos += bytes;
+                return true;
+            }
+
+            // the seal is stored after the last end, so check end once more after seeing it
+            if (seg.header->sealed.load(std::memory_order_acquire) == 0) return false;
+            if (m_pos < seg.header->end.load(std::memory_order_acquire)) continue;
+
+            const auto next = m_segment + 1;
+            if (next >= m_first_seqs.size()) refresh();
+            if (next >= m_first_seqs.size()) return false;
+
+            std::unique_ptr<Segment> seg_next;
+            if (!open_segment(next, seg_next, true).ok()) return false; // not ready yet, try again later
+            m_cur = std::move(seg_next);
+            m_segment = next;
+            m_pos = 0;
+        }
+    }
+
+    ShmResult JournalReader::seek(std::uint64_t seq) noexcept {
+        if (m_cur == nullptr) return { ShmErr::NotOpen, ShmOp::Read };
+        refresh();
+
+        // last segment starting at or before seq, one the writer is still
+        // setting up counts as starting after it
+        std::uint32_t lo = 0;
+        auto hi = static_cast<std::uint32_t>(m_first_seqs.size() - 1);
+        while (lo < hi) {
+            const auto mid = lo + (hi - lo + 1) / 2;
+            std::uint64_t fs = 0;
+            if (first_seq(mid, fs).ok() && fs <= seq) lo = mid;
+            else hi = mid - 1;
+        }
+
+        if (lo != m_segment) {
+            std::unique_ptr<Segment> seg;
+            const auto res = open_segment(lo, seg, true);
+            if (!res.ok()) return res;
+            m_cur = std::move(seg);
+            m_segment = lo;
+        }
+
+        // last index entry at or before seq, then scan from it
+        const auto& seg = *m_cur;
+        const auto n = seg.header->index_count.load(std::memory_order_acquire);
+        std::uint32_t l = 0;
+        std::uint32_t r = n;
+        while (l < r) {
+            const auto m = l + (r - l) / 2;
+            if (seg.index[m].seq <= seq) l = m + 1;
+            else r = m;
+        }
+
+        std::uint64_t pos = l > 0 ? seg.index[l - 1].offset : 0;
+        const auto end = seg.header->end.load(std::memory_order_acquire);
+        while (pos < end) {
+            const auto* rec = reinterpret_cast<const Record*>(seg.data + pos);
+            if (rec->seq >= seq) break;
+            pos += detail::journal_record_bytes(rec->size);
+        }
+        m_pos = pos < end ? pos : end;
+        return { ShmErr::None, ShmOp::Read };
+    }
+
+    ShmResult JournalReader::read(std::uint64_t seq, JournalRecord& out) noexcept {
+        const auto res = seek(seq);
+        if (!res.ok()) return res;
+        if (!next(out) || out.seq != seq) return { ShmErr::DoesNotExist, ShmOp::Read };
+        return res;
+    }
+}
@@ -0,0 +1,250 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "shm/shm.h"
+
+namespace shm {
+    namespace detail {
+        constexpr std::uint32_t journal_magic = 0x4D4F4F4A; // "MOOJ"
+        constexpr std::uint32_t journal_version = 1;
+        constexpr std::size_t journal_align = 8;
+
+        // one entry every index_stride records, offset is from the data start
+        struct JournalIndexEntry {
+            std::uint64_t seq;
+            std::uint64_t offset;
+        };
+
+        // lives at the front of every segment file, layout must not change
+        // without bumping journal_version
+        struct JournalSegmentHeader {
+            std::atomic<std::uint32_t> magic;       // written last by the creator
+            std::uint32_t version;
+            std::uint32_t segment;                  // file number
+            std::uint32_t index_stride;
+            std::uint32_t index_capacity;
+            std::uint32_t reserved;
+            std::uint64_t first_seq;
+            std::uint64_t segment_size;
+            std::uint64_t index_offset;             // from the header
+            std::uint64_t data_offset;              // from the header
+            std::uint64_t schema_hash;              // JournalConfig::schema_hash, 0 = none
+
+            alignas(64) std::atomic<std::uint64_t> end;     // data bytes holding complete records
+            std::atomic<std::uint64_t> next_seq;            // one past the last record
+            std::atomic<std::uint32_t> index_count;
+            std::atomic<std::uint32_t> sealed;              // 1 = the writer moved on to the next segment
+        };
+
+        // in front of every record, records are padded to journal_align
+        struct JournalRecordHeader {
+            std::uint32_t size;                     // payload bytes
+            std::uint32_t reserved;
+            std::uint64_t seq;
+            std::uint64_t timestamp;                // whatever the writer passed, 0 = none
+        };
+
+        constexpr std::size_t journal_record_bytes(std::size_t payload) noexcept {
+            return (sizeof(JournalRecordHeader) + payload + journal_align - 1) & ~(journal_align - 1);
+        }
+
+        // a journal segment mapped through Shm's file mode
+        struct JournalSegment {
+            std::string path;                       // Shm keeps a pointer to it
+            Shm shm;
+            JournalSegmentHeader* header = nullptr;
+            JournalIndexEntry* index = nullptr;
+            std::byte* data = nullptr;
+            std::uint64_t capacity = 0;             // data bytes
+            std::uint64_t synced = 0;               // data bytes flushed so far, syncer only
+
+            JournalSegment(std::string p, std::uint32_t no, std::size_t size, const ShmOptions& opts);
+        };
+    }
+
+    struct JournalConfig {
+        std::string dir = ".";                      // must exist
+        std::string name = "journal";               // files are <dir>/<name>.<segment>.jnl
+        std::size_t segment_size = 64u << 20;       // per file: header, sparse index and records
+        std::uint32_t index_stride = 64;            // one index entry every N records
+        std::uint32_t index_capacity = 16384;       // entries per segment, later records are just not indexed
+        std::uint32_t sync_interval_ms = 10;        // background flush period, 0 = no syncer thread
+        bool durable = false;                       // background flush waits for the disk instead of scheduling it
+        std::uint64_t schema_hash = 0;              // stamped in every segment, msg::schema_hash<T>() fits here
+        ShmOptions shm{};                           // prefault/lock/numa for the mappings, file_path is set per segment
+    };
+
+    // a record as stored, data points into the reader's mapping and is only
+    // valid until the reader moves to another segment
+    struct JournalRecord {
+        std::uint64_t seq = 0;
+        std::uint64_t timestamp = 0;
+        const std::byte* data = nullptr;
+        std::size_t size = 0;
+    };
+
+    // Append only journal of variable sized records on memory mapped, fixed
+    // size segment files. Records get consecutive sequence numbers starting
+    // at 1 and are written with a memcpy into the mapping, so append() does
+    // no syscalls except when the segment is full and the next file is made.
+    // Getting the pages to disk is left to a background thread that flushes
+    // whatever was appended since its last pass every sync_interval_ms; a
+    // crash can only lose the records of the last interval, flush() forces it.
+    // open() on an existing journal carries on after its last record.
+    // NOTE: one thread appends, the segment files are never deleted by the journal
+    class JournalWriter {
+        using Segment = detail::JournalSegment;
+
+        private:
+            JournalConfig m_cfg{};
+            std::unique_ptr<Segment> m_cur{};       // swapped under m_seg_mtx, read freely by the writer
+            std::uint32_t m_segment = 0;
+            std::uint64_t m_end = 0;                // writer copy of m_cur->header->end
+            std::uint64_t m_next_seq = 1;
+            std::uint32_t m_since_index = 0;        // records since the last index entry
+
+            std::mutex m_seg_mtx;
+            std::vector<std::unique_ptr<Segment>> m_retired{}; // sealed, waiting for their last flush
+            std::condition_variable m_cv;
+            std::thread m_syncer{};
+            bool m_stop = false;                    // guarded by m_seg_mtx
+
+            [[nodiscard]] ShmResult start_segment(std::uint32_t no, std::uint64_t first_seq) noexcept;
+            [[nodiscard]] ShmResult rotate() noexcept;
+            [[nodiscard]] ShmResult flush_locked(bool async) noexcept;
+            void sync_loop() noexcept;
+
+        public:
+            explicit JournalWriter(const JournalConfig& cfg = JournalConfig{});
+            ~JournalWriter();
+
+            JournalWriter(const JournalWriter&) = delete;
+            JournalWriter& operator=(const JournalWriter&) = delete;
+            JournalWriter(JournalWriter&&) = delete;
+            JournalWriter& operator=(JournalWriter&&) = delete;
+
+            // starts a new journal or resumes an existing one, then starts the syncer
+            [[nodiscard]] ShmResult open();
+            // stops the syncer and flushes everything to disk
+            void close() noexcept;
+
+            // room for a size byte record in the mapping, rotating first when
+            // it does not fit. Write the payload to out then commit() it
+            [[nodiscard]] ShmResult reserve(std::size_t size, std::byte*& out) noexcept;
+            // publishes the reserved record, size must not exceed the reservation
+            void commit(std::size_t size, std::uint64_t timestamp = 0) noexcept;
+
+            [[nodiscard]] ShmResult append(const void* data, std::size_t size, std::uint64_t timestamp = 0) noexcept {
+                std::byte* out = nullptr;
+                const auto res = reserve(size, out);
+                if (!res.ok()) return res;
+                std::memcpy(out, data, size);
+                commit(size, timestamp);
+                return res;
+            }
+
+            // pointers go to the overload above, not in as values
+            template <typename T, typename = std::enable_if_t<!std::is_pointer_v<T>>>
+            [[nodiscard]] ShmResult append(const T& value, std::uint64_t timestamp = 0) noexcept {
+                static_assert(std::is_trivially_copyable_v<T>, "JournalWriter::append needs a trivially copyable type");
+                return append(&value, sizeof(T), timestamp);
+            }
+
+            // copies up to max elements a queue consumer can see (front()/release(),
+            // ShmQueue or the msg queues) straight from the ring into the journal,
+            // one record each, and releases them. Returns records written
+            template <typename Consumer>
+            std::size_t drain(Consumer& consumer, std::size_t max = SIZE_MAX) noexcept {
+                std::size_t written = 0;
+                while (written < max) {
+                    const auto span = consumer.front(max - written);
+                    if (span.empty()) break;
+
+                    std::size_t done = 0;
+                    for (const auto& item : span) {
+                        if (!append(item).ok()) break;
+                        ++done;
+                    }
+                    consumer.release(done);
+                    written += done;
+                    if (done != span.size()) break;
+                }
+                return written;
+            }
+
+            // writes everything appended so far to disk and waits for it
+            [[nodiscard]] ShmResult flush() noexcept;
+
+            // biggest payload a segment of this config can hold
+            [[nodiscard]] std::size_t max_record() const noexcept;
+            [[nodiscard]] std::uint64_t next_seq() const noexcept { return m_next_seq; }
+            [[nodiscard]] std::uint32_t segment() const noexcept { return m_segment; }
+            [[nodiscard]] bool is_open() const noexcept { return m_cur != nullptr; }
+    };
+
+    // Reads a journal, from another process or while it is being written.
+    // next() streams records in sequence order across segments and returns
+    // false once it has caught up with the writer; calling it again later
+    // picks up what was appended since. seek() jumps to a sequence number by
+    // binary searching the segments' first sequence, then the segment's
+    // sparse index, then scanning at most index_stride records.
+    // NOTE: the mappings are read-write, the files need write permission
+    class JournalReader {
+        using Segment = detail::JournalSegment;
+
+        private:
+            JournalConfig m_cfg{};
+            std::vector<std::uint64_t> m_first_seqs{}; // per known segment, 0 = not read yet
+            std::unique_ptr<Segment> m_cur{};
+            std::uint32_t m_segment = 0;
+            std::uint64_t m_pos = 0;                // data offset of the next record in m_cur
+
+            std::string path(std::uint32_t no) const;
+            void refresh() noexcept;
+            [[nodiscard]] ShmResult open_segment(std::uint32_t no, std::unique_ptr<Segment>& out, bool map_all) const noexcept;
+            [[nodiscard]] ShmResult first_seq(std::uint32_t no, std::uint64_t& out) noexcept;
+
+        public:
+            explicit JournalReader(const JournalConfig& cfg = JournalConfig{});
+
+            // positions at the first record
+            [[nodiscard]] ShmResult open();
+            void close() noexcept;
+
+            // next record in sequence, false when there is nothing more yet
+            [[nodiscard]] bool next(JournalRecord& out) noexcept;
+
+            // positions so next() returns seq, or the first record after it when
+            // seq is past the end. seq before the first record goes to the start
+            [[nodiscard]] ShmResult seek(std::uint64_t seq) noexcept;
+
+            // random access, seek() then next(). DoesNotExist when seq was not written
+            [[nodiscard]] ShmResult read(std::uint64_t seq, JournalRecord& out) noexcept;
+
+            // fn(const JournalRecord&) for every record until caught up or max,
+            // returns records visited
+            template <typename Fn>
+            std::size_t replay(Fn&& fn, std::size_t max = SIZE_MAX) {
+                std::size_t n = 0;
+                JournalRecord rec{};
+                while (n < max && next(rec)) {
+                    fn(rec);
+                    ++n;
+                }
+                return n;
+            }
+
+            [[nodiscard]] std::uint32_t segment() const noexcept { return m_segment; }
+            [[nodiscard]] bool is_open() const noexcept { return m_cur != nullptr; }
+    };
+}
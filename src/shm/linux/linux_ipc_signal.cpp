@@ -0,0 +1,23 @@
+#if defined(MOO_LINUX)
+#include "shm/ipc_bus.h"
+#include "platform/futex.h"
+
+namespace shm {
+    // the futex is keyed on the physical page, so every process mapping the
+    // region parks on the same word
+    ShmResult IpcSignal::bind(detail::IpcSignalWord* word) noexcept {
+        if (word == nullptr) return { ShmErr::InvalidOffset, ShmOp::Attach };
+        m_word = word;
+        return { ShmErr::None, ShmOp::Attach };
+    }
+
+    bool IpcSignal::park(std::uint32_t epoch, std::uint64_t timeout_ns) noexcept {
+        return plat::futex_wait(m_word->epoch, epoch, timeout_ns, true);
+    }
+
+    void IpcSignal::wake() noexcept {
+        m_word->epoch.fetch_add(1, std::memory_order_release);
+        plat::futex_wake_all(m_word->epoch, true);
+    }
+}
+#endif
@@ -2,8 +2,10 @@
 #include "shm/shm.h"
 
 #include <fcntl.h>      // shm_open, O_*
-#include <sys/mman.h>   // mmap, munmap, PROT_*, MAP_*
+#include <sys/mman.h>   // mmap, munmap, mlock, PROT_*, MAP_*
 #include <sys/stat.h>   // mode_t
+#include <sys/syscall.h> // SYS_mbind
+#include <linux/mempolicy.h> // MPOL_*
 #include <unistd.h>     // ftruncate, close
 #include <cerrno>
 
@@ -16,19 +18,60 @@ namespace shm {
     //     return static_cast<shm_handle>(fd);
     // }
 
-    Shm::Shm(const int32_t id, const size_t total_size) : 
-        m_id(id), m_total_size(total_size), m_handle(-1), m_view(nullptr) {}
+    namespace {
+        constexpr size_t small_page = 4096;
+
+        size_t page_bytes(ShmPageSize page) noexcept {
+            switch (page) {
+                case ShmPageSize::Huge2M: return size_t{2} * 1024 * 1024;
+                case ShmPageSize::Huge1G: return size_t{1024} * 1024 * 1024;
+                default: return small_page;
+            }
+        }
+
+        size_t round_up(size_t bytes, size_t page) noexcept {
+            return (bytes + page - 1) & ~(page - 1);
+        }
+
+        // hugetlbfs wants a real file on its mount, shm_open lives on tmpfs
+        std::string huge_path(const ShmOptions& opts, int32_t id) {
+            std::string dir;
+            if (opts.hugetlbfs_dir != nullptr) {
+                dir = opts.hugetlbfs_dir;
+            } else {
+                dir = opts.page_size == ShmPageSize::Huge1G ? "/dev/hugepages1G" : "/dev/hugepages";
+            }
+            return dir + "/eroil.node." + std::to_string(id);
+        }
+
+        void touch_pages(const std::byte* view, size_t bytes, size_t step) noexcept {
+            const volatile std::byte* p = view;
+            for (size_t off = 0; off < bytes; off += step) {
+                (void)p[off];
+            }
+        }
+    }
+
+    Shm::Shm(const int32_t id, const size_t total_size, const ShmOptions& opts) : 
+        m_id(id), m_total_size(total_size), m_handle(-1), m_view(nullptr), m_opts(opts) {}
 
     Shm::Shm(Shm&& other) noexcept
         : m_id(other.m_id),
           m_total_size(other.m_total_size),
           m_handle(other.m_handle),
-          m_view(other.m_view) {
+          m_view(other.m_view),
+          m_opts(other.m_opts),
+          m_mapped_size(other.m_mapped_size),
+          m_huge(other.m_huge),
+          m_locked(other.m_locked) {
 
         other.m_handle = -1;
         other.m_view   = nullptr;
         other.m_id  = -1;
         other.m_total_size = 0;
+        other.m_mapped_size = 0;
+        other.m_huge = false;
+        other.m_locked = false;
     }
 
     Shm& Shm::operator=(Shm&& other) noexcept {
@@ -39,11 +82,18 @@ namespace shm {
             m_total_size = other.m_total_size;
             m_handle = other.m_handle;
             m_view = other.m_view;
+            m_opts = other.m_opts;
+            m_mapped_size = other.m_mapped_size;
+            m_huge = other.m_huge;
+            m_locked = other.m_locked;
 
             other.m_handle = -1;
             other.m_view = nullptr;
             other.m_id = -1;
             other.m_total_size = 0;
+            other.m_mapped_size = 0;
+            other.m_huge = false;
+            other.m_locked = false;
         }
         return *this;
     }
@@ -56,14 +106,141 @@ namespace shm {
         return "/eroil.node." + std::to_string(m_id);
     }
 
+    // mbind has to happen before pages are faulted in, so with a numa node
+    // MAP_POPULATE is skipped and the prefault happens here instead
+    ShmErr Shm::apply_mapping_options() noexcept {
+        if (m_opts.numa_node >= 0) {
+            constexpr size_t bits = sizeof(unsigned long) * 8;
+            constexpr size_t max_nodes = 1024;
+            unsigned long mask[max_nodes / bits]{};
+            const auto node = static_cast<size_t>(m_opts.numa_node);
+            if (node >= max_nodes) return ShmErr::NumaBindFailed;
+            mask[node / bits] = 1ul << (node % bits);
+
+            if (::syscall(SYS_mbind, m_view, m_mapped_size, MPOL_BIND, mask, max_nodes + 1, MPOL_MF_MOVE) != 0) {
+                return ShmErr::NumaBindFailed;
+            }
+
+            if (m_opts.prefault) {
+                bool populated = false;
+                #if defined(MADV_POPULATE_WRITE)
+                    populated = ::madvise(m_view, m_mapped_size, MADV_POPULATE_WRITE) == 0; // 5.14+
+                #endif
+                if (!populated) {
+                    touch_pages(m_view, m_mapped_size, m_huge ? page_bytes(m_opts.page_size) : small_page);
+                }
+            }
+        }
+
+        if (m_opts.lock) {
+            if (::mlock(m_view, m_mapped_size) != 0) return ShmErr::LockFailed;
+            m_locked = true;
+        }
+
+        return ShmErr::None;
+    }
+
+    ShmResult Shm::map_file(bool create) noexcept {
+        const ShmOp op = create ? ShmOp::Create : ShmOp::Open;
+        const int flags = create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR;
+
+        m_handle = ::open(m_opts.file_path, flags, 0644);
+        if (m_handle < 0) {
+            if (errno == EEXIST) return { ShmErr::AlreadyExists, op };
+            if (errno == ENOENT) return { ShmErr::DoesNotExist, op };
+            return { ShmErr::UnknownError, op };
+        }
+
+        const auto fail = [&](ShmErr err) -> ShmResult {
+            close();
+            if (create) ::unlink(m_opts.file_path); // delete the partially created file
+            return { err, op };
+        };
+
+        if (create) {
+            if (m_total_size == 0) return fail(ShmErr::SizeMismatch);
+            if (::ftruncate(m_handle, static_cast<off_t>(m_total_size)) != 0) return fail(ShmErr::UnknownError);
+        } else {
+            struct stat st;
+            if (fstat(m_handle, &st) != 0) return fail(ShmErr::UnknownError);
+            if (m_total_size == 0) m_total_size = static_cast<size_t>(st.st_size);
+            if (m_total_size == 0 || static_cast<size_t>(st.st_size) != m_total_size) return fail(ShmErr::SizeMismatch);
+        }
+
+        const int populate = (m_opts.prefault && m_opts.numa_node < 0) ? MAP_POPULATE : 0;
+        void* view = ::mmap(nullptr, m_total_size, PROT_READ | PROT_WRITE, MAP_SHARED | populate, m_handle, 0);
+        if (view == MAP_FAILED) return fail(ShmErr::FileMapFailed);
+
+        m_view = static_cast<shm_view>(view);
+        m_mapped_size = m_total_size;
+        m_huge = false;
+
+        const ShmErr err = apply_mapping_options();
+        if (err != ShmErr::None) return fail(err);
+        return { ShmErr::None, op };
+    }
+
+    ShmResult Shm::sync(size_t offset, size_t bytes, bool async) noexcept {
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Write };
+        if (offset > m_mapped_size) return { ShmErr::InvalidOffset, ShmOp::Write };
+        if (bytes > m_mapped_size - offset) bytes = m_mapped_size - offset;
+        if (bytes == 0) return { ShmErr::None, ShmOp::Write };
+
+        // msync wants a page aligned start
+        const size_t start = offset & ~(small_page - 1);
+        if (::msync(m_view + start, offset + bytes - start, async ? MS_ASYNC : MS_SYNC) != 0) {
+            return { ShmErr::UnknownError, ShmOp::Write };
+        }
+        return { ShmErr::None, ShmOp::Write };
+    }
+
     ShmResult Shm::create() {
         if (is_valid()) return { ShmErr::DoubleOpen, ShmOp::Create };
+        if (m_opts.file_path != nullptr) return map_file(true);
 
         const std::string n = name();
         if (n.empty() || n[0] != '/') {
             return { ShmErr::InvalidName, ShmOp::Create };
         }
 
+        const int populate = (m_opts.prefault && m_opts.numa_node < 0) ? MAP_POPULATE : 0;
+
+        if (m_opts.page_size != ShmPageSize::Default) {
+            const std::string path = huge_path(m_opts, m_id);
+            const size_t total = round_up(total_size(), page_bytes(m_opts.page_size));
+
+            m_handle = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0777);
+            if (m_handle < 0 && errno == EEXIST) return { ShmErr::AlreadyExists, ShmOp::Create };
+
+            if (m_handle >= 0) {
+                // hugetlbfs only reserves pages at mmap, so that is where a short pool shows up
+                void* view = MAP_FAILED;
+                if (::ftruncate(m_handle, static_cast<off_t>(total)) == 0) {
+                    view = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED | populate, m_handle, 0);
+                }
+
+                if (view != MAP_FAILED) {
+                    m_view = static_cast<shm_view>(view);
+                    m_mapped_size = total;
+                    m_huge = true;
+
+                    const ShmErr err = apply_mapping_options();
+                    if (err != ShmErr::None) {
+                        close();
+                        ::unlink(path.c_str());
+                        return { err, ShmOp::Create };
+                    }
+                    return { ShmErr::None, ShmOp::Create };
+                }
+
+                ::close(m_handle);
+                m_handle = -1;
+                ::unlink(path.c_str());
+            }
+
+            if (!m_opts.huge_fallback) return { ShmErr::HugePagesUnavailable, ShmOp::Create };
+        }
+
         // O_EXCL makes create fail if it already exists
         m_handle = ::shm_open(n.c_str(), O_RDWR | O_CREAT | O_EXCL, 0777);
         if (m_handle < 0) {
@@ -74,60 +251,100 @@ namespace shm {
         const size_t total = total_size();
         if (::ftruncate(m_handle, static_cast<off_t>(total)) != 0) {
             ::close(m_handle);
+            m_handle = -1;
             ::shm_unlink(n.c_str()); // delete the partially created file
             return { ShmErr::UnknownError, ShmOp::Create };
         }
 
-        m_view = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
-        if (m_view == MAP_FAILED) {
+        void* view = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED | populate, m_handle, 0);
+        if (view == MAP_FAILED) {
             ::close(m_handle);
+            m_handle = -1;
             ::shm_unlink(n.c_str()); // delete the partially created file
             return { ShmErr::FileMapFailed, ShmOp::Create };
         }
+        m_view = static_cast<shm_view>(view);
+        m_mapped_size = total;
+
+        const ShmErr err = apply_mapping_options();
+        if (err != ShmErr::None) {
+            close();
+            ::shm_unlink(n.c_str());
+            return { err, ShmOp::Create };
+        }
        
         return { ShmErr::None, ShmOp::Create };
     }
 
     ShmResult Shm::open() {
         if (is_valid()) return { ShmErr::DoubleOpen, ShmOp::Open };
+        if (m_opts.file_path != nullptr) return map_file(false);
 
         const std::string n = name();
         if (n.empty() || n[0] != '/') {
             return { ShmErr::InvalidName, ShmOp::Open };
         }
 
-        m_handle = ::shm_open(n.c_str(), O_RDWR, 0777);
-        if (m_handle < 0) {
-            if (errno == ENOENT) return { ShmErr::DoesNotExist, ShmOp::Open };
-            return { ShmErr::UnknownError, ShmOp::Open };
+        size_t total = total_size();
+        bool huge = false;
+
+        // creator may have fallen back to normal pages, so look in both places
+        if (m_opts.page_size != ShmPageSize::Default) {
+            m_handle = ::open(huge_path(m_opts, m_id).c_str(), O_RDWR);
+            if (m_handle >= 0) {
+                total = round_up(total, page_bytes(m_opts.page_size));
+                huge = true;
+            } else if (errno != ENOENT || !m_opts.huge_fallback) {
+                if (errno == ENOENT) return { ShmErr::DoesNotExist, ShmOp::Open };
+                return { ShmErr::UnknownError, ShmOp::Open };
+            }
+        }
+
+        if (!huge) {
+            m_handle = ::shm_open(n.c_str(), O_RDWR, 0777);
+            if (m_handle < 0) {
+                if (errno == ENOENT) return { ShmErr::DoesNotExist, ShmOp::Open };
+                return { ShmErr::UnknownError, ShmOp::Open };
+            }
         }
 
         struct stat st;
         if (fstat(m_handle, &st) != 0) {
             ::close(m_handle);
+            m_handle = -1;
             return { ShmErr::UnknownError, ShmOp::Open };
         }
 
-        if ( static_cast<size_t>(st.st_size) != total_size()) {
+        if (total == 0 && !huge) total = m_total_size = static_cast<size_t>(st.st_size);
+        if ( static_cast<size_t>(st.st_size) != total) {
             ::close(m_handle);
+            m_handle = -1;
             return { ShmErr::SizeMismatch, ShmOp::Open };
         }
 
-        const size_t total = total_size();
-        m_view = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, m_handle, 0);
-        if (m_view == MAP_FAILED) {
+        const int populate = (m_opts.prefault && m_opts.numa_node < 0) ? MAP_POPULATE : 0;
+        void* view = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED | populate, m_handle, 0);
+        if (view == MAP_FAILED) {
             ::close(m_handle);
+            m_handle = -1;
             return { ShmErr::FileMapFailed, ShmOp::Open };
         }
+        m_view = static_cast<shm_view>(view);
+        m_mapped_size = total;
+        m_huge = huge;
+
+        const ShmErr err = apply_mapping_options();
+        if (err != ShmErr::None) {
+            close();
+            return { err, ShmOp::Open };
+        }
 
         return { ShmErr::None, ShmOp::Open };
     }
 
     void Shm::close() noexcept {
-        const size_t total = total_size();
-
         if (m_view != nullptr) {
-            ::munmap(m_view, total);
+            ::munmap(m_view, m_mapped_size); // drops any mlock too
             m_view = nullptr;
         }
 
@@ -136,9 +353,13 @@ namespace shm {
             m_handle = -1;
         }
 
+        m_mapped_size = 0;
+        m_huge = false;
+        m_locked = false;
+
         // delete the shared memory file
         //::shm_unlink(name().c_str());
     }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,9 @@
 #include <string>
 #include <vector>
 #include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
 
 namespace shm {
     enum class ShmErr {
@@ -24,6 +27,17 @@ namespace shm {
         RecvFailed,
         WouldBlock,
         InvalidOffset,
+
+        // queue / layout attach
+        BadMagic,
+        VersionMismatch,
+        LayoutMismatch,
+        SchemaMismatch,
+
+        // mapping options
+        HugePagesUnavailable,
+        LockFailed,
+        NumaBindFailed,
     };
 
     enum class ShmOp {
@@ -31,6 +45,7 @@ namespace shm {
         Open,
         Read,
         Write,
+        Attach,
     };
 
     struct ShmResult {
@@ -61,6 +76,13 @@ namespace shm {
                 case ShmErr::RecvFailed: return "RecvFailed";
                 case ShmErr::WouldBlock: return "WouldBlock";
                 case ShmErr::InvalidOffset: return "InvalidOffset";
+                case ShmErr::BadMagic: return "BadMagic";
+                case ShmErr::VersionMismatch: return "VersionMismatch";
+                case ShmErr::LayoutMismatch: return "LayoutMismatch";
+                case ShmErr::SchemaMismatch: return "SchemaMismatch";
+                case ShmErr::HugePagesUnavailable: return "HugePagesUnavailable";
+                case ShmErr::LockFailed: return "LockFailed";
+                case ShmErr::NumaBindFailed: return "NumaBindFailed";
                 default: return "Unknown - error is undefined";
             }
         }
@@ -71,11 +93,32 @@ namespace shm {
                 case ShmOp::Open: return "Open";
                 case ShmOp::Read: return "Read";
                 case ShmOp::Write: return "Write";
+                case ShmOp::Attach: return "Attach";
                 default: return "Unknown - op is undefined";
             }
         }
     };
 
+    enum class ShmPageSize : std::uint8_t {
+        Default,    // normal 4KB pages
+        Huge2M,     // linux: hugetlbfs file, windows: large pages (SEC_LARGE_PAGES)
+        Huge1G,     // linux only (1G hugetlbfs mount), windows treats it as Huge2M
+    };
+
+    // how the region gets mapped, creator and openers should pass the same
+    // page_size and hugetlbfs_dir so they find the same backing file.
+    // everything here is about taking page faults and tlb misses up front
+    // instead of on the first message
+    struct ShmOptions {
+        ShmPageSize page_size = ShmPageSize::Default;
+        bool huge_fallback = true;          // use normal pages when huge pages cant be had, else HugePagesUnavailable
+        const char* hugetlbfs_dir = nullptr; // linux mount to put huge page files in, nullptr = /dev/hugepages(1G)
+        bool prefault = false;              // fault every page in during create()/open() (MAP_POPULATE / touch)
+        bool lock = false;                  // mlock / VirtualLock so pages are never swapped or reclaimed
+        std::int32_t numa_node = -1;        // bind pages to this node (mbind / *Numa apis), -1 = leave alone
+        const char* file_path = nullptr;    // map this regular file instead of a named shm object, page_size is ignored. Must outlive the Shm
+    };
+
     #if defined(MOO_WIN32)
         using shm_handle = void*;
         using shm_view = void*;
@@ -90,9 +133,21 @@ namespace shm {
             size_t m_total_size;
             shm_handle m_handle;
             shm_view m_view;
+            ShmOptions m_opts{};
+            size_t m_mapped_size = 0;   // total_size rounded up to the page size in use
+            bool m_huge = false;        // huge pages actually in use
+            bool m_locked = false;
+            #if defined(MOO_WIN32)
+                void* m_file = nullptr;     // backing file when opts.file_path is set
+            #endif
+
+            // platform dependent, runs the lock/numa/prefault steps on a fresh view
+            [[nodiscard]] ShmErr apply_mapping_options() noexcept;
+            // platform dependent, create()/open() for opts.file_path
+            [[nodiscard]] ShmResult map_file(bool create) noexcept;
 
         public:
-            Shm(const int32_t id, const size_t total_size);
+            Shm(const int32_t id, const size_t total_size, const ShmOptions& opts = ShmOptions{});
             virtual ~Shm() { close(); }
 
             Shm(const Shm&) = delete;
@@ -104,12 +159,22 @@ namespace shm {
             [[nodiscard]] bool is_valid() const noexcept;
             std::string name() const noexcept;
             [[nodiscard]] ShmResult create();
+            // a total_size of 0 takes the size of the existing region
             [[nodiscard]] ShmResult open();
             void close() noexcept;
 
+            // writes dirty pages of [offset, offset + bytes) back to the backing
+            // file (msync / FlushViewOfFile + FlushFileBuffers), async only
+            // schedules the writeback. Only meaningful with opts.file_path
+            [[nodiscard]] ShmResult sync(size_t offset, size_t bytes, bool async = false) noexcept;
+
             // shared implementation
             void memset(size_t offset, int32_t val, size_t bytes);
             size_t total_size() const noexcept;
+            size_t mapped_size() const noexcept { return m_mapped_size; }
+            bool uses_huge_pages() const noexcept { return m_huge; }
+            bool is_locked() const noexcept { return m_locked; }
+            const ShmOptions& options() const noexcept { return m_opts; }
             [[nodiscard]] ShmResult read(void* buf, const size_t size, const size_t offset) const noexcept;
             [[nodiscard]] ShmResult write(const void* buf, const size_t size, const size_t offset) noexcept;
             template <typename T>
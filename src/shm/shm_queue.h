@@ -0,0 +1,413 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include "shm/shm.h"
+#include "msg/span.h"
+#include "msg/schema.h"
+
+namespace shm {
+    namespace detail {
+        constexpr std::uint32_t queue_magic = 0x4D4F4F51; // "MOOQ"
+        constexpr std::uint32_t queue_version = 2;
+        constexpr std::size_t cache_line = 64;
+
+        constexpr std::size_t align_up(std::size_t v, std::size_t a) noexcept {
+            return (v + a - 1) & ~(a - 1);
+        }
+
+        enum class SlotState : std::uint32_t {
+            Free = 0,
+            Initializing = 1,
+            Active = 2
+        };
+
+        // lives at the front of the region, layout must not change
+        // without bumping queue_version
+        struct ShmQueueHeader {
+            std::atomic<std::uint32_t> magic;       // written last by the creator
+            std::uint32_t version;
+            std::uint64_t capacity;
+            std::uint32_t elem_size;
+            std::uint32_t elem_align;
+            std::uint32_t max_consumers;
+            std::uint32_t reserved;
+            std::uint64_t slots_offset;             // from the header
+            std::uint64_t buffer_offset;            // from the header
+            std::uint64_t schema_hash;              // msg::schema_hash<T>(), 0 = no schema
+
+            alignas(cache_line) std::atomic<std::uint64_t> head;
+            alignas(cache_line) std::atomic<std::uint32_t> producer_claimed;
+        };
+
+        struct alignas(cache_line) ShmConsumerSlot {
+            std::atomic<SlotState> state;
+            std::atomic<std::uint64_t> tail;
+            alignas(cache_line) std::uint64_t cached_head; // owning consumer only
+        };
+    }
+
+    // Lock free single producer multiple consumer broadcast ring placement
+    // constructed into a Shm region so producer and consumers can live in
+    // different processes. Uses the same head/tail index protocol as
+    // msg::SPMCQueue; a queue made with max_consumers = 1 is an SPSC ring.
+    // Element types with a MOO_SCHEMA (msg/schema.h) have their layout hash
+    // stored in the header, attach() refuses a ring built from another layout.
+    // NOTE: the ShmQueue view, its Producer and Consumer must not outlive the Shm mapping.
+    // NOTE: a process that dies holding a handle leaves its claim set.
+    template <typename T>
+    class ShmQueue {
+        static_assert(std::is_trivially_copyable_v<T>, "ShmQueue only supports trivially copyable types");
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ShmQueue needs lock free 64-bit atomics to be process shared");
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "ShmQueue needs lock free 32-bit atomics to be process shared");
+        static_assert(alignof(T) <= detail::cache_line, "ShmQueue element alignment must be <= 64");
+
+        using Header = detail::ShmQueueHeader;
+        using ConsumerSlot = detail::ShmConsumerSlot;
+        using SlotState = detail::SlotState;
+
+        private:
+            Header* m_header = nullptr;
+            ConsumerSlot* m_slots = nullptr;
+            T* m_buffer = nullptr;
+            std::size_t m_mask = 0;
+
+            std::size_t to_index(std::uint64_t i) const noexcept { return static_cast<std::size_t>(i) & m_mask; }
+
+            static std::size_t slots_offset() noexcept {
+                return detail::align_up(sizeof(Header), detail::cache_line);
+            }
+
+            static std::size_t buffer_offset(std::size_t max_consumers) noexcept {
+                return detail::align_up(slots_offset() + max_consumers * sizeof(ConsumerSlot), detail::cache_line);
+            }
+
+            void bind(std::byte* base) noexcept {
+                m_header = reinterpret_cast<Header*>(base);
+                m_slots = reinterpret_cast<ConsumerSlot*>(base + m_header->slots_offset);
+                m_buffer = reinterpret_cast<T*>(base + m_header->buffer_offset);
+                m_mask = static_cast<std::size_t>(m_header->capacity) - 1;
+            }
+
+            std::uint64_t min_tail_snapshot(std::uint64_t head) const noexcept {
+                std::uint64_t min_tail = head;
+                for (std::size_t i = 0; i < m_header->max_consumers; ++i) {
+                    const auto& slot = m_slots[i];
+                    if (slot.state.load(std::memory_order_acquire) == SlotState::Active) {
+                        // pairs with the consumers release, their reads of the slot are done
+                        const auto t = slot.tail.load(std::memory_order_acquire);
+                        if (t < min_tail) min_tail = t;
+                    }
+                }
+                return min_tail;
+            }
+
+            // producer side free slots, rescans consumer tails only when the cached
+            // min tail says the ring is full
+            std::size_t free_slots(std::uint64_t head, std::uint64_t& cached_min_tail) const noexcept {
+                if (head - cached_min_tail >= capacity()) {
+                    cached_min_tail = min_tail_snapshot(head);
+                }
+                return capacity() - static_cast<std::size_t>(head - cached_min_tail);
+            }
+
+            std::size_t available_slots(ConsumerSlot& slot, std::uint64_t tail) const noexcept {
+                if (slot.cached_head <= tail) {
+                    slot.cached_head = m_header->head.load(std::memory_order_acquire);
+                    if (slot.cached_head <= tail) return 0;
+                }
+                return static_cast<std::size_t>(slot.cached_head - tail);
+            }
+
+        public:
+            ShmQueue() = default;
+            ~ShmQueue() = default;
+
+            ShmQueue(const ShmQueue&) = delete;
+            ShmQueue& operator=(const ShmQueue&) = delete;
+            ShmQueue(ShmQueue&&) = delete;
+            ShmQueue& operator=(ShmQueue&&) = delete;
+
+            // bytes of Shm needed for a ring of capacity slots with max_consumers readers
+            static constexpr std::size_t required_size(std::size_t capacity, std::size_t max_consumers) noexcept {
+                return detail::align_up(sizeof(Header), detail::cache_line)
+                    + detail::align_up(max_consumers * sizeof(ConsumerSlot), detail::cache_line)
+                    + capacity * sizeof(T);
+            }
+
+            // placement constructs a new ring at offset, call after Shm::create()
+            [[nodiscard]] ShmResult create(Shm& shm, std::size_t capacity, std::size_t max_consumers, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Create };
+                if (capacity == 0 || (capacity & (capacity - 1)) != 0) return { ShmErr::LayoutMismatch, ShmOp::Create };
+                if (max_consumers == 0) return { ShmErr::LayoutMismatch, ShmOp::Create };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Create };
+                if (offset > shm.total_size() || required_size(capacity, max_consumers) > shm.total_size() - offset) {
+                    return { ShmErr::TooLarge, ShmOp::Create };
+                }
+
+                auto* base = shm.map_to_type<std::byte>(offset);
+                if (base == nullptr) return { ShmErr::InvalidOffset, ShmOp::Create };
+
+                auto* header = new (base) Header{};
+                header->version = detail::queue_version;
+                header->capacity = capacity;
+                header->elem_size = static_cast<std::uint32_t>(sizeof(T));
+                header->elem_align = static_cast<std::uint32_t>(alignof(T));
+                header->max_consumers = static_cast<std::uint32_t>(max_consumers);
+                header->slots_offset = slots_offset();
+                header->buffer_offset = buffer_offset(max_consumers);
+                header->schema_hash = msg::schema_hash<T>();
+                header->head.store(0, std::memory_order_relaxed);
+                header->producer_claimed.store(0, std::memory_order_relaxed);
+
+                auto* slots = reinterpret_cast<ConsumerSlot*>(base + header->slots_offset);
+                for (std::size_t i = 0; i < max_consumers; ++i) {
+                    new (&slots[i]) ConsumerSlot{};
+                }
+
+                auto* buffer = reinterpret_cast<T*>(base + header->buffer_offset);
+                for (std::size_t i = 0; i < capacity; ++i) {
+                    new (&buffer[i]) T{};
+                }
+
+                // publish last, attach() fails with BadMagic until this is visible
+                header->magic.store(detail::queue_magic, std::memory_order_release);
+                bind(base);
+                return { ShmErr::None, ShmOp::Create };
+            }
+
+            // attaches to a ring another process created, call after Shm::open()
+            [[nodiscard]] ShmResult attach(Shm& shm, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Attach };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                auto* header = shm.map_to_type<Header>(offset);
+                if (header == nullptr) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                if (header->magic.load(std::memory_order_acquire) != detail::queue_magic) {
+                    return { ShmErr::BadMagic, ShmOp::Attach };
+                }
+                if (header->version != detail::queue_version) {
+                    return { ShmErr::VersionMismatch, ShmOp::Attach };
+                }
+                if (header->elem_size != sizeof(T) || header->elem_align != alignof(T)) {
+                    return { ShmErr::LayoutMismatch, ShmOp::Attach };
+                }
+                // same size but a different field layout, name or version
+                if (header->schema_hash != msg::schema_hash<T>()) {
+                    return { ShmErr::SchemaMismatch, ShmOp::Attach };
+                }
+
+                const auto capacity = static_cast<std::size_t>(header->capacity);
+                const auto max_consumers = static_cast<std::size_t>(header->max_consumers);
+                if (capacity == 0 || (capacity & (capacity - 1)) != 0 || max_consumers == 0) {
+                    return { ShmErr::LayoutMismatch, ShmOp::Attach };
+                }
+                if (header->slots_offset != slots_offset() || header->buffer_offset != buffer_offset(max_consumers)) {
+                    return { ShmErr::LayoutMismatch, ShmOp::Attach };
+                }
+                if (required_size(capacity, max_consumers) > shm.total_size() - offset) {
+                    return { ShmErr::SizeMismatch, ShmOp::Attach };
+                }
+
+                bind(reinterpret_cast<std::byte*>(header));
+                return { ShmErr::None, ShmOp::Attach };
+            }
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_header != nullptr; }
+            [[nodiscard]] std::size_t capacity() const noexcept { return m_mask + 1; }
+            [[nodiscard]] std::size_t max_consumers() const noexcept { return m_header->max_consumers; }
+            [[nodiscard]] std::uint64_t schema_hash() const noexcept { return m_header->schema_hash; }
+
+            class Producer {
+                private:
+                    ShmQueue* m_queue = nullptr;
+                    std::uint64_t m_cached_min_tail = 0;
+
+                public:
+                    explicit Producer(ShmQueue& q) noexcept : m_queue(&q) {
+                        m_cached_min_tail = q.m_header->head.load(std::memory_order_relaxed) - q.capacity();
+                    }
+
+                    ~Producer() {
+                        if (m_queue != nullptr) {
+                            m_queue->m_header->producer_claimed.store(0, std::memory_order_release);
+                        }
+                    }
+
+                    Producer(const Producer&) = delete;
+                    Producer& operator=(const Producer&) = delete;
+
+                    Producer(Producer&& other) noexcept
+                        : m_queue(other.m_queue), m_cached_min_tail(other.m_cached_min_tail) {
+                        other.m_queue = nullptr;
+                    }
+
+                    Producer& operator=(Producer&& other) noexcept {
+                        if (this != &other) {
+                            if (m_queue) {
+                                m_queue->m_header->producer_claimed.store(0, std::memory_order_release);
+                            }
+                            m_queue = other.m_queue;
+                            m_cached_min_tail = other.m_cached_min_tail;
+                            other.m_queue = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    [[nodiscard]] bool push(const T& item) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        auto& q = *m_queue;
+                        const auto head = q.m_header->head.load(std::memory_order_relaxed);
+                        if (q.free_slots(head, m_cached_min_tail) == 0) {
+                            return false; // queue is full
+                        }
+
+                        q.m_buffer[q.to_index(head)] = item;
+                        q.m_header->head.store(head + 1, std::memory_order_release);
+                        return true;
+                    }
+
+                    // zero-copy write: returns up to max contiguous free slots
+                    [[nodiscard]] msg::Span<T> reserve(std::size_t max = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        auto& q = *m_queue;
+                        const auto head = q.m_header->head.load(std::memory_order_relaxed);
+                        const auto start = q.to_index(head);
+                        const auto free = q.free_slots(head, m_cached_min_tail);
+
+                        auto count = max < free ? max : free;
+                        if (count > q.capacity() - start) count = q.capacity() - start;
+                        return msg::Span<T>{ &q.m_buffer[start], count };
+                    }
+
+                    // publishes n slots previously handed out by reserve()
+                    void commit(std::size_t n = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid producer: queue is null");
+                        const auto head = m_queue->m_header->head.load(std::memory_order_relaxed);
+                        m_queue->m_header->head.store(head + n, std::memory_order_release);
+                    }
+            };
+
+            class Consumer {
+                private:
+                    ShmQueue* m_queue = nullptr;
+                    std::size_t m_slot_idx = 0;
+
+                    void free_slot() noexcept {
+                        auto& slot = m_queue->m_slots[m_slot_idx];
+                        slot.tail.store(0, std::memory_order_relaxed);
+                        slot.state.store(SlotState::Free, std::memory_order_release);
+                    }
+
+                public:
+                    Consumer(ShmQueue& q, std::size_t slot_idx) noexcept : m_queue(&q), m_slot_idx(slot_idx) {}
+
+                    ~Consumer() {
+                        if (m_queue != nullptr) free_slot();
+                    }
+
+                    Consumer(const Consumer&) = delete;
+                    Consumer& operator=(const Consumer&) = delete;
+
+                    Consumer(Consumer&& other) noexcept : m_queue(other.m_queue), m_slot_idx(other.m_slot_idx) {
+                        other.m_queue = nullptr;
+                    }
+
+                    Consumer& operator=(Consumer&& other) noexcept {
+                        if (this != &other) {
+                            if (m_queue != nullptr) free_slot();
+                            m_queue = other.m_queue;
+                            m_slot_idx = other.m_slot_idx;
+                            other.m_queue = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    [[nodiscard]] bool try_pop(T& out) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& q = *m_queue;
+                        auto& slot = q.m_slots[m_slot_idx];
+                        const auto tail = slot.tail.load(std::memory_order_relaxed);
+                        if (q.available_slots(slot, tail) == 0) {
+                            return false; // queue is empty
+                        }
+
+                        out = q.m_buffer[q.to_index(tail)];
+                        slot.tail.store(tail + 1, std::memory_order_release);
+                        return true;
+                    }
+
+                    std::optional<T> pop() noexcept {
+                        T out;
+                        if (!try_pop(out)) return std::nullopt;
+                        return out;
+                    }
+
+                    // zero-copy read: returns up to max contiguous unread slots
+                    [[nodiscard]] msg::Span<const T> front(std::size_t max = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& q = *m_queue;
+                        auto& slot = q.m_slots[m_slot_idx];
+                        const auto tail = slot.tail.load(std::memory_order_relaxed);
+                        const auto start = q.to_index(tail);
+                        const auto available = q.available_slots(slot, tail);
+
+                        auto count = max < available ? max : available;
+                        if (count > q.capacity() - start) count = q.capacity() - start;
+                        return msg::Span<const T>{ &q.m_buffer[start], count };
+                    }
+
+                    // releases n slots previously handed out by front()
+                    void release(std::size_t n = 1) noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        auto& slot = m_queue->m_slots[m_slot_idx];
+                        const auto tail = slot.tail.load(std::memory_order_relaxed);
+                        slot.tail.store(tail + n, std::memory_order_release);
+                    }
+
+                    std::size_t count_snapshot() const noexcept {
+                        assert(m_queue != nullptr && "Invalid consumer: queue is null");
+                        const auto head = m_queue->m_header->head.load(std::memory_order_acquire);
+                        const auto tail = m_queue->m_slots[m_slot_idx].tail.load(std::memory_order_relaxed);
+                        const auto diff = head - tail;
+                        if (diff > m_queue->capacity()) {
+                            return m_queue->capacity(); // overflow
+                        }
+                        return static_cast<std::size_t>(diff);
+                    }
+            };
+
+            [[nodiscard]] std::optional<Producer> make_producer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
+                std::uint32_t expected = 0;
+                if (!m_header->producer_claimed.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+                    return std::nullopt;
+                }
+                return Producer(*this);
+            }
+
+            [[nodiscard]] std::optional<Consumer> make_consumer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
+                const auto head = m_header->head.load(std::memory_order_acquire);
+                for (std::size_t i = 0; i < m_header->max_consumers; ++i) {
+                    SlotState expected = SlotState::Free;
+                    if (m_slots[i].state.compare_exchange_strong(expected, SlotState::Initializing, std::memory_order_acq_rel)) {
+                        m_slots[i].tail.store(head, std::memory_order_relaxed);
+                        m_slots[i].cached_head = head;
+                        m_slots[i].state.store(SlotState::Active, std::memory_order_release);
+                        return Consumer(*this, i);
+                    }
+                }
+
+                return std::nullopt; // no free consumer slots
+            }
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include "shm/shm.h"
+#include "shm/shm_queue.h"
+#include "evt/fast_semaphore.h"
+
+namespace shm {
+    namespace detail {
+        constexpr std::uint32_t semaphore_magic = 0x4D4F4F54; // "MOOT"
+        constexpr std::uint32_t semaphore_version = 1;
+
+        // lives at the front of the region, layout must not change
+        // without bumping semaphore_version
+        struct ShmSemaphoreHeader {
+            std::atomic<std::uint32_t> magic;       // written last by the creator
+            std::uint32_t version;
+            alignas(cache_line) evt::detail::FutexSemState state;
+        };
+    }
+
+    // evt::FastSemaphore placed in a Shm region so processes can signal each
+    // other without a kernel semaphore object. Uncontended post/try_wait are
+    // one atomic op, waits spin then sleep on a process shared futex.
+    // NOTE: on windows WaitOnAddress does not work across processes, waiters
+    // there poll the count in 1ms sleeps instead
+    // NOTE: the ShmSemaphore view must not outlive the Shm mapping
+    class ShmSemaphore {
+        using Header = detail::ShmSemaphoreHeader;
+
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "ShmSemaphore needs lock free 32-bit atomics to be process shared");
+
+        private:
+            Header* m_header = nullptr;
+
+        public:
+            ShmSemaphore() = default;
+            ~ShmSemaphore() = default;
+
+            ShmSemaphore(const ShmSemaphore&) = delete;
+            ShmSemaphore& operator=(const ShmSemaphore&) = delete;
+            ShmSemaphore(ShmSemaphore&&) = delete;
+            ShmSemaphore& operator=(ShmSemaphore&&) = delete;
+
+            static constexpr std::size_t required_size() noexcept { return sizeof(Header); }
+
+            // placement constructs the semaphore at offset, call after Shm::create()
+            [[nodiscard]] ShmResult create(Shm& shm, std::uint32_t initial = 0, std::uint32_t max_count = 0, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Create };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Create };
+                if (offset > shm.total_size() || required_size() > shm.total_size() - offset) {
+                    return { ShmErr::TooLarge, ShmOp::Create };
+                }
+
+                auto* base = shm.map_to_type<std::byte>(offset);
+                if (base == nullptr) return { ShmErr::InvalidOffset, ShmOp::Create };
+
+                auto* header = new (base) Header{};
+                header->version = detail::semaphore_version;
+                header->state.count.store(initial, std::memory_order_relaxed);
+                header->state.max_count = max_count;
+
+                // publish last, attach() fails with BadMagic until this is visible
+                header->magic.store(detail::semaphore_magic, std::memory_order_release);
+                m_header = header;
+                return { ShmErr::None, ShmOp::Create };
+            }
+
+            // attaches to a semaphore another process created, call after Shm::open()
+            [[nodiscard]] ShmResult attach(Shm& shm, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Attach };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                auto* header = shm.map_to_type<Header>(offset);
+                if (header == nullptr) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                if (header->magic.load(std::memory_order_acquire) != detail::semaphore_magic) {
+                    return { ShmErr::BadMagic, ShmOp::Attach };
+                }
+                if (header->version != detail::semaphore_version) {
+                    return { ShmErr::VersionMismatch, ShmOp::Attach };
+                }
+
+                m_header = header;
+                return { ShmErr::None, ShmOp::Attach };
+            }
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_header != nullptr; }
+
+            [[nodiscard]] evt::SemResult post() noexcept {
+                if (m_header == nullptr) return { evt::SemErr::NotInitialized, evt::SemOp::Post };
+                return evt::detail::futex_sem_post(m_header->state, true);
+            }
+
+            [[nodiscard]] evt::SemResult try_wait() noexcept {
+                if (m_header == nullptr) return { evt::SemErr::NotInitialized, evt::SemOp::TryWait };
+                return evt::detail::futex_sem_try_wait(m_header->state);
+            }
+
+            [[nodiscard]] evt::SemResult wait(std::uint32_t milliseconds = 0) noexcept {
+                if (m_header == nullptr) return { evt::SemErr::NotInitialized, evt::SemOp::Wait };
+                return evt::detail::futex_sem_wait(m_header->state, static_cast<std::uint64_t>(milliseconds) * 1'000'000u, true);
+            }
+
+            // timeout_ns of 0 waits forever, measured on the monotonic clock
+            [[nodiscard]] evt::SemResult wait_ns(std::uint64_t timeout_ns) noexcept {
+                if (m_header == nullptr) return { evt::SemErr::NotInitialized, evt::SemOp::Wait };
+                return evt::detail::futex_sem_wait(m_header->state, timeout_ns, true);
+            }
+
+            std::uint32_t count_snapshot() const noexcept {
+                return m_header != nullptr ? m_header->state.count.load(std::memory_order_relaxed) : 0;
+            }
+    };
+}
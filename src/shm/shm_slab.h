@@ -0,0 +1,277 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include "shm/shm.h"
+#include "shm/shm_queue.h"
+
+namespace shm {
+    // 32-bit offset based handle into a ShmSlab, the same value means the same
+    // block in every process that attached the slab. top 4 bits pick the size
+    // class, the rest is the block index within it
+    using ShmHandle = std::uint32_t;
+    constexpr ShmHandle invalid_handle = UINT32_MAX;
+
+    struct ShmSlabClass {
+        std::uint32_t block_size = 0;   // rounded up to 64 bytes
+        std::uint32_t block_count = 0;
+    };
+
+    namespace detail {
+        constexpr std::uint32_t slab_magic = 0x4D4F4F53; // "MOOS"
+        constexpr std::uint32_t slab_version = 1;
+        constexpr std::size_t slab_max_classes = 16;
+        constexpr std::uint32_t slab_index_bits = 28;
+        constexpr std::uint32_t slab_index_mask = (1u << slab_index_bits) - 1;
+        constexpr std::uint32_t slab_nil = slab_index_mask; // end of a free list, never a real block
+
+        struct alignas(cache_line) ShmSlabClassDesc {
+            std::uint32_t block_size;
+            std::uint32_t block_count;
+            std::uint64_t blocks_offset;    // from the header
+            std::uint64_t next_offset;      // from the header, one uint32 link per block
+
+            // treiber stack, low 32 bits = top block, high 32 bits = aba tag bumped on every pop
+            alignas(cache_line) std::atomic<std::uint64_t> free_head;
+            std::atomic<std::uint32_t> free_count;
+        };
+
+        // lives at the front of the region, layout must not change
+        // without bumping slab_version
+        struct ShmSlabHeader {
+            std::atomic<std::uint32_t> magic;       // written last by the creator
+            std::uint32_t version;
+            std::uint32_t class_count;
+            std::uint32_t reserved;
+            std::uint64_t total_size;               // bytes from the header to the end of the last class
+            ShmSlabClassDesc classes[slab_max_classes];
+        };
+    }
+
+    // Size classed block allocator placement constructed into a Shm region.
+    // Each class is a run of fixed size blocks with a lock free free list, so
+    // any process can allocate a block, write a payload straight into it,
+    // push just the 32-bit handle through a ShmQueue and let the reader free
+    // it once done, payload never gets copied.
+    // allocate() takes the smallest class that fits and moves up to bigger
+    // classes when that one is empty.
+    // NOTE: classes must be given smallest block_size first
+    // NOTE: the ShmSlab view must not outlive the Shm mapping, blocks held by
+    // a process that dies are leaked until the region is recreated
+    class ShmSlab {
+        using Header = detail::ShmSlabHeader;
+        using ClassDesc = detail::ShmSlabClassDesc;
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ShmSlab needs lock free 64-bit atomics to be process shared");
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "ShmSlab needs lock free 32-bit atomics to be process shared");
+
+        private:
+            Header* m_header = nullptr;
+            std::byte* m_base = nullptr;
+
+            static std::uint32_t block_bytes(std::uint32_t size) noexcept {
+                return static_cast<std::uint32_t>(detail::align_up(size, detail::cache_line));
+            }
+
+            std::atomic<std::uint32_t>* links(const ClassDesc& c) const noexcept {
+                return reinterpret_cast<std::atomic<std::uint32_t>*>(m_base + c.next_offset);
+            }
+
+            static std::uint32_t head_index(std::uint64_t head) noexcept { return static_cast<std::uint32_t>(head); }
+            static std::uint64_t make_head(std::uint64_t tag, std::uint32_t idx) noexcept { return (tag << 32) | idx; }
+
+            [[nodiscard]] bool pop(ClassDesc& c, std::uint32_t& out) noexcept {
+                auto* next = links(c);
+                auto head = c.free_head.load(std::memory_order_acquire);
+                while (true) {
+                    const auto idx = head_index(head);
+                    if (idx == detail::slab_nil) return false;
+
+                    // if the block was popped and pushed back meanwhile the tag moved, so the CAS fails
+                    const auto new_head = make_head((head >> 32) + 1, next[idx].load(std::memory_order_relaxed));
+                    if (c.free_head.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire)) {
+                        c.free_count.fetch_sub(1, std::memory_order_relaxed);
+                        out = idx;
+                        return true;
+                    }
+                }
+            }
+
+            void push(ClassDesc& c, std::uint32_t idx) noexcept {
+                auto* next = links(c);
+                auto head = c.free_head.load(std::memory_order_relaxed);
+                while (true) {
+                    next[idx].store(head_index(head), std::memory_order_relaxed);
+                    if (c.free_head.compare_exchange_weak(head, make_head(head >> 32, idx), std::memory_order_release, std::memory_order_relaxed)) {
+                        c.free_count.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+            }
+
+            static bool valid_classes(const ShmSlabClass* classes, std::size_t count) noexcept {
+                if (classes == nullptr || count == 0 || count > detail::slab_max_classes) return false;
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (classes[i].block_size == 0 || classes[i].block_count == 0) return false;
+                    if (classes[i].block_count >= detail::slab_nil) return false;
+                    if (i != 0 && classes[i].block_size <= classes[i - 1].block_size) return false;
+                }
+                return true;
+            }
+
+        public:
+            ShmSlab() = default;
+            ~ShmSlab() = default;
+
+            ShmSlab(const ShmSlab&) = delete;
+            ShmSlab& operator=(const ShmSlab&) = delete;
+            ShmSlab(ShmSlab&&) = delete;
+            ShmSlab& operator=(ShmSlab&&) = delete;
+
+            // bytes of Shm needed for these classes
+            static std::size_t required_size(const ShmSlabClass* classes, std::size_t count) noexcept {
+                std::size_t size = detail::align_up(sizeof(Header), detail::cache_line);
+                for (std::size_t i = 0; i < count; ++i) {
+                    const auto n = static_cast<std::size_t>(classes[i].block_count);
+                    size += detail::align_up(n * sizeof(std::uint32_t), detail::cache_line);
+                    size += n * block_bytes(classes[i].block_size);
+                }
+                return size;
+            }
+
+            static std::size_t required_size(std::initializer_list<ShmSlabClass> classes) noexcept {
+                return required_size(classes.begin(), classes.size());
+            }
+
+            // placement constructs a new slab at offset, call after Shm::create()
+            [[nodiscard]] ShmResult create(Shm& shm, const ShmSlabClass* classes, std::size_t count, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Create };
+                if (!valid_classes(classes, count)) return { ShmErr::LayoutMismatch, ShmOp::Create };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Create };
+
+                const auto total = required_size(classes, count);
+                if (offset > shm.total_size() || total > shm.total_size() - offset) {
+                    return { ShmErr::TooLarge, ShmOp::Create };
+                }
+
+                auto* base = shm.map_to_type<std::byte>(offset);
+                if (base == nullptr) return { ShmErr::InvalidOffset, ShmOp::Create };
+
+                auto* header = new (base) Header{};
+                header->version = detail::slab_version;
+                header->class_count = static_cast<std::uint32_t>(count);
+                header->total_size = total;
+
+                m_header = header;
+                m_base = base;
+
+                std::size_t cursor = detail::align_up(sizeof(Header), detail::cache_line);
+                for (std::size_t i = 0; i < count; ++i) {
+                    auto& c = header->classes[i];
+                    c.block_size = block_bytes(classes[i].block_size);
+                    c.block_count = classes[i].block_count;
+                    c.next_offset = cursor;
+                    cursor += detail::align_up(static_cast<std::size_t>(c.block_count) * sizeof(std::uint32_t), detail::cache_line);
+                    c.blocks_offset = cursor;
+                    cursor += static_cast<std::size_t>(c.block_count) * c.block_size;
+
+                    // every block free, linked in index order
+                    auto* next = links(c);
+                    for (std::uint32_t b = 0; b < c.block_count; ++b) {
+                        new (&next[b]) std::atomic<std::uint32_t>(b + 1 < c.block_count ? b + 1 : detail::slab_nil);
+                    }
+                    c.free_head.store(make_head(0, 0), std::memory_order_relaxed);
+                    c.free_count.store(c.block_count, std::memory_order_relaxed);
+                }
+
+                // publish last, attach() fails with BadMagic until this is visible
+                header->magic.store(detail::slab_magic, std::memory_order_release);
+                return { ShmErr::None, ShmOp::Create };
+            }
+
+            [[nodiscard]] ShmResult create(Shm& shm, std::initializer_list<ShmSlabClass> classes, std::size_t offset = 0) noexcept {
+                return create(shm, classes.begin(), classes.size(), offset);
+            }
+
+            // attaches to a slab another process created, call after Shm::open()
+            [[nodiscard]] ShmResult attach(Shm& shm, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Attach };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                auto* header = shm.map_to_type<Header>(offset);
+                if (header == nullptr) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                if (header->magic.load(std::memory_order_acquire) != detail::slab_magic) {
+                    return { ShmErr::BadMagic, ShmOp::Attach };
+                }
+                if (header->version != detail::slab_version) {
+                    return { ShmErr::VersionMismatch, ShmOp::Attach };
+                }
+                if (header->class_count == 0 || header->class_count > detail::slab_max_classes) {
+                    return { ShmErr::LayoutMismatch, ShmOp::Attach };
+                }
+                if (header->total_size > shm.total_size() - offset) {
+                    return { ShmErr::SizeMismatch, ShmOp::Attach };
+                }
+
+                m_header = header;
+                m_base = reinterpret_cast<std::byte*>(header);
+                return { ShmErr::None, ShmOp::Attach };
+            }
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_header != nullptr; }
+            [[nodiscard]] std::size_t class_count() const noexcept { return m_header->class_count; }
+            [[nodiscard]] std::size_t block_size(std::size_t cls) const noexcept { return m_header->classes[cls].block_size; }
+            [[nodiscard]] std::size_t block_count(std::size_t cls) const noexcept { return m_header->classes[cls].block_count; }
+            std::size_t free_snapshot(std::size_t cls) const noexcept {
+                return m_header->classes[cls].free_count.load(std::memory_order_relaxed);
+            }
+
+            // invalid_handle when bytes is larger than every class or all fitting classes are empty
+            [[nodiscard]] ShmHandle allocate(std::size_t bytes) noexcept {
+                assert(is_valid() && "Invalid ShmSlab: not created or attached");
+                for (std::uint32_t i = 0; i < m_header->class_count; ++i) {
+                    auto& c = m_header->classes[i];
+                    if (c.block_size < bytes) continue;
+
+                    std::uint32_t idx = 0;
+                    if (pop(c, idx)) return (i << detail::slab_index_bits) | idx;
+                }
+                return invalid_handle;
+            }
+
+            // any process, any thread. the handle must come from allocate() on this slab
+            void free(ShmHandle handle) noexcept {
+                assert(is_valid() && "Invalid ShmSlab: not created or attached");
+                assert(owns(handle) && "Invalid ShmSlab handle");
+                push(m_header->classes[handle >> detail::slab_index_bits], handle & detail::slab_index_mask);
+            }
+
+            [[nodiscard]] bool owns(ShmHandle handle) const noexcept {
+                if (handle == invalid_handle) return false;
+                const auto cls = handle >> detail::slab_index_bits;
+                return cls < m_header->class_count && (handle & detail::slab_index_mask) < m_header->classes[cls].block_count;
+            }
+
+            // 64 byte aligned, capacity(handle) bytes usable
+            [[nodiscard]] std::byte* data(ShmHandle handle) const noexcept {
+                assert(owns(handle) && "Invalid ShmSlab handle");
+                const auto& c = m_header->classes[handle >> detail::slab_index_bits];
+                return m_base + c.blocks_offset + static_cast<std::size_t>(handle & detail::slab_index_mask) * c.block_size;
+            }
+
+            [[nodiscard]] std::size_t capacity(ShmHandle handle) const noexcept {
+                return m_header->classes[handle >> detail::slab_index_bits].block_size;
+            }
+
+            template <typename T>
+            [[nodiscard]] T* as(ShmHandle handle) const noexcept {
+                static_assert(alignof(T) <= detail::cache_line, "ShmSlab blocks are 64 byte aligned");
+                assert(sizeof(T) <= capacity(handle) && "ShmSlab block too small for T");
+                return reinterpret_cast<T*>(data(handle));
+            }
+    };
+}
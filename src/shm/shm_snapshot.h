@@ -0,0 +1,291 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include "shm/shm.h"
+#include "shm/shm_queue.h"
+#include "msg/wait_strategy.h"
+
+namespace shm {
+    namespace detail {
+        constexpr std::uint32_t snapshot_magic = 0x4D4F4F4C; // "MOOL" (latest)
+        constexpr std::uint32_t snapshot_version = 1;
+
+        // lives at the front of the region, layout must not change
+        // without bumping snapshot_version
+        struct ShmSnapshotHeader {
+            std::atomic<std::uint32_t> magic;       // written last by the creator
+            std::uint32_t version;
+            std::uint32_t elem_size;
+            std::uint32_t elem_align;
+            std::uint32_t slot_count;
+            std::uint32_t slot_stride;
+            std::uint64_t slots_offset;             // from the header
+
+            alignas(cache_line) std::atomic<std::uint32_t> writer_claimed;
+        };
+
+        // seq is odd while the writer is inside the slot, value follows on
+        // the next cache line so readers spinning on seq dont share it
+        struct alignas(cache_line) ShmSnapshotSlot {
+            std::atomic<std::uint64_t> seq;
+        };
+    }
+
+    // Latest value publishing over a Shm region: one writer process, any
+    // number of reader processes, readers never block or slow the writer.
+    // Each slot is its own seqlock so a region can hold many independently
+    // versioned values (one per instrument, per field group, ...); version()
+    // tells readers whether a slot changed without copying it.
+    // The writer is wait free, a reader that raced a write just copies again.
+    // NOTE: the ShmSnapshot view and its Writer must not outlive the Shm mapping.
+    // NOTE: a process that dies holding the writer leaves its claim set.
+    template <typename T>
+    class ShmSnapshot {
+        static_assert(std::is_trivially_copyable_v<T>, "ShmSnapshot only supports trivially copyable types");
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "ShmSnapshot needs lock free 64-bit atomics to be process shared");
+        static_assert(alignof(T) <= detail::cache_line, "ShmSnapshot element alignment must be <= 64");
+
+        using Header = detail::ShmSnapshotHeader;
+        using Slot = detail::ShmSnapshotSlot;
+
+        private:
+            Header* m_header = nullptr;
+            std::byte* m_slots = nullptr;
+
+            static constexpr std::size_t value_offset() noexcept { return detail::align_up(sizeof(Slot), detail::cache_line); }
+            static constexpr std::size_t slot_stride() noexcept {
+                return detail::align_up(value_offset() + sizeof(T), detail::cache_line);
+            }
+
+            static constexpr std::size_t slots_offset() noexcept {
+                return detail::align_up(sizeof(Header), detail::cache_line);
+            }
+
+            Slot& slot(std::size_t i) const noexcept {
+                assert(i < m_header->slot_count && "ShmSnapshot slot out of range");
+                return *reinterpret_cast<Slot*>(m_slots + i * slot_stride());
+            }
+
+            T* value(std::size_t i) const noexcept {
+                return reinterpret_cast<T*>(m_slots + i * slot_stride() + value_offset());
+            }
+
+            void bind(std::byte* base) noexcept {
+                m_header = reinterpret_cast<Header*>(base);
+                m_slots = base + m_header->slots_offset;
+            }
+
+            void begin_write(std::size_t i) noexcept {
+                auto& s = slot(i);
+                s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            void end_write(std::size_t i) noexcept {
+                auto& s = slot(i);
+                s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+
+            [[nodiscard]] bool try_read_impl(std::size_t i, T& out, std::uint64_t& seq_out) const noexcept {
+                auto& s = slot(i);
+                const auto before = s.seq.load(std::memory_order_acquire);
+                if ((before & 1) != 0) return false; // writer is mid update
+
+                out = *value(i);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (s.seq.load(std::memory_order_relaxed) != before) return false; // torn
+
+                seq_out = before;
+                return true;
+            }
+
+        public:
+            ShmSnapshot() = default;
+            ~ShmSnapshot() = default;
+
+            ShmSnapshot(const ShmSnapshot&) = delete;
+            ShmSnapshot& operator=(const ShmSnapshot&) = delete;
+            ShmSnapshot(ShmSnapshot&&) = delete;
+            ShmSnapshot& operator=(ShmSnapshot&&) = delete;
+
+            // bytes of Shm needed for slot_count independently versioned values
+            static constexpr std::size_t required_size(std::size_t slot_count = 1) noexcept {
+                return slots_offset() + slot_count * slot_stride();
+            }
+
+            // placement constructs the slots at offset (value initialized,
+            // version 0), call after Shm::create()
+            [[nodiscard]] ShmResult create(Shm& shm, std::size_t slot_count = 1, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Create };
+                if (slot_count == 0 || slot_count > UINT32_MAX) return { ShmErr::LayoutMismatch, ShmOp::Create };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Create };
+                if (offset > shm.total_size() || required_size(slot_count) > shm.total_size() - offset) {
+                    return { ShmErr::TooLarge, ShmOp::Create };
+                }
+
+                auto* base = shm.map_to_type<std::byte>(offset);
+                if (base == nullptr) return { ShmErr::InvalidOffset, ShmOp::Create };
+
+                auto* header = new (base) Header{};
+                header->version = detail::snapshot_version;
+                header->elem_size = static_cast<std::uint32_t>(sizeof(T));
+                header->elem_align = static_cast<std::uint32_t>(alignof(T));
+                header->slot_count = static_cast<std::uint32_t>(slot_count);
+                header->slot_stride = static_cast<std::uint32_t>(slot_stride());
+                header->slots_offset = slots_offset();
+                header->writer_claimed.store(0, std::memory_order_relaxed);
+
+                auto* slots = base + header->slots_offset;
+                for (std::size_t i = 0; i < slot_count; ++i) {
+                    new (slots + i * slot_stride()) Slot{};
+                    new (slots + i * slot_stride() + value_offset()) T{};
+                }
+
+                // publish last, attach() fails with BadMagic until this is visible
+                header->magic.store(detail::snapshot_magic, std::memory_order_release);
+                bind(base);
+                return { ShmErr::None, ShmOp::Create };
+            }
+
+            // attaches to slots another process created, call after Shm::open()
+            [[nodiscard]] ShmResult attach(Shm& shm, std::size_t offset = 0) noexcept {
+                if (!shm.is_valid()) return { ShmErr::NotOpen, ShmOp::Attach };
+                if (offset % detail::cache_line != 0) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                auto* header = shm.map_to_type<Header>(offset);
+                if (header == nullptr) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+                if (header->magic.load(std::memory_order_acquire) != detail::snapshot_magic) {
+                    return { ShmErr::BadMagic, ShmOp::Attach };
+                }
+                if (header->version != detail::snapshot_version) {
+                    return { ShmErr::VersionMismatch, ShmOp::Attach };
+                }
+                if (header->elem_size != sizeof(T) || header->elem_align != alignof(T) ||
+                    header->slot_stride != slot_stride() || header->slots_offset != slots_offset() ||
+                    header->slot_count == 0) {
+                    return { ShmErr::LayoutMismatch, ShmOp::Attach };
+                }
+                if (required_size(header->slot_count) > shm.total_size() - offset) {
+                    return { ShmErr::SizeMismatch, ShmOp::Attach };
+                }
+
+                bind(reinterpret_cast<std::byte*>(header));
+                return { ShmErr::None, ShmOp::Attach };
+            }
+
+            class Writer {
+                private:
+                    ShmSnapshot* m_snap = nullptr;
+
+                public:
+                    explicit Writer(ShmSnapshot& s) noexcept : m_snap(&s) {}
+                    ~Writer() {
+                        if (m_snap != nullptr) {
+                            m_snap->m_header->writer_claimed.store(0, std::memory_order_release);
+                        }
+                    }
+
+                    Writer(const Writer&) = delete;
+                    Writer& operator=(const Writer&) = delete;
+
+                    Writer(Writer&& other) noexcept : m_snap(other.m_snap) {
+                        other.m_snap = nullptr;
+                    }
+
+                    Writer& operator=(Writer&& other) noexcept {
+                        if (this != &other) {
+                            if (m_snap != nullptr) {
+                                m_snap->m_header->writer_claimed.store(0, std::memory_order_release);
+                            }
+                            m_snap = other.m_snap;
+                            other.m_snap = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    // replaces the whole value of slot i
+                    void publish(const T& item, std::size_t i = 0) noexcept {
+                        assert(m_snap != nullptr && "Invalid writer: snapshot is null");
+                        m_snap->begin_write(i);
+                        *m_snap->value(i) = item;
+                        m_snap->end_write(i);
+                    }
+
+                    // edits slot i in place, fn(T&) should only touch the fields
+                    // that changed and must not block since readers retry meanwhile
+                    template <typename F>
+                    void update(F&& fn, std::size_t i = 0) noexcept {
+                        assert(m_snap != nullptr && "Invalid writer: snapshot is null");
+                        m_snap->begin_write(i);
+                        fn(*m_snap->value(i));
+                        m_snap->end_write(i);
+                    }
+            };
+
+            class Reader {
+                private:
+                    const ShmSnapshot* m_snap = nullptr;
+
+                public:
+                    explicit Reader(const ShmSnapshot& s) noexcept : m_snap(&s) {}
+
+                    // copies slot i, retrying torn reads. false only if max_retries
+                    // (0 = unlimited) ran out while the writer kept updating
+                    [[nodiscard]] bool read(T& out, std::size_t i = 0, std::uint32_t max_retries = 0) const noexcept {
+                        assert(m_snap != nullptr && "Invalid reader: snapshot is null");
+                        std::uint64_t seq = 0;
+                        for (std::uint32_t n = 0; max_retries == 0 || n < max_retries; ++n) {
+                            if (m_snap->try_read_impl(i, out, seq)) return true;
+                            msg::detail::cpu_relax();
+                        }
+                        return false;
+                    }
+
+                    // copies slot i only if it was published since last_version,
+                    // updates last_version. pass 0 the first time
+                    [[nodiscard]] bool read_if_changed(T& out, std::uint64_t& last_version, std::size_t i = 0) const noexcept {
+                        assert(m_snap != nullptr && "Invalid reader: snapshot is null");
+                        std::uint64_t seq = 0;
+                        while (true) {
+                            if (m_snap->version(i) == last_version) return false;
+                            if (m_snap->try_read_impl(i, out, seq)) {
+                                last_version = seq / 2;
+                                return true;
+                            }
+                            msg::detail::cpu_relax();
+                        }
+                    }
+            };
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_header != nullptr; }
+            [[nodiscard]] std::size_t slot_count() const noexcept { return m_header->slot_count; }
+
+            // number of completed publishes to slot i, cheap change detection
+            [[nodiscard]] std::uint64_t version(std::size_t i = 0) const noexcept {
+                return slot(i).seq.load(std::memory_order_acquire) / 2;
+            }
+
+            // one writer across every process attached to the region
+            [[nodiscard]] std::optional<Writer> make_writer() noexcept {
+                if (!is_valid()) return std::nullopt;
+
+                std::uint32_t expected = 0;
+                if (!m_header->writer_claimed.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+                    return std::nullopt;
+                }
+                return Writer(*this);
+            }
+
+            // any number of readers
+            [[nodiscard]] std::optional<Reader> make_reader() const noexcept {
+                if (!is_valid()) return std::nullopt;
+                return Reader(*this);
+            }
+    };
+}
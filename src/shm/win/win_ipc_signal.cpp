@@ -0,0 +1,35 @@
+#if defined(MOO_WIN32)
+#include "shm/ipc_bus.h"
+
+namespace shm {
+    // WaitOnAddress only wakes threads of the calling process, parked
+    // subscribers in other processes wait on a named semaphore instead
+    ShmResult IpcSignal::bind(detail::IpcSignalWord* word) noexcept {
+        if (word == nullptr) return { ShmErr::InvalidOffset, ShmOp::Attach };
+
+        const auto r = m_sem.open();
+        if (!r.ok() && r.code != evt::NamedSemErr::DoubleOpen) return { ShmErr::UnknownError, ShmOp::Attach };
+
+        m_word = word;
+        return { ShmErr::None, ShmOp::Attach };
+    }
+
+    bool IpcSignal::park(std::uint32_t epoch, std::uint64_t timeout_ns) noexcept {
+        if (m_word->epoch.load(std::memory_order_acquire) != epoch) return true;
+
+        // wait_ns treats 0 as forever, same as we do
+        const auto r = m_sem.wait_ns(timeout_ns);
+        return r.ok();
+    }
+
+    // one post per parked waiter. A waiter that found data before parking
+    // leaves its post behind, that only costs someone a spurious wakeup later
+    void IpcSignal::wake() noexcept {
+        m_word->epoch.fetch_add(1, std::memory_order_release);
+        const auto waiters = m_word->waiters.load(std::memory_order_acquire);
+        for (std::uint32_t i = 0; i < waiters; ++i) {
+            if (!m_sem.post().ok()) break;
+        }
+    }
+}
+#endif
@@ -23,19 +23,66 @@ namespace shm {
         return out;
     }
 
-    Shm::Shm(const int32_t id, const size_t total_size) : 
-        m_id(id), m_total_size(total_size), m_handle(nullptr), m_view(nullptr) {}
+    namespace {
+        #if defined(FILE_MAP_LARGE_PAGES)
+            constexpr DWORD map_large_pages = FILE_MAP_LARGE_PAGES;
+        #else
+            constexpr DWORD map_large_pages = 0x20000000; // older sdks
+        #endif
+
+        size_t round_up(size_t bytes, size_t page) noexcept {
+            return (bytes + page - 1) & ~(page - 1);
+        }
+
+        // large page sections need SeLockMemoryPrivilege held and enabled
+        bool enable_lock_memory_privilege() noexcept {
+            HANDLE token = nullptr;
+            if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+                return false;
+            }
+
+            TOKEN_PRIVILEGES tp{};
+            tp.PrivilegeCount = 1;
+            tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+            bool ok = ::LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid) != 0;
+            // AdjustTokenPrivileges "succeeds" without the privilege, the real answer is in GetLastError
+            ok = ok && ::AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr) != 0
+                    && ::GetLastError() == ERROR_SUCCESS;
+
+            ::CloseHandle(token);
+            return ok;
+        }
+
+        void touch_pages(const std::byte* view, size_t bytes, size_t step) noexcept {
+            const volatile std::byte* p = view;
+            for (size_t off = 0; off < bytes; off += step) {
+                (void)p[off];
+            }
+        }
+    }
+
+    Shm::Shm(const int32_t id, const size_t total_size, const ShmOptions& opts) : 
+        m_id(id), m_total_size(total_size), m_handle(nullptr), m_view(nullptr), m_opts(opts) {}
 
     Shm::Shm(Shm&& other) noexcept : 
         m_id(other.m_id),
         m_total_size(other.m_total_size),
         m_handle(other.m_handle),
-        m_view(other.m_view) {
+        m_view(other.m_view),
+        m_opts(other.m_opts),
+        m_mapped_size(other.m_mapped_size),
+        m_huge(other.m_huge),
+        m_locked(other.m_locked),
+        m_file(other.m_file) {
 
         other.m_handle = nullptr;
         other.m_view   = nullptr;
+        other.m_file = nullptr;
         other.m_id  = -1;
         other.m_total_size = 0;
+        other.m_mapped_size = 0;
+        other.m_huge = false;
+        other.m_locked = false;
     }
 
     Shm& Shm::operator=(Shm&& other) noexcept {
@@ -46,11 +93,20 @@ namespace shm {
             m_total_size = other.m_total_size;
             m_handle = other.m_handle;
             m_view = other.m_view;
+            m_opts = other.m_opts;
+            m_mapped_size = other.m_mapped_size;
+            m_huge = other.m_huge;
+            m_locked = other.m_locked;
+            m_file = other.m_file;
 
             other.m_handle = nullptr;
             other.m_view = nullptr;
+            other.m_file = nullptr;
             other.m_id = -1;
             other.m_total_size = 0;
+            other.m_mapped_size = 0;
+            other.m_huge = false;
+            other.m_locked = false;
         }
         return *this;
     }
@@ -67,22 +123,142 @@ namespace shm {
         return "Local\\eroil.node." + std::to_string(m_id);
     }
 
+    ShmErr Shm::apply_mapping_options() noexcept {
+        if (m_opts.prefault) {
+            touch_pages(static_cast<const std::byte*>(m_view), m_mapped_size, 4096);
+        }
+
+        if (m_huge) {
+            m_locked = true; // large pages are never paged out
+            return ShmErr::None;
+        }
+
+        if (m_opts.lock) {
+            if (!::VirtualLock(m_view, m_mapped_size)) {
+                // default working set is tiny, grow it by the region and retry once
+                SIZE_T min_ws = 0;
+                SIZE_T max_ws = 0;
+                if (!::GetProcessWorkingSetSize(::GetCurrentProcess(), &min_ws, &max_ws) ||
+                    !::SetProcessWorkingSetSize(::GetCurrentProcess(), min_ws + m_mapped_size, max_ws + m_mapped_size) ||
+                    !::VirtualLock(m_view, m_mapped_size)) {
+                    return ShmErr::LockFailed;
+                }
+            }
+            m_locked = true;
+        }
+
+        return ShmErr::None;
+    }
+
+    ShmResult Shm::map_file(bool create) noexcept {
+        const ShmOp op = create ? ShmOp::Create : ShmOp::Open;
+        const std::wstring path = to_windows_wstring(m_opts.file_path);
+        if (path.empty()) return { ShmErr::InvalidName, op };
+
+        m_file = ::CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                               FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                               create ? CREATE_NEW : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            m_file = nullptr;
+            const DWORD e = ::GetLastError();
+            if (e == ERROR_FILE_EXISTS) return { ShmErr::AlreadyExists, op };
+            if (e == ERROR_FILE_NOT_FOUND || e == ERROR_PATH_NOT_FOUND) return { ShmErr::DoesNotExist, op };
+            return { ShmErr::UnknownError, op };
+        }
+
+        const auto fail = [&](ShmErr err) -> ShmResult {
+            close();
+            if (create) ::DeleteFileW(path.c_str()); // delete the partially created file
+            return { err, op };
+        };
+
+        if (!create) {
+            LARGE_INTEGER size{};
+            if (!::GetFileSizeEx(m_file, &size)) return fail(ShmErr::UnknownError);
+            if (m_total_size == 0) m_total_size = static_cast<size_t>(size.QuadPart);
+            if (static_cast<size_t>(size.QuadPart) != m_total_size) return fail(ShmErr::SizeMismatch);
+        }
+        if (m_total_size == 0) return fail(ShmErr::SizeMismatch);
+
+        // a file mapping bigger than the file grows the file, which is how create sizes it
+        const auto size = static_cast<std::uint64_t>(m_total_size);
+        m_handle = ::CreateFileMappingW(m_file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFFu), nullptr);
+        if (m_handle == nullptr) return fail(ShmErr::UnknownError);
+
+        if (m_opts.numa_node >= 0) {
+            m_view = ::MapViewOfFileExNuma(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0, nullptr, static_cast<DWORD>(m_opts.numa_node));
+        } else {
+            m_view = ::MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        }
+        if (m_view == nullptr) return fail(ShmErr::FileMapFailed);
+
+        m_mapped_size = m_total_size;
+        m_huge = false;
+
+        const ShmErr err = apply_mapping_options();
+        if (err != ShmErr::None) return fail(err);
+        return { ShmErr::None, op };
+    }
+
+    ShmResult Shm::sync(size_t offset, size_t bytes, bool async) noexcept {
+        if (!is_valid()) return { ShmErr::NotOpen, ShmOp::Write };
+        if (offset > m_mapped_size) return { ShmErr::InvalidOffset, ShmOp::Write };
+        if (bytes > m_mapped_size - offset) bytes = m_mapped_size - offset;
+        if (bytes == 0) return { ShmErr::None, ShmOp::Write };
+
+        // FlushViewOfFile only starts the writeback, FlushFileBuffers waits for the disk
+        if (!::FlushViewOfFile(static_cast<std::byte*>(m_view) + offset, bytes)) {
+            return { ShmErr::UnknownError, ShmOp::Write };
+        }
+        if (!async && m_file != nullptr && !::FlushFileBuffers(m_file)) {
+            return { ShmErr::UnknownError, ShmOp::Write };
+        }
+        return { ShmErr::None, ShmOp::Write };
+    }
+
     ShmResult Shm::create() {
         if (is_valid()) return { ShmErr::DoubleOpen, ShmOp::Create };
+        if (m_opts.file_path != nullptr) return map_file(true);
 
         std::wstring wname = to_windows_wstring(name());
         if (wname.empty()) {
             return { ShmErr::InvalidName, ShmOp::Create };
         }
 
-        m_handle = ::CreateFileMappingW(
-            INVALID_HANDLE_VALUE,
-            nullptr,
-            PAGE_READWRITE,
-            0,
-            static_cast<DWORD>(total_size()),
-            wname.c_str()
-        );
+        size_t total = total_size();
+        bool huge = false;
+        if (m_opts.page_size != ShmPageSize::Default) {
+            const SIZE_T large = ::GetLargePageMinimum();
+            huge = large != 0 && enable_lock_memory_privilege();
+            if (huge) total = round_up(total, large);
+            if (!huge && !m_opts.huge_fallback) return { ShmErr::HugePagesUnavailable, ShmOp::Create };
+        }
+
+        const auto create_mapping = [&](DWORD protect, size_t bytes) -> HANDLE {
+            const auto size = static_cast<std::uint64_t>(bytes);
+            const auto hi = static_cast<DWORD>(size >> 32);
+            const auto lo = static_cast<DWORD>(size & 0xFFFFFFFFu);
+            if (m_opts.numa_node >= 0) {
+                return ::CreateFileMappingNumaW(INVALID_HANDLE_VALUE, nullptr, protect, hi, lo,
+                                                wname.c_str(), static_cast<DWORD>(m_opts.numa_node));
+            }
+            return ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, protect, hi, lo, wname.c_str());
+        };
+
+        if (huge) {
+            m_handle = create_mapping(PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES, total);
+            if (m_handle == nullptr) {
+                // not enough contiguous memory for large pages right now
+                if (!m_opts.huge_fallback) return { ShmErr::HugePagesUnavailable, ShmOp::Create };
+                huge = false;
+                total = total_size();
+            }
+        }
+
+        if (m_handle == nullptr) {
+            m_handle = create_mapping(PAGE_READWRITE, total);
+        }
 
         if (m_handle == nullptr) {
             close();
@@ -94,17 +270,32 @@ namespace shm {
             return { ShmErr::AlreadyExists, ShmOp::Create };
         }
 
-        m_view = ::MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        const DWORD access = FILE_MAP_ALL_ACCESS | (huge ? map_large_pages : 0);
+        if (m_opts.numa_node >= 0) {
+            m_view = ::MapViewOfFileExNuma(m_handle, access, 0, 0, 0, nullptr, static_cast<DWORD>(m_opts.numa_node));
+        } else {
+            m_view = ::MapViewOfFile(m_handle, access, 0, 0, 0);
+        }
+
         if (m_view == nullptr) {
             close();
             return { ShmErr::FileMapFailed, ShmOp::Create };
         }
+        m_mapped_size = total;
+        m_huge = huge;
+
+        const ShmErr err = apply_mapping_options();
+        if (err != ShmErr::None) {
+            close();
+            return { err, ShmOp::Create };
+        }
  
         return { ShmErr::None, ShmOp::Create };
     }
 
     ShmResult Shm::open() {
         if (is_valid()) return { ShmErr::DoubleOpen, ShmOp::Open };
+        if (m_opts.file_path != nullptr) return map_file(false);
 
         std::wstring wname = to_windows_wstring(name());
         if (wname.empty()) {
@@ -123,12 +314,37 @@ namespace shm {
             return { ShmErr::UnknownError, ShmOp::Open };
         }
 
-        m_view = ::MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        const auto map = [&](DWORD access) -> void* {
+            if (m_opts.numa_node >= 0) {
+                return ::MapViewOfFileExNuma(m_handle, access, 0, 0, 0, nullptr, static_cast<DWORD>(m_opts.numa_node));
+            }
+            return ::MapViewOfFile(m_handle, access, 0, 0, 0);
+        };
+
+        // a large page section has to be mapped with FILE_MAP_LARGE_PAGES
+        bool huge = false;
+        m_view = map(FILE_MAP_ALL_ACCESS);
+        if (m_view == nullptr && m_opts.page_size != ShmPageSize::Default) {
+            m_view = map(FILE_MAP_ALL_ACCESS | map_large_pages);
+            huge = m_view != nullptr;
+        }
+
         if (m_view == nullptr) {
             close();
             m_handle = nullptr;
             return { ShmErr::FileMapFailed, ShmOp::Open };
         }
+
+        MEMORY_BASIC_INFORMATION info{};
+        m_mapped_size = ::VirtualQuery(m_view, &info, sizeof(info)) != 0 ? info.RegionSize : total_size();
+        if (m_total_size == 0) m_total_size = m_mapped_size;
+        m_huge = huge;
+
+        const ShmErr err = apply_mapping_options();
+        if (err != ShmErr::None) {
+            close();
+            return { err, ShmOp::Open };
+        }
    
         return { ShmErr::None, ShmOp::Open };
     }
@@ -143,6 +359,15 @@ namespace shm {
             ::CloseHandle(m_handle);
             m_handle = nullptr;
         }
+
+        if (m_file != nullptr) {
+            ::CloseHandle(m_file);
+            m_file = nullptr;
+        }
+
+        m_mapped_size = 0;
+        m_huge = false;
+        m_locked = false;
     }
 }
 
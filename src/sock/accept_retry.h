@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <thread>
+#include "socket_result.h"
+
+namespace sock::detail {
+    // out of fds (EMFILE/ENFILE) or an error that does not go away by itself:
+    // give close() elsewhere a moment before draining again
+    constexpr auto accept_backoff = std::chrono::milliseconds(10);
+
+    // For loops draining an edge triggered listener, after accept_into failed
+    // with r. False when the backlog is empty or the listener is gone, go back
+    // to poll. True keeps draining, giving up early would leave queued
+    // connections waiting for an edge that only comes with the next client.
+    // Errors that only cost the connection being accepted retry right away,
+    // anything else sleeps accept_backoff first so it can not spin hot
+    [[nodiscard]] inline bool accept_retry(const SockResult& r) noexcept {
+        switch (r.code) {
+            case SockErr::WouldBlock:       // fallthrough
+            case SockErr::Closed:           // fallthrough
+            case SockErr::Shutdown:         // fallthrough
+            case SockErr::InvalidHandle:    // fallthrough
+            case SockErr::NotOpen:
+                return false;
+            default:
+                break;
+        }
+
+        if (!is_transient_accept_err(r.sys_error)) std::this_thread::sleep_for(accept_backoff);
+        return true;
+    }
+}
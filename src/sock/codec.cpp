@@ -0,0 +1,552 @@
+#include "sock/codec.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace sock {
+    namespace {
+        constexpr std::uint32_t hello_magic = 0x4D4F4F43; // "MOOC"
+        constexpr std::uint8_t hello_version = 1;
+        constexpr std::uint8_t hello_stateless = 1u << 0;
+
+        constexpr std::size_t min_match = 4;
+        constexpr std::size_t last_literals = 5;    // a block always ends in literals, like lz4
+        constexpr unsigned hash_bits = 14;
+        static_assert((std::size_t{1} << hash_bits) == codec::lz_table_size, "lz table size");
+
+        void put_be32(std::byte* out, std::uint32_t v) noexcept {
+            out[0] = static_cast<std::byte>(v >> 24);
+            out[1] = static_cast<std::byte>(v >> 16);
+            out[2] = static_cast<std::byte>(v >> 8);
+            out[3] = static_cast<std::byte>(v);
+        }
+
+        std::uint32_t get_be32(const std::byte* in) noexcept {
+            return (static_cast<std::uint32_t>(in[0]) << 24)
+                 | (static_cast<std::uint32_t>(in[1]) << 16)
+                 | (static_cast<std::uint32_t>(in[2]) << 8)
+                 | static_cast<std::uint32_t>(in[3]);
+        }
+
+        std::uint32_t read32(const std::byte* p) noexcept {
+            std::uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        std::uint64_t read64(const std::byte* p) noexcept {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        std::uint32_t hash4(std::uint32_t v) noexcept {
+            return (v * 2654435761u) >> (32 - hash_bits);
+        }
+
+        // index of the first differing byte in two words loaded from memory
+        std::size_t first_diff_byte(std::uint64_t diff) noexcept {
+            #if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+                #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                    return static_cast<std::size_t>(__builtin_clzll(diff)) >> 3;
+                #else
+                    return static_cast<std::size_t>(__builtin_ctzll(diff)) >> 3;
+                #endif
+            #elif defined(_MSC_VER) && !defined(__clang__)
+                unsigned long idx = 0;
+                _BitScanForward64(&idx, diff);
+                return static_cast<std::size_t>(idx) >> 3;
+            #else
+                return static_cast<std::size_t>(__builtin_ctzll(diff)) >> 3;
+            #endif
+        }
+
+        // how many bytes at a and b agree, b stops at limit. 8 at a time
+        std::size_t match_length(const std::byte* a, const std::byte* b, const std::byte* limit) noexcept {
+            const std::byte* start = b;
+            while (limit - b >= 8) {
+                const auto diff = read64(a) ^ read64(b);
+                if (diff != 0) return static_cast<std::size_t>(b - start) + first_diff_byte(diff);
+                a += 8;
+                b += 8;
+            }
+            while (b < limit && *a == *b) {
+                ++a;
+                ++b;
+            }
+            return static_cast<std::size_t>(b - start);
+        }
+
+        // 255 run encoding of a 4 bit field overflow
+        std::size_t length_bytes(std::size_t len) noexcept {
+            return len >= 15 ? (len - 15) / 255 + 1 : 0;
+        }
+
+        std::byte* write_length(std::byte* op, std::size_t len) noexcept {
+            len -= 15;
+            while (len >= 255) {
+                *op++ = std::byte{255};
+                len -= 255;
+            }
+            *op++ = static_cast<std::byte>(len);
+            return op;
+        }
+
+        bool read_length(const std::byte* in, std::size_t size, std::size_t& ip, std::size_t& len) noexcept {
+            for (;;) {
+                if (ip >= size) return false;
+                const auto b = static_cast<std::size_t>(in[ip++]);
+                len += b;
+                if (b != 255) return true;
+            }
+        }
+
+        // one sequence: literals [lit, lit + lit_len) then a match, or just
+        // the literals when match_len is 0 (the last sequence)
+        std::byte* emit(std::byte* op, const std::byte* oend, const std::byte* lit, std::size_t lit_len,
+                        std::size_t offset, std::size_t match_len) noexcept {
+            const auto ml = match_len != 0 ? match_len - min_match : 0;
+            const auto need = 1 + length_bytes(lit_len) + lit_len + (match_len != 0 ? 2 + length_bytes(ml) : 0);
+            if (static_cast<std::size_t>(oend - op) < need) return nullptr;
+
+            std::byte* token = op++;
+            auto t = static_cast<unsigned>(std::min<std::size_t>(lit_len, 15)) << 4;
+            if (lit_len >= 15) op = write_length(op, lit_len);
+            std::memcpy(op, lit, lit_len);
+            op += lit_len;
+
+            if (match_len != 0) {
+                *op++ = static_cast<std::byte>(offset);
+                *op++ = static_cast<std::byte>(offset >> 8);
+                t |= static_cast<unsigned>(std::min<std::size_t>(ml, 15));
+                if (ml >= 15) op = write_length(op, ml);
+            }
+            *token = static_cast<std::byte>(t);
+            return op;
+        }
+
+        std::uint32_t fnv1a(const std::byte* data, std::size_t size) noexcept {
+            std::uint32_t h = 2166136261u;
+            for (std::size_t i = 0; i < size; ++i) {
+                h ^= static_cast<std::uint32_t>(data[i]);
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        std::uint32_t window_of(const CodecConfig& cfg) noexcept {
+            return std::min(cfg.window, codec::max_window);
+        }
+    }
+
+    namespace codec {
+        void xor_bytes(const std::byte* a, const std::byte* b, std::byte* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+            #if defined(__AVX2__)
+                for (; i + 32 <= n; i += 32) {
+                    const auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                    const auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_xor_si256(va, vb));
+                }
+            #endif
+            #if defined(__SSE2__) || defined(_M_X64)
+                for (; i + 16 <= n; i += 16) {
+                    const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                    const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(va, vb));
+                }
+            #elif defined(__ARM_NEON) || defined(_M_ARM64)
+                for (; i + 16 <= n; i += 16) {
+                    const auto va = vld1q_u8(reinterpret_cast<const std::uint8_t*>(a + i));
+                    const auto vb = vld1q_u8(reinterpret_cast<const std::uint8_t*>(b + i));
+                    vst1q_u8(reinterpret_cast<std::uint8_t*>(out + i), veorq_u8(va, vb));
+                }
+            #endif
+            for (; i + 8 <= n; i += 8) {
+                const auto v = read64(a + i) ^ read64(b + i);
+                std::memcpy(out + i, &v, sizeof(v));
+            }
+            for (; i < n; ++i) out[i] = a[i] ^ b[i];
+        }
+
+        std::size_t lz_compress(const std::byte* base, std::size_t lo, std::size_t begin, std::size_t end,
+                                std::byte* out, std::size_t cap, std::uint32_t* table,
+                                const std::uint32_t* dict_table) noexcept {
+            std::byte* op = out;
+            const std::byte* oend = out + cap;
+            std::size_t anchor = begin;
+
+            if (end - begin >= min_match + last_literals) {
+                const std::size_t match_limit = end - last_literals;
+                std::size_t ip = begin;
+                std::size_t misses = 0;
+
+                while (ip + min_match <= match_limit) {
+                    const auto seq = read32(base + ip);
+                    const auto h = hash4(seq);
+                    std::size_t cand = table[h];
+                    table[h] = static_cast<std::uint32_t>(ip);
+
+                    if ((cand < lo || cand >= ip || ip - cand > max_window || read32(base + cand) != seq) && dict_table != nullptr) {
+                        cand = dict_table[h];
+                    }
+                    if (cand < lo || cand >= ip || ip - cand > max_window || read32(base + cand) != seq) {
+                        // skip ahead faster through data that does not compress
+                        ip += 1 + (misses++ >> 5);
+                        continue;
+                    }
+                    misses = 0;
+
+                    while (ip > anchor && cand > lo && base[ip - 1] == base[cand - 1]) {
+                        --ip;
+                        --cand;
+                    }
+
+                    const auto len = min_match + match_length(base + cand + min_match, base + ip + min_match, base + match_limit);
+                    op = emit(op, oend, base + anchor, ip - anchor, ip - cand, len);
+                    if (op == nullptr) return 0;
+
+                    ip += len;
+                    anchor = ip;
+                    if (ip - 2 >= begin && ip + 2 <= end) table[hash4(read32(base + ip - 2))] = static_cast<std::uint32_t>(ip - 2);
+                }
+            }
+
+            op = emit(op, oend, base + anchor, end - anchor, 0, 0);
+            if (op == nullptr) return 0;
+            return static_cast<std::size_t>(op - out);
+        }
+
+        void lz_index(const std::byte* base, std::size_t begin, std::size_t end, std::uint32_t* table) noexcept {
+            for (std::size_t i = begin; i + min_match <= end; ++i) {
+                table[hash4(read32(base + i))] = static_cast<std::uint32_t>(i);
+            }
+        }
+
+        bool lz_decompress(const std::byte* in, std::size_t size, std::byte* base, std::size_t lo,
+                           std::size_t begin, std::size_t raw) noexcept {
+            std::size_t ip = 0;
+            std::size_t op = begin;
+            const std::size_t oend = begin + raw;
+
+            for (;;) {
+                if (ip >= size) return false;
+                const auto token = static_cast<unsigned>(in[ip++]);
+
+                std::size_t lit = token >> 4;
+                if (lit == 15 && !read_length(in, size, ip, lit)) return false;
+                if (lit > size - ip || lit > oend - op) return false;
+                std::memcpy(base + op, in + ip, lit);
+                ip += lit;
+                op += lit;
+
+                if (ip == size) return op == oend;  // the last sequence has no match
+
+                if (size - ip < 2) return false;
+                const auto offset = static_cast<std::size_t>(in[ip]) | (static_cast<std::size_t>(in[ip + 1]) << 8);
+                ip += 2;
+                if (offset == 0 || offset > op - lo) return false;
+
+                std::size_t len = token & 15u;
+                if (len == 15 && !read_length(in, size, ip, len)) return false;
+                len += min_match;
+                if (len > oend - op) return false;
+
+                // chunks no longer than the offset never overlap what they copy
+                std::byte* dst = base + op;
+                const std::byte* src = dst - offset;
+                std::size_t left = len;
+                if (offset >= 16) {
+                    for (; left >= 16; left -= 16, dst += 16, src += 16) std::memcpy(dst, src, 16);
+                } else if (offset >= 8) {
+                    for (; left >= 8; left -= 8, dst += 8, src += 8) std::memcpy(dst, src, 8);
+                }
+                for (; left != 0; --left) *dst++ = *src++;
+                op += len;
+            }
+        }
+
+        void write_hello(std::byte* out, const CodecConfig& cfg) noexcept {
+            put_be32(out, hello_magic);
+            out[4] = static_cast<std::byte>(hello_version);
+            out[5] = static_cast<std::byte>(cfg.features);
+            out[6] = static_cast<std::byte>(cfg.stateless ? hello_stateless : 0);
+            out[7] = std::byte{0};
+            put_be32(out + 8, window_of(cfg));
+            put_be32(out + 12, cfg.max_keys);
+            put_be32(out + 16, cfg.dictionary_size != 0 ? fnv1a(cfg.dictionary, cfg.dictionary_size) : 0);
+        }
+
+        bool read_hello(const std::byte* in, std::size_t size, CodecConfig& cfg) noexcept {
+            if (size < hello_size || get_be32(in) != hello_magic || static_cast<std::uint8_t>(in[4]) != hello_version) return false;
+
+            cfg.features &= static_cast<std::uint8_t>(in[5]);
+            if ((static_cast<std::uint8_t>(in[6]) & hello_stateless) != 0) cfg.stateless = true;
+            cfg.window = std::min(window_of(cfg), get_be32(in + 8));
+            cfg.max_keys = std::min(cfg.max_keys, get_be32(in + 12));
+
+            const auto ours = cfg.dictionary_size != 0 ? fnv1a(cfg.dictionary, cfg.dictionary_size) : 0;
+            if (ours != get_be32(in + 16)) {
+                // the preset would decode into garbage, go without compression
+                cfg.features &= static_cast<std::uint8_t>(~feature::Compress);
+                cfg.dictionary = nullptr;
+                cfg.dictionary_size = 0;
+            }
+            return true;
+        }
+
+        std::size_t decoded_size(const std::byte* in, std::size_t size) noexcept {
+            return size < 5 ? 0 : get_be32(in + 1);
+        }
+    }
+
+    namespace detail {
+        void CodecHistory::reset(const CodecConfig& cfg) {
+            m_window = window_of(cfg);
+            m_keep = !cfg.stateless;
+
+            // only the tail of a preset is ever in reach
+            const auto preset = cfg.dictionary != nullptr ? std::min(cfg.dictionary_size, m_window) : 0;
+            m_buf.assign(2 * m_window + 1, std::byte{0});
+            if (preset != 0) std::memcpy(m_buf.data(), cfg.dictionary + cfg.dictionary_size - preset, preset);
+            m_len = preset;
+            m_preset = preset;
+        }
+
+        std::size_t CodecHistory::prepare(std::size_t size) {
+            if (m_buf.size() < m_len + size) m_buf.resize(m_len + size);
+            return m_len;
+        }
+
+        void CodecHistory::commit(std::size_t size, std::uint32_t* table) noexcept {
+            if (!m_keep) return;    // the preset stays, the message is forgotten
+
+            m_len += size;
+            if (m_len <= 2 * m_window) return;
+
+            const auto shift = m_len - m_window;
+            std::memmove(m_buf.data(), m_buf.data() + shift, m_window);
+            m_len = m_window;
+            if (table == nullptr) return;
+            for (std::size_t i = 0; i < codec::lz_table_size; ++i) {
+                table[i] = table[i] > shift ? static_cast<std::uint32_t>(table[i] - shift) : 0;
+            }
+        }
+    }
+
+    CodecEncoder::CodecEncoder(const CodecConfig& cfg) {
+        reset(cfg);
+    }
+
+    void CodecEncoder::reset(const CodecConfig& cfg) {
+        m_cfg = cfg;
+        m_hist.reset(cfg);
+        m_keys.clear();
+        m_preset_table.reset();
+        if ((cfg.features & codec::feature::Compress) != 0) {
+            if (m_table == nullptr) m_table.reset(new std::uint32_t[codec::lz_table_size]);
+            std::fill(m_table.get(), m_table.get() + codec::lz_table_size, 0u);
+
+            // messages overwrite table entries, so a stateless encoder keeps the
+            // presets entries apart where they survive every message
+            if (m_hist.preset() != 0) {
+                auto* table = m_table.get();
+                if (cfg.stateless) {
+                    m_preset_table.reset(new std::uint32_t[codec::lz_table_size]);
+                    std::fill(m_preset_table.get(), m_preset_table.get() + codec::lz_table_size, 0u);
+                    table = m_preset_table.get();
+                }
+                codec::lz_index(m_hist.base(), 0, m_hist.preset(), table);
+            }
+        }
+    }
+
+    std::size_t CodecEncoder::encode(const void* data, std::size_t size, std::byte* out, std::size_t cap, std::uint32_t key) {
+        if (cap < bound(size) || size > UINT32_MAX || (data == nullptr && size != 0)) return 0;
+
+        const auto* in = static_cast<const std::byte*>(data);
+        const std::byte* stage = in;
+        std::uint8_t flags = 0;
+
+        if ((m_cfg.features & codec::feature::Delta) != 0 && !m_cfg.stateless && key != codec::no_key) {
+            auto it = m_keys.find(key);
+            if (it != m_keys.end()) {
+                const auto& prev = it->second;
+                const auto n = std::min(prev.size(), size);
+                m_scratch.resize(size);
+                codec::xor_bytes(prev.data(), in, m_scratch.data(), n);
+                if (size > n) std::memcpy(m_scratch.data() + n, in + n, size - n);
+                stage = m_scratch.data();
+                flags |= codec::flag::Delta;
+            } else if (m_keys.size() < m_cfg.max_keys) {
+                it = m_keys.emplace(key, std::vector<std::byte>{}).first;
+            }
+            if (it != m_keys.end()) {
+                it->second.assign(in, in + size);
+                flags |= codec::flag::Keep;
+            }
+        }
+
+        put_be32(out + 1, static_cast<std::uint32_t>(size));
+        std::size_t head = 5;
+        if ((flags & (codec::flag::Delta | codec::flag::Keep)) != 0) {
+            put_be32(out + 5, key);
+            head = 9;
+        }
+
+        std::size_t body = 0;
+        if ((m_cfg.features & codec::feature::Compress) != 0) {
+            // every message joins the history whether it compresses or not,
+            // the decoder does the same
+            const auto begin = m_hist.prepare(size);
+            if (size != 0) std::memcpy(m_hist.base() + begin, stage, size);
+            if (size != 0 && size >= m_cfg.min_compress) {
+                // only worth it when it comes out smaller, an empty one never does
+                body = codec::lz_compress(m_hist.base(), m_hist.low(begin), begin, begin + size, out + head, size - 1,
+                                            m_table.get(), m_preset_table.get());
+                if (body != 0) flags |= codec::flag::Compress;
+            }
+            m_hist.commit(size, m_table.get());
+        }
+
+        if ((flags & codec::flag::Compress) == 0) {
+            if (size != 0) std::memcpy(out + head, stage, size);
+            body = size;
+        }
+
+        out[0] = static_cast<std::byte>(flags);
+        return head + body;
+    }
+
+    CodecDecoder::CodecDecoder(const CodecConfig& cfg) {
+        reset(cfg);
+    }
+
+    void CodecDecoder::reset(const CodecConfig& cfg) {
+        m_cfg = cfg;
+        m_hist.reset(cfg);
+        m_keys.clear();
+    }
+
+    SockResult CodecDecoder::decode(const std::byte* in, std::size_t size, std::byte* out, std::size_t cap) {
+        const SockResult corrupt{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+        if (size < 5) return corrupt;
+
+        const auto flags = static_cast<std::uint8_t>(in[0]);
+        const bool compress = (m_cfg.features & codec::feature::Compress) != 0;
+        const bool delta = (m_cfg.features & codec::feature::Delta) != 0 && !m_cfg.stateless;
+        if ((flags & ~(codec::flag::Compress | codec::flag::Delta | codec::flag::Keep)) != 0) return corrupt;
+        if ((flags & codec::flag::Compress) != 0 && !compress) return corrupt;
+        if ((flags & (codec::flag::Delta | codec::flag::Keep)) != 0 && !delta) return corrupt;
+
+        const std::size_t raw = get_be32(in + 1);
+        if (raw > cap) return SockResult{ SockErr::SizeTooLarge, SockOp::Recv, 0, 0 };
+
+        std::size_t head = 5;
+        std::uint32_t key = codec::no_key;
+        if ((flags & (codec::flag::Delta | codec::flag::Keep)) != 0) {
+            if (size < 9) return corrupt;
+            key = get_be32(in + 5);
+            head = 9;
+        }
+        const auto* body = in + head;
+        const auto body_size = size - head;
+        if ((flags & codec::flag::Compress) == 0 && body_size != raw) return corrupt;
+
+        const std::vector<std::byte>* prev = nullptr;
+        if ((flags & codec::flag::Delta) != 0) {
+            const auto it = m_keys.find(key);
+            if (it == m_keys.end()) return corrupt;
+            prev = &it->second;
+        }
+
+        const std::byte* stage = body;
+        std::size_t begin = 0;
+        if (compress) {
+            begin = m_hist.prepare(raw);
+            if ((flags & codec::flag::Compress) != 0) {
+                if (!codec::lz_decompress(body, body_size, m_hist.base(), m_hist.low(begin), begin, raw)) return corrupt;
+            } else if (raw != 0) {
+                std::memcpy(m_hist.base() + begin, body, raw);
+            }
+            stage = m_hist.base() + begin;
+        }
+
+        if (prev != nullptr) {
+            const auto n = std::min(prev->size(), raw);
+            codec::xor_bytes(prev->data(), stage, out, n);
+            if (raw > n) std::memcpy(out + n, stage + n, raw - n);
+        } else if (raw != 0) {
+            std::memcpy(out, stage, raw);
+        }
+
+        // stage points into the history, it may move once committed
+        if (compress) m_hist.commit(raw, nullptr);
+
+        if ((flags & codec::flag::Keep) != 0) {
+            auto it = m_keys.find(key);
+            if (it == m_keys.end()) {
+                if (m_keys.size() >= m_cfg.max_keys) return corrupt;
+                it = m_keys.emplace(key, std::vector<std::byte>{}).first;
+            }
+            it->second.assign(out, out + raw);
+        }
+
+        return SockResult{ SockErr::None, SockOp::Recv, 0, static_cast<std::int32_t>(raw) };
+    }
+
+    CodecStream::CodecStream(FramedStream& stream, const CodecConfig& cfg)
+        : m_stream(&stream), m_cfg(cfg), m_enc(cfg), m_dec(cfg) {}
+
+    SockResult CodecStream::negotiate() {
+        std::byte hello[codec::hello_size];
+        codec::write_hello(hello, m_cfg);
+        auto r = m_stream->write_frame(hello, sizeof(hello));
+        if (!r.ok()) return r;
+        r = m_stream->flush();
+        if (!r.ok()) return r;
+
+        Frame f;
+        r = m_stream->read_frame(f);
+        if (!r.ok()) return r;
+        if (!codec::read_hello(f.data(), f.size(), m_cfg)) return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+
+        m_enc.reset(m_cfg);
+        m_dec.reset(m_cfg);
+        return SockResult{ SockErr::None, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult CodecStream::write(const void* data, std::size_t size, std::uint32_t key) {
+        if (size > static_cast<std::size_t>(INT32_MAX)) return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+
+        m_out.resize(CodecEncoder::bound(size));
+        const auto n = m_enc.encode(data, size, m_out.data(), m_out.size(), key);
+        if (n == 0) return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+        return m_stream->write_frame(m_out.data(), n);
+    }
+
+    SockResult CodecStream::read(msg::Span<const std::byte>& out) {
+        Frame f;
+        auto r = m_stream->read_frame(f);
+        if (!r.ok()) return r;
+
+        // a length run byte stands for at most 255 output bytes, anything
+        // claiming more than that is corrupt and must not size the buffer
+        const auto raw = codec::decoded_size(f.data(), f.size());
+        if (raw / 255 > f.size()) return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+        m_in.resize(raw);
+        r = m_dec.decode(f.data(), f.size(), m_in.data(), m_in.size());
+        if (!r.ok()) return r;
+        out = msg::Span<const std::byte>{ m_in.data(), m_in.size() };
+        return r;
+    }
+}
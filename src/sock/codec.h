@@ -0,0 +1,185 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "msg/span.h"
+#include "socket_result.h"
+#include "framing.h"
+
+namespace sock {
+    // wire format of one encoded message, big endian:
+    //   flags (1) | raw size (4) | key (4, only with Delta or Keep) | body
+    // body is the LZ block when Compress is set, the message bytes otherwise.
+    // With Delta the message was XORed against the last one kept for key
+    // before compression, Keep tells the decoder to remember this one.
+    namespace codec {
+        // features a side can offer, the negotiated set is what both offered
+        namespace feature {
+            constexpr std::uint8_t Compress = 1u << 0;  // LZ with the last window bytes sent as dictionary
+            constexpr std::uint8_t Delta    = 1u << 1;  // XOR against the previous message of the same key
+        }
+
+        namespace flag {
+            constexpr std::uint8_t Compress = 1u << 0;
+            constexpr std::uint8_t Delta    = 1u << 1;
+            constexpr std::uint8_t Keep     = 1u << 2;
+        }
+
+        constexpr std::uint32_t no_key = UINT32_MAX;    // never delta encoded
+        constexpr std::size_t header_size = 9;          // largest header
+        constexpr std::size_t hello_size = 20;
+        constexpr std::uint32_t max_window = 65535;     // 16 bit match offsets
+
+        // XOR of a and b into out, all n bytes long (out may alias either).
+        // SSE2/AVX2/NEON when the target has them
+        void xor_bytes(const std::byte* a, const std::byte* b, std::byte* out, std::size_t n) noexcept;
+
+        // LZ4 style block compression of base[begin, end), matches may reach
+        // back to base[lo, begin). table holds lz_table_size positions and
+        // may be reused across calls, stale entries only cost ratio.
+        // dict_table is a second, read only table (lz_index) over a dictionary
+        // in front of begin, checked when tables candidate does not match.
+        // Returns bytes written, 0 when it would not fit in cap
+        constexpr std::size_t lz_table_size = 1u << 14;
+        [[nodiscard]] std::size_t lz_compress(const std::byte* base, std::size_t lo, std::size_t begin, std::size_t end,
+                                              std::byte* out, std::size_t cap, std::uint32_t* table,
+                                              const std::uint32_t* dict_table = nullptr) noexcept;
+        // adds every position of base[begin, end) to table
+        void lz_index(const std::byte* base, std::size_t begin, std::size_t end, std::uint32_t* table) noexcept;
+        // inverse of lz_compress, writes exactly raw bytes at base + begin,
+        // false on any malformed input (never reads or writes out of bounds)
+        [[nodiscard]] bool lz_decompress(const std::byte* in, std::size_t size, std::byte* base, std::size_t lo,
+                                         std::size_t begin, std::size_t raw) noexcept;
+    }
+
+    struct CodecConfig {
+        std::uint8_t features = codec::feature::Compress | codec::feature::Delta;
+        std::uint32_t window = codec::max_window;   // dictionary bytes kept per direction, at most max_window
+        std::uint32_t max_keys = 4096;              // keys remembered for delta, later keys go without
+        std::uint32_t min_compress = 64;            // shorter messages are sent as they are
+        bool stateless = false;                     // every message decodes on its own (datagrams): no history, no delta
+        const std::byte* dictionary = nullptr;      // preset dictionary, same bytes on both sides, must outlive the codec
+        std::size_t dictionary_size = 0;
+    };
+
+    namespace codec {
+        // what this side offers, sent once in each direction before any message
+        void write_hello(std::byte* out, const CodecConfig& cfg) noexcept;
+        // narrows cfg to what both sides support, false when in is not a hello.
+        // A preset dictionary that does not match the peer's turns Compress off
+        [[nodiscard]] bool read_hello(const std::byte* in, std::size_t size, CodecConfig& cfg) noexcept;
+        // raw size of an encoded message, 0 when too short to tell
+        [[nodiscard]] std::size_t decoded_size(const std::byte* in, std::size_t size) noexcept;
+    }
+
+    namespace detail {
+        // dictionary window, both ends append every message so they hold the
+        // same bytes. Trimmed back to window once twice that has piled up
+        class CodecHistory {
+            private:
+                std::vector<std::byte> m_buf{};
+                std::size_t m_len = 0;
+                std::size_t m_preset = 0;
+                std::size_t m_window = 0;
+                bool m_keep = true;
+
+            public:
+                void reset(const CodecConfig& cfg);
+
+                // room for size bytes after the history, returns where they go
+                [[nodiscard]] std::size_t prepare(std::size_t size);
+                // the prepared bytes join the history (or are forgotten when
+                // stateless), table positions are rebased when it trims
+                void commit(std::size_t size, std::uint32_t* table) noexcept;
+
+                [[nodiscard]] std::byte* base() noexcept { return m_buf.data(); }
+                [[nodiscard]] std::size_t preset() const noexcept { return m_preset; }
+                // oldest byte a match starting at begin may use
+                [[nodiscard]] std::size_t low(std::size_t begin) const noexcept { return begin > m_window ? begin - m_window : 0; }
+        };
+    }
+
+    // Compresses and delta encodes one direction of a connection. Messages
+    // must be decoded in the order they were encoded, by a CodecDecoder made
+    // from the same negotiated config, so the stateful features need an
+    // ordered lossless transport (tcp, the reliable multicast feed). For
+    // plain datagrams set stateless, then only a preset dictionary is shared.
+    // Delta only pays for similar messages under the same key and only
+    // together with Compress, the XOR turns unchanged bytes into zero runs.
+    // NOTE: not thread safe, one encoder per sending side
+    class CodecEncoder {
+        private:
+            CodecConfig m_cfg{};
+            detail::CodecHistory m_hist{};
+            std::unique_ptr<std::uint32_t[]> m_table{};
+            std::unique_ptr<std::uint32_t[]> m_preset_table{};  // stateless only, the preset indexed once
+            std::unordered_map<std::uint32_t, std::vector<std::byte>> m_keys{};
+            std::vector<std::byte> m_scratch{};
+
+        public:
+            explicit CodecEncoder(const CodecConfig& cfg = CodecConfig{});
+
+            // drops all state, both ends must reset together
+            void reset(const CodecConfig& cfg);
+
+            // out needs this much room for a size byte message
+            [[nodiscard]] static constexpr std::size_t bound(std::size_t size) noexcept { return codec::header_size + size; }
+
+            // encodes one message into out, bytes written or 0 when cap < bound(size)
+            [[nodiscard]] std::size_t encode(const void* data, std::size_t size, std::byte* out, std::size_t cap, std::uint32_t key = codec::no_key);
+
+            [[nodiscard]] const CodecConfig& config() const noexcept { return m_cfg; }
+    };
+
+    // NOTE: after an error the decoder is out of step with its encoder, the
+    // connection has to start over
+    class CodecDecoder {
+        private:
+            CodecConfig m_cfg{};
+            detail::CodecHistory m_hist{};
+            std::unordered_map<std::uint32_t, std::vector<std::byte>> m_keys{};
+
+        public:
+            explicit CodecDecoder(const CodecConfig& cfg = CodecConfig{});
+
+            void reset(const CodecConfig& cfg);
+
+            // decodes one message into out, bytes = its size. SizeTooLarge when
+            // cap < decoded_size(), InvalidArgument when the input is corrupt
+            [[nodiscard]] SockResult decode(const std::byte* in, std::size_t size, std::byte* out, std::size_t cap);
+
+            [[nodiscard]] const CodecConfig& config() const noexcept { return m_cfg; }
+    };
+
+    // Codec stage on top of a FramedStream, one encoded message per frame.
+    // negotiate() right after connecting exchanges hellos so both ends agree
+    // on the features, then write()/read() work with plain messages.
+    // NOTE: same threading rules as FramedStream, one reader and one writer
+    class CodecStream {
+        private:
+            FramedStream* m_stream = nullptr;
+            CodecConfig m_cfg{};
+            CodecEncoder m_enc;
+            CodecDecoder m_dec;
+            std::vector<std::byte> m_out{};
+            std::vector<std::byte> m_in{};
+
+        public:
+            CodecStream(FramedStream& stream, const CodecConfig& cfg = CodecConfig{});
+
+            // sends our hello and waits for the peers, both sides call it first
+            [[nodiscard]] SockResult negotiate();
+
+            // encodes and queues one message, flush() sends it. bytes = bytes queued
+            [[nodiscard]] SockResult write(const void* data, std::size_t size, std::uint32_t key = codec::no_key);
+            [[nodiscard]] SockResult flush() { return m_stream->flush(); }
+
+            // next message, out stays valid until the next read. bytes = its size
+            [[nodiscard]] SockResult read(msg::Span<const std::byte>& out);
+
+            // negotiated set
+            [[nodiscard]] std::uint8_t features() const noexcept { return m_cfg.features; }
+    };
+}
@@ -0,0 +1,273 @@
+#include "sock/framing.h"
+#include <cstring>
+#include <new>
+
+namespace sock {
+    namespace {
+        void put_be32(std::byte* out, std::uint32_t v) noexcept {
+            out[0] = static_cast<std::byte>(v >> 24);
+            out[1] = static_cast<std::byte>(v >> 16);
+            out[2] = static_cast<std::byte>(v >> 8);
+            out[3] = static_cast<std::byte>(v);
+        }
+
+        std::uint32_t get_be32(const std::byte* in) noexcept {
+            return (static_cast<std::uint32_t>(in[0]) << 24)
+                 | (static_cast<std::uint32_t>(in[1]) << 16)
+                 | (static_cast<std::uint32_t>(in[2]) << 8)
+                 | static_cast<std::uint32_t>(in[3]);
+        }
+    }
+
+    namespace detail {
+        SegmentPool::SegmentPool(std::uint32_t segment_size, std::uint32_t count) : m_free(count) {
+            if (segment_size == 0 || !m_free.is_valid()) return;
+
+            const auto bytes = static_cast<std::size_t>(segment_size) * count;
+            std::unique_ptr<std::byte[]> memory(new (std::nothrow) std::byte[bytes]);
+            std::unique_ptr<std::atomic<std::uint32_t>[]> refs(new (std::nothrow) std::atomic<std::uint32_t>[count]);
+            if (memory == nullptr || refs == nullptr) return;
+
+            m_free_push = m_free.make_producer();
+            m_free_pop = m_free.make_consumer();
+            for (std::uint32_t i = 0; i < count; ++i) {
+                refs[i].store(0, std::memory_order_relaxed);
+                (void)m_free_push->push(i);
+            }
+
+            m_refs = std::move(refs);
+            m_memory = std::move(memory);
+            m_segment_size = segment_size;
+            m_count = count;
+        }
+
+        bool SegmentPool::acquire(std::uint32_t& index) noexcept {
+            if (!m_free_pop->try_pop(index)) return false;
+            m_refs[index].store(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void SegmentPool::retain(std::uint32_t index) noexcept {
+            m_refs[index].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void SegmentPool::release(std::uint32_t index) noexcept {
+            // acq_rel so the last releaser sees every other holders reads finished
+            if (m_refs[index].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                (void)m_free_push->push(index); // cant fail, the queue holds every index
+            }
+        }
+
+        std::uint32_t SegmentPool::ref_count(std::uint32_t index) const noexcept {
+            return m_refs[index].load(std::memory_order_acquire);
+        }
+    }
+
+    FramedStream::FramedStream(TCPClient& client, const FramedConfig& cfg)
+        : m_client(&client), m_pool(cfg.segment_size, cfg.segment_count) {
+        if (cfg.segment_size <= header_size) return;
+
+        const auto limit = cfg.segment_size - header_size;
+        m_max_frame = (cfg.max_frame == 0 || cfg.max_frame > limit) ? limit : cfg.max_frame;
+
+        m_out_cap = cfg.coalesce_bytes < header_size ? header_size : cfg.coalesce_bytes;
+        m_out.reset(new (std::nothrow) std::byte[m_out_cap]);
+    }
+
+    FramedStream::~FramedStream() {
+        if (m_segment != no_segment) {
+            m_pool.release(m_segment);
+        }
+    }
+
+    SockErr FramedStream::try_extract(Frame& out) noexcept {
+        if (m_segment == no_segment) return SockErr::WouldBlock;
+
+        const auto avail = m_write_off - m_read_off;
+        if (avail < header_size) return SockErr::WouldBlock;
+
+        std::byte* base = m_pool.data(m_segment) + m_read_off;
+        const auto len = get_be32(base);
+        if (len > m_max_frame) return SockErr::SizeTooLarge;
+        if (avail - header_size < len) return SockErr::WouldBlock;
+
+        m_pool.retain(m_segment);
+        out.release();
+        out.m_pool = &m_pool;
+        out.m_segment = m_segment;
+        out.m_data = base + header_size;
+        out.m_size = len;
+
+        m_read_off += header_size + len;
+        return SockErr::None;
+    }
+
+    // makes sure the partial frame at m_read_off can be completed in the
+    // current segment, moving it to the front or to a fresh segment if not
+    SockErr FramedStream::make_room() noexcept {
+        const auto size = m_pool.segment_size();
+
+        if (m_segment == no_segment) {
+            if (!m_pool.acquire(m_segment)) {
+                m_segment = no_segment;
+                return SockErr::ResourceExhausted;
+            }
+            m_read_off = 0;
+            m_write_off = 0;
+            return SockErr::None;
+        }
+
+        const auto avail = m_write_off - m_read_off;
+        if (avail == 0 && m_pool.ref_count(m_segment) == 1) {
+            m_read_off = 0; // fully consumed and unpinned, reuse from the start
+            m_write_off = 0;
+            return SockErr::None;
+        }
+
+        std::uint32_t need = header_size;
+        if (avail >= header_size) {
+            need += get_be32(m_pool.data(m_segment) + m_read_off);
+        }
+
+        if (m_write_off < size && size - m_read_off >= need) {
+            return SockErr::None; // still room to read the rest in place
+        }
+
+        // no frames point into this segment, slide the tail to the front
+        if (m_pool.ref_count(m_segment) == 1) {
+            std::byte* base = m_pool.data(m_segment);
+            if (avail != 0) std::memmove(base, base + m_read_off, avail);
+            m_read_off = 0;
+            m_write_off = avail;
+            return SockErr::None;
+        }
+
+        std::uint32_t next = 0;
+        if (!m_pool.acquire(next)) return SockErr::ResourceExhausted;
+
+        if (avail != 0) std::memcpy(m_pool.data(next), m_pool.data(m_segment) + m_read_off, avail);
+        m_pool.release(m_segment);
+        m_segment = next;
+        m_read_off = 0;
+        m_write_off = avail;
+        return SockErr::None;
+    }
+
+    SockResult FramedStream::fill() {
+        const auto room = make_room();
+        if (room != SockErr::None) {
+            return SockResult{ room, SockOp::Recv, 0, 0 };
+        }
+
+        const auto r = m_client->recv(m_pool.data(m_segment) + m_write_off, m_pool.segment_size() - m_write_off);
+        if (r.ok()) {
+            m_write_off += static_cast<std::uint32_t>(r.bytes);
+        }
+        return r;
+    }
+
+    SockResult FramedStream::read_frame(Frame& out) {
+        if (!is_valid()) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+        }
+
+        while (true) {
+            const auto err = try_extract(out);
+            if (err == SockErr::None) {
+                return SockResult{ SockErr::None, SockOp::Recv, 0, static_cast<int>(out.size()) };
+            }
+
+            if (err != SockErr::WouldBlock) {
+                return SockResult{ err, SockOp::Recv, 0, 0 };
+            }
+
+            const auto r = fill();
+            if (!r.ok()) return r;
+        }
+    }
+
+    SockResult FramedStream::read_frames(Frame* out, std::size_t max) {
+        if (!is_valid()) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+        }
+
+        if (out == nullptr || max == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Recv, 0, 0 };
+        }
+
+        std::size_t count = 0;
+        bool filled = false;
+        while (count < max) {
+            const auto err = try_extract(out[count]);
+            if (err == SockErr::None) {
+                ++count;
+                continue;
+            }
+
+            if (err != SockErr::WouldBlock) {
+                if (count != 0) break; // hand back what we have, the error repeats next call
+                return SockResult{ err, SockOp::Recv, 0, 0 };
+            }
+
+            if (count != 0 || filled) break;
+
+            const auto r = fill();
+            if (!r.ok()) return r;
+            filled = true;
+        }
+
+        return SockResult{ SockErr::None, SockOp::Recv, 0, static_cast<int>(count) };
+    }
+
+    SockResult FramedStream::write_frame(const void* head, const std::size_t head_size, const void* data, const std::size_t size) {
+        if (!is_valid()) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+        }
+
+        if ((data == nullptr && size != 0) || (head == nullptr && head_size != 0)) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+        }
+
+        if (size > static_cast<std::size_t>(INT32_MAX) - header_size || head_size > static_cast<std::size_t>(INT32_MAX) - header_size - size) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+        }
+
+        const auto payload = static_cast<std::uint32_t>(head_size + size);
+        const auto frame_len = payload + header_size;
+        if (m_out_len + frame_len > m_out_cap && m_out_len != 0) {
+            const auto r = flush();
+            if (!r.ok()) return r;
+        }
+
+        if (frame_len > m_out_cap) {
+            std::byte header[header_size];
+            put_be32(header, payload);
+            if (head_size == 0) return m_client->send_all_v({ IoVec{ header, header_size }, IoVec{ data, size } });
+            return m_client->send_all_v({ IoVec{ header, header_size }, IoVec{ head, head_size }, IoVec{ data, size } });
+        }
+
+        auto* out = m_out.get() + m_out_len;
+        put_be32(out, payload);
+        if (head_size != 0) std::memcpy(out + header_size, head, head_size);
+        if (size != 0) std::memcpy(out + header_size + head_size, data, size);
+        m_out_len += frame_len;
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(frame_len) };
+    }
+
+    SockResult FramedStream::flush() {
+        if (m_out_len == 0) {
+            return SockResult{ SockErr::None, SockOp::Send, 0, 0 };
+        }
+
+        const auto r = m_client->send_all(m_out.get(), m_out_len);
+        const auto sent = static_cast<std::uint32_t>(r.bytes);
+        if (sent >= m_out_len) {
+            m_out_len = 0;
+        } else if (sent != 0) {
+            // keep the unsent tail (WouldBlock on a non-blocking socket)
+            std::memmove(m_out.get(), m_out.get() + sent, m_out_len - sent);
+            m_out_len -= sent;
+        }
+        return r;
+    }
+}
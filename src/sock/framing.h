@@ -0,0 +1,184 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include "msg/mpmc_queue.h"
+#include "msg/span.h"
+#include "socket_result.h"
+#include "tcp_socket.h"
+
+namespace sock {
+    struct FramedConfig {
+        std::uint32_t segment_size = 64 * 1024;  // recv chunk, every frame must fit in one
+        std::uint32_t segment_count = 64;        // pool size, power of 2
+        std::uint32_t max_frame = 0;             // largest payload accepted, 0 = segment_size - header
+        std::uint32_t coalesce_bytes = 16 * 1024; // outbound frames smaller than this are batched
+    };
+
+    namespace detail {
+        // fixed pool of receive segments, frames pin the segment they point
+        // into and the last one out puts it back on the free list
+        class SegmentPool {
+            private:
+                using IndexQueue = msg::DynMPMCQueue<std::uint32_t>;
+
+                std::unique_ptr<std::byte[]> m_memory{};
+                std::unique_ptr<std::atomic<std::uint32_t>[]> m_refs{};
+                IndexQueue m_free;
+                std::optional<IndexQueue::Producer> m_free_push{};
+                std::optional<IndexQueue::Consumer> m_free_pop{};
+                std::uint32_t m_segment_size = 0;
+                std::uint32_t m_count = 0;
+
+            public:
+                SegmentPool(std::uint32_t segment_size, std::uint32_t count);
+                ~SegmentPool() = default;
+
+                SegmentPool(const SegmentPool&) = delete;
+                SegmentPool& operator=(const SegmentPool&) = delete;
+                SegmentPool(SegmentPool&&) = delete;
+                SegmentPool& operator=(SegmentPool&&) = delete;
+
+                [[nodiscard]] bool is_valid() const noexcept { return m_memory != nullptr; }
+                [[nodiscard]] std::uint32_t segment_size() const noexcept { return m_segment_size; }
+
+                [[nodiscard]] bool acquire(std::uint32_t& index) noexcept;
+                void retain(std::uint32_t index) noexcept;
+                void release(std::uint32_t index) noexcept;
+                [[nodiscard]] std::uint32_t ref_count(std::uint32_t index) const noexcept;
+
+                std::byte* data(std::uint32_t index) noexcept {
+                    return m_memory.get() + static_cast<std::size_t>(index) * m_segment_size;
+                }
+        };
+    }
+
+    // One received message, payload points straight into a pooled receive
+    // segment (no copy). The segment goes back to the pool once every frame
+    // in it is released or destroyed, so holding frames for long stalls reads.
+    // NOTE: frames must not outlive the FramedStream that produced them
+    class Frame {
+        private:
+            detail::SegmentPool* m_pool = nullptr;
+            std::uint32_t m_segment = 0;
+            const std::byte* m_data = nullptr;
+            std::uint32_t m_size = 0;
+
+            friend class FramedStream;
+
+        public:
+            Frame() = default;
+            ~Frame() { release(); }
+
+            Frame(const Frame&) = delete;
+            Frame& operator=(const Frame&) = delete;
+
+            Frame(Frame&& other) noexcept
+                : m_pool(other.m_pool), m_segment(other.m_segment), m_data(other.m_data), m_size(other.m_size) {
+                other.m_pool = nullptr;
+                other.m_data = nullptr;
+                other.m_size = 0;
+            }
+
+            Frame& operator=(Frame&& other) noexcept {
+                if (this != &other) {
+                    release();
+                    m_pool = other.m_pool;
+                    m_segment = other.m_segment;
+                    m_data = other.m_data;
+                    m_size = other.m_size;
+                    other.m_pool = nullptr;
+                    other.m_data = nullptr;
+                    other.m_size = 0;
+                }
+                return *this;
+            }
+
+            void release() noexcept {
+                if (m_pool != nullptr) {
+                    m_pool->release(m_segment);
+                    m_pool = nullptr;
+                }
+                m_data = nullptr;
+                m_size = 0;
+            }
+
+            [[nodiscard]] bool empty() const noexcept { return m_pool == nullptr; }
+            [[nodiscard]] const std::byte* data() const noexcept { return m_data; }
+            [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+            [[nodiscard]] msg::Span<const std::byte> payload() const noexcept { return msg::Span<const std::byte>{ m_data, m_size }; }
+    };
+
+    // Length prefixed framing over a connected TCPClient. Each frame on the
+    // wire is a 4 byte big endian payload length followed by the payload.
+    // Reads pull as much as the socket has into a pooled segment with one
+    // recv and hand back every whole frame in it zero copy. Writes copy small
+    // frames into a coalescing buffer that flush() sends in one syscall,
+    // frames at least coalesce_bytes long go out directly with one gather send.
+    // NOTE: one reader thread and one writer thread at most
+    // NOTE: write side expects a blocking socket, on a non-blocking one a
+    // WouldBlock from a direct (large) frame leaves it partially written
+    class FramedStream {
+        public:
+            static constexpr std::uint32_t header_size = 4;
+
+        private:
+            static constexpr std::uint32_t no_segment = UINT32_MAX;
+
+            TCPClient* m_client = nullptr;
+            detail::SegmentPool m_pool;
+            std::uint32_t m_max_frame = 0;
+
+            // reader only
+            std::uint32_t m_segment = no_segment; // the stream holds one ref on it
+            std::uint32_t m_read_off = 0;
+            std::uint32_t m_write_off = 0;
+
+            // writer only
+            std::unique_ptr<std::byte[]> m_out{};
+            std::uint32_t m_out_cap = 0;
+            std::uint32_t m_out_len = 0;
+
+            [[nodiscard]] SockErr try_extract(Frame& out) noexcept;
+            [[nodiscard]] SockErr make_room() noexcept;
+            [[nodiscard]] SockResult fill();
+
+        public:
+            FramedStream(TCPClient& client, const FramedConfig& cfg = FramedConfig{});
+            ~FramedStream();
+
+            FramedStream(const FramedStream&) = delete;
+            FramedStream& operator=(const FramedStream&) = delete;
+            FramedStream(FramedStream&&) = delete;
+            FramedStream& operator=(FramedStream&&) = delete;
+
+            // false when the config was bad or allocation failed
+            [[nodiscard]] bool is_valid() const noexcept { return m_pool.is_valid() && m_out != nullptr; }
+            [[nodiscard]] std::uint32_t max_frame() const noexcept { return m_max_frame; }
+
+            // next whole frame, recvs only when nothing is buffered (blocks on a
+            // blocking socket, WouldBlock on a non-blocking one). bytes = payload size.
+            // SizeTooLarge means the peer sent a frame over max_frame, the stream
+            // cant resync after that so close the connection.
+            // ResourceExhausted means every segment is pinned by held frames
+            [[nodiscard]] SockResult read_frame(Frame& out);
+
+            // fills out with every frame already buffered, doing at most one recv
+            // if there were none. bytes = frames written to out
+            [[nodiscard]] SockResult read_frames(Frame* out, std::size_t max);
+
+            // queues a frame, sending pending frames first when it would not fit
+            [[nodiscard]] SockResult write_frame(const void* data, const std::size_t size) {
+                return write_frame(nullptr, 0, data, size);
+            }
+            // same, the frame payload is head followed by data, so a protocol
+            // header does not have to be copied in front of the body first
+            [[nodiscard]] SockResult write_frame(const void* head, const std::size_t head_size, const void* data, const std::size_t size);
+
+            // sends everything queued by write_frame, bytes = bytes sent
+            [[nodiscard]] SockResult flush();
+            [[nodiscard]] std::size_t pending_write_bytes() const noexcept { return m_out_len; }
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "socket_result.h"
+#include "socket_handle.h"
+
+namespace sock {
+    struct IoRingConfig {
+        std::uint32_t entries = 256;         // submission queue size, kernel rounds up to a power of 2
+        std::uint32_t fixed_buffers = 0;     // registered buffers for queue_*_fixed()
+        std::uint32_t recv_buffers = 0;      // kernel picked buffers for queue_recv_multishot()
+        std::uint32_t buffer_size = 2048;    // size of each fixed/recv buffer
+    };
+
+    struct IoCompletion {
+        std::uint64_t user_data = 0;
+        std::int32_t res = 0;     // bytes on success, -errno on failure
+        std::uint32_t flags = 0;  // raw cqe flags
+
+        [[nodiscard]] bool has_buffer() const noexcept { return (flags & 1u) != 0; }           // IORING_CQE_F_BUFFER
+        [[nodiscard]] std::uint16_t buffer_id() const noexcept { return static_cast<std::uint16_t>(flags >> 16); }
+        [[nodiscard]] bool more() const noexcept { return (flags & 2u) != 0; }                 // IORING_CQE_F_MORE, multishot still armed
+
+        [[nodiscard]] SockResult to_result(SockOp op) const noexcept {
+            if (res > 0) return SockResult{ SockErr::None, op, 0, res };
+            if (res == 0) return SockResult{ op == SockOp::Recv ? SockErr::Closed : SockErr::None, op, 0, 0 };
+            return SockResult{ map_err(-res), op, -res, 0 };
+        }
+    };
+
+    // Batched async socket I/O over io_uring (linux only). Queue any number of
+    // sends/recvs with the queue_* calls (no syscall), push them all to the
+    // kernel with one submit(), then reap() completions straight out of the
+    // shared ring. Multishot recv keeps one recv armed per socket that
+    // completes once per message into kernel picked buffers, hand each one
+    // back with recycle_buffer() when done with it.
+    // NOTE: open() fails with NotInitialized when io_uring is missing or
+    // disabled (and always on windows), keep using the blocking calls then.
+    // NOTE: not thread safe, one ring per thread
+    class IoRing {
+        private:
+            #if defined(MOO_LINUX)
+                int m_fd = -1;
+
+                void* m_sq_ring = nullptr;
+                std::size_t m_sq_ring_size = 0;
+                void* m_cq_ring = nullptr;
+                std::size_t m_cq_ring_size = 0;
+                void* m_sqes = nullptr;
+                std::size_t m_sqes_size = 0;
+
+                unsigned* m_sq_head = nullptr;
+                unsigned* m_sq_tail = nullptr;
+                unsigned m_sq_mask = 0;
+                unsigned m_sq_entries = 0;
+                unsigned m_sq_pending_tail = 0; // queued locally, published on submit()
+
+                unsigned* m_cq_head = nullptr;
+                unsigned* m_cq_tail = nullptr;
+                unsigned m_cq_mask = 0;
+                void* m_cqes = nullptr;
+
+                std::byte* m_fixed_mem = nullptr;
+                std::uint32_t m_fixed_count = 0;
+                std::byte* m_recv_mem = nullptr;
+                std::uint32_t m_recv_count = 0;
+                std::uint32_t m_buffer_size = 0;
+
+                void* next_sqe() noexcept;
+                SockResult queue_provide(std::uint16_t first, std::uint32_t count) noexcept;
+            #endif
+            std::uint64_t m_provide_errors = 0;
+            std::int32_t m_provide_error = 0;
+            bool m_open = false;
+
+        public:
+            IoRing() = default;
+            ~IoRing();
+
+            IoRing(const IoRing&) = delete;
+            IoRing& operator=(const IoRing&) = delete;
+            IoRing(IoRing&&) = delete;
+            IoRing& operator=(IoRing&&) = delete;
+
+            // NOTE: fixed buffers need RLIMIT_MEMLOCK headroom, if registering them
+            // fails the ring still opens and fixed_buffer_count() reports 0
+            [[nodiscard]] SockResult open(const IoRingConfig& cfg = IoRingConfig{});
+            void close() noexcept;
+
+            [[nodiscard]] std::byte* fixed_buffer(std::uint16_t index) noexcept;
+            [[nodiscard]] std::byte* recv_buffer(std::uint16_t id) noexcept;
+            [[nodiscard]] std::uint32_t fixed_buffer_count() const noexcept;
+            [[nodiscard]] std::uint32_t recv_buffer_count() const noexcept;
+            [[nodiscard]] std::uint32_t buffer_size() const noexcept;
+
+            // these only fill submission entries, ResourceExhausted means the
+            // submission queue is full and needs a submit() first
+            [[nodiscard]] SockResult queue_send(socket_handle handle, const void* data, std::size_t size, std::uint64_t user_data) noexcept;
+            [[nodiscard]] SockResult queue_recv(socket_handle handle, void* data, std::size_t size, std::uint64_t user_data) noexcept;
+            [[nodiscard]] SockResult queue_send_fixed(socket_handle handle, std::uint16_t index, std::size_t size, std::uint64_t user_data) noexcept;
+            [[nodiscard]] SockResult queue_recv_fixed(socket_handle handle, std::uint16_t index, std::size_t size, std::uint64_t user_data) noexcept;
+            [[nodiscard]] SockResult queue_recv_multishot(socket_handle handle, std::uint64_t user_data) noexcept;
+            [[nodiscard]] SockResult recycle_buffer(std::uint16_t id) noexcept;
+
+            // hands everything queued to the kernel in one syscall, optionally
+            // blocking until wait_for completions are ready. bytes = entries submitted
+            [[nodiscard]] SockResult submit(std::uint32_t wait_for = 0) noexcept;
+
+            // copies up to max ready completions out of the ring, no syscall
+            [[nodiscard]] std::size_t reap(IoCompletion* out, std::size_t max) noexcept;
+
+            // shared implementation
+            [[nodiscard]] bool is_open() const noexcept { return m_open; }
+            // buffers the kernel refused to take back (open() or recycle_buffer()),
+            // reaped silently. While this grows the recv buffers run out and
+            // multishot recvs end with ResourceExhausted (ENOBUFS)
+            [[nodiscard]] std::uint64_t provide_errors() const noexcept { return m_provide_errors; }
+            // errno of the last one, 0 if none
+            [[nodiscard]] std::int32_t last_provide_error() const noexcept { return m_provide_error; }
+    };
+}
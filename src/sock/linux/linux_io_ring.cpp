@@ -0,0 +1,361 @@
+#if defined(MOO_LINUX)
+#include "sock/io_ring.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <vector>
+
+namespace sock {
+    // reserved user_data for our own provide-buffer entries, reap() drops them
+    static constexpr std::uint64_t internal_token = ~std::uint64_t{0};
+    static constexpr std::uint16_t recv_group = 0;
+
+    static int ring_setup(unsigned entries, io_uring_params* params) noexcept {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int ring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    static int ring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) noexcept {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+    }
+
+    template <typename T>
+    static T* at_offset(void* base, std::uint32_t offset) noexcept {
+        return static_cast<T*>(static_cast<void*>(static_cast<std::byte*>(base) + offset));
+    }
+
+    static void* map_buffers(std::uint32_t count, std::uint32_t size) noexcept {
+        if (count == 0) return nullptr;
+        void* mem = ::mmap(nullptr, static_cast<std::size_t>(count) * size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return mem == MAP_FAILED ? nullptr : mem;
+    }
+
+    IoRing::~IoRing() {
+        close();
+    }
+
+    SockResult IoRing::open(const IoRingConfig& cfg) {
+        if (m_open) return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+        if (cfg.entries == 0 || cfg.buffer_size == 0) return SockResult{ SockErr::InvalidArgument, SockOp::Open, 0, 0 };
+        if (cfg.fixed_buffers > 0xFFFF || cfg.recv_buffers > 0xFFFF) return SockResult{ SockErr::SizeTooLarge, SockOp::Open, 0, 0 };
+
+        io_uring_params params{};
+        m_fd = ring_setup(cfg.entries, &params);
+        if (m_fd < 0) {
+            const int err = errno;
+            m_fd = -1;
+            // ENOSYS: kernel too old, EPERM: disabled by sysctl/seccomp
+            const auto code = (err == ENOSYS || err == EPERM) ? SockErr::NotInitialized : map_err(err);
+            return SockResult{ code, SockOp::Open, err, 0 };
+        }
+
+        m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap && m_cq_ring_size > m_sq_ring_size) m_sq_ring_size = m_cq_ring_size;
+
+        void* sq = ::mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        if (sq == MAP_FAILED) {
+            const int err = errno;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+        m_sq_ring = sq;
+
+        if (single_mmap) {
+            m_cq_ring = m_sq_ring;
+        } else {
+            void* cq = ::mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+            if (cq == MAP_FAILED) {
+                const int err = errno;
+                close();
+                return SockResult{ map_err(err), SockOp::Open, err, 0 };
+            }
+            m_cq_ring = cq;
+        }
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            const int err = errno;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+        m_sqes = sqes;
+
+        m_sq_head = at_offset<unsigned>(m_sq_ring, params.sq_off.head);
+        m_sq_tail = at_offset<unsigned>(m_sq_ring, params.sq_off.tail);
+        m_sq_mask = *at_offset<unsigned>(m_sq_ring, params.sq_off.ring_mask);
+        m_sq_entries = params.sq_entries;
+        m_sq_pending_tail = *m_sq_tail;
+
+        // sqe slots map 1:1 onto the index array so it only needs filling once
+        auto* array = at_offset<unsigned>(m_sq_ring, params.sq_off.array);
+        for (unsigned i = 0; i < m_sq_entries; ++i) array[i] = i;
+
+        m_cq_head = at_offset<unsigned>(m_cq_ring, params.cq_off.head);
+        m_cq_tail = at_offset<unsigned>(m_cq_ring, params.cq_off.tail);
+        m_cq_mask = *at_offset<unsigned>(m_cq_ring, params.cq_off.ring_mask);
+        m_cqes = at_offset<void>(m_cq_ring, params.cq_off.cqes);
+
+        m_buffer_size = cfg.buffer_size;
+        m_open = true;
+
+        // registered buffers skip the per io page pinning, optional
+        if (cfg.fixed_buffers != 0) {
+            m_fixed_mem = static_cast<std::byte*>(map_buffers(cfg.fixed_buffers, cfg.buffer_size));
+            if (m_fixed_mem != nullptr) {
+                std::vector<iovec> iovs(cfg.fixed_buffers);
+                for (std::uint32_t i = 0; i < cfg.fixed_buffers; ++i) {
+                    iovs[i].iov_base = m_fixed_mem + static_cast<std::size_t>(i) * cfg.buffer_size;
+                    iovs[i].iov_len = cfg.buffer_size;
+                }
+
+                if (ring_register(m_fd, IORING_REGISTER_BUFFERS, iovs.data(), cfg.fixed_buffers) == 0) {
+                    m_fixed_count = cfg.fixed_buffers;
+                } else {
+                    ::munmap(m_fixed_mem, static_cast<std::size_t>(cfg.fixed_buffers) * cfg.buffer_size);
+                    m_fixed_mem = nullptr;
+                }
+            }
+        }
+
+        // provided buffers for multishot recv, handed to the kernel with the first submit
+        if (cfg.recv_buffers != 0) {
+            m_recv_mem = static_cast<std::byte*>(map_buffers(cfg.recv_buffers, cfg.buffer_size));
+            if (m_recv_mem == nullptr) {
+                const int err = errno;
+                close();
+                return SockResult{ map_err(err), SockOp::Open, err, 0 };
+            }
+            m_recv_count = cfg.recv_buffers;
+
+            const auto provided = queue_provide(0, m_recv_count);
+            if (!provided.ok()) {
+                close();
+                return SockResult{ provided.code, SockOp::Open, provided.sys_error, 0 };
+            }
+        }
+
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void IoRing::close() noexcept {
+        if (m_fixed_mem != nullptr) ::munmap(m_fixed_mem, static_cast<std::size_t>(m_fixed_count) * m_buffer_size);
+        if (m_recv_mem != nullptr) ::munmap(m_recv_mem, static_cast<std::size_t>(m_recv_count) * m_buffer_size);
+        if (m_sqes != nullptr) ::munmap(m_sqes, m_sqes_size);
+        if (m_cq_ring != nullptr && m_cq_ring != m_sq_ring) ::munmap(m_cq_ring, m_cq_ring_size);
+        if (m_sq_ring != nullptr) ::munmap(m_sq_ring, m_sq_ring_size);
+        if (m_fd >= 0) ::close(m_fd);
+
+        m_fd = -1;
+        m_sq_ring = m_cq_ring = m_sqes = m_cqes = nullptr;
+        m_sq_head = m_sq_tail = m_cq_head = m_cq_tail = nullptr;
+        m_fixed_mem = m_recv_mem = nullptr;
+        m_fixed_count = m_recv_count = 0;
+        m_provide_errors = 0;
+        m_provide_error = 0;
+        m_open = false;
+    }
+
+    std::byte* IoRing::fixed_buffer(std::uint16_t index) noexcept {
+        if (index >= m_fixed_count) return nullptr;
+        return m_fixed_mem + static_cast<std::size_t>(index) * m_buffer_size;
+    }
+
+    std::byte* IoRing::recv_buffer(std::uint16_t id) noexcept {
+        if (id >= m_recv_count) return nullptr;
+        return m_recv_mem + static_cast<std::size_t>(id) * m_buffer_size;
+    }
+
+    std::uint32_t IoRing::fixed_buffer_count() const noexcept { return m_fixed_count; }
+    std::uint32_t IoRing::recv_buffer_count() const noexcept { return m_recv_count; }
+    std::uint32_t IoRing::buffer_size() const noexcept { return m_buffer_size; }
+
+    void* IoRing::next_sqe() noexcept {
+        const unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+        if (m_sq_pending_tail - head >= m_sq_entries) {
+            return nullptr; // full, caller needs to submit()
+        }
+
+        auto* sqe = static_cast<io_uring_sqe*>(m_sqes) + (m_sq_pending_tail & m_sq_mask);
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++m_sq_pending_tail;
+        return sqe;
+    }
+
+    SockResult IoRing::queue_provide(std::uint16_t first, std::uint32_t count) noexcept {
+        auto* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Recv, 0, 0 };
+
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<std::int32_t>(count);
+        sqe->addr = reinterpret_cast<std::uintptr_t>(m_recv_mem + static_cast<std::size_t>(first) * m_buffer_size);
+        sqe->len = m_buffer_size;
+        sqe->off = first;
+        sqe->buf_group = recv_group;
+        sqe->user_data = internal_token;
+        return SockResult{ SockErr::None, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::queue_send(socket_handle handle, const void* data, std::size_t size, std::uint64_t user_data) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+        if (handle == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Send, 0, 0 };
+        if (data == nullptr || size == 0) return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        if (size > static_cast<std::size_t>(INT32_MAX)) return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+
+        auto* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Send, 0, 0 };
+
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = handle;
+        sqe->addr = reinterpret_cast<std::uintptr_t>(data);
+        sqe->len = static_cast<std::uint32_t>(size);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = user_data;
+        return SockResult{ SockErr::None, SockOp::Send, 0, 0 };
+    }
+
+    SockResult IoRing::queue_recv(socket_handle handle, void* data, std::size_t size, std::uint64_t user_data) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        if (handle == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Recv, 0, 0 };
+        if (data == nullptr || size == 0) return SockResult{ SockErr::SizeZero, SockOp::Recv, 0, 0 };
+        if (size > static_cast<std::size_t>(INT32_MAX)) return SockResult{ SockErr::SizeTooLarge, SockOp::Recv, 0, 0 };
+
+        auto* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Recv, 0, 0 };
+
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = handle;
+        sqe->addr = reinterpret_cast<std::uintptr_t>(data);
+        sqe->len = static_cast<std::uint32_t>(size);
+        sqe->user_data = user_data;
+        return SockResult{ SockErr::None, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::queue_send_fixed(socket_handle handle, std::uint16_t index, std::size_t size, std::uint64_t user_data) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+        if (handle == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Send, 0, 0 };
+        if (index >= m_fixed_count) return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+        if (size == 0) return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        if (size > m_buffer_size) return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+
+        auto* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Send, 0, 0 };
+
+        // write on a socket is a send with no flags
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = handle;
+        sqe->addr = reinterpret_cast<std::uintptr_t>(fixed_buffer(index));
+        sqe->len = static_cast<std::uint32_t>(size);
+        sqe->buf_index = index;
+        sqe->user_data = user_data;
+        return SockResult{ SockErr::None, SockOp::Send, 0, 0 };
+    }
+
+    SockResult IoRing::queue_recv_fixed(socket_handle handle, std::uint16_t index, std::size_t size, std::uint64_t user_data) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        if (handle == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Recv, 0, 0 };
+        if (index >= m_fixed_count) return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+        if (size == 0) return SockResult{ SockErr::SizeZero, SockOp::Recv, 0, 0 };
+        if (size > m_buffer_size) return SockResult{ SockErr::SizeTooLarge, SockOp::Recv, 0, 0 };
+
+        auto* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Recv, 0, 0 };
+
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = handle;
+        sqe->addr = reinterpret_cast<std::uintptr_t>(fixed_buffer(index));
+        sqe->len = static_cast<std::uint32_t>(size);
+        sqe->buf_index = index;
+        sqe->user_data = user_data;
+        return SockResult{ SockErr::None, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::queue_recv_multishot(socket_handle handle, std::uint64_t user_data) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        if (handle == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Recv, 0, 0 };
+        if (m_recv_count == 0) return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+
+        auto* sqe = static_cast<io_uring_sqe*>(next_sqe());
+        if (sqe == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Recv, 0, 0 };
+
+        // NOTE: needs linux 6.0, older kernels complete this with -EINVAL
+        sqe->opcode = IORING_OP_RECV;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->fd = handle;
+        sqe->buf_group = recv_group;
+        sqe->user_data = user_data;
+        return SockResult{ SockErr::None, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::recycle_buffer(std::uint16_t id) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        if (id >= m_recv_count) return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+        return queue_provide(id, 1);
+    }
+
+    SockResult IoRing::submit(std::uint32_t wait_for) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Submit, 0, 0 };
+
+        // publish the queued entries, the kernel reads the tail with acquire
+        __atomic_store_n(m_sq_tail, m_sq_pending_tail, __ATOMIC_RELEASE);
+        const unsigned to_submit = m_sq_pending_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+        if (to_submit == 0 && wait_for == 0) {
+            return SockResult{ SockErr::None, SockOp::Submit, 0, 0 };
+        }
+
+        const unsigned flags = wait_for != 0 ? IORING_ENTER_GETEVENTS : 0u;
+        int n = 0;
+        do {
+            n = ring_enter(m_fd, to_submit, wait_for, flags);
+        } while (n < 0 && errno == EINTR);
+
+        if (n < 0) {
+            const int err = errno;
+            // EBUSY: completion ring is backed up, reap() and try again
+            const auto code = err == EBUSY || err == EAGAIN ? SockErr::WouldBlock : map_err(err);
+            return SockResult{ code, SockOp::Submit, err, 0 };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Submit, 0, n };
+    }
+
+    std::size_t IoRing::reap(IoCompletion* out, std::size_t max) noexcept {
+        if (!m_open || out == nullptr) return 0;
+
+        unsigned head = *m_cq_head; // we are the only writer of the cq head
+        const unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+        const auto* cqes = static_cast<const io_uring_cqe*>(m_cqes);
+
+        std::size_t count = 0;
+        while (head != tail && count < max) {
+            const auto& cqe = cqes[head & m_cq_mask];
+            ++head;
+            if (cqe.user_data == internal_token) {
+                // provide-buffers ack, a failed one leaves its buffers out of the group
+                if (cqe.res < 0) {
+                    ++m_provide_errors;
+                    m_provide_error = -cqe.res;
+                }
+                continue;
+            }
+            out[count++] = IoCompletion{ cqe.user_data, cqe.res, cqe.flags };
+        }
+
+        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        return count;
+    }
+}
+#endif
@@ -55,6 +55,25 @@ namespace sock {
         }
     }
 
+    bool is_transient_accept_err(int e) noexcept {
+        // accept(2) hands back pending network errors of the new socket
+        switch (e) {
+            case ECONNABORTED:
+            case EPROTO:
+            case EPERM:
+            case ENETDOWN:
+            case ENOPROTOOPT:
+            case EHOSTDOWN:
+            case ENONET:
+            case EHOSTUNREACH:
+            case EOPNOTSUPP:
+            case ENETUNREACH:
+                return true;
+            default:
+                return false;
+        }
+    }
+
 }
 
 #endif
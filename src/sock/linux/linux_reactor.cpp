@@ -0,0 +1,182 @@
+#if defined(MOO_LINUX)
+#include "sock/reactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace sock {
+    // reserved token for the wake eventfd, never handed out
+    static constexpr std::uint64_t wake_token = ~std::uint64_t{0};
+
+    static std::uint32_t to_epoll(std::uint32_t events) noexcept {
+        std::uint32_t out = EPOLLET | EPOLLRDHUP;
+        if (events & ready::Read)  out |= EPOLLIN;
+        if (events & ready::Write) out |= EPOLLOUT;
+        return out;
+    }
+
+    static std::uint32_t from_epoll(std::uint32_t events) noexcept {
+        std::uint32_t out = 0;
+        if (events & EPOLLIN)  out |= ready::Read;
+        if (events & EPOLLOUT) out |= ready::Write;
+        if (events & EPOLLERR) out |= ready::Error;
+        if (events & (EPOLLHUP | EPOLLRDHUP)) out |= ready::HangUp;
+        return out;
+    }
+
+    Reactor::Reactor() = default;
+
+    Reactor::~Reactor() {
+        close();
+    }
+
+    SockResult Reactor::open() {
+        if (m_open) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+        }
+
+        m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        if (m_epoll < 0) {
+            const int err = errno;
+            m_epoll = -1;
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        m_wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_wake_fd < 0) {
+            const int err = errno;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = wake_token;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake_fd, &ev) != 0) {
+            const int err = errno;
+            close();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        m_open = true;
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void Reactor::close() noexcept {
+        if (m_wake_fd >= 0) ::close(m_wake_fd);
+        if (m_epoll >= 0) ::close(m_epoll);
+        m_wake_fd = -1;
+        m_epoll = -1;
+        m_open = false;
+    }
+
+    SockResult Reactor::add(const TCPSocket& socket, std::uint64_t token, std::uint32_t events) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        if (socket.handle() == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        if (token == wake_token) return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+
+        epoll_event ev{};
+        ev.events = to_epoll(events);
+        ev.data.u64 = token;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket.handle(), &ev) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::modify(const TCPSocket& socket, std::uint64_t token, std::uint32_t events) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        if (socket.handle() == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        if (token == wake_token) return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+
+        epoll_event ev{};
+        ev.events = to_epoll(events);
+        ev.data.u64 = token;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_MOD, socket.handle(), &ev) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::remove(const TCPSocket& socket) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        if (socket.handle() == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket.handle(), nullptr) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::add(const evt::Notifier& notifier, std::uint64_t token) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        if (!notifier.is_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        if (token == wake_token) return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+
+        // eventfd is readable while its counter is non zero, every post() is
+        // a new edge even if the counter was already non zero
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLET;
+        ev.data.u64 = token;
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, notifier.native_handle(), &ev) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::remove(const evt::Notifier& notifier) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        if (!notifier.is_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+
+        if (::epoll_ctl(m_epoll, EPOLL_CTL_DEL, notifier.native_handle(), nullptr) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::poll(ReactorEvent* out, std::size_t max, std::int32_t timeout_ms) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Poll, 0, 0 };
+        if (out == nullptr || max == 0) return SockResult{ SockErr::SizeZero, SockOp::Poll, 0, 0 };
+
+        constexpr std::size_t batch = 256;
+        epoll_event events[batch];
+        const int want = static_cast<int>(max < batch ? max : batch);
+
+        int n = 0;
+        do {
+            n = ::epoll_wait(m_epoll, events, want, timeout_ms);
+        } while (n < 0 && errno == EINTR);
+
+        if (n < 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Poll, err, 0 };
+        }
+
+        std::int32_t count = 0;
+        for (int i = 0; i < n; ++i) {
+            const auto& ev = events[i];
+            if (ev.data.u64 == wake_token) {
+                std::uint64_t drained = 0;
+                (void)::read(m_wake_fd, &drained, sizeof(drained));
+                continue;
+            }
+            out[count++] = ReactorEvent{ ev.data.u64, from_epoll(ev.events) };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Poll, 0, count };
+    }
+
+    void Reactor::wake() noexcept {
+        if (m_wake_fd < 0) return;
+        const std::uint64_t one = 1;
+        (void)::write(m_wake_fd, &one, sizeof(one));
+    }
+}
+#endif
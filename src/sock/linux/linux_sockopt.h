@@ -0,0 +1,98 @@
+#pragma once
+#if defined(MOO_LINUX)
+#include "sock/socket_options.h"
+
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <ctime>
+#include <sys/time.h>
+#include <cstring>
+#include <string>
+
+// shared by the linux tcp/udp sources, not part of the public api
+namespace sock::detail {
+    // room for a gro segment size plus an SO_TIMESTAMPING triple per datagram
+    constexpr std::size_t recv_cmsg_space = CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(timespec) * 3);
+
+    inline int set_int_opt(int fd, int level, int name, int value) noexcept {
+        if (::setsockopt(fd, level, name, &value, static_cast<socklen_t>(sizeof(value))) != 0) {
+            return errno;
+        }
+        return 0;
+    }
+
+    // SO_RCVBUF/SO_SNDBUF/SO_BUSY_POLL, returns the first errno or 0
+    inline int apply_buffer_opts(int fd, std::int32_t rcvbuf, std::int32_t sndbuf, std::int32_t busy_poll_us) noexcept {
+        if (rcvbuf > 0) { if (const int e = set_int_opt(fd, SOL_SOCKET, SO_RCVBUF, rcvbuf)) return e; }
+        if (sndbuf > 0) { if (const int e = set_int_opt(fd, SOL_SOCKET, SO_SNDBUF, sndbuf)) return e; }
+        if (busy_poll_us > 0) { if (const int e = set_int_opt(fd, SOL_SOCKET, SO_BUSY_POLL, busy_poll_us)) return e; }
+        return 0;
+    }
+
+    inline int set_recv_timeout(int fd, std::int32_t timeout_ms) noexcept {
+        timeval tv{};
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, static_cast<socklen_t>(sizeof(tv))) != 0) {
+            return errno;
+        }
+        return 0;
+    }
+
+    inline int enable_timestamps(int fd, Timestamping mode) noexcept {
+        switch (mode) {
+            case Timestamping::None: return 0;
+            case Timestamping::Software: return set_int_opt(fd, SOL_SOCKET, SO_TIMESTAMPNS, 1);
+            case Timestamping::Hardware: {
+                const int flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE
+                                | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+                return set_int_opt(fd, SOL_SOCKET, SO_TIMESTAMPING, flags);
+            }
+            default: return EINVAL;
+        }
+    }
+
+    // best effort, asks the nic driver to stamp every received packet
+    inline int enable_nic_timestamps(int fd, const std::string& iface) noexcept {
+        if (iface.empty() || iface.size() >= IFNAMSIZ) return EINVAL;
+
+        hwtstamp_config hw{};
+        hw.tx_type = HWTSTAMP_TX_OFF;
+        hw.rx_filter = HWTSTAMP_FILTER_ALL;
+
+        ifreq req{};
+        std::memcpy(req.ifr_name, iface.c_str(), iface.size());
+        req.ifr_data = reinterpret_cast<char*>(&hw);
+        return ::ioctl(fd, SIOCSHWTSTAMP, &req) == 0 ? 0 : errno;
+    }
+
+    inline std::uint64_t to_ns(const timespec& ts) noexcept {
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    // returns true if c was a timestamp cmsg
+    inline bool read_timestamp(const cmsghdr* c, RecvTimestamp& out) noexcept {
+        if (c->cmsg_level != SOL_SOCKET) return false;
+
+        if (c->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts{};
+            std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            out.software_ns = to_ns(ts);
+            return true;
+        }
+
+        if (c->cmsg_type == SCM_TIMESTAMPING) {
+            // [0] software, [1] legacy, [2] raw hardware
+            timespec ts[3]{};
+            std::memcpy(ts, CMSG_DATA(c), sizeof(ts));
+            out.software_ns = to_ns(ts[0]);
+            out.hardware_ns = to_ns(ts[2]);
+            return true;
+        }
+        return false;
+    }
+}
+#endif
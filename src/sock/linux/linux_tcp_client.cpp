@@ -1,15 +1,44 @@
 #if defined(MOO_LINUX)
 
 #include "sock/tcp_socket.h"
+#include "sock/io_ring.h"
+#include "sock/linux/linux_sockopt.h"
+#include "instr/instr.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 
 namespace sock {
-    TCPClient::TCPClient() : TCPSocket(), m_dest_id(INVALID_NODE) {}
+    // counters for one send/recv syscall, compile to nothing without MOO_INSTRUMENT.
+    // errno is put back since the first count on a thread may allocate
+    static void note_send(size_t wanted, ssize_t sent) noexcept {
+        const int saved = errno;
+        MOO_INSTR_COUNT(instr::Counter::TcpSendCalls, 1);
+        if (sent > 0) {
+            MOO_INSTR_COUNT(instr::Counter::TcpSendBytes, sent);
+            MOO_INSTR_COUNT_IF(static_cast<size_t>(sent) < wanted, instr::Counter::TcpPartialSends);
+        }
+        errno = saved;
+    }
+
+    static void note_recv(ssize_t got) noexcept {
+        const int saved = errno;
+        MOO_INSTR_COUNT(instr::Counter::TcpRecvCalls, 1);
+        if (got > 0) MOO_INSTR_COUNT(instr::Counter::TcpRecvBytes, got);
+        errno = saved;
+    }
+
+    // the kernel drops back to delayed acks after a while, TCP_QUICKACK
+    // has to be set again after reads to stay in quick ack mode
+    void TCPClient::rearm_quick_ack() noexcept {
+        if (m_quick_ack) {
+            (void)detail::set_int_opt(m_handle, IPPROTO_TCP, TCP_QUICKACK, 1);
+        }
+    }
 
     SockResult TCPClient::connect(const char* ip, uint16_t port) {
         if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
@@ -28,10 +57,46 @@ namespace sock {
         }
 
         if (::connect(m_handle, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            const int err = errno;
+            if (err == EINPROGRESS) {
+                // non-blocking connect in flight, wait for writable then finish_connect()
+                return SockResult{ SockErr::WouldBlock, SockOp::Connect, err, 0 };
+            }
+            return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+        }
+
+        m_connected = true;
+        return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
+    }
+
+    SockResult TCPClient::finish_connect() {
+        if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
+        if (is_connected())  return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
+
+        int so_err = 0;
+        socklen_t len = static_cast<socklen_t>(sizeof(so_err));
+        if (::getsockopt(m_handle, SOL_SOCKET, SO_ERROR, &so_err, &len) != 0) {
             const int err = errno;
             return SockResult{ map_err(err), SockOp::Connect, err, 0 };
         }
 
+        if (so_err == EINPROGRESS || so_err == EALREADY) {
+            return SockResult{ SockErr::WouldBlock, SockOp::Connect, so_err, 0 };
+        }
+
+        if (so_err != 0) {
+            return SockResult{ map_err(so_err), SockOp::Connect, so_err, 0 };
+        }
+
+        // SO_ERROR is also 0 while the handshake is still running
+        sockaddr_in peer{};
+        socklen_t peer_len = static_cast<socklen_t>(sizeof(peer));
+        if (::getpeername(m_handle, reinterpret_cast<sockaddr*>(&peer), &peer_len) != 0) {
+            const int err = errno;
+            if (err == ENOTCONN) return SockResult{ SockErr::WouldBlock, SockOp::Connect, err, 0 };
+            return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+        }
+
         m_connected = true;
         return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
     }
@@ -52,7 +117,9 @@ namespace sock {
         // NOTE: may not always send all bytes, use send_all() for that
         ssize_t sent_bytes = 0;
         {
+            MOO_INSTR_TIMER_START(lock_t0);
             std::lock_guard lock(m_send_mtx);
+            MOO_INSTR_TIMER_RECORD(lock_t0, instr::Hist::TcpSendLockWait);
             sent_bytes = ::send(
                 m_handle,
                 data,
@@ -60,6 +127,7 @@ namespace sock {
                 MSG_NOSIGNAL
             );
         }
+        note_send(size, sent_bytes);
 
         if (sent_bytes > 0) {
             return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(sent_bytes) };
@@ -94,7 +162,9 @@ namespace sock {
         size_t total = 0;
         const auto* ptr = static_cast<const std::byte*>(data);
 
+        MOO_INSTR_TIMER_START(lock_t0);
         std::lock_guard lock(m_send_mtx);
+        MOO_INSTR_TIMER_RECORD(lock_t0, instr::Hist::TcpSendLockWait);
         while (total < size) {
             const size_t remaining = size - total;
 
@@ -104,6 +174,7 @@ namespace sock {
                 remaining,
                 MSG_NOSIGNAL
             );
+            note_send(remaining, sent);
 
             if (sent > 0) {
                 total += static_cast<size_t>(sent);
@@ -131,6 +202,143 @@ namespace sock {
         return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
     }
 
+    SockResult TCPClient::send_all_v(const IoVec* bufs, const size_t count) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        if (bufs == nullptr || count == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        size_t size = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (bufs[i].data == nullptr && bufs[i].size != 0) {
+                return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+            }
+            size += bufs[i].size;
+        }
+
+        if (size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+        }
+
+        // sendmsg takes at most IOV_MAX entries, go in windows of this many
+        constexpr size_t max_iov = 64;
+        iovec iov[max_iov];
+
+        size_t total = 0;
+        size_t next = 0;      // first buffer not yet loaded into iov
+        size_t loaded = 0;    // entries in iov
+        size_t first = 0;     // first entry of iov with bytes left
+
+        MOO_INSTR_TIMER_START(lock_t0);
+        std::lock_guard lock(m_send_mtx);
+        MOO_INSTR_TIMER_RECORD(lock_t0, instr::Hist::TcpSendLockWait);
+        while (total < size) {
+            if (first == loaded) {
+                // window drained, load the next one
+                first = 0;
+                loaded = 0;
+                while (next < count && loaded < max_iov) {
+                    if (bufs[next].size != 0) {
+                        iov[loaded].iov_base = const_cast<void*>(bufs[next].data);
+                        iov[loaded].iov_len = bufs[next].size;
+                        ++loaded;
+                    }
+                    ++next;
+                }
+            }
+
+            msghdr msg{};
+            msg.msg_iov = &iov[first];
+            msg.msg_iovlen = loaded - first;
+
+            const ssize_t sent = ::sendmsg(m_handle, &msg, MSG_NOSIGNAL);
+            note_send(size - total, sent);
+            if (sent > 0) {
+                total += static_cast<size_t>(sent);
+
+                // skip fully written entries, trim the partially written one
+                auto left = static_cast<size_t>(sent);
+                while (first < loaded && left >= iov[first].iov_len) {
+                    left -= iov[first].iov_len;
+                    ++first;
+                }
+                if (left > 0) {
+                    iov[first].iov_base = static_cast<std::byte*>(iov[first].iov_base) + left;
+                    iov[first].iov_len -= left;
+                }
+                continue;
+            }
+
+            if (sent == 0) {
+                m_connected = false;
+                return SockResult{ SockErr::Closed, SockOp::Send, 0, static_cast<int>(total) };
+            }
+
+            const int err = errno;
+            if (err == EINTR) {
+                continue; // retry
+            }
+
+            if (is_fatal_send_err(err)) {
+                m_connected = false;
+            }
+
+            return SockResult{ map_err(err), SockOp::Send, err, static_cast<int>(total) };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
+    }
+
+    SockResult TCPClient::send_v_once(const IoVec* bufs, const size_t count) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        constexpr size_t max_iov = 64;
+        iovec iov[max_iov];
+        const size_t n = count < max_iov ? count : max_iov;
+        for (size_t i = 0; i < n; ++i) {
+            iov[i].iov_base = const_cast<void*>(bufs[i].data);
+            iov[i].iov_len = bufs[i].size;
+        }
+
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+
+        ssize_t sent = 0;
+        size_t wanted = 0;
+        for (size_t i = 0; i < n; ++i) wanted += iov[i].iov_len;
+
+        do {
+            sent = ::sendmsg(m_handle, &msg, MSG_NOSIGNAL);
+            note_send(wanted, sent);
+        } while (sent < 0 && errno == EINTR);
+
+        if (sent > 0) {
+            return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(sent) };
+        }
+
+        if (sent == 0) {
+            m_connected = false;
+            return SockResult{ SockErr::Closed, SockOp::Send, 0, 0 };
+        }
+
+        const int err = errno;
+        if (is_fatal_send_err(err)) {
+            m_connected = false;
+        }
+
+        return SockResult{ map_err(err), SockOp::Send, err, 0 };
+    }
+
     SockResult TCPClient::recv(void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
@@ -150,8 +358,10 @@ namespace sock {
             size,
             0
         );
+        note_recv(recv_bytes);
 
         if (recv_bytes > 0) {
+            rearm_quick_ack();
             return SockResult{ SockErr::None, SockOp::Recv, 0, static_cast<int>(recv_bytes) };
         }
 
@@ -165,6 +375,48 @@ namespace sock {
         return SockResult{ map_err(err), SockOp::Recv, err, 0 };
     }
 
+    SockResult TCPClient::recv(void* data, const size_t size, RecvTimestamp& timestamp) {
+        timestamp = RecvTimestamp{};
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
+        }
+
+        if (size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Recv, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Recv, 0, 0 };
+        }
+
+        iovec iov{ data, size };
+        alignas(cmsghdr) unsigned char ctrl[detail::recv_cmsg_space];
+
+        msghdr msg{};
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+
+        const ssize_t recv_bytes = ::recvmsg(m_handle, &msg, 0);
+        note_recv(recv_bytes);
+        if (recv_bytes > 0) {
+            for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+                (void)detail::read_timestamp(c, timestamp);
+            }
+            rearm_quick_ack();
+            return SockResult{ SockErr::None, SockOp::Recv, 0, static_cast<int>(recv_bytes) };
+        }
+
+        if (recv_bytes == 0) {
+            m_connected = false;
+            return SockResult{ SockErr::Closed, SockOp::Recv, 0, 0 };
+        }
+
+        const int err = errno;
+        return SockResult{ map_err(err), SockOp::Recv, err, 0 };
+    }
+
     SockResult TCPClient::recv_all(void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
@@ -188,6 +440,7 @@ namespace sock {
                 size - total,
                 0
             );
+            note_recv(recv_bytes);
 
             if (recv_bytes > 0) {
                 total += static_cast<size_t>(recv_bytes);
@@ -217,6 +470,7 @@ namespace sock {
             };
         }
 
+        rearm_quick_ack();
         return SockResult{
             SockErr::None,
             SockOp::Recv,
@@ -224,5 +478,26 @@ namespace sock {
             static_cast<int>(total)
         };
     }
+
+    SockResult TCPClient::queue_send(IoRing& ring, const void* data, const size_t size, std::uint64_t user_data) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+        return ring.queue_send(m_handle, data, size, user_data);
+    }
+
+    SockResult TCPClient::queue_recv(IoRing& ring, void* data, const size_t size, std::uint64_t user_data) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv(m_handle, data, size, user_data);
+    }
+
+    SockResult TCPClient::queue_recv_multishot(IoRing& ring, std::uint64_t user_data) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv_multishot(m_handle, user_data);
+    }
 }
 #endif
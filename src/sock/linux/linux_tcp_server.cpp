@@ -1,10 +1,12 @@
 #if defined(MOO_LINUX)
 #include "sock/tcp_socket.h"
+#include "sock/linux/linux_sockopt.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <errno.h>
 
@@ -52,36 +54,58 @@ namespace sock {
         return SockResult{ SockErr::None, SockOp::Listen, 0, 0 };
     }
 
-    std::pair<std::shared_ptr<TCPClient>, SockResult> TCPServer::accept() {
-        SockResult result{ SockErr::Unknown, SockOp::Accept, 0, 0 };
-
+    SockResult TCPServer::accept_into(TCPClient& out) {
         if (!handle_valid()) {
-            result.code = SockErr::InvalidHandle;
-            return { nullptr, result };
+            return SockResult{ SockErr::InvalidHandle, SockOp::Accept, 0, 0 };
         }
 
         sockaddr_in conn{};
         socklen_t conn_size = static_cast<socklen_t>(sizeof(conn));
 
-        int fd = ::accept(m_handle, reinterpret_cast<sockaddr*>(&conn), &conn_size);
+        // accept4 hands back the client already in our mode, saves an fcntl per client
+        const int flags = SOCK_CLOEXEC | (m_nonblocking ? SOCK_NONBLOCK : 0);
+        int fd = -1;
+        do {
+            fd = ::accept4(m_handle, reinterpret_cast<sockaddr*>(&conn), &conn_size, flags);
+        } while (fd < 0 && errno == EINTR);
+
         if (fd < 0) {
-            result.sys_error = errno;
+            const int err = errno;
 
             // When request_stop() closes the listen socket, accept commonly fails with EBADF.
             // Also treat ENOTSOCK as closed.
-            if (result.sys_error == EBADF || result.sys_error == ENOTSOCK) {
-                result.code = SockErr::Closed;
-            } else {
-                result.code = map_err(result.sys_error);
+            if (err == EBADF || err == ENOTSOCK) {
+                return SockResult{ SockErr::Closed, SockOp::Accept, err, 0 };
             }
-            return { nullptr, result };
+            return SockResult{ map_err(err), SockOp::Accept, err, 0 };
         }
 
-        auto client = std::make_shared<TCPClient>();
-        client->adopt(fd, true);
+        out.adopt(fd, true, m_nonblocking);
+        return SockResult{ SockErr::None, SockOp::Accept, 0, 0 };
+    }
 
-        result.code = SockErr::None;
+    std::pair<std::shared_ptr<TCPClient>, SockResult> TCPServer::accept() {
+        auto client = std::make_shared<TCPClient>();
+        const auto result = accept_into(*client);
+        if (!result.ok()) return { nullptr, result };
         return { std::move(client), result };
     }
+
+    SockResult TCPServer::apply_listen_options(const TcpListenOptions& opts) {
+        if (!handle_valid()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        int err = 0;
+        if (opts.reuse_port) err = detail::set_int_opt(m_handle, SOL_SOCKET, SO_REUSEPORT, 1);
+        if (err == 0 && opts.fastopen_queue > 0) err = detail::set_int_opt(m_handle, IPPROTO_TCP, TCP_FASTOPEN, opts.fastopen_queue);
+        if (err == 0 && opts.defer_accept_s > 0) err = detail::set_int_opt(m_handle, IPPROTO_TCP, TCP_DEFER_ACCEPT, opts.defer_accept_s);
+
+        if (err != 0) {
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
 }
 #endif
@@ -1,6 +1,7 @@
 #if defined(MOO_LINUX)
 
 #include "sock/tcp_socket.h"
+#include "sock/linux/linux_sockopt.h"
 #include <utility>
 
 #include <sys/types.h>
@@ -8,6 +9,7 @@
 #include <netinet/in.h>   // AF_INET
 #include <netinet/tcp.h>  // IPPROTO_TCP
 #include <unistd.h>       // close()
+#include <fcntl.h>
 #include <errno.h>
 
 namespace sock {
@@ -27,13 +29,17 @@ namespace sock {
 
     TCPSocket::TCPSocket(TCPSocket&& other) noexcept
         : m_handle(std::exchange(other.m_handle, INVALID_SOCKET)),
-          m_connected(std::exchange(other.m_connected, false)) {}
+          m_connected(std::exchange(other.m_connected, false)),
+          m_nonblocking(std::exchange(other.m_nonblocking, false)),
+          m_quick_ack(std::exchange(other.m_quick_ack, false)) {}
 
     TCPSocket& TCPSocket::operator=(TCPSocket&& other) noexcept {
         if (this != &other) {
             close();
             m_handle = std::exchange(other.m_handle, INVALID_SOCKET);
             m_connected = std::exchange(other.m_connected, false);
+            m_nonblocking = std::exchange(other.m_nonblocking, false);
+            m_quick_ack = std::exchange(other.m_quick_ack, false);
         }
         return *this;
     }
@@ -70,6 +76,48 @@ namespace sock {
         }
         m_handle = INVALID_SOCKET;
         m_connected = false;
+        m_nonblocking = false;
+        m_quick_ack = false;
+    }
+
+    SockResult TCPSocket::set_nonblocking(bool enable) {
+        if (!handle_valid()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        const int flags = ::fcntl(m_handle, F_GETFL, 0);
+        if (flags < 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        const int wanted = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+        if (wanted != flags && ::fcntl(m_handle, F_SETFL, wanted) != 0) {
+            const int err = errno;
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        m_nonblocking = enable;
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult TCPSocket::apply_options(const TcpSocketOptions& opts) {
+        if (!handle_valid()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        int err = detail::apply_buffer_opts(m_handle, opts.rcvbuf, opts.sndbuf, opts.busy_poll_us);
+        if (err == 0 && opts.no_delay)  err = detail::set_int_opt(m_handle, IPPROTO_TCP, TCP_NODELAY, 1);
+        if (err == 0 && opts.quick_ack) err = detail::set_int_opt(m_handle, IPPROTO_TCP, TCP_QUICKACK, 1);
+        if (err == 0 && opts.recv_timeout_ms > 0) err = detail::set_recv_timeout(m_handle, opts.recv_timeout_ms);
+        if (err == 0) err = detail::enable_timestamps(m_handle, opts.timestamps);
+
+        if (err != 0) {
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        m_quick_ack = opts.quick_ack;
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
     }
 }
 #endif
@@ -1,17 +1,50 @@
 #if defined(MOO_LINUX)
 
 #include "sock/udp_multicast.h"
+#include "sock/io_ring.h"
+#include "sock/linux/linux_sockopt.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>   // sockaddr_in, IPPROTO_IP
+#include <netinet/udp.h>  // UDP_SEGMENT, UDP_GRO
 #include <arpa/inet.h>    // inet_pton
+#include <linux/filter.h> // sock_filter, SO_ATTACH_FILTER
+#include <linux/if_ether.h>
+#include <linux/if_packet.h> // TPACKET_V3
+#include <sys/mman.h>
+#include <poll.h>
 #include <unistd.h>       // close
 #include <errno.h>
 #include <cstring>
 #include <utility>
 
 namespace sock {
+    // max datagrams handed to one recvmmsg/sendmmsg, keeps the scratch arrays on the stack
+    static constexpr std::size_t max_batch = 64;
+
+    static UdpEndpoint to_endpoint(const sockaddr_in& addr) noexcept {
+        return UdpEndpoint{ ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port) };
+    }
+
+    static std::uint16_t load_be16(const std::uint8_t* p) noexcept {
+        return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    static std::uint32_t load_be32(const std::uint8_t* p) noexcept {
+        return (std::uint32_t{p[0]} << 24) | (std::uint32_t{p[1]} << 16) | (std::uint32_t{p[2]} << 8) | p[3];
+    }
+
+    static int attach_filter(int fd, sock_filter* prog, std::size_t len) noexcept {
+        sock_fprog fprog{};
+        fprog.len = static_cast<unsigned short>(len);
+        fprog.filter = prog;
+        if (::setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, static_cast<socklen_t>(sizeof(fprog))) != 0) {
+            return errno;
+        }
+        return 0;
+    }
+
     bool UDPMulticastSocket::handle_valid() const noexcept {
         return m_handle != INVALID_SOCKET;
     }
@@ -27,7 +60,15 @@ namespace sock {
         : m_handle(std::exchange(o.m_handle, INVALID_SOCKET)),
           m_open(std::exchange(o.m_open, false)),
           m_joined(std::exchange(o.m_joined, false)),
-          m_cfg(o.m_cfg) {}
+          m_cfg(o.m_cfg),
+          m_dst_addr(o.m_dst_addr),
+          m_dst_port(o.m_dst_port),
+          m_ring_fd(std::exchange(o.m_ring_fd, -1)),
+          m_ring(std::exchange(o.m_ring, nullptr)),
+          m_ring_block(o.m_ring_block),
+          m_ring_left(o.m_ring_left),
+          m_ring_next(o.m_ring_next),
+          m_ring_held(std::exchange(o.m_ring_held, false)) {}
 
     UDPMulticastSocket& UDPMulticastSocket::operator=(UDPMulticastSocket&& o) noexcept {
         if (this != &o) {
@@ -36,11 +77,19 @@ namespace sock {
             m_open   = std::exchange(o.m_open, false);
             m_joined = std::exchange(o.m_joined, false);
             m_cfg    = o.m_cfg;
+            m_dst_addr = o.m_dst_addr;
+            m_dst_port = o.m_dst_port;
+            m_ring_fd = std::exchange(o.m_ring_fd, -1);
+            m_ring = std::exchange(o.m_ring, nullptr);
+            m_ring_block = o.m_ring_block;
+            m_ring_left = o.m_ring_left;
+            m_ring_next = o.m_ring_next;
+            m_ring_held = std::exchange(o.m_ring_held, false);
         }
         return *this;
     }
 
-    SockResult UDPMulticastSocket::open_and_join(const cfg::UdpMcastConfig& cfg) {
+    SockResult UDPMulticastSocket::open_and_join(const UdpMcastConfig& cfg) {
         SockResult result{};
         result.op = SockOp::Open;
 
@@ -86,6 +135,27 @@ namespace sock {
             return result;
         }
 
+        // buffer sizing / busy poll / timestamps
+        result.op = SockOp::Configure;
+        int opt_err = detail::apply_buffer_opts(m_handle, cfg.rcvbuf, cfg.sndbuf, cfg.busy_poll_us);
+        if (opt_err == 0) opt_err = detail::enable_timestamps(m_handle, cfg.timestamps);
+        if (opt_err != 0) {
+            result.sys_error = opt_err;
+            result.code = map_err(opt_err);
+            close();
+            return result;
+        }
+
+        if (cfg.timestamps == Timestamping::Hardware && !cfg.hw_timestamp_iface.empty()) {
+            (void)detail::enable_nic_timestamps(m_handle, cfg.hw_timestamp_iface); // software stamps still flow if this fails
+        }
+
+        // gro is best effort, older kernels just never coalesce
+        if (cfg.gro) {
+            int on = 1;
+            (void)::setsockopt(m_handle, SOL_UDP, UDP_GRO, &on, static_cast<socklen_t>(sizeof(on)));
+        }
+
         // TTL
         result.op = SockOp::Send;
         int ttl = cfg.ttl;
@@ -118,12 +188,253 @@ namespace sock {
             return result;
         }
 
+        // resolve the destination once so sends dont re-parse group_ip
+        m_dst_addr = mreq.imr_multiaddr.s_addr;
+        m_dst_port = htons(cfg.port);
+
         m_joined = true;
+
+        if (!cfg.ring_iface.empty()) {
+            result.op = SockOp::Configure;
+            const int ring_err = open_ring();
+            if (ring_err != 0) {
+                result.sys_error = ring_err;
+                result.code = map_err(ring_err);
+                close();
+                return result;
+            }
+        }
+
         result.code = SockErr::None;
         result.op = SockOp::Open;
         return result;
     }
 
+    int UDPMulticastSocket::open_ring() noexcept {
+        const unsigned ifindex = ::if_nametoindex(m_cfg.ring_iface.c_str());
+        if (ifindex == 0) return errno != 0 ? errno : ENODEV;
+
+        const auto page = static_cast<std::uint32_t>(::sysconf(_SC_PAGESIZE));
+        const std::uint32_t block_size = m_cfg.ring_block_size;
+        const std::uint32_t block_count = m_cfg.ring_block_count;
+        if (block_size == 0 || block_size % page != 0 || block_count == 0) return EINVAL;
+
+        // protocol 0 receives nothing until bind, so no frame lands before the filter is on
+        m_ring_fd = ::socket(AF_PACKET, SOCK_DGRAM, 0);
+        if (m_ring_fd < 0) return errno;
+
+        const auto fail = [this](int err) noexcept {
+            close_ring();
+            return err;
+        };
+
+        if (const int e = detail::set_int_opt(m_ring_fd, SOL_PACKET, PACKET_VERSION, TPACKET_V3)) return fail(e);
+
+        // SOCK_DGRAM frames start at the ip header: ipv4, udp, unfragmented, to group:port
+        const std::uint32_t group = ntohl(m_dst_addr);
+        sock_filter prog[] = {
+            BPF_STMT(BPF_LD | BPF_H | BPF_ABS, static_cast<std::uint32_t>(SKF_AD_OFF + SKF_AD_PROTOCOL)), // ethertype
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 10),
+            BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),                  // ip protocol
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 8),
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 16),                 // destination
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, group, 0, 6),
+            BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),                  // more fragments / offset
+            BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3FFF, 4, 0),
+            BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),                 // x = ip header length
+            BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),                  // udp destination port
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, m_cfg.port, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, 0x40000),
+            BPF_STMT(BPF_RET | BPF_K, 0),
+        };
+        if (const int e = attach_filter(m_ring_fd, prog, sizeof(prog) / sizeof(prog[0]))) return fail(e);
+
+        if (m_cfg.timestamps == Timestamping::Hardware) {
+            (void)detail::set_int_opt(m_ring_fd, SOL_PACKET, PACKET_TIMESTAMP, SOF_TIMESTAMPING_RAW_HARDWARE);
+        }
+
+        tpacket_req3 req{};
+        req.tp_block_size = block_size;
+        req.tp_block_nr = block_count;
+        req.tp_frame_size = TPACKET_ALIGNMENT << 7; // only used for tp_frame_nr with v3
+        req.tp_frame_nr = (block_size / req.tp_frame_size) * block_count;
+        req.tp_retire_blk_tov = m_cfg.ring_block_timeout_ms;
+        if (::setsockopt(m_ring_fd, SOL_PACKET, PACKET_RX_RING, &req, static_cast<socklen_t>(sizeof(req))) != 0) {
+            return fail(errno);
+        }
+
+        const std::size_t bytes = std::size_t{block_size} * block_count;
+        void* ring = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, 0);
+        if (ring == MAP_FAILED) return fail(errno);
+        m_ring = static_cast<std::byte*>(ring);
+        m_ring_block = 0;
+        m_ring_left = 0;
+        m_ring_next = 0;
+        m_ring_held = false;
+
+        sockaddr_ll ll{};
+        ll.sll_family = AF_PACKET;
+        // only ETH_P_ALL taps see frames leaving the interface, which is
+        // where this host's own sends show up when loopback is on
+        ll.sll_protocol = htons(m_cfg.loopback ? ETH_P_ALL : ETH_P_IP);
+        ll.sll_ifindex = static_cast<int>(ifindex);
+        if (::bind(m_ring_fd, reinterpret_cast<sockaddr*>(&ll), static_cast<socklen_t>(sizeof(ll))) != 0) {
+            return fail(errno);
+        }
+
+        // the udp socket only stays for the membership and sends
+        sock_filter drop[] = { BPF_STMT(BPF_RET | BPF_K, 0) };
+        (void)attach_filter(m_handle, drop, 1);
+        return 0;
+    }
+
+    void UDPMulticastSocket::close_ring() noexcept {
+        if (m_ring != nullptr) {
+            ::munmap(m_ring, std::size_t{m_cfg.ring_block_size} * m_cfg.ring_block_count);
+            m_ring = nullptr;
+        }
+        if (m_ring_fd >= 0) {
+            ::close(m_ring_fd);
+            m_ring_fd = -1;
+        }
+        m_ring_left = 0;
+        m_ring_held = false;
+    }
+
+    SockResult UDPMulticastSocket::ring_next(UdpDatagram& out, int timeout_ms) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        for (;;) {
+            std::byte* block = m_ring + std::size_t{m_ring_block} * m_cfg.ring_block_size;
+            auto* desc = reinterpret_cast<tpacket_block_desc*>(block);
+
+            if (m_ring_left == 0) {
+                if (m_ring_held) {
+                    // done with it, hand it back and move to the next block
+                    __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+                    m_ring_held = false;
+                    m_ring_block = (m_ring_block + 1) % m_cfg.ring_block_count;
+                    continue;
+                }
+
+                if ((__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+                    if (timeout_ms == 0) { result.code = SockErr::WouldBlock; return result; }
+
+                    pollfd pfd{ m_ring_fd, POLLIN | POLLRDNORM | POLLERR, 0 };
+                    const int n = ::poll(&pfd, 1, timeout_ms);
+                    if (n < 0) {
+                        if (errno == EINTR) continue;
+                        result.sys_error = errno;
+                        result.code = map_err(result.sys_error);
+                        return result;
+                    }
+                    if (n == 0) { result.code = SockErr::WouldBlock; return result; }
+                    continue;
+                }
+
+                m_ring_held = true;
+                m_ring_left = desc->hdr.bh1.num_pkts;
+                m_ring_next = desc->hdr.bh1.offset_to_first_pkt;
+                continue;
+            }
+
+            const auto* hdr = reinterpret_cast<const tpacket3_hdr*>(block + m_ring_next);
+            m_ring_next += hdr->tp_next_offset;
+            --m_ring_left;
+
+            // the kernel filter already matched, this guards against truncated frames
+            const auto* ip = reinterpret_cast<const std::uint8_t*>(hdr) + hdr->tp_net;
+            const std::uint32_t len = hdr->tp_snaplen;
+            if (len < 28 || (ip[0] >> 4) != 4) continue;
+            const std::uint32_t ihl = (ip[0] & 0x0Fu) * 4u;
+            if (ihl < 20 || len < ihl + 8 || ip[9] != IPPROTO_UDP) continue;
+            if ((load_be16(ip + 6) & 0x3FFF) != 0) continue;
+            if (load_be32(ip + 16) != ntohl(m_dst_addr)) continue;
+
+            const auto* udp = ip + ihl;
+            const std::uint16_t udp_len = load_be16(udp + 4);
+            if (load_be16(udp + 2) != m_cfg.port || udp_len < 8 || ihl + udp_len > len) continue;
+
+            out.data = const_cast<std::uint8_t*>(udp + 8);
+            out.length = udp_len - 8u;
+            out.size = out.length;
+            out.segment_size = 0;
+            out.source = UdpEndpoint{ load_be32(ip + 12), load_be16(udp) };
+            out.timestamp = RecvTimestamp{};
+            if (m_cfg.timestamps != Timestamping::None) {
+                const std::uint64_t ns = std::uint64_t{hdr->tp_sec} * 1000000000ull + hdr->tp_nsec;
+                if ((hdr->tp_status & TP_STATUS_TS_RAW_HARDWARE) != 0) out.timestamp.hardware_ns = ns;
+                else out.timestamp.software_ns = ns;
+            }
+
+            result.code = SockErr::None;
+            result.bytes = static_cast<int>(out.length);
+            return result;
+        }
+    }
+
+    SockResult UDPMulticastSocket::recv_ring(RingFn fn, void* ctx, int timeout_ms, size_t max_count) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (fn == nullptr || max_count == 0) { result.code = SockErr::InvalidArgument; return result; }
+        if (max_count > static_cast<size_t>(INT32_MAX)) max_count = static_cast<size_t>(INT32_MAX);
+
+        int delivered = 0;
+        const int limit = static_cast<int>(max_count);
+        if (m_ring != nullptr) {
+            UdpDatagram msg{};
+            while (delivered < limit) {
+                const auto r = ring_next(msg, delivered == 0 ? timeout_ms : 0);
+                if (!r.ok()) {
+                    if (delivered > 0 && r.code == SockErr::WouldBlock) break;
+                    return r;
+                }
+                fn(ctx, msg);
+                ++delivered;
+            }
+        } else {
+            // no ring, same contract over the socket
+            pollfd pfd{ m_handle, POLLIN, 0 };
+            int n = 0;
+            do { n = ::poll(&pfd, 1, timeout_ms); } while (n < 0 && errno == EINTR);
+            if (n < 0) {
+                result.sys_error = errno;
+                result.code = map_err(result.sys_error);
+                return result;
+            }
+            if (n == 0) { result.code = SockErr::WouldBlock; return result; }
+
+            static thread_local std::uint8_t buf[65536];
+            while (delivered < limit) {
+                sockaddr_in src{};
+                socklen_t srclen = static_cast<socklen_t>(sizeof(src));
+                const ssize_t recvd = ::recvfrom(m_handle, buf, sizeof(buf), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&src), &srclen);
+                if (recvd < 0) {
+                    if (errno == EINTR) continue;
+                    if (delivered > 0 || errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    result.sys_error = errno;
+                    result.code = map_err(result.sys_error);
+                    return result;
+                }
+
+                UdpDatagram msg{};
+                msg.data = buf;
+                msg.size = static_cast<std::uint32_t>(recvd);
+                msg.length = msg.size;
+                msg.source = to_endpoint(src);
+                fn(ctx, msg);
+                ++delivered;
+            }
+        }
+
+        result.bytes = delivered;
+        result.code = SockErr::None;
+        return result;
+    }
+
     SockResult UDPMulticastSocket::send_broadcast(const void* data, size_t size) noexcept {
         SockResult result{};
         result.op = SockOp::Send;
@@ -134,13 +445,9 @@ namespace sock {
         if (size > static_cast<size_t>(INT32_MAX)) { result.code = SockErr::SizeTooLarge; return result; }
 
         sockaddr_in dst{};
-        dst.sin_family = AF_INET;
-        dst.sin_port   = htons(m_cfg.port);
-
-        if (::inet_pton(AF_INET, m_cfg.group_ip.c_str(), &dst.sin_addr) != 1) {
-            result.code = SockErr::InvalidIp;
-            return result;
-        }
+        dst.sin_family      = AF_INET;
+        dst.sin_port        = m_dst_port;
+        dst.sin_addr.s_addr = m_dst_addr;
 
         const ssize_t sent = ::sendto(
             m_handle,
@@ -163,6 +470,16 @@ namespace sock {
     }
 
     SockResult UDPMulticastSocket::recv_broadcast(void* data, size_t size) noexcept {
+        UdpEndpoint source{};
+        return recv_broadcast(data, size, source);
+    }
+
+    SockResult UDPMulticastSocket::recv_broadcast(void* data, size_t size, UdpEndpoint& source) noexcept {
+        if (m_cfg.timestamps != Timestamping::None || m_ring != nullptr) {
+            RecvTimestamp timestamp{};
+            return recv_broadcast(data, size, source, timestamp);
+        }
+
         SockResult result{};
         result.op = SockOp::Recv;
 
@@ -189,12 +506,263 @@ namespace sock {
             return result;
         }
 
+        source = to_endpoint(src);
+        result.bytes = static_cast<int>(recvd);
+        result.code = SockErr::None;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::recv_broadcast(void* data, size_t size, UdpEndpoint& source, RecvTimestamp& timestamp) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!data) { result.code = SockErr::InvalidArgument; return result; }
+        if (size == 0) { result.code = SockErr::SizeZero; return result; }
+        if (size > static_cast<size_t>(INT32_MAX)) { result.code = SockErr::SizeTooLarge; return result; }
+
+        if (m_ring != nullptr) {
+            // copies out of the ring, truncating like recvfrom does
+            UdpDatagram msg{};
+            result = ring_next(msg, -1);
+            if (!result.ok()) return result;
+            const std::size_t n = msg.length < size ? msg.length : size;
+            std::memcpy(data, msg.data, n);
+            source = msg.source;
+            timestamp = msg.timestamp;
+            result.bytes = static_cast<int>(n);
+            return result;
+        }
+
+        sockaddr_in src{};
+        iovec iov{ data, size };
+        alignas(cmsghdr) unsigned char ctrl[detail::recv_cmsg_space];
+
+        msghdr msg{};
+        msg.msg_name       = &src;
+        msg.msg_namelen    = static_cast<socklen_t>(sizeof(src));
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+
+        ssize_t recvd = 0;
+        do {
+            recvd = ::recvmsg(m_handle, &msg, 0);
+        } while (recvd < 0 && errno == EINTR);
+
+        if (recvd < 0) {
+            result.sys_error = errno;
+            result.code = map_err(result.sys_error);
+            return result;
+        }
+
+        timestamp = RecvTimestamp{};
+        for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+            (void)detail::read_timestamp(c, timestamp);
+        }
+
+        source = to_endpoint(src);
         result.bytes = static_cast<int>(recvd);
         result.code = SockErr::None;
         return result;
     }
 
+    SockResult UDPMulticastSocket::recv_batch(UdpDatagram* msgs, size_t count) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!msgs) { result.code = SockErr::InvalidArgument; return result; }
+        if (count == 0) { result.code = SockErr::SizeZero; return result; }
+        if (count > max_batch) count = max_batch;
+
+        if (m_ring != nullptr) {
+            std::size_t filled = 0;
+            for (; filled < count; ++filled) {
+                auto& msg = msgs[filled];
+                if (!msg.data || msg.size == 0) { result.code = SockErr::InvalidArgument; result.bytes = static_cast<int>(filled); return result; }
+
+                UdpDatagram in{};
+                const auto r = ring_next(in, filled == 0 ? -1 : 0);
+                if (!r.ok()) {
+                    if (filled > 0 && r.code == SockErr::WouldBlock) break;
+                    return r;
+                }
+                msg.length = in.length < msg.size ? in.length : msg.size;
+                std::memcpy(msg.data, in.data, msg.length);
+                msg.source = in.source;
+                msg.segment_size = 0;
+                msg.timestamp = in.timestamp;
+            }
+            result.bytes = static_cast<int>(filled);
+            result.code = SockErr::None;
+            return result;
+        }
+
+        // per datagram control space for the gro segment size and timestamps
+        constexpr std::size_t cmsg_space = detail::recv_cmsg_space;
+        const bool want_ctrl = m_cfg.gro || m_cfg.timestamps != Timestamping::None;
+
+        mmsghdr hdrs[max_batch];
+        iovec iovs[max_batch];
+        sockaddr_in srcs[max_batch];
+        alignas(cmsghdr) unsigned char ctrl[max_batch][cmsg_space];
+        std::memset(hdrs, 0, sizeof(hdrs[0]) * count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!msgs[i].data || msgs[i].size == 0) { result.code = SockErr::InvalidArgument; return result; }
+
+            iovs[i].iov_base = msgs[i].data;
+            iovs[i].iov_len  = msgs[i].size;
+            hdrs[i].msg_hdr.msg_iov     = &iovs[i];
+            hdrs[i].msg_hdr.msg_iovlen  = 1;
+            hdrs[i].msg_hdr.msg_name    = &srcs[i];
+            hdrs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(sizeof(srcs[i]));
+            if (want_ctrl) {
+                hdrs[i].msg_hdr.msg_control    = ctrl[i];
+                hdrs[i].msg_hdr.msg_controllen = cmsg_space;
+            }
+        }
+
+        int n = 0;
+        do {
+            n = ::recvmmsg(m_handle, hdrs, static_cast<unsigned>(count), MSG_WAITFORONE, nullptr);
+        } while (n < 0 && errno == EINTR);
+
+        if (n < 0) {
+            result.sys_error = errno;
+            result.code = map_err(result.sys_error);
+            return result;
+        }
+
+        for (std::size_t i = 0; i < static_cast<std::size_t>(n); ++i) {
+            auto& msg = msgs[i];
+            msg.length = hdrs[i].msg_len;
+            msg.source = to_endpoint(srcs[i]);
+            msg.segment_size = 0;
+            msg.timestamp = RecvTimestamp{};
+
+            for (cmsghdr* c = CMSG_FIRSTHDR(&hdrs[i].msg_hdr); c != nullptr; c = CMSG_NXTHDR(&hdrs[i].msg_hdr, c)) {
+                if (detail::read_timestamp(c, msg.timestamp)) continue;
+                if (c->cmsg_level == SOL_UDP && c->cmsg_type == UDP_GRO) {
+                    int seg = 0;
+                    std::memcpy(&seg, CMSG_DATA(c), sizeof(seg));
+                    if (seg > 0 && static_cast<std::uint32_t>(seg) < msg.length) {
+                        msg.segment_size = static_cast<std::uint16_t>(seg);
+                    }
+                }
+            }
+        }
+
+        result.bytes = n;
+        result.code = SockErr::None;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::send_batch(const UdpDatagram* msgs, size_t count) noexcept {
+        SockResult result{};
+        result.op = SockOp::Send;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!msgs) { result.code = SockErr::InvalidArgument; return result; }
+        if (count == 0) { result.code = SockErr::SizeZero; return result; }
+
+        sockaddr_in dst{};
+        dst.sin_family      = AF_INET;
+        dst.sin_port        = m_dst_port;
+        dst.sin_addr.s_addr = m_dst_addr;
+
+        mmsghdr hdrs[max_batch];
+        iovec iovs[max_batch];
+
+        std::size_t total = 0;
+        while (total < count) {
+            const std::size_t chunk = (count - total) < max_batch ? (count - total) : max_batch;
+            std::memset(hdrs, 0, sizeof(hdrs[0]) * chunk);
+
+            for (std::size_t i = 0; i < chunk; ++i) {
+                const auto& msg = msgs[total + i];
+                if (!msg.data || msg.size == 0) { result.code = SockErr::InvalidArgument; result.bytes = static_cast<int>(total); return result; }
+
+                iovs[i].iov_base = msg.data;
+                iovs[i].iov_len  = msg.size;
+                hdrs[i].msg_hdr.msg_iov     = &iovs[i];
+                hdrs[i].msg_hdr.msg_iovlen  = 1;
+                hdrs[i].msg_hdr.msg_name    = &dst;
+                hdrs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(sizeof(dst));
+            }
+
+            const int sent = ::sendmmsg(m_handle, hdrs, static_cast<unsigned>(chunk), 0);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                result.sys_error = errno;
+                result.code = map_err(result.sys_error);
+                result.bytes = static_cast<int>(total);
+                return result;
+            }
+
+            total += static_cast<std::size_t>(sent);
+            if (static_cast<std::size_t>(sent) < chunk) break; // socket buffer full, report what went
+        }
+
+        result.bytes = static_cast<int>(total);
+        result.code = SockErr::None;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::send_segmented(const void* data, size_t size, std::uint16_t segment_size) noexcept {
+        SockResult result{};
+        result.op = SockOp::Send;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!data || segment_size == 0) { result.code = SockErr::InvalidArgument; return result; }
+        if (size == 0) { result.code = SockErr::SizeZero; return result; }
+        if (size > static_cast<size_t>(INT32_MAX)) { result.code = SockErr::SizeTooLarge; return result; }
+
+        sockaddr_in dst{};
+        dst.sin_family      = AF_INET;
+        dst.sin_port        = m_dst_port;
+        dst.sin_addr.s_addr = m_dst_addr;
+
+        iovec iov{ const_cast<void*>(data), size };
+        alignas(cmsghdr) unsigned char ctrl[CMSG_SPACE(sizeof(std::uint16_t))] = {};
+
+        msghdr msg{};
+        msg.msg_name    = &dst;
+        msg.msg_namelen = static_cast<socklen_t>(sizeof(dst));
+        msg.msg_iov     = &iov;
+        msg.msg_iovlen  = 1;
+
+        // a single segment needs no gso, also keeps us working on pre 4.18 kernels
+        if (size > segment_size) {
+            msg.msg_control    = ctrl;
+            msg.msg_controllen = sizeof(ctrl);
+            cmsghdr* c = CMSG_FIRSTHDR(&msg);
+            c->cmsg_level = SOL_UDP;
+            c->cmsg_type  = UDP_SEGMENT;
+            c->cmsg_len   = CMSG_LEN(sizeof(std::uint16_t));
+            std::memcpy(CMSG_DATA(c), &segment_size, sizeof(segment_size));
+        }
+
+        ssize_t sent = 0;
+        do {
+            sent = ::sendmsg(m_handle, &msg, 0);
+        } while (sent < 0 && errno == EINTR);
+
+        if (sent < 0) {
+            result.sys_error = errno;
+            result.code = map_err(result.sys_error);
+            return result;
+        }
+
+        result.bytes = static_cast<int>(sent);
+        result.code = SockErr::None;
+        return result;
+    }
+
     void UDPMulticastSocket::close() noexcept {
+        close_ring();
         if (handle_valid()) {
             int rc;
             do { rc = ::close(m_handle); }
@@ -204,5 +772,19 @@ namespace sock {
         m_open = false;
         m_joined = false;
     }
+
+    SockResult UDPMulticastSocket::queue_recv_broadcast(IoRing& ring, void* data, size_t size, std::uint64_t user_data) noexcept {
+        if (!is_open() || !m_joined) {
+            return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv(m_handle, data, size, user_data);
+    }
+
+    SockResult UDPMulticastSocket::queue_recv_multishot(IoRing& ring, std::uint64_t user_data) noexcept {
+        if (!is_open() || !m_joined) {
+            return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv_multishot(m_handle, user_data);
+    }
 }
 #endif
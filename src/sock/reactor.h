@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include "socket_result.h"
+#include "socket_handle.h"
+#include "tcp_socket.h"
+#include "evt/notifier.h"
+
+namespace sock {
+    // readiness bits for Reactor::add/modify and ReactorEvent::events
+    namespace ready {
+        constexpr std::uint32_t Read   = 1u << 0; // data to recv, or a client to accept
+        constexpr std::uint32_t Write  = 1u << 1; // send buffer has room, or connect finished
+        constexpr std::uint32_t Error  = 1u << 2; // socket error pending, recv/send to get it
+        constexpr std::uint32_t HangUp = 1u << 3; // peer closed
+    }
+
+    struct ReactorEvent {
+        std::uint64_t token = 0;   // whatever was passed to add()
+        std::uint32_t events = 0;  // ready:: bits
+    };
+
+    // Readiness event loop for many non-blocking sockets from one thread.
+    // Linux uses epoll in edge triggered mode: an event fires once per state
+    // change, so on Read keep calling recv()/accept() until WouldBlock.
+    // Windows uses WSAPoll (level triggered), draining to WouldBlock works the same.
+    // evt::Notifiers can be registered next to sockets so one thread services
+    // both, they report ready::Read while they hold a count.
+    // NOTE: sockets must be removed before they are closed on windows
+    // NOTE: WSAPoll cant wait on semaphore handles, so on windows a poll with
+    // notifiers registered wakes every 1ms to check them
+    class Reactor {
+        private:
+            #if defined(MOO_WIN32)
+                struct Registration {
+                    socket_handle handle;
+                    std::uint64_t token;
+                    std::uint32_t events;
+                };
+
+                struct NotifierRegistration {
+                    evt::notify_handle handle;
+                    std::uint64_t token;
+                };
+
+                std::mutex m_mtx;
+                std::vector<Registration> m_regs{};
+                std::vector<NotifierRegistration> m_notifiers{};
+                socket_handle m_wake_handle; // loopback udp socket, wake() sends to it
+            #elif defined(MOO_LINUX)
+                int m_epoll = -1;
+                int m_wake_fd = -1; // eventfd, wake() bumps it
+            #endif
+            bool m_open = false;
+
+        public:
+            Reactor();
+            ~Reactor();
+
+            Reactor(const Reactor&) = delete;
+            Reactor& operator=(const Reactor&) = delete;
+            Reactor(Reactor&&) = delete;
+            Reactor& operator=(Reactor&&) = delete;
+
+            [[nodiscard]] SockResult open();
+            void close() noexcept;
+
+            [[nodiscard]] SockResult add(const TCPSocket& socket, std::uint64_t token, std::uint32_t events);
+            [[nodiscard]] SockResult modify(const TCPSocket& socket, std::uint64_t token, std::uint32_t events);
+            [[nodiscard]] SockResult remove(const TCPSocket& socket);
+
+            // on Read take counts with notifier.try_wait() until WouldBlock, like
+            // draining a socket. notifier must be removed before it is closed
+            [[nodiscard]] SockResult add(const evt::Notifier& notifier, std::uint64_t token);
+            [[nodiscard]] SockResult remove(const evt::Notifier& notifier);
+
+            // waits up to timeout_ms (-1 = forever, 0 = just check) and fills out
+            // with ready sockets, result.bytes is the number of events written
+            [[nodiscard]] SockResult poll(ReactorEvent* out, std::size_t max, std::int32_t timeout_ms);
+
+            // makes a blocked poll() return early, safe from any thread
+            void wake() noexcept;
+
+            // shared implementation
+            [[nodiscard]] bool is_open() const noexcept { return m_open; }
+    };
+}
@@ -0,0 +1,562 @@
+#include "sock/reliable_mcast.h"
+#include "sock/accept_retry.h"
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace sock {
+    namespace {
+        void put_be16(std::byte* out, std::uint16_t v) noexcept {
+            out[0] = static_cast<std::byte>(v >> 8);
+            out[1] = static_cast<std::byte>(v);
+        }
+
+        void put_be32(std::byte* out, std::uint32_t v) noexcept {
+            out[0] = static_cast<std::byte>(v >> 24);
+            out[1] = static_cast<std::byte>(v >> 16);
+            out[2] = static_cast<std::byte>(v >> 8);
+            out[3] = static_cast<std::byte>(v);
+        }
+
+        void put_be64(std::byte* out, std::uint64_t v) noexcept {
+            put_be32(out, static_cast<std::uint32_t>(v >> 32));
+            put_be32(out + 4, static_cast<std::uint32_t>(v));
+        }
+
+        std::uint16_t get_be16(const std::byte* in) noexcept {
+            return static_cast<std::uint16_t>((static_cast<std::uint32_t>(in[0]) << 8) | static_cast<std::uint32_t>(in[1]));
+        }
+
+        std::uint32_t get_be32(const std::byte* in) noexcept {
+            return (static_cast<std::uint32_t>(in[0]) << 24)
+                 | (static_cast<std::uint32_t>(in[1]) << 16)
+                 | (static_cast<std::uint32_t>(in[2]) << 8)
+                 | static_cast<std::uint32_t>(in[3]);
+        }
+
+        std::uint64_t get_be64(const std::byte* in) noexcept {
+            return (static_cast<std::uint64_t>(get_be32(in)) << 32) | get_be32(in + 4);
+        }
+
+        // different every run so subscribers can tell a restarted publisher
+        // (whose sequence starts over) from a very late packet
+        std::uint32_t make_session(const void* salt) noexcept {
+            auto v = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            v ^= static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(salt));
+            v ^= v >> 33;
+            v *= 0xFF51AFD7ED558CCDull;
+            v ^= v >> 33;
+            const auto s = static_cast<std::uint32_t>(v);
+            return s == 0 ? 1 : s;
+        }
+
+        bool is_pow2(std::uint32_t v) noexcept { return v != 0 && (v & (v - 1)) == 0; }
+    }
+
+    namespace mcast {
+        void write_header(std::byte* out, const Header& h) noexcept {
+            put_be32(out, magic);
+            out[4] = static_cast<std::byte>(version);
+            out[5] = static_cast<std::byte>(h.kind);
+            put_be16(out + 6, h.count);
+            put_be32(out + 8, h.session);
+            put_be32(out + 12, 0);
+            put_be64(out + 16, h.first_seq);
+            put_be64(out + 24, h.end_seq);
+        }
+
+        bool read_header(const std::byte* in, std::size_t size, Header& out) noexcept {
+            if (in == nullptr || size < header_size) return false;
+            if (get_be32(in) != magic || static_cast<std::uint8_t>(in[4]) != version) return false;
+
+            const auto kind = static_cast<std::uint8_t>(in[5]);
+            if (kind < static_cast<std::uint8_t>(Kind::Data) || kind > static_cast<std::uint8_t>(Kind::End)) return false;
+
+            out.kind = static_cast<Kind>(kind);
+            out.count = get_be16(in + 6);
+            out.session = get_be32(in + 8);
+            out.first_seq = get_be64(in + 16);
+            out.end_seq = get_be64(in + 24);
+            if (out.kind == Kind::Data && out.end_seq != out.first_seq + out.count) return false;
+            return true;
+        }
+    }
+
+    ReliableMcastPublisher::ReliableMcastPublisher(const ReliableMcastPublisherConfig& cfg) : m_cfg(cfg) {
+        if (!is_pow2(m_cfg.retransmit_packets) || max_message() == 0 || m_cfg.mtu > 65507) return;
+
+        const auto bytes = static_cast<std::size_t>(m_cfg.retransmit_packets) * m_cfg.mtu;
+        std::unique_ptr<std::byte[]> ring(new (std::nothrow) std::byte[bytes]);
+        std::unique_ptr<SlotMeta[]> meta(new (std::nothrow) SlotMeta[m_cfg.retransmit_packets]);
+        if (ring == nullptr || meta == nullptr) return;
+
+        m_ring = std::move(ring);
+        m_meta = std::move(meta);
+        m_mask = static_cast<std::size_t>(m_cfg.retransmit_packets) - 1;
+    }
+
+    ReliableMcastPublisher::~ReliableMcastPublisher() {
+        stop();
+    }
+
+    SockResult ReliableMcastPublisher::start() {
+        if (m_started) return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+        if (m_ring == nullptr) return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+
+        m_session = make_session(this);
+
+        auto r = m_mcast.open_and_join(m_cfg.mcast);
+        if (r.ok()) r = m_server.open();
+        if (r.ok()) r = m_server.set_nonblocking(true);
+        if (r.ok()) r = m_server.bind(m_cfg.retransmit_port, m_cfg.retransmit_ip.c_str());
+        if (r.ok()) r = m_server.listen(0);
+        if (r.ok()) r = m_reactor.open();
+        if (r.ok()) r = m_reactor.add(m_server, 0, ready::Read);
+        if (!r.ok()) {
+            m_reactor.close();
+            m_server.close();
+            m_mcast.close();
+            return r;
+        }
+
+        m_stop.store(false, std::memory_order_relaxed);
+        m_accept_thread = std::thread([this]() noexcept { accept_loop(); });
+        m_started = true;
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void ReliableMcastPublisher::stop() noexcept {
+        if (!m_started) return;
+
+        m_stop.store(true, std::memory_order_release);
+        m_reactor.wake();
+        if (m_accept_thread.joinable()) m_accept_thread.join();
+
+        // shutdown wakes a session blocked in recv, the socket itself is only
+        // closed once its thread has been joined
+        {
+            std::lock_guard<std::mutex> lock(m_sessions_mtx);
+            for (auto& s : m_sessions) {
+                if (!s->done.load(std::memory_order_acquire)) s->client.shutdown();
+            }
+            for (auto& s : m_sessions) {
+                if (s->thread.joinable()) s->thread.join();
+            }
+            m_sessions.clear();
+        }
+
+        // reactor first, windows wants sockets removed before they close
+        (void)m_reactor.remove(m_server);
+        m_reactor.close();
+        m_server.close();
+        m_mcast.close();
+
+        m_pending_count = 0;
+        m_pending_bytes = 0;
+        m_started = false;
+    }
+
+    SockResult ReliableMcastPublisher::publish(const void* data, std::size_t size) noexcept {
+        if (!m_started) return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+        if (data == nullptr) return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+        if (size == 0) return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        if (size > max_message()) return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+
+        const auto need = static_cast<std::uint32_t>(mcast::msg_len_size + size);
+        if (m_pending_count != 0 &&
+            (mcast::header_size + m_pending_bytes + need > m_cfg.mtu || m_pending_count == UINT16_MAX)) {
+            const auto r = flush();
+            if (!r.ok()) return r;
+        }
+
+        std::byte* out = slot(m_head) + mcast::header_size + m_pending_bytes;
+        put_be16(out, static_cast<std::uint16_t>(size));
+        std::memcpy(out + mcast::msg_len_size, data, size);
+        m_pending_bytes += need;
+        ++m_pending_count;
+        ++m_next_seq;
+
+        if (!m_cfg.batch) {
+            const auto r = flush();
+            if (!r.ok()) return r;
+        }
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<std::int32_t>(size) };
+    }
+
+    SockResult ReliableMcastPublisher::flush() noexcept {
+        if (!m_started) return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+        if (m_pending_count == 0) return SockResult{ SockErr::None, SockOp::Send, 0, 0 };
+
+        mcast::Header h{};
+        h.kind = mcast::Kind::Data;
+        h.count = static_cast<std::uint16_t>(m_pending_count);
+        h.session = m_session;
+        h.first_seq = m_next_seq - m_pending_count;
+        h.end_seq = m_next_seq;
+
+        std::byte* packet = slot(m_head);
+        mcast::write_header(packet, h);
+        const auto bytes = static_cast<std::uint32_t>(mcast::header_size) + m_pending_bytes;
+        const auto r = m_mcast.send_broadcast(packet, bytes);
+
+        // kept even when the send failed, to subscribers that is just a gap
+        {
+            std::lock_guard<std::mutex> lock(m_ring_mtx);
+            m_meta[static_cast<std::size_t>(m_head) & m_mask] = SlotMeta{ h.first_seq, h.count, bytes };
+            ++m_head;
+            if (m_head - m_tail > m_mask) ++m_tail; // keep the slot at m_head free for the next packet
+        }
+
+        ++m_packets;
+        m_messages += m_pending_count;
+        m_pending_count = 0;
+        m_pending_bytes = 0;
+        return r;
+    }
+
+    SockResult ReliableMcastPublisher::heartbeat() noexcept {
+        const auto r = flush();
+        if (!r.ok()) return r;
+
+        mcast::Header h{};
+        h.kind = mcast::Kind::Heartbeat;
+        h.session = m_session;
+        h.first_seq = m_next_seq;
+        h.end_seq = m_next_seq;
+
+        std::byte packet[mcast::header_size];
+        mcast::write_header(packet, h);
+        ++m_heartbeats;
+        return m_mcast.send_broadcast(packet, sizeof(packet));
+    }
+
+    ReliableMcastPublisherStats ReliableMcastPublisher::stats() const noexcept {
+        ReliableMcastPublisherStats out{};
+        out.messages = m_messages;
+        out.packets = m_packets;
+        out.heartbeats = m_heartbeats;
+        out.naks = m_naks.load(std::memory_order_relaxed);
+        out.retransmitted = m_retransmitted.load(std::memory_order_relaxed);
+        out.unrecoverable = m_unrecoverable.load(std::memory_order_relaxed);
+        return out;
+    }
+
+    void ReliableMcastPublisher::accept_loop() noexcept {
+        ReactorEvent events[4];
+        while (!m_stop.load(std::memory_order_acquire)) {
+            const auto pr = m_reactor.poll(events, 4, -1);
+            if (!pr.ok()) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(m_sessions_mtx);
+
+            // reap subscribers that went away
+            for (std::size_t i = 0; i < m_sessions.size();) {
+                if (m_sessions[i]->done.load(std::memory_order_acquire)) {
+                    m_sessions[i]->thread.join();
+                    m_sessions[i] = std::move(m_sessions.back());
+                    m_sessions.pop_back();
+                } else {
+                    ++i;
+                }
+            }
+
+            // edge triggered, drain the backlog until WouldBlock
+            while (!m_stop.load(std::memory_order_acquire)) {
+                std::unique_ptr<Session> s(new (std::nothrow) Session{});
+                if (s == nullptr) break;
+
+                const auto ar = m_server.accept_into(s->client);
+                if (!ar.ok()) {
+                    if (!detail::accept_retry(ar)) break;
+                    continue;
+                }
+
+                TcpSocketOptions opts{};
+                opts.no_delay = true;
+                if (!s->client.set_nonblocking(false).ok() || !s->client.apply_options(opts).ok()) continue;
+
+                Session& ref = *s;
+                ref.thread = std::thread([this, &ref]() noexcept { serve(ref); });
+                m_sessions.push_back(std::move(s));
+            }
+        }
+    }
+
+    void ReliableMcastPublisher::serve(Session& s) noexcept {
+        FramedConfig fc{};
+        fc.segment_size = 4096;     // naks are tiny
+        fc.segment_count = 4;
+        fc.coalesce_bytes = 64 * 1024;
+        FramedStream stream(s.client, fc);
+
+        while (stream.is_valid() && !m_stop.load(std::memory_order_acquire)) {
+            mcast::Header h{};
+            {
+                Frame f;
+                if (!stream.read_frame(f).ok()) break;
+                if (!mcast::read_header(f.data(), f.size(), h) || h.kind != mcast::Kind::Nak) continue;
+            }
+
+            m_naks.fetch_add(1, std::memory_order_relaxed);
+            if (!answer_nak(stream, h.first_seq, h.end_seq).ok()) break;
+        }
+
+        s.done.store(true, std::memory_order_release);
+    }
+
+    SockResult ReliableMcastPublisher::answer_nak(FramedStream& stream, std::uint64_t from, std::uint64_t to) noexcept {
+        std::unique_ptr<std::byte[]> buf(new (std::nothrow) std::byte[m_cfg.mtu]);
+        if (buf == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Send, 0, 0 };
+
+        mcast::Header ctl{};
+        ctl.session = m_session;
+        std::byte ctl_buf[mcast::header_size];
+
+        auto seq = from;
+        while (seq < to) {
+            SlotMeta meta{};
+            bool found = false;
+            bool published = false;
+            std::uint64_t oldest = to;
+            {
+                // the packet holding seq is the last one starting at or before it,
+                // copied out so the publisher is not held up by the send
+                std::lock_guard<std::mutex> lock(m_ring_mtx);
+                if (m_tail != m_head) {
+                    oldest = m_meta[static_cast<std::size_t>(m_tail) & m_mask].first_seq;
+                    const auto& newest = m_meta[static_cast<std::size_t>(m_head - 1) & m_mask];
+                    published = seq < newest.first_seq + newest.count;
+
+                    auto lo = m_tail;
+                    auto hi = m_head;
+                    while (lo < hi) {
+                        const auto mid = lo + (hi - lo) / 2;
+                        if (m_meta[static_cast<std::size_t>(mid) & m_mask].first_seq <= seq) lo = mid + 1;
+                        else hi = mid;
+                    }
+                    if (lo != m_tail) {
+                        meta = m_meta[static_cast<std::size_t>(lo - 1) & m_mask];
+                        if (seq < meta.first_seq + meta.count) {
+                            std::memcpy(buf.get(), slot(lo - 1), meta.bytes);
+                            found = true;
+                        }
+                    }
+                }
+            }
+
+            if (!found) {
+                if (!published && seq >= oldest) break; // not sent yet, nothing more to give
+
+                // already pushed out of the ring
+                const auto lost_end = oldest > seq && oldest < to ? oldest : to;
+                m_unrecoverable.fetch_add(lost_end - seq, std::memory_order_relaxed);
+                ctl.kind = mcast::Kind::Lost;
+                ctl.first_seq = seq;
+                ctl.end_seq = lost_end;
+                mcast::write_header(ctl_buf, ctl);
+                const auto r = stream.write_frame(ctl_buf, sizeof(ctl_buf));
+                if (!r.ok()) return r;
+                seq = lost_end;
+                continue;
+            }
+
+            const auto r = stream.write_frame(buf.get(), meta.bytes);
+            if (!r.ok()) return r;
+            m_retransmitted.fetch_add(1, std::memory_order_relaxed);
+            seq = meta.first_seq + meta.count;
+        }
+
+        ctl.kind = mcast::Kind::End;
+        ctl.first_seq = from;
+        ctl.end_seq = to;
+        mcast::write_header(ctl_buf, ctl);
+        const auto r = stream.write_frame(ctl_buf, sizeof(ctl_buf));
+        if (!r.ok()) return r;
+        return stream.flush();
+    }
+
+    ReliableMcastSubscriber::ReliableMcastSubscriber(const ReliableMcastSubscriberConfig& cfg) : m_cfg(cfg) {
+        if (m_cfg.mtu <= mcast::header_size || m_cfg.mtu > 65507) return;
+        m_buf.reset(new (std::nothrow) std::byte[m_cfg.mtu]);
+    }
+
+    ReliableMcastSubscriber::~ReliableMcastSubscriber() {
+        close();
+    }
+
+    SockResult ReliableMcastSubscriber::open() {
+        if (m_buf == nullptr) return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+        m_expected = 0;
+        m_session = 0;
+        return m_mcast.open_and_join(m_cfg.mcast);
+    }
+
+    void ReliableMcastSubscriber::close() noexcept {
+        m_stream.reset();
+        m_tcp.disconnect();
+        m_mcast.close();
+    }
+
+    SockResult ReliableMcastSubscriber::poll(MessageFn fn, void* ctx) {
+        if (fn == nullptr || m_buf == nullptr) return SockResult{ SockErr::InvalidArgument, SockOp::Recv, 0, 0 };
+
+        auto r = m_mcast.recv_broadcast(m_buf.get(), m_cfg.mtu);
+        if (!r.ok()) return r;
+
+        const auto size = static_cast<std::size_t>(r.bytes);
+        r.bytes = 0;
+
+        mcast::Header h{};
+        if (!mcast::read_header(m_buf.get(), size, h) ||
+            (h.kind != mcast::Kind::Data && h.kind != mcast::Kind::Heartbeat)) {
+            ++m_stats.malformed;
+            return r;
+        }
+        ++m_stats.packets;
+
+        // first packet, or the publisher restarted and numbers from 1 again.
+        // its retransmit ring is new too so the old connection is useless
+        if (m_expected == 0 || h.session != m_session) {
+            if (m_expected != 0) {
+                ++m_stats.resets;
+                m_stream.reset();
+                m_tcp.disconnect();
+            }
+            m_session = h.session;
+            m_expected = h.first_seq;
+        }
+
+        const auto before = m_stats.delivered;
+        if (h.first_seq > m_expected) {
+            ++m_stats.gaps;
+            recover(h.first_seq, fn, ctx);
+        }
+        if (h.kind == mcast::Kind::Data) {
+            deliver(h, m_buf.get() + mcast::header_size, size - mcast::header_size, fn, ctx, false);
+        }
+
+        r.bytes = static_cast<std::int32_t>(m_stats.delivered - before);
+        return r;
+    }
+
+    void ReliableMcastSubscriber::lose(std::uint64_t from, std::uint64_t to) noexcept {
+        if (to <= from) return;
+        m_stats.lost += to - from;
+        m_expected = to;
+        if (m_cfg.on_loss) m_cfg.on_loss(from, to);
+    }
+
+    void ReliableMcastSubscriber::deliver(const mcast::Header& h, const std::byte* body, std::size_t size, MessageFn fn, void* ctx, bool recovered) {
+        auto seq = h.first_seq;
+        std::size_t off = 0;
+        for (std::uint32_t i = 0; i < h.count; ++i, ++seq) {
+            if (off + mcast::msg_len_size > size) {
+                ++m_stats.malformed;
+                return;
+            }
+            const auto len = get_be16(body + off);
+            off += mcast::msg_len_size;
+            if (off + len > size) {
+                ++m_stats.malformed;
+                return;
+            }
+
+            if (seq < m_expected) {
+                ++m_stats.duplicates;
+            } else {
+                if (seq > m_expected) lose(m_expected, seq); // recovery gave up part way
+                fn(ctx, seq, body + off, len);
+                m_expected = seq + 1;
+                ++m_stats.delivered;
+                if (recovered) ++m_stats.recovered;
+            }
+            off += len;
+        }
+    }
+
+    bool ReliableMcastSubscriber::connect_retransmit() noexcept {
+        if (m_stream != nullptr) return true;
+
+        m_tcp.disconnect();
+        if (!m_tcp.open_and_connect(m_cfg.retransmit_ip.c_str(), m_cfg.retransmit_port).ok()) {
+            m_tcp.disconnect();
+            return false;
+        }
+
+        // poll() must not hang on a publisher that stopped answering
+        TcpSocketOptions opts{};
+        opts.no_delay = true;
+        opts.recv_timeout_ms = static_cast<std::int32_t>(m_cfg.recover_timeout_ms);
+        if (!m_tcp.apply_options(opts).ok()) {
+            m_tcp.disconnect();
+            return false;
+        }
+
+        FramedConfig fc{};
+        const auto frame = m_cfg.mtu + FramedStream::header_size;
+        fc.segment_size = frame > fc.segment_size ? frame : fc.segment_size;
+        fc.coalesce_bytes = 1024;   // only naks go out
+        m_stream.reset(new (std::nothrow) FramedStream(m_tcp, fc));
+        if (m_stream == nullptr || !m_stream->is_valid()) {
+            m_stream.reset();
+            m_tcp.disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    void ReliableMcastSubscriber::recover(std::uint64_t to, MessageFn fn, void* ctx) {
+        if (!m_cfg.recover || !connect_retransmit()) {
+            lose(m_expected, to);
+            return;
+        }
+
+        mcast::Header nak{};
+        nak.kind = mcast::Kind::Nak;
+        nak.session = m_session;
+        nak.first_seq = m_expected;
+        nak.end_seq = to;
+
+        std::byte buf[mcast::header_size];
+        mcast::write_header(buf, nak);
+        auto r = m_stream->write_frame(buf, sizeof(buf));
+        if (r.ok()) r = m_stream->flush();
+
+        // the recv timeout bounds each read, the deadline a publisher trickling frames
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_cfg.recover_timeout_ms);
+        while (r.ok() && std::chrono::steady_clock::now() < deadline) {
+            Frame f;
+            r = m_stream->read_frame(f);
+            if (!r.ok()) break;
+
+            mcast::Header h{};
+            if (!mcast::read_header(f.data(), f.size(), h) || h.session != m_session) {
+                ++m_stats.malformed;
+                continue;
+            }
+
+            switch (h.kind) {
+                case mcast::Kind::Data:
+                    deliver(h, f.data() + mcast::header_size, f.size() - mcast::header_size, fn, ctx, true);
+                    break;
+                case mcast::Kind::Lost:
+                    if (h.end_seq > m_expected) lose(m_expected, h.end_seq);
+                    break;
+                case mcast::Kind::End:
+                    lose(m_expected, to); // whatever the publisher did not have
+                    return;
+                default:
+                    ++m_stats.malformed;
+                    break;
+            }
+        }
+
+        // connection failed or timed out mid recovery, reconnect on the next gap
+        m_stream.reset();
+        m_tcp.disconnect();
+        lose(m_expected, to);
+    }
+}
@@ -0,0 +1,244 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "socket_result.h"
+#include "tcp_socket.h"
+#include "udp_multicast.h"
+#include "framing.h"
+#include "reactor.h"
+
+namespace sock {
+    // wire format shared by the publisher and subscriber, every field big endian.
+    // A data packet is the header followed by count messages, each a 2 byte
+    // length then its bytes. Messages are numbered, not packets, so batching
+    // and retransmit work on the same sequence space
+    namespace mcast {
+        constexpr std::uint32_t magic = 0x4D4F4F52; // "MOOR"
+        constexpr std::uint8_t version = 1;
+        constexpr std::size_t header_size = 32;
+        constexpr std::size_t msg_len_size = 2;
+
+        enum class Kind : std::uint8_t {
+            Data = 1,       // [first_seq, first_seq + count)
+            Heartbeat = 2,  // nothing, first_seq = next seq to be published
+            Nak = 3,        // subscriber -> publisher, resend [first_seq, end_seq)
+            Lost = 4,       // publisher -> subscriber, [first_seq, end_seq) is gone
+            End = 5,        // publisher -> subscriber, a Nak has been fully answered
+        };
+
+        struct Header {
+            Kind kind = Kind::Data;
+            std::uint16_t count = 0;
+            std::uint32_t session = 0;  // random per publisher start
+            std::uint64_t first_seq = 0;
+            std::uint64_t end_seq = 0;
+        };
+
+        void write_header(std::byte* out, const Header& h) noexcept;
+        // false when out is too short or not one of ours
+        [[nodiscard]] bool read_header(const std::byte* in, std::size_t size, Header& out) noexcept;
+    }
+
+    struct ReliableMcastPublisherConfig {
+        UdpMcastConfig mcast{};
+        std::string retransmit_ip = "0.0.0.0";  // tcp NAK channel bind address
+        std::uint16_t retransmit_port = 30002;
+        std::uint32_t mtu = 1472;               // largest datagram, 1500 - ip - udp headers
+        std::uint32_t retransmit_packets = 4096; // packets kept for NAKs, power of 2
+        bool batch = true;                      // false = every publish() is sent at once
+    };
+
+    struct ReliableMcastPublisherStats {
+        std::uint64_t messages = 0;
+        std::uint64_t packets = 0;
+        std::uint64_t heartbeats = 0;
+        std::uint64_t naks = 0;                 // retransmit requests served
+        std::uint64_t retransmitted = 0;        // packets resent over tcp
+        std::uint64_t unrecoverable = 0;        // messages asked for after they left the ring
+    };
+
+    // Sequenced multicast sender. Messages are batched into MTU sized
+    // datagrams, every datagram sent is also kept in a bounded ring so a
+    // subscriber that saw a gap can ask for just the missing messages over
+    // the tcp retransmit channel instead of resyncing from a snapshot.
+    // Packets are built in place in the ring slot they are kept in, so
+    // keeping them costs no copy. A background thread accepts subscribers
+    // and a thread per connected subscriber answers its NAKs.
+    // NOTE: publish/flush/heartbeat from one thread only
+    // NOTE: batched messages sit in the pending packet until flush(), or
+    // until the next one does not fit
+    class ReliableMcastPublisher {
+        private:
+            struct SlotMeta {
+                std::uint64_t first_seq = 0;
+                std::uint32_t count = 0;
+                std::uint32_t bytes = 0;
+            };
+
+            struct Session {
+                TCPClient client;
+                std::thread thread;
+                std::atomic<bool> done{false};
+            };
+
+            ReliableMcastPublisherConfig m_cfg{};
+            UDPMulticastSocket m_mcast;
+            std::uint32_t m_session = 0;
+
+            // ring of sent packets, [m_tail, m_head) are kept. The slot at
+            // m_head is the packet being built and never visible to NAKs
+            std::unique_ptr<std::byte[]> m_ring{};
+            std::unique_ptr<SlotMeta[]> m_meta{};
+            std::uint64_t m_head = 0;
+            std::uint64_t m_tail = 0;
+            std::size_t m_mask = 0;
+            mutable std::mutex m_ring_mtx;
+
+            // publisher thread only
+            std::uint64_t m_next_seq = 1;
+            std::uint32_t m_pending_count = 0;
+            std::uint32_t m_pending_bytes = 0;
+
+            TCPServer m_server;
+            Reactor m_reactor;
+            std::thread m_accept_thread{};
+            std::mutex m_sessions_mtx;
+            std::vector<std::unique_ptr<Session>> m_sessions{};
+            std::atomic<bool> m_stop{false};
+            bool m_started = false;
+
+            std::uint64_t m_messages = 0;
+            std::uint64_t m_packets = 0;
+            std::uint64_t m_heartbeats = 0;
+            std::atomic<std::uint64_t> m_naks{0};
+            std::atomic<std::uint64_t> m_retransmitted{0};
+            std::atomic<std::uint64_t> m_unrecoverable{0};
+
+            std::byte* slot(std::uint64_t i) const noexcept { return m_ring.get() + (static_cast<std::size_t>(i) & m_mask) * m_cfg.mtu; }
+
+            void accept_loop() noexcept;
+            void serve(Session& s) noexcept;
+            [[nodiscard]] SockResult answer_nak(FramedStream& stream, std::uint64_t from, std::uint64_t to) noexcept;
+
+        public:
+            explicit ReliableMcastPublisher(const ReliableMcastPublisherConfig& cfg = ReliableMcastPublisherConfig{});
+            ~ReliableMcastPublisher();
+
+            ReliableMcastPublisher(const ReliableMcastPublisher&) = delete;
+            ReliableMcastPublisher& operator=(const ReliableMcastPublisher&) = delete;
+            ReliableMcastPublisher(ReliableMcastPublisher&&) = delete;
+            ReliableMcastPublisher& operator=(ReliableMcastPublisher&&) = delete;
+
+            // joins the group, opens the retransmit listener and starts its thread
+            [[nodiscard]] SockResult start();
+            // flushes nothing, pending messages are dropped. Joins every thread
+            void stop() noexcept;
+
+            // queues one message, sending the pending packet first when it would
+            // not fit. SizeTooLarge when size > max_message()
+            [[nodiscard]] SockResult publish(const void* data, std::size_t size) noexcept;
+            // sends the pending packet, no-op when nothing is pending
+            [[nodiscard]] SockResult flush() noexcept;
+            // flushes, then sends an empty packet carrying the next sequence so
+            // subscribers notice a lost tail while the feed is quiet
+            [[nodiscard]] SockResult heartbeat() noexcept;
+
+            [[nodiscard]] std::size_t max_message() const noexcept {
+                return m_cfg.mtu > mcast::header_size + mcast::msg_len_size ? m_cfg.mtu - mcast::header_size - mcast::msg_len_size : 0;
+            }
+            [[nodiscard]] std::uint64_t next_seq() const noexcept { return m_next_seq; }
+            [[nodiscard]] std::uint32_t session() const noexcept { return m_session; }
+            [[nodiscard]] ReliableMcastPublisherStats stats() const noexcept;
+    };
+
+    struct ReliableMcastSubscriberConfig {
+        UdpMcastConfig mcast{};
+        std::string retransmit_ip = "127.0.0.1"; // publisher host
+        std::uint16_t retransmit_port = 30002;
+        std::uint32_t mtu = 1472;               // must be >= the publishers
+        bool recover = true;                    // false = report gaps as lost without asking
+        std::uint32_t recover_timeout_ms = 500; // > 0, a recovery still short after this is reported lost
+        // called when messages [from, to) can not be recovered, they are skipped
+        std::function<void(std::uint64_t from, std::uint64_t to)> on_loss{};
+    };
+
+    struct ReliableMcastSubscriberStats {
+        std::uint64_t packets = 0;
+        std::uint64_t delivered = 0;
+        std::uint64_t duplicates = 0;           // messages seen twice and dropped
+        std::uint64_t gaps = 0;
+        std::uint64_t recovered = 0;            // messages filled in over tcp
+        std::uint64_t lost = 0;
+        std::uint64_t resets = 0;               // publisher restarted, sequence started over
+        std::uint64_t malformed = 0;
+    };
+
+    // Receiving side of ReliableMcastPublisher. poll() reads one datagram
+    // and hands its messages to the callback strictly in sequence order. When
+    // a packet (or heartbeat) shows messages were skipped, poll() asks the
+    // publisher for that range over tcp right away, delivers what comes
+    // back, then carries on with the packet that showed the gap, so only the
+    // dropped messages cross the wire again. The tcp channel is connected
+    // lazily on the first gap, a recovery that takes longer than
+    // recover_timeout_ms reports the rest lost and drops it. Joining late
+    // starts at whatever arrives first.
+    // NOTE: one thread calls poll(), the callback runs on it
+    class ReliableMcastSubscriber {
+        public:
+            using MessageFn = void (*)(void* ctx, std::uint64_t seq, const std::byte* data, std::size_t size);
+
+        private:
+            ReliableMcastSubscriberConfig m_cfg{};
+            UDPMulticastSocket m_mcast;
+            TCPClient m_tcp;
+            std::unique_ptr<FramedStream> m_stream{};
+            std::unique_ptr<std::byte[]> m_buf{};
+            std::uint64_t m_expected = 0;   // 0 = nothing seen yet
+            std::uint32_t m_session = 0;
+            ReliableMcastSubscriberStats m_stats{};
+
+            template <typename Fn>
+            static void thunk(void* ctx, std::uint64_t seq, const std::byte* data, std::size_t size) {
+                (*static_cast<Fn*>(ctx))(seq, data, size);
+            }
+
+            void lose(std::uint64_t from, std::uint64_t to) noexcept;
+            void deliver(const mcast::Header& h, const std::byte* body, std::size_t size, MessageFn fn, void* ctx, bool recovered);
+            void recover(std::uint64_t to, MessageFn fn, void* ctx);
+            [[nodiscard]] bool connect_retransmit() noexcept;
+
+        public:
+            explicit ReliableMcastSubscriber(const ReliableMcastSubscriberConfig& cfg = ReliableMcastSubscriberConfig{});
+            ~ReliableMcastSubscriber();
+
+            ReliableMcastSubscriber(const ReliableMcastSubscriber&) = delete;
+            ReliableMcastSubscriber& operator=(const ReliableMcastSubscriber&) = delete;
+            ReliableMcastSubscriber(ReliableMcastSubscriber&&) = delete;
+            ReliableMcastSubscriber& operator=(ReliableMcastSubscriber&&) = delete;
+
+            [[nodiscard]] SockResult open();
+            void close() noexcept;
+
+            // blocks for one datagram, bytes = messages delivered (recovered included)
+            [[nodiscard]] SockResult poll(MessageFn fn, void* ctx);
+
+            // fn(std::uint64_t seq, const std::byte* data, std::size_t size)
+            template <typename Fn>
+            [[nodiscard]] SockResult poll(Fn&& fn) {
+                using F = std::remove_reference_t<Fn>;
+                return poll(&thunk<F>, const_cast<void*>(static_cast<const void*>(&fn)));
+            }
+
+            // next sequence poll() will deliver, 0 before the first packet
+            [[nodiscard]] std::uint64_t expected_seq() const noexcept { return m_expected; }
+            [[nodiscard]] const ReliableMcastSubscriberStats& stats() const noexcept { return m_stats; }
+    };
+}
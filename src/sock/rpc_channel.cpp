@@ -0,0 +1,407 @@
+#include "sock/rpc_channel.h"
+#include <chrono>
+#include <new>
+
+namespace sock {
+    namespace {
+        // request id: slot generation << 32 | connection << 24 | slot
+        std::uint64_t make_id(std::uint32_t gen, std::uint32_t conn, std::uint32_t slot) noexcept {
+            return (static_cast<std::uint64_t>(gen) << 32) | (static_cast<std::uint64_t>(conn) << 24) | slot;
+        }
+
+        std::uint32_t id_gen(std::uint64_t id) noexcept { return static_cast<std::uint32_t>(id >> 32); }
+        std::uint32_t id_conn(std::uint64_t id) noexcept { return static_cast<std::uint32_t>(id >> 24) & 0xFFu; }
+        std::uint32_t id_slot(std::uint64_t id) noexcept { return static_cast<std::uint32_t>(id) & 0xFFFFFFu; }
+
+        std::uint64_t next_rand(std::uint64_t& state) noexcept {
+            // splitmix64
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // blocking call() parks on one of these until the reader fills it
+        struct SyncCall {
+            std::mutex mtx;
+            std::condition_variable cv;
+            bool done = false;
+            SockResult result{};
+            std::vector<std::byte>* out = nullptr;
+
+            static void on_response(void* ctx, const SockResult& result, const std::byte* data, std::size_t size) {
+                auto& call = *static_cast<SyncCall*>(ctx);
+                std::lock_guard<std::mutex> lock(call.mtx);
+                call.result = result;
+                if (result.ok()) call.out->assign(data, data + size);
+                call.done = true;
+                call.cv.notify_one();
+            }
+        };
+    }
+
+    namespace rpc {
+        void write_id(std::byte* out, std::uint64_t id) noexcept {
+            for (std::size_t i = 0; i < id_size; ++i) {
+                out[i] = static_cast<std::byte>(id >> (8 * (id_size - 1 - i)));
+            }
+        }
+
+        std::uint64_t read_id(const std::byte* in) noexcept {
+            std::uint64_t id = 0;
+            for (std::size_t i = 0; i < id_size; ++i) {
+                id = (id << 8) | static_cast<std::uint64_t>(in[i]);
+            }
+            return id;
+        }
+    }
+
+    RpcChannel::RpcChannel(const RpcChannelConfig& cfg) : m_cfg(cfg) {}
+
+    RpcChannel::~RpcChannel() {
+        close();
+    }
+
+    SockResult RpcChannel::open() {
+        if (m_open) return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+
+        if (m_cfg.connections == 0 || m_cfg.connections > max_connections ||
+            m_cfg.max_in_flight == 0 || m_cfg.max_in_flight > max_slots ||
+            m_cfg.port == 0 || m_cfg.reconnect_min_ms == 0 || m_cfg.reconnect_max_ms < m_cfg.reconnect_min_ms) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 };
+        }
+
+        m_stop.store(false, std::memory_order_relaxed);
+        m_conns.clear();
+        m_conns.reserve(m_cfg.connections);
+        const auto seed = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+        for (std::uint32_t i = 0; i < m_cfg.connections; ++i) {
+            std::unique_ptr<Connection> c(new (std::nothrow) Connection());
+            if (c == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Open, 0, 0 };
+
+            c->index = i;
+            c->rng = seed ^ (static_cast<std::uint64_t>(i) << 48);
+            c->slots.reset(new (std::nothrow) Slot[m_cfg.max_in_flight]);
+            if (c->slots == nullptr) return SockResult{ SockErr::ResourceExhausted, SockOp::Open, 0, 0 };
+
+            // handed out lowest first so a lightly loaded channel stays in a few cache lines
+            c->free.reserve(m_cfg.max_in_flight);
+            for (std::uint32_t s = m_cfg.max_in_flight; s > 0; --s) c->free.push_back(s - 1);
+            m_conns.push_back(std::move(c));
+        }
+
+        for (auto& c : m_conns) (void)connect(*c);
+        for (auto& c : m_conns) {
+            Connection& ref = *c;
+            ref.thread = std::thread([this, &ref]() noexcept { run(ref); });
+        }
+
+        m_open = true;
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void RpcChannel::close() noexcept {
+        if (!m_open) return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_stop_mtx);
+            m_stop.store(true, std::memory_order_release);
+        }
+        m_stop_cv.notify_all();
+
+        // shutdown wakes a reader blocked in recv, the socket is only closed
+        // by the reader itself. Under send_mtx so it never meets the reader
+        // swapping the socket, a connect after this sees m_stop and gives up
+        for (auto& c : m_conns) {
+            std::lock_guard<std::mutex> lock(c->send_mtx);
+            c->client.shutdown();
+        }
+        for (auto& c : m_conns) {
+            if (c->thread.joinable()) c->thread.join();
+        }
+
+        m_conns.clear();
+        m_open = false;
+    }
+
+    bool RpcChannel::connect(Connection& c) noexcept {
+        {
+            // every change to the socket happens under send_mtx, close()
+            // shuts it down under the same lock. Only senders that raced a
+            // drop wait here, the rest skip connections that are not up
+            std::lock_guard<std::mutex> lock(c.send_mtx);
+            if (m_stop.load(std::memory_order_acquire)) return false;
+
+            c.client.disconnect();
+            if (!c.client.open_and_connect(m_cfg.ip.c_str(), m_cfg.port).ok()) {
+                c.client.disconnect();
+                return false;
+            }
+
+            TcpSocketOptions opts{};
+            opts.no_delay = m_cfg.no_delay;
+            (void)c.client.apply_options(opts);
+
+            std::unique_ptr<FramedStream> stream(new (std::nothrow) FramedStream(c.client, m_cfg.framing));
+            if (stream == nullptr || !stream->is_valid()) {
+                c.client.disconnect();
+                return false;
+            }
+            c.stream = std::move(stream);
+        }
+        c.up.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void RpcChannel::drop(Connection& c) noexcept {
+        c.up.store(false, std::memory_order_release);
+        {
+            // senders hold send_mtx for as long as they touch the socket, so
+            // it is never closed (and its handle reused) under one
+            std::lock_guard<std::mutex> lock(c.send_mtx);
+            c.stream.reset();
+            c.client.disconnect();
+        }
+        fail_all(c, m_stop.load(std::memory_order_acquire) ? SockErr::Shutdown : SockErr::Closed);
+    }
+
+    void RpcChannel::run(Connection& c) noexcept {
+        auto backoff = m_cfg.reconnect_min_ms;
+
+        while (!m_stop.load(std::memory_order_acquire)) {
+            if (!c.up.load(std::memory_order_acquire)) {
+                if (!connect(c)) {
+                    // +-25% so a fleet of clients does not come back in lockstep
+                    const auto quarter = backoff / 4;
+                    const auto wait = backoff - quarter + static_cast<std::uint32_t>(next_rand(c.rng) % (2 * static_cast<std::uint64_t>(quarter) + 1));
+                    std::unique_lock<std::mutex> lock(m_stop_mtx);
+                    m_stop_cv.wait_for(lock, std::chrono::milliseconds(wait), [this] { return m_stop.load(std::memory_order_acquire); });
+                    backoff = backoff > m_cfg.reconnect_max_ms / 2 ? m_cfg.reconnect_max_ms : backoff * 2;
+                    continue;
+                }
+                m_reconnects.fetch_add(1, std::memory_order_relaxed);
+            }
+            backoff = m_cfg.reconnect_min_ms;
+
+            {
+                // a close() whose shutdown already went by would never wake
+                // this read, it set m_stop before taking the lock
+                std::lock_guard<std::mutex> lock(c.send_mtx);
+                if (m_stop.load(std::memory_order_acquire)) break;
+            }
+
+            // the reader owns the read side of the stream, only it swaps the pointer
+            FramedStream& stream = *c.stream;
+            for (;;) {
+                Frame f;
+                if (!stream.read_frame(f).ok()) break;
+                if (f.size() < rpc::id_size) {
+                    m_stale.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                complete(c, rpc::read_id(f.data()), f.data() + rpc::id_size, f.size() - rpc::id_size);
+            }
+            drop(c);
+        }
+
+        drop(c);
+    }
+
+    SockResult RpcChannel::send(Connection& c, std::uint64_t id, const void* data, std::size_t size) noexcept {
+        std::byte head[rpc::id_size];
+        rpc::write_id(head, id);
+
+        c.senders.fetch_add(1, std::memory_order_acq_rel);
+        std::lock_guard<std::mutex> lock(c.send_mtx);
+
+        SockResult r{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        if (c.stream != nullptr) r = c.stream->write_frame(head, rpc::id_size, data, size);
+
+        // whoever queued last flushes everything the others queued before it
+        if (c.senders.fetch_sub(1, std::memory_order_acq_rel) == 1 && c.stream != nullptr) {
+            const auto f = c.stream->flush();
+            if (r.ok() && !f.ok()) r = f;
+        }
+
+        // a broken socket gets cycled by the reader, shutdown makes sure it notices
+        if (!r.ok() && r.code != SockErr::SizeTooLarge && c.stream != nullptr) c.client.shutdown();
+        return r;
+    }
+
+    SockResult RpcChannel::submit(const void* data, std::size_t size, ResponseFn fn, void* ctx, Connection*& conn, std::uint64_t& id) noexcept {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+        if (fn == nullptr || (data == nullptr && size != 0)) return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+
+        // least loaded connection that is up, starting somewhere new each call so ties spread
+        const auto n = static_cast<std::uint32_t>(m_conns.size());
+        const auto start = m_next.fetch_add(1, std::memory_order_relaxed);
+        Connection* best = nullptr;
+        std::uint32_t best_load = UINT32_MAX;
+        bool any_up = false;
+        for (std::uint32_t i = 0; i < n; ++i) {
+            auto& c = *m_conns[(start + i) % n];
+            if (!c.up.load(std::memory_order_acquire)) continue;
+            any_up = true;
+            const auto load = c.in_flight.load(std::memory_order_relaxed);
+            if (load < m_cfg.max_in_flight && load < best_load) {
+                best = &c;
+                best_load = load;
+            }
+        }
+        if (best == nullptr) {
+            return SockResult{ any_up ? SockErr::ResourceExhausted : SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(best->slot_mtx);
+            if (best->free.empty()) return SockResult{ SockErr::ResourceExhausted, SockOp::Send, 0, 0 };
+            const auto s = best->free.back();
+            best->free.pop_back();
+            auto& slot = best->slots[s];
+            slot.fn = fn;
+            slot.ctx = ctx;
+            id = make_id(slot.gen, best->index, s);
+            best->in_flight.fetch_add(1, std::memory_order_relaxed);
+        }
+        conn = best;
+
+        const auto r = send(*best, id, data, size);
+        if (!r.ok() && cancel(*best, id)) return r;
+
+        // sent, or the reader already failed the slot and fn has its answer
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<std::int32_t>(size) };
+    }
+
+    SockResult RpcChannel::call_async(const void* data, std::size_t size, ResponseFn fn, void* ctx) noexcept {
+        Connection* conn = nullptr;
+        std::uint64_t id = 0;
+        return submit(data, size, fn, ctx, conn, id);
+    }
+
+    SockResult RpcChannel::call(const void* data, std::size_t size, std::vector<std::byte>& response, std::uint32_t timeout_ms) {
+        SyncCall sync{};
+        sync.out = &response;
+
+        Connection* conn = nullptr;
+        std::uint64_t id = 0;
+        const auto r = submit(data, size, &SyncCall::on_response, &sync, conn, id);
+        if (!r.ok()) return r;
+
+        std::unique_lock<std::mutex> lock(sync.mtx);
+        if (timeout_ms == 0) {
+            sync.cv.wait(lock, [&sync] { return sync.done; });
+            return sync.result;
+        }
+
+        if (sync.cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&sync] { return sync.done; })) {
+            return sync.result;
+        }
+
+        lock.unlock();
+        if (cancel(*conn, id)) return SockResult{ SockErr::TimedOut, SockOp::Recv, 0, 0 };
+
+        // the reader took the slot already, sync lives on this stack so wait it out
+        lock.lock();
+        sync.cv.wait(lock, [&sync] { return sync.done; });
+        return sync.result;
+    }
+
+    bool RpcChannel::cancel(Connection& c, std::uint64_t id) noexcept {
+        const auto s = id_slot(id);
+        std::lock_guard<std::mutex> lock(c.slot_mtx);
+        auto& slot = c.slots[s];
+        if (slot.fn == nullptr || slot.gen != id_gen(id)) return false;
+
+        slot.fn = nullptr;
+        slot.ctx = nullptr;
+        ++slot.gen;
+        c.free.push_back(s);
+        c.in_flight.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void RpcChannel::complete(Connection& c, std::uint64_t id, const std::byte* data, std::size_t size) noexcept {
+        const auto s = id_slot(id);
+        ResponseFn fn = nullptr;
+        void* ctx = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(c.slot_mtx);
+            if (id_conn(id) == c.index && s < m_cfg.max_in_flight) {
+                auto& slot = c.slots[s];
+                if (slot.fn != nullptr && slot.gen == id_gen(id)) {
+                    fn = slot.fn;
+                    ctx = slot.ctx;
+                    slot.fn = nullptr;
+                    slot.ctx = nullptr;
+                    ++slot.gen;
+                    c.free.push_back(s);
+                    c.in_flight.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        if (fn == nullptr) {
+            m_stale.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_responses.fetch_add(1, std::memory_order_relaxed);
+        fn(ctx, SockResult{ SockErr::None, SockOp::Recv, 0, static_cast<std::int32_t>(size) }, data, size);
+    }
+
+    void RpcChannel::fail_all(Connection& c, SockErr code) noexcept {
+        struct Failed {
+            ResponseFn fn;
+            void* ctx;
+        };
+
+        std::vector<Failed> failed{};
+        {
+            std::lock_guard<std::mutex> lock(c.slot_mtx);
+            const auto used = m_cfg.max_in_flight - static_cast<std::uint32_t>(c.free.size());
+            if (used == 0) return;
+            failed.reserve(used);
+
+            for (std::uint32_t s = 0; s < m_cfg.max_in_flight; ++s) {
+                auto& slot = c.slots[s];
+                if (slot.fn == nullptr) continue;
+                failed.push_back(Failed{ slot.fn, slot.ctx });
+                slot.fn = nullptr;
+                slot.ctx = nullptr;
+                ++slot.gen;
+                c.free.push_back(s);
+            }
+            c.in_flight.store(0, std::memory_order_relaxed);
+        }
+
+        m_failed.fetch_add(failed.size(), std::memory_order_relaxed);
+        const SockResult r{ code, SockOp::Recv, 0, 0 };
+        for (const auto& f : failed) f.fn(f.ctx, r, nullptr, 0);
+    }
+
+    std::uint32_t RpcChannel::connected() const noexcept {
+        std::uint32_t n = 0;
+        for (const auto& c : m_conns) {
+            if (c->up.load(std::memory_order_acquire)) ++n;
+        }
+        return n;
+    }
+
+    std::uint32_t RpcChannel::in_flight() const noexcept {
+        std::uint32_t n = 0;
+        for (const auto& c : m_conns) n += c->in_flight.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    RpcChannelStats RpcChannel::stats() const noexcept {
+        RpcChannelStats s{};
+        s.requests = m_requests.load(std::memory_order_relaxed);
+        s.responses = m_responses.load(std::memory_order_relaxed);
+        s.failed = m_failed.load(std::memory_order_relaxed);
+        s.stale = m_stale.load(std::memory_order_relaxed);
+        s.reconnects = m_reconnects.load(std::memory_order_relaxed);
+        return s;
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "socket_result.h"
+#include "socket_options.h"
+#include "tcp_socket.h"
+#include "framing.h"
+
+namespace sock {
+    // wire format: every request and response is one FramedStream frame whose
+    // payload starts with the 8 byte big endian request id, then the body.
+    // A server answers by echoing the id in front of its response, in any
+    // order and from any number of requests in flight
+    namespace rpc {
+        constexpr std::size_t id_size = 8;
+
+        void write_id(std::byte* out, std::uint64_t id) noexcept;
+        [[nodiscard]] std::uint64_t read_id(const std::byte* in) noexcept;
+    }
+
+    struct RpcChannelConfig {
+        std::string ip = "127.0.0.1";
+        std::uint16_t port = 0;
+        std::uint32_t connections = 4;          // 1 - 256
+        std::uint32_t max_in_flight = 1024;     // per connection, calls past it get ResourceExhausted
+        std::uint32_t reconnect_min_ms = 10;    // first retry after a drop, doubles per failed attempt
+        std::uint32_t reconnect_max_ms = 2000;
+        bool no_delay = true;                   // TCP_NODELAY, requests are flushed as soon as nobody else is sending
+        FramedConfig framing{};                 // responses must fit framing.segment_size
+    };
+
+    struct RpcChannelStats {
+        std::uint64_t requests = 0;
+        std::uint64_t responses = 0;
+        std::uint64_t failed = 0;               // requests failed because their connection dropped
+        std::uint64_t stale = 0;                // responses for unknown, cancelled or timed out ids
+        std::uint64_t reconnects = 0;           // connects made by the reader threads after open()
+    };
+
+    // Client side request/response channel pipelining many requests over a
+    // few TCPClient connections instead of one blocking round trip at a time.
+    // Each request gets an id naming its connection and slot, responses are
+    // matched by it so they may come back in any order. Requests go to the
+    // connected connection with the fewest in flight. Senders that pile up on
+    // a connection are batched, whoever sends last flushes everyone's frames
+    // with one syscall. Every connection has a reader thread that delivers its
+    // responses and reconnects with jittered exponential backoff when it drops,
+    // failing what was in flight on it with Closed.
+    // NOTE: call_async/call are safe from any number of threads, open/close are not
+    // NOTE: callbacks run on the reader threads, keep them short
+    class RpcChannel {
+        public:
+            // result Closed/Shutdown (data null) when the connection dropped or
+            // the channel closed before the response came
+            using ResponseFn = void (*)(void* ctx, const SockResult& result, const std::byte* data, std::size_t size);
+
+        private:
+            static constexpr std::uint32_t max_connections = 256;
+            static constexpr std::uint32_t max_slots = 1u << 24;
+
+            struct Slot {
+                std::uint32_t gen = 0;          // bumped on every free so late responses miss
+                ResponseFn fn = nullptr;
+                void* ctx = nullptr;
+            };
+
+            struct Connection {
+                std::uint32_t index = 0;
+                TCPClient client;
+                std::unique_ptr<FramedStream> stream{};     // swapped by the reader under send_mtx
+                std::mutex send_mtx;
+                std::atomic<std::uint32_t> senders{0};      // waiting for or holding send_mtx
+                std::atomic<bool> up{false};
+
+                std::mutex slot_mtx;
+                std::unique_ptr<Slot[]> slots{};
+                std::vector<std::uint32_t> free{};
+                std::atomic<std::uint32_t> in_flight{0};
+
+                std::thread thread{};
+                std::uint64_t rng = 0;                      // backoff jitter, reader only
+            };
+
+            RpcChannelConfig m_cfg{};
+            std::vector<std::unique_ptr<Connection>> m_conns{};
+            std::atomic<std::uint32_t> m_next{0};
+            std::mutex m_stop_mtx;
+            std::condition_variable m_stop_cv;
+            std::atomic<bool> m_stop{false};
+            bool m_open = false;
+
+            std::atomic<std::uint64_t> m_requests{0};
+            std::atomic<std::uint64_t> m_responses{0};
+            std::atomic<std::uint64_t> m_failed{0};
+            std::atomic<std::uint64_t> m_stale{0};
+            std::atomic<std::uint64_t> m_reconnects{0};
+
+            [[nodiscard]] SockResult submit(const void* data, std::size_t size, ResponseFn fn, void* ctx, Connection*& conn, std::uint64_t& id) noexcept;
+            [[nodiscard]] SockResult send(Connection& c, std::uint64_t id, const void* data, std::size_t size) noexcept;
+            [[nodiscard]] bool cancel(Connection& c, std::uint64_t id) noexcept;
+            void complete(Connection& c, std::uint64_t id, const std::byte* data, std::size_t size) noexcept;
+            void fail_all(Connection& c, SockErr code) noexcept;
+
+            [[nodiscard]] bool connect(Connection& c) noexcept;
+            void drop(Connection& c) noexcept;
+            void run(Connection& c) noexcept;
+
+        public:
+            explicit RpcChannel(const RpcChannelConfig& cfg = RpcChannelConfig{});
+            ~RpcChannel();
+
+            RpcChannel(const RpcChannel&) = delete;
+            RpcChannel& operator=(const RpcChannel&) = delete;
+            RpcChannel(RpcChannel&&) = delete;
+            RpcChannel& operator=(RpcChannel&&) = delete;
+
+            // connects every connection once and starts the reader threads.
+            // ok even when the connects failed, those keep being retried,
+            // connected() says how many are up
+            [[nodiscard]] SockResult open();
+            // fails everything in flight with Shutdown and joins the readers
+            void close() noexcept;
+
+            // sends a request, fn(ctx, ...) gets exactly one call with its
+            // response or failure when this returns ok, and none otherwise.
+            // NotConnected when no connection is up, ResourceExhausted when
+            // every connection is at max_in_flight
+            [[nodiscard]] SockResult call_async(const void* data, std::size_t size, ResponseFn fn, void* ctx) noexcept;
+
+            // blocking round trip, response is replaced with the body.
+            // TimedOut after timeout_ms (0 = wait forever), a late response is dropped
+            [[nodiscard]] SockResult call(const void* data, std::size_t size, std::vector<std::byte>& response, std::uint32_t timeout_ms = 0);
+
+            [[nodiscard]] std::uint32_t connected() const noexcept;
+            [[nodiscard]] std::uint32_t in_flight() const noexcept;
+            [[nodiscard]] RpcChannelStats stats() const noexcept;
+            [[nodiscard]] bool is_open() const noexcept { return m_open; }
+    };
+}
@@ -0,0 +1,174 @@
+#include "sock/sharded_listener.h"
+#include "sock/accept_retry.h"
+#include "platform/platform.h"
+#include <chrono>
+#include <new>
+
+namespace sock {
+    namespace {
+        // every pooled client handed out: wait for one to come back without spinning
+        constexpr auto pool_backoff = std::chrono::milliseconds(1);
+    }
+
+    ClientPool::ClientPool(std::uint32_t capacity) : m_free(capacity) {
+        if (!m_free.is_valid()) return;
+
+        std::unique_ptr<TCPClient[]> clients(new (std::nothrow) TCPClient[capacity]);
+        if (clients == nullptr) return;
+
+        m_free_push = m_free.make_producer();
+        m_free_pop = m_free.make_consumer();
+        for (std::uint32_t i = 0; i < capacity; ++i) {
+            (void)m_free_push->push(i);
+        }
+        m_clients = std::move(clients);
+    }
+
+    PooledClient ClientPool::acquire() noexcept {
+        std::uint32_t index = 0;
+        if (!is_valid() || !m_free_pop->try_pop(index)) return PooledClient{};
+        return PooledClient(this, index);
+    }
+
+    void ClientPool::give_back(std::uint32_t index) noexcept {
+        auto& client = m_clients[index];
+        client.disable_async_send();
+        client.disconnect();
+        (void)m_free_push->push(index); // cant fail, the queue holds every index
+    }
+
+    ShardedListener::ShardedListener(const ShardedListenerConfig& cfg) : m_pool(cfg.pool_size), m_cfg(cfg) {}
+
+    ShardedListener::~ShardedListener() {
+        stop();
+    }
+
+    SockResult ShardedListener::start(AcceptFn on_accept) {
+        if (!m_threads.empty()) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Listen, 0, 0 };
+        }
+
+        if (!m_pool.is_valid() || !on_accept) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Listen, 0, 0 };
+        }
+
+        auto shards = m_cfg.shards;
+        if (shards == 0) shards = std::thread::hardware_concurrency();
+        if (shards == 0) shards = 1;
+
+        #if defined(MOO_LINUX)
+            const std::uint32_t sockets = shards;
+            auto listen_opts = m_cfg.listen;
+            listen_opts.reuse_port = true;
+        #else
+            const std::uint32_t sockets = 1;
+            const auto listen_opts = m_cfg.listen;
+        #endif
+
+        m_stop.store(false, std::memory_order_relaxed);
+        m_on_accept = std::move(on_accept);
+
+        for (std::uint32_t i = 0; i < sockets; ++i) {
+            auto server = std::make_unique<TCPServer>();
+            auto r = server->open();
+            if (r.ok()) r = server->set_nonblocking(true);
+            if (r.ok()) r = server->apply_listen_options(listen_opts);
+            if (r.ok()) r = server->bind(m_cfg.port, m_cfg.ip);
+            if (r.ok()) r = server->listen(m_cfg.backlog);
+            if (!r.ok()) {
+                m_servers.clear();
+                return r;
+            }
+            m_servers.push_back(std::move(server));
+        }
+
+        for (std::uint32_t i = 0; i < shards; ++i) {
+            auto reactor = std::make_unique<Reactor>();
+            auto r = reactor->open();
+            if (r.ok()) r = reactor->add(*m_servers[i % sockets], i, ready::Read);
+            if (!r.ok()) {
+                m_reactors.clear();
+                m_servers.clear();
+                return r;
+            }
+            m_reactors.push_back(std::move(reactor));
+        }
+
+        m_threads.reserve(shards);
+        for (std::uint32_t i = 0; i < shards; ++i) {
+            m_threads.emplace_back([this, i]() noexcept { accept_loop(i); });
+            if (m_cfg.pin_threads) {
+                plat::affinitize_thread(m_threads.back(), m_cfg.first_cpu + i);
+            }
+        }
+
+        return SockResult{ SockErr::None, SockOp::Listen, 0, 0 };
+    }
+
+    void ShardedListener::stop() noexcept {
+        m_stop.store(true, std::memory_order_release);
+        for (auto& reactor : m_reactors) {
+            reactor->wake();
+        }
+
+        for (auto& t : m_threads) {
+            if (t.joinable()) t.join();
+        }
+
+        // reactors first, windows wants sockets removed before they close
+        m_threads.clear();
+        m_reactors.clear();
+        m_servers.clear();
+    }
+
+    void ShardedListener::accept_loop(std::uint32_t shard) noexcept {
+        auto& reactor = *m_reactors[shard];
+        auto& server = *m_servers[shard % m_servers.size()];
+
+        ReactorEvent events[4];
+        while (!m_stop.load(std::memory_order_acquire)) {
+            const auto pr = reactor.poll(events, 4, -1);
+            if (!pr.ok()) {
+                m_accept_errors.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+                continue;
+            }
+
+            // edge triggered, drain the backlog until WouldBlock
+            while (!m_stop.load(std::memory_order_acquire)) {
+                PooledClient client = m_pool.acquire();
+                if (client.empty()) {
+                    m_pool_exhausted.fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::sleep_for(pool_backoff);
+                    continue;
+                }
+
+                const auto ar = server.accept_into(*client);
+                if (ar.code == SockErr::WouldBlock) break;
+                if (!ar.ok()) {
+                    m_accept_errors.fetch_add(1, std::memory_order_relaxed);
+                    if (!detail::accept_retry(ar)) break;
+                    continue;
+                }
+
+                // clients come out non-blocking from accept4, flip back if asked
+                if ((!m_cfg.nonblocking_clients && !client->set_nonblocking(false).ok()) ||
+                    !client->apply_options(m_cfg.client).ok()) {
+                    m_accept_errors.fetch_add(1, std::memory_order_relaxed);
+                    continue; // client goes back to the pool closed
+                }
+
+                m_accepted.fetch_add(1, std::memory_order_relaxed);
+                m_on_accept(std::move(client), shard);
+            }
+        }
+    }
+
+    ListenerStats ShardedListener::stats() const noexcept {
+        ListenerStats out{};
+        out.accepted = m_accepted.load(std::memory_order_relaxed);
+        out.accept_errors = m_accept_errors.load(std::memory_order_relaxed);
+        out.pool_exhausted = m_pool_exhausted.load(std::memory_order_relaxed);
+        return out;
+    }
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "msg/mpmc_queue.h"
+#include "socket_result.h"
+#include "socket_options.h"
+#include "tcp_socket.h"
+#include "reactor.h"
+
+namespace sock {
+    class ClientPool;
+
+    // a TCPClient borrowed from a ClientPool, closes it and hands it back
+    // when released or destroyed
+    class PooledClient {
+        private:
+            ClientPool* m_pool = nullptr;
+            std::uint32_t m_index = 0;
+
+            friend class ClientPool;
+            PooledClient(ClientPool* pool, std::uint32_t index) noexcept : m_pool(pool), m_index(index) {}
+
+        public:
+            PooledClient() = default;
+            ~PooledClient() { release(); }
+
+            PooledClient(const PooledClient&) = delete;
+            PooledClient& operator=(const PooledClient&) = delete;
+
+            PooledClient(PooledClient&& other) noexcept : m_pool(other.m_pool), m_index(other.m_index) {
+                other.m_pool = nullptr;
+            }
+
+            PooledClient& operator=(PooledClient&& other) noexcept {
+                if (this != &other) {
+                    release();
+                    m_pool = other.m_pool;
+                    m_index = other.m_index;
+                    other.m_pool = nullptr;
+                }
+                return *this;
+            }
+
+            void release() noexcept;
+
+            [[nodiscard]] bool empty() const noexcept { return m_pool == nullptr; }
+            [[nodiscard]] TCPClient* get() const noexcept;
+            TCPClient* operator->() const noexcept { return get(); }
+            TCPClient& operator*() const noexcept { return *get(); }
+    };
+
+    // Fixed set of preallocated TCPClient objects so accepting a connection
+    // never allocates. acquire() is lock free and safe from any thread.
+    // NOTE: PooledClients must not outlive the pool
+    class ClientPool {
+        private:
+            using IndexQueue = msg::DynMPMCQueue<std::uint32_t>;
+
+            std::unique_ptr<TCPClient[]> m_clients{};
+            IndexQueue m_free;
+            std::optional<IndexQueue::Producer> m_free_push{};
+            std::optional<IndexQueue::Consumer> m_free_pop{};
+
+            friend class PooledClient;
+            void give_back(std::uint32_t index) noexcept;
+
+        public:
+            // capacity must be a power of 2, check is_valid() before use
+            explicit ClientPool(std::uint32_t capacity);
+            ~ClientPool() = default;
+
+            ClientPool(const ClientPool&) = delete;
+            ClientPool& operator=(const ClientPool&) = delete;
+            ClientPool(ClientPool&&) = delete;
+            ClientPool& operator=(ClientPool&&) = delete;
+
+            [[nodiscard]] bool is_valid() const noexcept { return m_clients != nullptr; }
+            [[nodiscard]] std::size_t capacity() const noexcept { return m_free.capacity(); }
+
+            // empty PooledClient when every client is handed out
+            [[nodiscard]] PooledClient acquire() noexcept;
+            std::size_t available_snapshot() const noexcept { return m_free_pop ? m_free_pop->count_snapshot() : 0; }
+    };
+
+    inline TCPClient* PooledClient::get() const noexcept {
+        return m_pool != nullptr ? &m_pool->m_clients[m_index] : nullptr;
+    }
+
+    inline void PooledClient::release() noexcept {
+        if (m_pool != nullptr) {
+            m_pool->give_back(m_index);
+            m_pool = nullptr;
+        }
+    }
+
+    struct ShardedListenerConfig {
+        std::uint16_t port = 0;
+        const char* ip = "0.0.0.0";
+        std::uint32_t shards = 0;           // acceptor threads, 0 = std::thread::hardware_concurrency()
+        bool pin_threads = false;           // pin shard i to cpu first_cpu + i
+        std::uint32_t first_cpu = 0;
+        std::uint32_t pool_size = 1024;     // pooled clients shared by every shard, power of 2
+        int backlog = 0;                    // per shard, 0 = SOMAXCONN
+        bool nonblocking_clients = false;   // hand out clients in non-blocking mode
+        TcpListenOptions listen{};          // reuse_port is forced on for linux shards
+        TcpSocketOptions client{};          // applied to every accepted client
+    };
+
+    struct ListenerStats {
+        std::uint64_t accepted = 0;
+        std::uint64_t accept_errors = 0;
+        std::uint64_t pool_exhausted = 0;   // times an acceptor had to wait for a free client
+    };
+
+    // Multi threaded acceptor for reconnect storms. On linux every shard gets
+    // its own SO_REUSEPORT listen socket so the kernel load balances incoming
+    // connections across them with no shared accept queue, on windows the
+    // shards share one listen socket. Each shard accepts into pooled clients
+    // and hands them to on_accept on its own thread. Listen sockets are
+    // non-blocking so accept4 hands clients out with SOCK_NONBLOCK set and
+    // each shard drains its backlog per wakeup.
+    // NOTE: on_accept runs on the acceptor threads, keep it short (hand the
+    // client to a reactor or worker) or the shard stops accepting meanwhile
+    class ShardedListener {
+        public:
+            using AcceptFn = std::function<void(PooledClient&& client, std::uint32_t shard)>;
+
+        private:
+            ClientPool m_pool;
+            std::vector<std::unique_ptr<TCPServer>> m_servers{};  // one per shard (linux) or just one (windows)
+            std::vector<std::unique_ptr<Reactor>> m_reactors{};   // one per shard, stop() wakes them
+            std::vector<std::thread> m_threads{};
+            AcceptFn m_on_accept{};
+            ShardedListenerConfig m_cfg{};
+
+            alignas(64) std::atomic<bool> m_stop{false};
+            std::atomic<std::uint64_t> m_accepted{0};
+            std::atomic<std::uint64_t> m_accept_errors{0};
+            std::atomic<std::uint64_t> m_pool_exhausted{0};
+
+            void accept_loop(std::uint32_t shard) noexcept;
+
+        public:
+            explicit ShardedListener(const ShardedListenerConfig& cfg = ShardedListenerConfig{});
+            ~ShardedListener();
+
+            ShardedListener(const ShardedListener&) = delete;
+            ShardedListener& operator=(const ShardedListener&) = delete;
+            ShardedListener(ShardedListener&&) = delete;
+            ShardedListener& operator=(ShardedListener&&) = delete;
+
+            // opens and binds every shard then starts the acceptor threads
+            [[nodiscard]] SockResult start(AcceptFn on_accept);
+
+            // stops accepting and joins the acceptors, handed out clients stay open
+            void stop() noexcept;
+
+            [[nodiscard]] std::size_t num_shards() const noexcept { return m_threads.size(); }
+            [[nodiscard]] ClientPool& pool() noexcept { return m_pool; }
+            [[nodiscard]] ListenerStats stats() const noexcept;
+    };
+}
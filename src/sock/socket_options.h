@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+namespace sock {
+    enum class Timestamping : std::uint8_t {
+        None = 0,
+        Software,   // kernel stamps on receive (SO_TIMESTAMPNS)
+        Hardware,   // nic stamps where supported, software stamp alongside (SO_TIMESTAMPING)
+    };
+
+    // receive timestamps in ns since the unix epoch, 0 = not available
+    struct RecvTimestamp {
+        std::uint64_t software_ns = 0;
+        std::uint64_t hardware_ns = 0;
+    };
+
+    // per socket tuning, 0/false leaves the os default alone.
+    // busy_poll, quick_ack and timestamps are linux only and ignored on windows
+    struct TcpSocketOptions {
+        bool no_delay = false;                      // TCP_NODELAY, disable nagle
+        bool quick_ack = false;                     // TCP_QUICKACK, re-armed after every recv since the kernel clears it
+        std::int32_t rcvbuf = 0;                    // SO_RCVBUF bytes
+        std::int32_t sndbuf = 0;                    // SO_SNDBUF bytes
+        std::int32_t busy_poll_us = 0;              // SO_BUSY_POLL, spin in the driver on blocking recv
+        std::int32_t recv_timeout_ms = 0;           // SO_RCVTIMEO, blocking recv gives up (linux WouldBlock, windows TimedOut)
+        Timestamping timestamps = Timestamping::None;
+    };
+
+    // listen socket tuning, apply between open() and bind().
+    // reuse_port and defer_accept are linux only and ignored on windows
+    struct TcpListenOptions {
+        bool reuse_port = false;                    // SO_REUSEPORT, several sockets share a port and the kernel spreads connections
+        std::int32_t fastopen_queue = 0;            // TCP_FASTOPEN, pending syn+data connections allowed (windows: any > 0 enables it)
+        std::int32_t defer_accept_s = 0;            // TCP_DEFER_ACCEPT, only wake accept once the client sent data
+    };
+}
@@ -44,7 +44,9 @@ namespace sock {
         Send,
         Recv, 
         Shutdown, 
-        Close 
+        Close,
+        Poll,
+        Submit
     };
 
     struct SockResult {
@@ -98,6 +100,8 @@ namespace sock {
                 case SockOp::Recv: return "Recv"; 
                 case SockOp::Shutdown: return "Shutdown"; 
                 case SockOp::Close: return "Close";
+                case SockOp::Poll: return "Poll";
+                case SockOp::Submit: return "Submit";
                 default: return "Unknown - op is undefined";
             }
         }
@@ -105,4 +109,7 @@ namespace sock {
 
     SockErr map_err(int err) noexcept;
     bool is_fatal_send_err(int e) noexcept;
+    // accept failed for the one pending connection (aborted, refused by a
+    // firewall), the next one in the backlog may still be fine
+    bool is_transient_accept_err(int e) noexcept;
 }
\ No newline at end of file
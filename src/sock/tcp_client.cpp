@@ -0,0 +1,203 @@
+#include "sock/tcp_socket.h"
+#include "msg/mpsc_queue.h"
+#include "instr/instr.h"
+#include <atomic>
+#include <cstring>
+#include <optional>
+
+namespace sock {
+    namespace {
+        struct SendDesc {
+            const void* data;
+            std::size_t size;
+            SendRelease release;
+            void* ctx;
+        };
+
+        constexpr std::size_t max_coalesce = 64;
+
+        void release_desc(const SendDesc& d, bool sent) noexcept {
+            if (d.release != nullptr) d.release(d.ctx, d.data, d.size, sent);
+        }
+    }
+
+    struct AsyncSendState {
+        using Queue = msg::DynMPSCQueue<SendDesc>;
+
+        AsyncSendConfig cfg;
+        Queue queue;
+        std::optional<Queue::Producer> producer{};
+        std::optional<Queue::Consumer> consumer{};
+
+        // writer only, popped but not fully written yet
+        SendDesc inflight[max_coalesce]{};
+        std::size_t inflight_count = 0;
+        std::size_t inflight_offset = 0; // bytes of inflight[0] already written
+
+        alignas(64) std::atomic<std::uint64_t> queued_bytes{0};
+        std::atomic<std::uint64_t> queued_msgs{0};
+        std::atomic<bool> above_high_water{false};
+
+        alignas(64) std::atomic<std::uint64_t> sent_msgs{0};
+        std::atomic<std::uint64_t> sent_bytes{0};
+        std::atomic<std::uint64_t> send_calls{0};
+        std::atomic<std::uint64_t> rejected{0};
+        std::atomic<std::uint64_t> high_water_events{0};
+
+        explicit AsyncSendState(AsyncSendConfig c) : cfg(std::move(c)), queue(cfg.queue_capacity) {}
+    };
+
+    // defined here so unique_ptr<AsyncSendState> sees the complete type
+    TCPClient::TCPClient() : TCPSocket() {}
+
+    TCPClient::~TCPClient() {
+        disable_async_send();
+    }
+
+    SockResult TCPClient::enable_async_send(AsyncSendConfig cfg) {
+        if (m_async != nullptr) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Configure, 0, 0 };
+        }
+
+        auto state = std::make_unique<AsyncSendState>(std::move(cfg));
+        if (!state->queue.is_valid()) {
+            return SockResult{ SockErr::InvalidArgument, SockOp::Configure, 0, 0 }; // capacity not a power of 2
+        }
+
+        state->producer = state->queue.make_producer();
+        state->consumer = state->queue.make_consumer();
+        m_async = std::move(state);
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    void TCPClient::disable_async_send() noexcept {
+        if (m_async == nullptr) return;
+
+        std::lock_guard lock(m_send_mtx);
+        auto& st = *m_async;
+        for (std::size_t i = 0; i < st.inflight_count; ++i) {
+            release_desc(st.inflight[i], false);
+        }
+
+        SendDesc d{};
+        while (st.consumer->try_pop(d)) {
+            release_desc(d, false);
+        }
+        m_async.reset();
+    }
+
+    SockResult TCPClient::send_async(const void* data, const size_t size, SendRelease release, void* ctx) {
+        if (m_async == nullptr) {
+            return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+        }
+
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        if (data == nullptr || size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+        }
+
+        auto& st = *m_async;
+
+        // count before publishing so the writer never subtracts bytes or
+        // messages we havent added, undone if the queue turns it away
+        const auto queued = st.queued_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        st.queued_msgs.fetch_add(1, std::memory_order_relaxed);
+        if (!st.producer->push(SendDesc{ data, size, release, ctx })) {
+            st.queued_msgs.fetch_sub(1, std::memory_order_relaxed);
+            st.queued_bytes.fetch_sub(size, std::memory_order_relaxed);
+            st.rejected.fetch_add(1, std::memory_order_relaxed);
+            return SockResult{ SockErr::ResourceExhausted, SockOp::Send, 0, 0 };
+        }
+
+        const auto high_water = st.cfg.high_water_bytes;
+        if (high_water != 0 && queued >= high_water && !st.above_high_water.exchange(true, std::memory_order_acq_rel)) {
+            st.high_water_events.fetch_add(1, std::memory_order_relaxed);
+            if (st.cfg.on_high_water) st.cfg.on_high_water(static_cast<std::size_t>(queued));
+        }
+
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(size) };
+    }
+
+    SockResult TCPClient::flush() {
+        if (m_async == nullptr) {
+            return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+        }
+
+        MOO_INSTR_TIMER_START(lock_t0);
+        std::lock_guard lock(m_send_mtx);
+        MOO_INSTR_TIMER_RECORD(lock_t0, instr::Hist::TcpSendLockWait);
+        auto& st = *m_async;
+        std::size_t total = 0;
+
+        while (true) {
+            // top up the batch from the queue
+            while (st.inflight_count < max_coalesce && st.consumer->try_pop(st.inflight[st.inflight_count])) {
+                ++st.inflight_count;
+            }
+            if (st.inflight_count == 0) break;
+
+            IoVec vec[max_coalesce];
+            for (std::size_t i = 0; i < st.inflight_count; ++i) {
+                vec[i] = IoVec{ st.inflight[i].data, st.inflight[i].size };
+            }
+            vec[0].data = static_cast<const std::byte*>(vec[0].data) + st.inflight_offset;
+            vec[0].size -= st.inflight_offset;
+
+            const auto r = send_v_once(vec, st.inflight_count);
+            st.send_calls.fetch_add(1, std::memory_order_relaxed);
+            if (!r.ok()) {
+                return SockResult{ r.code, SockOp::Send, r.sys_error, static_cast<int>(total) };
+            }
+
+            // retire fully written buffers, remember how far into the next one we got
+            auto left = static_cast<std::size_t>(r.bytes) + st.inflight_offset;
+            std::size_t done = 0;
+            while (done < st.inflight_count && left >= st.inflight[done].size) {
+                left -= st.inflight[done].size;
+                release_desc(st.inflight[done], true);
+                ++done;
+            }
+
+            if (done != 0) {
+                std::memmove(st.inflight, st.inflight + done, (st.inflight_count - done) * sizeof(SendDesc));
+                st.inflight_count -= done;
+            }
+            st.inflight_offset = left;
+
+            total += static_cast<std::size_t>(r.bytes);
+            const auto queued = st.queued_bytes.fetch_sub(static_cast<std::uint64_t>(r.bytes), std::memory_order_relaxed)
+                              - static_cast<std::uint64_t>(r.bytes);
+            st.queued_msgs.fetch_sub(done, std::memory_order_relaxed);
+            st.sent_msgs.fetch_add(done, std::memory_order_relaxed);
+            st.sent_bytes.fetch_add(static_cast<std::uint64_t>(r.bytes), std::memory_order_relaxed);
+
+            if (st.cfg.high_water_bytes != 0 && queued < st.cfg.high_water_bytes / 2) {
+                st.above_high_water.store(false, std::memory_order_release);
+            }
+        }
+
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
+    }
+
+    AsyncSendStats TCPClient::async_stats() const noexcept {
+        if (m_async == nullptr) return AsyncSendStats{};
+
+        const auto& st = *m_async;
+        AsyncSendStats out{};
+        out.queued_msgs = st.queued_msgs.load(std::memory_order_relaxed);
+        out.queued_bytes = st.queued_bytes.load(std::memory_order_relaxed);
+        out.sent_msgs = st.sent_msgs.load(std::memory_order_relaxed);
+        out.sent_bytes = st.sent_bytes.load(std::memory_order_relaxed);
+        out.send_calls = st.send_calls.load(std::memory_order_relaxed);
+        out.rejected = st.rejected.load(std::memory_order_relaxed);
+        out.high_water_events = st.high_water_events.load(std::memory_order_relaxed);
+        return out;
+    }
+}
@@ -3,20 +3,51 @@
 #include <mutex>
 #include <memory>
 #include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include "socket_result.h"
+#include "socket_handle.h"
+#include "socket_options.h"
 
 namespace sock {
-    #if defined(MOO_WIN32) 
-        using socket_handle = std::uintptr_t;
-    #elif defined(MOO_LINUX)
-        constexpr std::int32_t INVALID_SOCKET = -1;
-        using socket_handle = int;
-    #endif
+    class IoRing;
+
+    // one piece of a gather send, the caller owns the memory
+    struct IoVec {
+        const void* data = nullptr;
+        std::size_t size = 0;
+    };
+
+    // called once the async writer is done with a buffer, sent is false if it
+    // was dropped (async mode disabled or client destroyed) before going out
+    using SendRelease = void (*)(void* ctx, const void* data, std::size_t size, bool sent) noexcept;
+
+    struct AsyncSendConfig {
+        std::size_t queue_capacity = 4096;  // max queued buffers, power of 2
+        std::size_t high_water_bytes = 0;   // 0 = no high water callback
+        // fires on the producer thread when queued bytes cross high_water_bytes,
+        // re-armed once the writer drains below half of it
+        std::function<void(std::size_t queued_bytes)> on_high_water{};
+    };
+
+    struct AsyncSendStats {
+        std::uint64_t queued_msgs = 0;       // waiting to be written right now
+        std::uint64_t queued_bytes = 0;
+        std::uint64_t sent_msgs = 0;
+        std::uint64_t sent_bytes = 0;
+        std::uint64_t send_calls = 0;        // syscalls made by flush(), sent_msgs / send_calls = coalescing
+        std::uint64_t rejected = 0;          // send_async calls refused because the queue was full
+        std::uint64_t high_water_events = 0;
+    };
+
+    struct AsyncSendState;
 
     class TCPSocket {
         protected:
             socket_handle m_handle;
             bool m_connected;
+            bool m_nonblocking = false;
+            bool m_quick_ack = false;
 
         public:
             TCPSocket();
@@ -31,15 +62,26 @@ namespace sock {
             void shutdown() noexcept;
             void close() noexcept;
 
+            // in non-blocking mode calls that would wait return SockErr::WouldBlock,
+            // use with a sock::Reactor to find out when to retry
+            [[nodiscard]] SockResult set_nonblocking(bool enable);
+
+            // applies every set field, stops at the first failing option
+            [[nodiscard]] SockResult apply_options(const TcpSocketOptions& opts);
+
             // shared implementation
             [[nodiscard]] bool is_connected() const noexcept { 
                 return m_connected && handle_valid(); 
             }
 
-            void adopt(socket_handle handle, bool connected = true) noexcept {
+            [[nodiscard]] bool is_nonblocking() const noexcept { return m_nonblocking; }
+            [[nodiscard]] socket_handle handle() const noexcept { return m_handle; }
+
+            void adopt(socket_handle handle, bool connected = true, bool nonblocking = false) noexcept {
                 close();
                 m_handle = handle;
                 m_connected = connected;
+                m_nonblocking = nonblocking;
             }
 
             void disconnect() noexcept {
@@ -58,22 +100,66 @@ namespace sock {
             // destination out of order, we lock on sends. We do not need to lock
             // on recvs since only 1 thread listens to each sockets incoming messages
             std::mutex m_send_mtx; 
+            std::unique_ptr<AsyncSendState> m_async{};
+
+            void rearm_quick_ack() noexcept;
+            // one gather send syscall, no lock, no retry on partial writes
+            [[nodiscard]] SockResult send_v_once(const IoVec* bufs, const size_t count);
 
         public:
             TCPClient();
-            ~TCPClient() = default;
+            ~TCPClient();
 
             TCPClient(const TCPClient&) = delete;
             TCPClient& operator=(const TCPClient&) = delete;
             TCPClient(TCPClient&&) = delete;
             TCPClient& operator=(TCPClient&&) = delete;
 
+            // non-blocking sockets return WouldBlock while the connect is in flight,
+            // call finish_connect() once the reactor reports the socket writable
             [[nodiscard]] SockResult connect(const char* ip, uint16_t port);
+            [[nodiscard]] SockResult finish_connect();
             [[nodiscard]] SockResult send(const void* data, const size_t size);
             [[nodiscard]] SockResult send_all(const void* data, const size_t size);
+
+            // gather send (sendmsg/WSASend), writes every buffer back to back under
+            // one send lock hold so nothing interleaves, partial writes resume
+            // mid buffer. bytes = total sent
+            [[nodiscard]] SockResult send_all_v(const IoVec* bufs, const size_t count);
+            [[nodiscard]] SockResult send_all_v(std::initializer_list<IoVec> bufs) {
+                return send_all_v(bufs.begin(), bufs.size());
+            }
+
+            // async send mode: producers enqueue into a lock free MPSC queue and
+            // never touch the socket, one writer calls flush() to drain it,
+            // coalescing up to 64 buffers per sendmsg/WSASend. With a non-blocking
+            // socket register it with a Reactor for Write and flush() on readiness
+            // NOTE: enable/disable only while no producers are running
+            [[nodiscard]] SockResult enable_async_send(AsyncSendConfig cfg = AsyncSendConfig{});
+            void disable_async_send() noexcept;
+            [[nodiscard]] bool async_send_enabled() const noexcept { return m_async != nullptr; }
+
+            // queues data without copying, data must stay valid until release is
+            // called (release may be null). ResourceExhausted when the queue is full
+            [[nodiscard]] SockResult send_async(const void* data, const size_t size, SendRelease release = nullptr, void* ctx = nullptr);
+
+            // writer side, sends until the queue is empty or the socket would block.
+            // bytes = bytes written this call
+            [[nodiscard]] SockResult flush();
+            [[nodiscard]] AsyncSendStats async_stats() const noexcept;
+
             [[nodiscard]] SockResult recv(void* data, const size_t size);
+            // same as recv() but also returns the kernel receive time of the
+            // newest byte read, needs TcpSocketOptions::timestamps
+            [[nodiscard]] SockResult recv(void* data, const size_t size, RecvTimestamp& timestamp);
             [[nodiscard]] SockResult recv_all(void* data, const size_t size);
 
+            // io_uring path, only queues the op on ring, see sock::IoRing.
+            // completions come back from ring.reap() tagged with user_data
+            [[nodiscard]] SockResult queue_send(IoRing& ring, const void* data, const size_t size, std::uint64_t user_data);
+            [[nodiscard]] SockResult queue_recv(IoRing& ring, void* data, const size_t size, std::uint64_t user_data);
+            [[nodiscard]] SockResult queue_recv_multishot(IoRing& ring, std::uint64_t user_data);
+
             [[nodiscard]] SockResult open_and_connect(const char* ip, uint16_t port) {
                 const sock::SockResult open_err = open();
                 if (open_err.code != SockErr::None) {
@@ -95,7 +181,14 @@ namespace sock {
 
             [[nodiscard]] SockResult bind(uint16_t port, const char* ip = "0.0.0.0");
             [[nodiscard]] SockResult listen(int backlog = 0);
+            // non-blocking listeners return WouldBlock once the backlog is drained,
+            // accepted clients inherit the listeners non-blocking mode
             [[nodiscard]] std::pair<std::shared_ptr<TCPClient>, SockResult> accept();
+            // same as accept() but into a caller owned (pooled) client, no allocation.
+            // whatever socket out held before is closed
+            [[nodiscard]] SockResult accept_into(TCPClient& out);
+
+            [[nodiscard]] SockResult apply_listen_options(const TcpListenOptions& opts);
 
             [[nodiscard]] SockResult open_and_listen(uint16_t port, const char* ip = "0.0.0.0") {
                 sock::SockResult result = open();
@@ -106,6 +199,19 @@ namespace sock {
 
                 return listen(0);
             }
+
+            [[nodiscard]] SockResult open_and_listen(uint16_t port, const char* ip, const TcpListenOptions& opts, int backlog = 0) {
+                sock::SockResult result = open();
+                if (!result.ok()) return result;
+
+                result = apply_listen_options(opts);
+                if (!result.ok()) return result;
+
+                result = bind(port, ip);
+                if (!result.ok()) return result;
+
+                return listen(backlog);
+            }
             
             void request_stop() noexcept { close(); }
     };
@@ -1,10 +1,16 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 #include <utility>
 #include <string>
 #include "socket_result.h"
+#include "socket_handle.h"
+#include "socket_options.h"
 
 namespace sock {
+    class IoRing;
+
     struct UdpMcastConfig {
         std::string group_ip = "239.255.0.1"; // admin scope...which may not work
         uint16_t port = 30001;
@@ -12,21 +18,73 @@ namespace sock {
         int ttl = 1;
         bool loopback = true;
         bool reuse_addr = true;
+        bool gro = false; // linux: let the kernel coalesce same sized datagrams, see UdpDatagram::segment_size
+
+        // 0 leaves the os default, busy_poll and timestamps are linux only
+        std::int32_t rcvbuf = 0;        // SO_RCVBUF bytes, raise for bursty feeds
+        std::int32_t sndbuf = 0;        // SO_SNDBUF bytes
+        std::int32_t busy_poll_us = 0;  // SO_BUSY_POLL, spin in the driver on blocking recv
+        Timestamping timestamps = Timestamping::None;
+        std::string hw_timestamp_iface{}; // Hardware: also turn on nic rx stamping (SIOCSHWTSTAMP, needs CAP_NET_ADMIN)
+
+        // linux only: receive through a TPACKET_V3 packet ring (PACKET_RX_RING)
+        // bound to this interface instead of the udp socket, needs CAP_NET_RAW.
+        // The socket still joins the group and sends. Ignored on windows
+        std::string ring_iface{};
+        std::uint32_t ring_block_size = 1u << 20;   // bytes per ring block, multiple of the page size
+        std::uint32_t ring_block_count = 16;
+        std::uint32_t ring_block_timeout_ms = 1;    // a partly filled block is handed over after this long
     };
 
-    #if defined(MOO_WIN32) 
-        using socket_handle = std::uintptr_t;
-    #elif defined(MOO_LINUX)
-        constexpr std::int32_t INVALID_SOCKET = -1;
-        using socket_handle = int;
-    #endif
+    // ipv4 address/port in host byte order
+    struct UdpEndpoint {
+        std::uint32_t ip = 0;
+        std::uint16_t port = 0;
+    };
+
+    // one entry of a recv_batch/send_batch array, the caller owns the buffers
+    struct UdpDatagram {
+        void* data = nullptr;
+        std::uint32_t size = 0;         // recv: buffer capacity, send: bytes to send
+        std::uint32_t length = 0;       // recv: bytes received
+        std::uint16_t segment_size = 0; // recv with gro: length is several datagrams of this size (last may be short), 0 = just one
+        UdpEndpoint source{};           // recv: sender
+        RecvTimestamp timestamp{};      // recv: kernel/nic receive time if cfg.timestamps is set
+    };
 
+    // With cfg.ring_iface set the kernel copies matching frames into a ring
+    // shared with the process: a classic bpf filter on the packet socket only
+    // passes udp for our group and port, ip/udp headers are parsed here, and
+    // the udp socket gets a drop-all filter so the kernel stops queueing a
+    // second copy for it. recv_ring() reads the ring in place, the other
+    // recv calls copy out of it and keep working unchanged.
+    // NOTE: with the ring, stop the receiving thread before close(),
+    // request_stop() does not wake a thread waiting on the ring
     class UDPMulticastSocket final {
+        public:
+            using RingFn = void (*)(void* ctx, const UdpDatagram& msg);
+
         private:
             socket_handle m_handle;
             bool m_open;
             bool m_joined;
             UdpMcastConfig m_cfg{};
+            // group address resolved once at open_and_join (network byte order)
+            std::uint32_t m_dst_addr = 0;
+            std::uint16_t m_dst_port = 0;
+
+            // packet ring receive path, linux only
+            int m_ring_fd = -1;                 // AF_PACKET socket
+            std::byte* m_ring = nullptr;
+            std::uint32_t m_ring_block = 0;     // block being read
+            std::uint32_t m_ring_left = 0;      // packets left in it
+            std::uint32_t m_ring_next = 0;      // offset of the next packet in it
+            bool m_ring_held = false;           // m_ring_block is ours until released
+
+            template <typename Fn>
+            static void ring_thunk(void* ctx, const UdpDatagram& msg) {
+                (*static_cast<Fn*>(ctx))(msg);
+            }
 
         public:
             UDPMulticastSocket();
@@ -40,12 +98,50 @@ namespace sock {
             [[nodiscard]] SockResult open_and_join(const UdpMcastConfig& cfg);
             [[nodiscard]] SockResult send_broadcast(const void* data, size_t size) noexcept;
             [[nodiscard]] SockResult recv_broadcast(void* data, size_t size) noexcept;
+            [[nodiscard]] SockResult recv_broadcast(void* data, size_t size, UdpEndpoint& source) noexcept;
+            [[nodiscard]] SockResult recv_broadcast(void* data, size_t size, UdpEndpoint& source, RecvTimestamp& timestamp) noexcept;
+
+            // blocks for the first datagram then takes whatever else is already
+            // queued, up to count in one syscall (recvmmsg). bytes = datagrams filled
+            [[nodiscard]] SockResult recv_batch(UdpDatagram* msgs, size_t count) noexcept;
+
+            // sends count datagrams to the group in one syscall (sendmmsg). bytes = datagrams sent
+            [[nodiscard]] SockResult send_batch(const UdpDatagram* msgs, size_t count) noexcept;
+
+            // sends data as size/segment_size datagrams (last may be short). linux
+            // hands the split to the kernel/nic with UDP_SEGMENT (GSO), bytes = bytes sent
+            [[nodiscard]] SockResult send_segmented(const void* data, size_t size, std::uint16_t segment_size) noexcept;
+
+            // io_uring path, only queues the op on ring, see sock::IoRing.
+            // multishot keeps one recv armed that completes once per datagram
+            [[nodiscard]] SockResult queue_recv_broadcast(IoRing& ring, void* data, size_t size, std::uint64_t user_data) noexcept;
+            [[nodiscard]] SockResult queue_recv_multishot(IoRing& ring, std::uint64_t user_data) noexcept;
             void close() noexcept;
 
+            // blocks up to timeout_ms (-1 = forever) for the first datagram, then
+            // hands what was already received to fn, at most max_count so a
+            // steady feed still returns to the caller. With the ring msg.data
+            // points straight into it, so a callback writing into a queue
+            // reserve() slot copies the payload exactly once. msg.data is only
+            // valid inside fn. Without the ring this reads the socket into a
+            // scratch buffer. bytes = datagrams delivered, WouldBlock on timeout
+            [[nodiscard]] SockResult recv_ring(RingFn fn, void* ctx, int timeout_ms = -1, size_t max_count = 64) noexcept;
+
+            // fn(const UdpDatagram&)
+            template <typename Fn>
+            [[nodiscard]] SockResult recv_ring(Fn&& fn, int timeout_ms = -1, size_t max_count = 64) noexcept {
+                using F = std::remove_reference_t<Fn>;
+                return recv_ring(&ring_thunk<F>, const_cast<void*>(static_cast<const void*>(&fn)), timeout_ms, max_count);
+            }
+
             // shared implementation
+            [[nodiscard]] bool uses_ring() const noexcept { return m_ring != nullptr; }
+
             [[nodiscard]] bool is_open() const noexcept {
                 return m_open && handle_valid();
             }
+
+            [[nodiscard]] socket_handle handle() const noexcept { return m_handle; }
             
             void request_stop() noexcept {
                 close(); // breaks blocking recvfrom
@@ -53,5 +149,10 @@ namespace sock {
 
         private:
             bool handle_valid() const noexcept;
+
+            // linux only, ring setup/teardown and reading the next matching datagram
+            int open_ring() noexcept;
+            void close_ring() noexcept;
+            [[nodiscard]] SockResult ring_next(UdpDatagram& out, int timeout_ms) noexcept;
     };
 }
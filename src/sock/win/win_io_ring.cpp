@@ -0,0 +1,58 @@
+#if defined(MOO_WIN32)
+#include "sock/io_ring.h"
+
+namespace sock {
+    // no socket io_uring equivalent on windows (ioringapi only covers file reads),
+    // open() always fails so callers stay on the blocking path
+
+    IoRing::~IoRing() {
+        close();
+    }
+
+    SockResult IoRing::open(const IoRingConfig&) {
+        return SockResult{ SockErr::NotInitialized, SockOp::Open, 0, 0 };
+    }
+
+    void IoRing::close() noexcept {
+        m_open = false;
+    }
+
+    std::byte* IoRing::fixed_buffer(std::uint16_t) noexcept { return nullptr; }
+    std::byte* IoRing::recv_buffer(std::uint16_t) noexcept { return nullptr; }
+    std::uint32_t IoRing::fixed_buffer_count() const noexcept { return 0; }
+    std::uint32_t IoRing::recv_buffer_count() const noexcept { return 0; }
+    std::uint32_t IoRing::buffer_size() const noexcept { return 0; }
+
+    SockResult IoRing::queue_send(socket_handle, const void*, std::size_t, std::uint64_t) noexcept {
+        return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+    }
+
+    SockResult IoRing::queue_recv(socket_handle, void*, std::size_t, std::uint64_t) noexcept {
+        return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::queue_send_fixed(socket_handle, std::uint16_t, std::size_t, std::uint64_t) noexcept {
+        return SockResult{ SockErr::NotOpen, SockOp::Send, 0, 0 };
+    }
+
+    SockResult IoRing::queue_recv_fixed(socket_handle, std::uint16_t, std::size_t, std::uint64_t) noexcept {
+        return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::queue_recv_multishot(socket_handle, std::uint64_t) noexcept {
+        return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::recycle_buffer(std::uint16_t) noexcept {
+        return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+    }
+
+    SockResult IoRing::submit(std::uint32_t) noexcept {
+        return SockResult{ SockErr::NotOpen, SockOp::Submit, 0, 0 };
+    }
+
+    std::size_t IoRing::reap(IoCompletion*, std::size_t) noexcept {
+        return 0;
+    }
+}
+#endif
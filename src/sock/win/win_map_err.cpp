@@ -51,5 +51,16 @@ namespace sock {
                 return false;
         }
     }
+
+    bool is_transient_accept_err(int e) noexcept {
+        switch (e) {
+            case WSAECONNRESET:
+            case WSAECONNABORTED:
+            case WSAENETDOWN:
+                return true;
+            default:
+                return false;
+        }
+    }
 }
 #endif
\ No newline at end of file
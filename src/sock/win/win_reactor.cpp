@@ -0,0 +1,244 @@
+#if defined(MOO_WIN32)
+#include "sock/reactor.h"
+#include "windows_hdr.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <algorithm>
+
+namespace sock {
+    // IOCP is a completion model (the kernel does the recv into a buffer you
+    // hand it up front) and doesnt fit the readiness API TCPClient is built
+    // around, so windows polls the registered set with WSAPoll instead
+
+    static SOCKET as_native(socket_handle handle) noexcept {
+        return static_cast<SOCKET>(handle);
+    }
+
+    static socket_handle from_native(SOCKET handle) noexcept {
+        return static_cast<socket_handle>(handle);
+    }
+
+    static SHORT to_poll(std::uint32_t events) noexcept {
+        SHORT out = 0;
+        if (events & ready::Read)  out |= POLLRDNORM;
+        if (events & ready::Write) out |= POLLWRNORM;
+        return out;
+    }
+
+    static std::uint32_t from_poll(SHORT events) noexcept {
+        std::uint32_t out = 0;
+        if (events & POLLRDNORM) out |= ready::Read;
+        if (events & POLLWRNORM) out |= ready::Write;
+        if (events & (POLLERR | POLLNVAL)) out |= ready::Error;
+        if (events & POLLHUP) out |= ready::HangUp;
+        return out;
+    }
+
+    Reactor::Reactor() : m_wake_handle(INVALID_SOCKET) {}
+
+    Reactor::~Reactor() {
+        close();
+    }
+
+    SockResult Reactor::open() {
+        if (m_open) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Open, 0, 0 };
+        }
+
+        // udp socket bound to an ephemeral loopback port, wake() sends itself a byte
+        SOCKET wake = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (wake == INVALID_SOCKET) {
+            int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+
+        u_long mode = 1;
+        if (::bind(wake, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::ioctlsocket(wake, FIONBIO, &mode) != 0) {
+            int err = ::WSAGetLastError();
+            ::closesocket(wake);
+            return SockResult{ map_err(err), SockOp::Open, err, 0 };
+        }
+
+        m_wake_handle = from_native(wake);
+        m_open = true;
+        return SockResult{ SockErr::None, SockOp::Open, 0, 0 };
+    }
+
+    void Reactor::close() noexcept {
+        if (m_wake_handle != INVALID_SOCKET) {
+            ::closesocket(as_native(m_wake_handle));
+        }
+        m_wake_handle = INVALID_SOCKET;
+
+        std::lock_guard lock(m_mtx);
+        m_regs.clear();
+        m_notifiers.clear();
+        m_open = false;
+    }
+
+    SockResult Reactor::add(const TCPSocket& socket, std::uint64_t token, std::uint32_t events) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        if (socket.handle() == INVALID_SOCKET) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+
+        std::lock_guard lock(m_mtx);
+        const auto it = std::find_if(m_regs.begin(), m_regs.end(),
+                                    [&](const Registration& r) { return r.handle == socket.handle(); });
+        if (it != m_regs.end()) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Configure, 0, 0 };
+        }
+
+        m_regs.push_back(Registration{ socket.handle(), token, events });
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::modify(const TCPSocket& socket, std::uint64_t token, std::uint32_t events) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+
+        std::lock_guard lock(m_mtx);
+        const auto it = std::find_if(m_regs.begin(), m_regs.end(),
+                                    [&](const Registration& r) { return r.handle == socket.handle(); });
+        if (it == m_regs.end()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        it->token = token;
+        it->events = events;
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::remove(const TCPSocket& socket) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+
+        std::lock_guard lock(m_mtx);
+        const auto it = std::remove_if(m_regs.begin(), m_regs.end(),
+                                    [&](const Registration& r) { return r.handle == socket.handle(); });
+        if (it == m_regs.end()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        m_regs.erase(it, m_regs.end());
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::add(const evt::Notifier& notifier, std::uint64_t token) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+        if (!notifier.is_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+
+        std::lock_guard lock(m_mtx);
+        const auto it = std::find_if(m_notifiers.begin(), m_notifiers.end(),
+                                    [&](const NotifierRegistration& r) { return r.handle == notifier.native_handle(); });
+        if (it != m_notifiers.end()) {
+            return SockResult{ SockErr::DoubleOpen, SockOp::Configure, 0, 0 };
+        }
+
+        m_notifiers.push_back(NotifierRegistration{ notifier.native_handle(), token });
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::remove(const evt::Notifier& notifier) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Configure, 0, 0 };
+
+        std::lock_guard lock(m_mtx);
+        const auto it = std::remove_if(m_notifiers.begin(), m_notifiers.end(),
+                                    [&](const NotifierRegistration& r) { return r.handle == notifier.native_handle(); });
+        if (it == m_notifiers.end()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        m_notifiers.erase(it, m_notifiers.end());
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    SockResult Reactor::poll(ReactorEvent* out, std::size_t max, std::int32_t timeout_ms) {
+        if (!m_open) return SockResult{ SockErr::NotOpen, SockOp::Poll, 0, 0 };
+        if (out == nullptr || max == 0) return SockResult{ SockErr::SizeZero, SockOp::Poll, 0, 0 };
+
+        // snapshot the registrations so add/remove dont block behind a long poll,
+        // slot 0 is always the wake socket
+        std::vector<WSAPOLLFD> fds;
+        std::vector<std::uint64_t> tokens;
+        std::vector<NotifierRegistration> notifiers;
+        {
+            std::lock_guard lock(m_mtx);
+            fds.reserve(m_regs.size() + 1);
+            tokens.reserve(m_regs.size());
+            fds.push_back(WSAPOLLFD{ as_native(m_wake_handle), POLLRDNORM, 0 });
+            for (const auto& r : m_regs) {
+                fds.push_back(WSAPOLLFD{ as_native(r.handle), to_poll(r.events), 0 });
+                tokens.push_back(r.token);
+            }
+            notifiers = m_notifiers;
+        }
+
+        const ULONGLONG start = ::GetTickCount64();
+        std::int32_t count = 0;
+        while (true) {
+            // a zero timeout wait takes a count if there is one, hand it
+            // straight back so the caller can try_wait() it
+            for (const auto& r : notifiers) {
+                if (static_cast<std::size_t>(count) >= max) break;
+                if (::WaitForSingleObject(static_cast<HANDLE>(r.handle), 0) == WAIT_OBJECT_0) {
+                    (void)::ReleaseSemaphore(static_cast<HANDLE>(r.handle), 1, nullptr);
+                    out[count++] = ReactorEvent{ r.token, ready::Read };
+                }
+            }
+
+            // with notifiers registered sleep in 1ms slices so a post() is seen
+            std::int32_t slice = timeout_ms;
+            bool last = true;
+            if (count != 0) {
+                slice = 0;
+            } else if (!notifiers.empty() && timeout_ms != 0) {
+                last = false;
+                if (timeout_ms > 0) {
+                    const auto elapsed = static_cast<std::int64_t>(::GetTickCount64() - start);
+                    const auto left = static_cast<std::int64_t>(timeout_ms) - elapsed;
+                    if (left <= 1) last = true;
+                    slice = left <= 0 ? 0 : 1;
+                } else {
+                    slice = 1;
+                }
+            }
+
+            const int n = ::WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), slice);
+            if (n == SOCKET_ERROR) {
+                int err = ::WSAGetLastError();
+                return SockResult{ map_err(err), SockOp::Poll, err, 0 };
+            }
+
+            bool woken = false;
+            if (fds[0].revents & POLLRDNORM) {
+                char drain[64];
+                while (::recv(as_native(m_wake_handle), drain, sizeof(drain), 0) > 0) {}
+                woken = true;
+            }
+
+            for (std::size_t i = 1; i < fds.size() && static_cast<std::size_t>(count) < max; ++i) {
+                if (fds[i].revents == 0) continue;
+                out[count++] = ReactorEvent{ tokens[i - 1], from_poll(fds[i].revents) };
+            }
+
+            if (last || woken || count != 0) break;
+        }
+
+        return SockResult{ SockErr::None, SockOp::Poll, 0, count };
+    }
+
+    void Reactor::wake() noexcept {
+        if (m_wake_handle == INVALID_SOCKET) return;
+
+        sockaddr_in addr{};
+        int len = sizeof(addr);
+        if (::getsockname(as_native(m_wake_handle), reinterpret_cast<sockaddr*>(&addr), &len) != 0) return;
+
+        const char one = 1;
+        (void)::sendto(as_native(m_wake_handle), &one, 1, 0, reinterpret_cast<sockaddr*>(&addr), len);
+    }
+}
+#endif
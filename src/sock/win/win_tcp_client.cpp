@@ -1,6 +1,8 @@
 #if defined(MOO_WIN32)
 #include "sock/tcp_socket.h"
+#include "sock/io_ring.h"
 #include "windows_hdr.h"
+#include "instr/instr.h"
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
@@ -13,7 +15,26 @@ namespace sock {
     //     return static_cast<socket_handle>(handle);
     // }
 
-    TCPClient::TCPClient() : TCPSocket() {}
+    // counters for one send/recv call, compile to nothing without MOO_INSTRUMENT.
+    // the wsa error is put back since the first count on a thread may allocate
+    static void note_send(size_t wanted, long long sent) noexcept {
+        const int saved = ::WSAGetLastError();
+        MOO_INSTR_COUNT(instr::Counter::TcpSendCalls, 1);
+        if (sent > 0) {
+            MOO_INSTR_COUNT(instr::Counter::TcpSendBytes, sent);
+            MOO_INSTR_COUNT_IF(static_cast<size_t>(sent) < wanted, instr::Counter::TcpPartialSends);
+        }
+        ::WSASetLastError(saved);
+    }
+
+    static void note_recv(int got) noexcept {
+        const int saved = ::WSAGetLastError();
+        MOO_INSTR_COUNT(instr::Counter::TcpRecvCalls, 1);
+        if (got > 0) MOO_INSTR_COUNT(instr::Counter::TcpRecvBytes, got);
+        ::WSASetLastError(saved);
+    }
+
+    void TCPClient::rearm_quick_ack() noexcept {} // no TCP_QUICKACK on windows
 
     SockResult TCPClient::connect(const char* ip, uint16_t port) {
         if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
@@ -42,6 +63,38 @@ namespace sock {
         return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
     }
 
+    SockResult TCPClient::finish_connect() {
+        if (!handle_valid()) return SockResult{ SockErr::InvalidHandle, SockOp::Connect, 0, 0 };
+        if (is_connected()) return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
+
+        int so_err = 0;
+        int len = sizeof(so_err);
+        if (::getsockopt(as_native(m_handle), SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&so_err), &len) != 0) {
+            int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+        }
+
+        if (so_err == WSAEWOULDBLOCK || so_err == WSAEALREADY || so_err == WSAEINPROGRESS) {
+            return SockResult{ SockErr::WouldBlock, SockOp::Connect, so_err, 0 };
+        }
+
+        if (so_err != 0) {
+            return SockResult{ map_err(so_err), SockOp::Connect, so_err, 0 };
+        }
+
+        // SO_ERROR is also 0 while the handshake is still running
+        sockaddr_in peer{};
+        int peer_len = sizeof(peer);
+        if (::getpeername(as_native(m_handle), reinterpret_cast<sockaddr*>(&peer), &peer_len) != 0) {
+            int err = ::WSAGetLastError();
+            if (err == WSAENOTCONN) return SockResult{ SockErr::WouldBlock, SockOp::Connect, err, 0 };
+            return SockResult{ map_err(err), SockOp::Connect, err, 0 };
+        }
+
+        m_connected = true;
+        return SockResult{ SockErr::None, SockOp::Connect, 0, 0 };
+    }
+
     SockResult TCPClient::send(const void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
@@ -58,7 +111,9 @@ namespace sock {
         // NOTE: may not always send all bytes, use send_all() for that
         int sent_bytes = 0;
         {
+            MOO_INSTR_TIMER_START(lock_t0);
             std::lock_guard lock(m_send_mtx);
+            MOO_INSTR_TIMER_RECORD(lock_t0, instr::Hist::TcpSendLockWait);
             sent_bytes = ::send(
                 as_native(m_handle), 
                 static_cast<const char*>(data), 
@@ -66,6 +121,7 @@ namespace sock {
                 0
             );
         }
+        note_send(size, sent_bytes);
 
         if (sent_bytes > 0) {
             return SockResult{ SockErr::None, SockOp::Send, 0, sent_bytes };
@@ -100,10 +156,13 @@ namespace sock {
         size_t total = 0;
         auto* ptr = static_cast<const char*>(data);
 
+        MOO_INSTR_TIMER_START(lock_t0);
         std::lock_guard lock(m_send_mtx);
+        MOO_INSTR_TIMER_RECORD(lock_t0, instr::Hist::TcpSendLockWait);
         while (total < size) {
             int to_send = static_cast<int>(size - total);
             int sent_bytes = ::send(as_native(m_handle), ptr + total, to_send, 0);
+            note_send(size - total, sent_bytes);
 
             if (sent_bytes > 0) {
                 total += static_cast<size_t>(sent_bytes); 
@@ -131,6 +190,130 @@ namespace sock {
         return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
     }
 
+    SockResult TCPClient::send_all_v(const IoVec* bufs, const size_t count) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        if (bufs == nullptr || count == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        size_t size = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (bufs[i].data == nullptr && bufs[i].size != 0) {
+                return SockResult{ SockErr::InvalidArgument, SockOp::Send, 0, 0 };
+            }
+            size += bufs[i].size;
+        }
+
+        if (size == 0) {
+            return SockResult{ SockErr::SizeZero, SockOp::Send, 0, 0 };
+        }
+
+        if (size > static_cast<size_t>(INT32_MAX)) {
+            return SockResult{ SockErr::SizeTooLarge, SockOp::Send, 0, 0 };
+        }
+
+        constexpr size_t max_bufs = 64;
+        WSABUF wsa[max_bufs];
+
+        size_t total = 0;
+        size_t next = 0;      // first buffer not yet loaded into wsa
+        size_t loaded = 0;    // entries in wsa
+        size_t first = 0;     // first entry of wsa with bytes left
+
+        MOO_INSTR_TIMER_START(lock_t0);
+        std::lock_guard lock(m_send_mtx);
+        MOO_INSTR_TIMER_RECORD(lock_t0, instr::Hist::TcpSendLockWait);
+        while (total < size) {
+            if (first == loaded) {
+                first = 0;
+                loaded = 0;
+                while (next < count && loaded < max_bufs) {
+                    if (bufs[next].size != 0) {
+                        wsa[loaded].buf = static_cast<CHAR*>(const_cast<void*>(bufs[next].data));
+                        wsa[loaded].len = static_cast<ULONG>(bufs[next].size);
+                        ++loaded;
+                    }
+                    ++next;
+                }
+            }
+
+            DWORD sent = 0;
+            const int rc = ::WSASend(as_native(m_handle), &wsa[first], static_cast<DWORD>(loaded - first), &sent, 0, nullptr, nullptr);
+            note_send(size - total, rc == 0 ? static_cast<long long>(sent) : -1);
+            if (rc == 0) {
+                if (sent == 0) {
+                    m_connected = false;
+                    return SockResult{ SockErr::Closed, SockOp::Send, 0, static_cast<int>(total) };
+                }
+
+                total += sent;
+
+                // skip fully written entries, trim the partially written one
+                size_t left = sent;
+                while (first < loaded && left >= wsa[first].len) {
+                    left -= wsa[first].len;
+                    ++first;
+                }
+                if (left > 0) {
+                    wsa[first].buf += left;
+                    wsa[first].len -= static_cast<ULONG>(left);
+                }
+                continue;
+            }
+
+            int err = ::WSAGetLastError();
+            if (err == WSAEINTR) {
+                continue; // retry
+            }
+
+            if (is_fatal_send_err(err)) {
+                m_connected = false;
+            }
+
+            return SockResult{ map_err(err), SockOp::Send, err, static_cast<int>(total) };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(total) };
+    }
+
+    SockResult TCPClient::send_v_once(const IoVec* bufs, const size_t count) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+
+        constexpr size_t max_bufs = 64;
+        WSABUF wsa[max_bufs];
+        const size_t n = count < max_bufs ? count : max_bufs;
+        for (size_t i = 0; i < n; ++i) {
+            wsa[i].buf = static_cast<CHAR*>(const_cast<void*>(bufs[i].data));
+            wsa[i].len = static_cast<ULONG>(bufs[i].size);
+        }
+
+        size_t wanted = 0;
+        for (size_t i = 0; i < n; ++i) wanted += wsa[i].len;
+
+        DWORD sent = 0;
+        const int rc = ::WSASend(as_native(m_handle), wsa, static_cast<DWORD>(n), &sent, 0, nullptr, nullptr);
+        note_send(wanted, rc == 0 ? static_cast<long long>(sent) : -1);
+        if (rc == 0) {
+            if (sent == 0) {
+                m_connected = false;
+                return SockResult{ SockErr::Closed, SockOp::Send, 0, 0 };
+            }
+            return SockResult{ SockErr::None, SockOp::Send, 0, static_cast<int>(sent) };
+        }
+
+        int err = ::WSAGetLastError();
+        if (is_fatal_send_err(err)) {
+            m_connected = false;
+        }
+
+        return SockResult{ map_err(err), SockOp::Send, err, 0 };
+    }
+
     SockResult TCPClient::recv(void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
@@ -145,6 +328,7 @@ namespace sock {
         }
 
         int recv_bytes = ::recv(as_native(m_handle), static_cast<char*>(data), static_cast<int>(size), 0);
+        note_recv(recv_bytes);
         if (recv_bytes > 0) {
             return SockResult{ SockErr::None, SockOp::Recv, 0, recv_bytes };
         }
@@ -159,6 +343,11 @@ namespace sock {
         return SockResult{ map_err(err), SockOp::Recv, err, 0 };
     }
 
+    SockResult TCPClient::recv(void* data, const size_t size, RecvTimestamp& timestamp) {
+        timestamp = RecvTimestamp{}; // not available on windows
+        return recv(data, size);
+    }
+
     SockResult TCPClient::recv_all(void* data, const size_t size) {
         if (!is_connected()) {
             return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
@@ -182,6 +371,7 @@ namespace sock {
                 static_cast<int>(size - total),
                 0
             );
+            note_recv(recv_bytes);
 
             if (recv_bytes > 0) {
                 total += static_cast<size_t>(recv_bytes);
@@ -218,5 +408,26 @@ namespace sock {
             static_cast<int>(total)
         };
     }
+
+    SockResult TCPClient::queue_send(IoRing& ring, const void* data, const size_t size, std::uint64_t user_data) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Send, 0, 0 };
+        }
+        return ring.queue_send(m_handle, data, size, user_data);
+    }
+
+    SockResult TCPClient::queue_recv(IoRing& ring, void* data, const size_t size, std::uint64_t user_data) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv(m_handle, data, size, user_data);
+    }
+
+    SockResult TCPClient::queue_recv_multishot(IoRing& ring, std::uint64_t user_data) {
+        if (!is_connected()) {
+            return SockResult{ SockErr::NotConnected, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv_multishot(m_handle, user_data);
+    }
 }
-#endif
\ No newline at end of file
+#endif
@@ -63,12 +63,9 @@ namespace sock {
         return SockResult{ SockErr::None, SockOp::Listen, 0, 0 };
     }
 
-    std::pair<std::shared_ptr<TCPClient>, SockResult> TCPServer::accept() {
-        SockResult result{ SockErr::Unknown, SockOp::Accept, 0, 0 };
-
+    SockResult TCPServer::accept_into(TCPClient& out) {
         if (!handle_valid()) {
-            result.code = SockErr::InvalidHandle;
-            return { nullptr, result };
+            return SockResult{ SockErr::InvalidHandle, SockOp::Accept, 0, 0 };
         }
 
         sockaddr_in conn{};
@@ -76,20 +73,41 @@ namespace sock {
 
         SOCKET sock = ::accept(as_native(m_handle), reinterpret_cast<sockaddr*>(&conn), &conn_size);
         if (sock == INVALID_SOCKET) {
-            result.sys_error = ::WSAGetLastError();
-            if (result.sys_error == WSAEINVAL || result.sys_error == WSAENOTSOCK) {
-                result.code = SockErr::Closed;
-            } else {
-                result.code = map_err(result.sys_error);
+            int err = ::WSAGetLastError();
+            if (err == WSAEINVAL || err == WSAENOTSOCK) {
+                return SockResult{ SockErr::Closed, SockOp::Accept, err, 0 };
             }
-            return { nullptr, result };
+            return SockResult{ map_err(err), SockOp::Accept, err, 0 };
         }
 
+        // accepted sockets inherit the listeners non-blocking mode on windows
+        out.adopt(from_native(sock), true, m_nonblocking);
+        return SockResult{ SockErr::None, SockOp::Accept, 0, 0 };
+    }
+
+    std::pair<std::shared_ptr<TCPClient>, SockResult> TCPServer::accept() {
         auto client = std::make_shared<TCPClient>();
-        client->adopt(from_native(sock), true);
-        
-        result.code = SockErr::None;
+        const auto result = accept_into(*client);
+        if (!result.ok()) return { nullptr, result };
         return { std::move(client), result };
     }
+
+    SockResult TCPServer::apply_listen_options(const TcpListenOptions& opts) {
+        if (!handle_valid()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        // no SO_REUSEPORT or TCP_DEFER_ACCEPT on windows
+        if (opts.fastopen_queue > 0) {
+            const DWORD enable = 1;
+            if (::setsockopt(as_native(m_handle), IPPROTO_TCP, TCP_FASTOPEN,
+                             reinterpret_cast<const char*>(&enable), sizeof(enable)) != 0) {
+                int err = ::WSAGetLastError();
+                return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+            }
+        }
+
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
 }
 #endif
@@ -22,13 +22,17 @@ namespace sock {
 
     TCPSocket::TCPSocket(TCPSocket&& other) noexcept 
         : m_handle(std::exchange(other.m_handle, INVALID_SOCKET)), 
-          m_connected(std::exchange(other.m_connected, false)) {}
+          m_connected(std::exchange(other.m_connected, false)),
+          m_nonblocking(std::exchange(other.m_nonblocking, false)),
+          m_quick_ack(std::exchange(other.m_quick_ack, false)) {}
 
     TCPSocket& TCPSocket::operator=(TCPSocket&& other) noexcept {
         if (this != &other) {
             close();
             m_handle = std::exchange(other.m_handle, INVALID_SOCKET);
             m_connected = std::exchange(other.m_connected, false);
+            m_nonblocking = std::exchange(other.m_nonblocking, false);
+            m_quick_ack = std::exchange(other.m_quick_ack, false);
         }
         return *this;
     }
@@ -62,6 +66,46 @@ namespace sock {
         }
         m_handle = INVALID_SOCKET;
         m_connected = false;
+        m_nonblocking = false;
+        m_quick_ack = false;
+    }
+
+    SockResult TCPSocket::set_nonblocking(bool enable) {
+        if (!handle_valid()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        u_long mode = enable ? 1 : 0;
+        if (::ioctlsocket(as_native(m_handle), FIONBIO, &mode) != 0) {
+            int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        m_nonblocking = enable;
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
+    }
+
+    // busy_poll, quick_ack and timestamps have no windows equivalent
+    SockResult TCPSocket::apply_options(const TcpSocketOptions& opts) {
+        if (!handle_valid()) {
+            return SockResult{ SockErr::InvalidHandle, SockOp::Configure, 0, 0 };
+        }
+
+        const BOOL no_delay = TRUE;
+        const DWORD recv_timeout = opts.recv_timeout_ms > 0 ? static_cast<DWORD>(opts.recv_timeout_ms) : 0;
+        if ((opts.rcvbuf > 0 && ::setsockopt(as_native(m_handle), SOL_SOCKET, SO_RCVBUF,
+                                reinterpret_cast<const char*>(&opts.rcvbuf), sizeof(opts.rcvbuf)) != 0) ||
+            (opts.sndbuf > 0 && ::setsockopt(as_native(m_handle), SOL_SOCKET, SO_SNDBUF,
+                                reinterpret_cast<const char*>(&opts.sndbuf), sizeof(opts.sndbuf)) != 0) ||
+            (opts.no_delay && ::setsockopt(as_native(m_handle), IPPROTO_TCP, TCP_NODELAY,
+                                reinterpret_cast<const char*>(&no_delay), sizeof(no_delay)) != 0) ||
+            (recv_timeout != 0 && ::setsockopt(as_native(m_handle), SOL_SOCKET, SO_RCVTIMEO,
+                                reinterpret_cast<const char*>(&recv_timeout), sizeof(recv_timeout)) != 0)) {
+            int err = ::WSAGetLastError();
+            return SockResult{ map_err(err), SockOp::Configure, err, 0 };
+        }
+
+        return SockResult{ SockErr::None, SockOp::Configure, 0, 0 };
     }
 }
 #endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 #if defined(MOO_WIN32)
 #include "sock/udp_multicast.h"
+#include "sock/io_ring.h"
 #include "windows_hdr.h"
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -13,6 +14,9 @@ namespace sock {
         return static_cast<socket_handle>(h);
     }
 
+    static UdpEndpoint to_endpoint(const sockaddr_in& addr) noexcept {
+        return UdpEndpoint{ ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port) };
+    }
     
     bool UDPMulticastSocket::handle_valid() const noexcept {
          return m_handle != INVALID_SOCKET; 
@@ -29,7 +33,9 @@ namespace sock {
         m_handle(std::exchange(other.m_handle, INVALID_SOCKET)),
         m_open(std::exchange(other.m_open, false)),
         m_joined(std::exchange(other.m_joined, false)),
-        m_cfg(other.m_cfg) {}
+        m_cfg(other.m_cfg),
+        m_dst_addr(other.m_dst_addr),
+        m_dst_port(other.m_dst_port) {}
 
     UDPMulticastSocket& UDPMulticastSocket::operator=(UDPMulticastSocket&& other) noexcept {
         if (this != &other) {
@@ -38,6 +44,8 @@ namespace sock {
             m_open = std::exchange(other.m_open, false);
             m_joined = std::exchange(other.m_joined, false);
             m_cfg = other.m_cfg;
+            m_dst_addr = other.m_dst_addr;
+            m_dst_port = other.m_dst_port;
         }
         return *this;
     }
@@ -73,6 +81,18 @@ namespace sock {
             );
         }
 
+        // buffer sizing, busy poll and kernel timestamps have no windows equivalent
+        result.op = SockOp::Configure;
+        if ((cfg.rcvbuf > 0 && ::setsockopt(as_native(m_handle), SOL_SOCKET, SO_RCVBUF,
+                                reinterpret_cast<const char*>(&cfg.rcvbuf), sizeof(cfg.rcvbuf)) != 0) ||
+            (cfg.sndbuf > 0 && ::setsockopt(as_native(m_handle), SOL_SOCKET, SO_SNDBUF,
+                                reinterpret_cast<const char*>(&cfg.sndbuf), sizeof(cfg.sndbuf)) != 0)) {
+            result.sys_error = ::WSAGetLastError();
+            result.code = map_err(result.sys_error);
+            close();
+            return result;
+        }
+
         // bind
         result.op = SockOp::Bind;
 
@@ -128,6 +148,10 @@ namespace sock {
             return result;
         }
 
+        // resolve the destination once so sends dont re-parse group_ip
+        m_dst_addr = mreq.imr_multiaddr.s_addr;
+        m_dst_port = htons(cfg.port);
+
         m_joined = true;
         result.code = SockErr::None;
         result.op = SockOp::Open;
@@ -145,12 +169,8 @@ namespace sock {
 
         sockaddr_in dst{};
         dst.sin_family = AF_INET;
-        dst.sin_port = htons(m_cfg.port);
-
-        if (::inet_pton(AF_INET, m_cfg.group_ip.c_str(), &dst.sin_addr) != 1) {
-            result.code = SockErr::InvalidIp;
-            return result;
-        }
+        dst.sin_port = m_dst_port;
+        dst.sin_addr.s_addr = m_dst_addr;
 
         int sent = ::sendto(as_native(m_handle),
                             static_cast<const char*>(data),
@@ -171,6 +191,11 @@ namespace sock {
     }
 
     SockResult UDPMulticastSocket::recv_broadcast(void* data, size_t size) noexcept {
+        UdpEndpoint source{};
+        return recv_broadcast(data, size, source);
+    }
+
+    SockResult UDPMulticastSocket::recv_broadcast(void* data, size_t size, UdpEndpoint& source) noexcept {
         SockResult result{};
         result.op = SockOp::Recv;
 
@@ -195,11 +220,159 @@ namespace sock {
             return result;
         }
 
+        source = to_endpoint(src);
         result.bytes = recvd;
         result.code = SockErr::None;
         return result;
     }
 
+    SockResult UDPMulticastSocket::recv_broadcast(void* data, size_t size, UdpEndpoint& source, RecvTimestamp& timestamp) noexcept {
+        timestamp = RecvTimestamp{}; // not available on windows
+        return recv_broadcast(data, size, source);
+    }
+
+    // no recvmmsg on windows, block for the first datagram then keep reading
+    // while FIONREAD says more are queued
+    SockResult UDPMulticastSocket::recv_batch(UdpDatagram* msgs, size_t count) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!msgs) { result.code = SockErr::InvalidArgument; return result; }
+        if (count == 0) { result.code = SockErr::SizeZero; return result; }
+
+        size_t filled = 0;
+        while (filled < count) {
+            if (filled > 0) {
+                u_long pending = 0;
+                if (::ioctlsocket(as_native(m_handle), FIONREAD, &pending) != 0 || pending == 0) break;
+            }
+
+            auto& msg = msgs[filled];
+            if (!msg.data || msg.size == 0) { result.code = SockErr::InvalidArgument; result.bytes = static_cast<int>(filled); return result; }
+
+            const auto r = recv_broadcast(msg.data, msg.size, msg.source);
+            if (!r.ok()) {
+                if (filled > 0) break; // report what we have, error shows up next call
+                return r;
+            }
+
+            msg.length = static_cast<std::uint32_t>(r.bytes);
+            msg.segment_size = 0;
+            msg.timestamp = RecvTimestamp{};
+            ++filled;
+        }
+
+        result.bytes = static_cast<int>(filled);
+        result.code = SockErr::None;
+        return result;
+    }
+
+    SockResult UDPMulticastSocket::send_batch(const UdpDatagram* msgs, size_t count) noexcept {
+        SockResult result{};
+        result.op = SockOp::Send;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!msgs) { result.code = SockErr::InvalidArgument; return result; }
+        if (count == 0) { result.code = SockErr::SizeZero; return result; }
+
+        size_t sent = 0;
+        for (; sent < count; ++sent) {
+            const auto r = send_broadcast(msgs[sent].data, msgs[sent].size);
+            if (!r.ok()) {
+                if (sent > 0) break;
+                return r;
+            }
+        }
+
+        result.bytes = static_cast<int>(sent);
+        result.code = SockErr::None;
+        return result;
+    }
+
+    // no UDP_SEGMENT here, split in user space
+    SockResult UDPMulticastSocket::send_segmented(const void* data, size_t size, std::uint16_t segment_size) noexcept {
+        SockResult result{};
+        result.op = SockOp::Send;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (!data || segment_size == 0) { result.code = SockErr::InvalidArgument; return result; }
+        if (size == 0) { result.code = SockErr::SizeZero; return result; }
+        if (size > static_cast<size_t>(INT32_MAX)) { result.code = SockErr::SizeTooLarge; return result; }
+
+        const auto* ptr = static_cast<const char*>(data);
+        size_t total = 0;
+        while (total < size) {
+            const size_t chunk = (size - total) < segment_size ? (size - total) : segment_size;
+            const auto r = send_broadcast(ptr + total, chunk);
+            if (!r.ok()) {
+                result.code = r.code;
+                result.sys_error = r.sys_error;
+                result.bytes = static_cast<int>(total);
+                return result;
+            }
+            total += chunk;
+        }
+
+        result.bytes = static_cast<int>(total);
+        result.code = SockErr::None;
+        return result;
+    }
+
+    // no packet ring on windows (cfg.ring_iface is ignored), same contract over the socket
+    SockResult UDPMulticastSocket::recv_ring(RingFn fn, void* ctx, int timeout_ms, size_t max_count) noexcept {
+        SockResult result{};
+        result.op = SockOp::Recv;
+
+        if (!is_open() || !m_joined) { result.code = SockErr::NotOpen; return result; }
+        if (fn == nullptr || max_count == 0) { result.code = SockErr::InvalidArgument; return result; }
+        if (max_count > static_cast<size_t>(INT32_MAX)) max_count = static_cast<size_t>(INT32_MAX);
+
+        WSAPOLLFD pfd{};
+        pfd.fd = as_native(m_handle);
+        pfd.events = POLLRDNORM;
+        const int n = ::WSAPoll(&pfd, 1, timeout_ms);
+        if (n == SOCKET_ERROR) {
+            result.sys_error = ::WSAGetLastError();
+            result.code = map_err(result.sys_error);
+            return result;
+        }
+        if (n == 0) { result.code = SockErr::WouldBlock; return result; }
+
+        static thread_local char buf[65536];
+        int delivered = 0;
+        const int limit = static_cast<int>(max_count);
+        while (delivered < limit) {
+            if (delivered > 0) {
+                u_long pending = 0;
+                if (::ioctlsocket(as_native(m_handle), FIONREAD, &pending) != 0 || pending == 0) break;
+            }
+
+            sockaddr_in src{};
+            int srclen = sizeof(src);
+            const int recvd = ::recvfrom(as_native(m_handle), buf, static_cast<int>(sizeof(buf)), 0,
+                                         reinterpret_cast<sockaddr*>(&src), &srclen);
+            if (recvd == SOCKET_ERROR) {
+                if (delivered > 0) break; // error shows up next call
+                result.sys_error = ::WSAGetLastError();
+                result.code = map_err(result.sys_error);
+                return result;
+            }
+
+            UdpDatagram msg{};
+            msg.data = buf;
+            msg.size = static_cast<std::uint32_t>(recvd);
+            msg.length = msg.size;
+            msg.source = to_endpoint(src);
+            fn(ctx, msg);
+            ++delivered;
+        }
+
+        result.bytes = delivered;
+        result.code = SockErr::None;
+        return result;
+    }
+
     void UDPMulticastSocket::close() noexcept {
         if (handle_valid()) {
             ::closesocket(as_native(m_handle));
@@ -208,5 +381,19 @@ namespace sock {
         m_open = false;
         m_joined = false;
     }
+
+    SockResult UDPMulticastSocket::queue_recv_broadcast(IoRing& ring, void* data, size_t size, std::uint64_t user_data) noexcept {
+        if (!is_open() || !m_joined) {
+            return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv(m_handle, data, size, user_data);
+    }
+
+    SockResult UDPMulticastSocket::queue_recv_multishot(IoRing& ring, std::uint64_t user_data) noexcept {
+        if (!is_open() || !m_joined) {
+            return SockResult{ SockErr::NotOpen, SockOp::Recv, 0, 0 };
+        }
+        return ring.queue_recv_multishot(m_handle, user_data);
+    }
 }
-#endif
\ No newline at end of file
+#endif